@@ -37,6 +37,7 @@ typedef unsigned char cab_UBYTE; /* 8 bits  */
 typedef UINT16        cab_UWORD; /* 16 bits */
 typedef UINT32        cab_ULONG; /* 32 bits */
 typedef INT32         cab_LONG;  /* 32 bits */
+typedef UINT64        cab_UQUAD; /* 64 bits */
 
 typedef UINT32        cab_off_t;
 
@@ -45,6 +46,7 @@ typedef UINT32        cab_off_t;
 # define CHAR_BIT (8)
 #endif
 #define CAB_ULONG_BITS (sizeof(cab_ULONG) * CHAR_BIT)
+#define CAB_UQUAD_BITS (sizeof(cab_UQUAD) * CHAR_BIT)
 
 /* structure offsets */
 #define cfhead_Signature         (0x00)
@@ -102,8 +104,8 @@ typedef UINT32        cab_off_t;
 
 /* MSZIP stuff */
 #define ZIPWSIZE 	0x8000  /* window size */
-#define ZIPLBITS	9	/* bits in base literal/length lookup table */
-#define ZIPDBITS	6	/* bits in base distance lookup table */
+#define ZIPLBITS	10	/* bits in base literal/length lookup table */
+#define ZIPDBITS	8	/* bits in base distance lookup table */
 #define ZIPBMAX		16      /* maximum bit length of any code */
 #define ZIPN_MAX	288     /* maximum number of codes in any set */
 
@@ -176,8 +178,9 @@ struct QTMstate {
 #define LZX_NUM_SECONDARY_LENGTHS    (249) /* length tree #elements */
 
 /* LZX huffman defines: tweak tablebits as desired */
+#define LZX_MAX_CODE_LENGTH     (16)
 #define LZX_PRETREE_MAXSYMBOLS  (LZX_PRETREE_NUM_ELEMENTS)
-#define LZX_PRETREE_TABLEBITS   (6)
+#define LZX_PRETREE_TABLEBITS   (8)
 #define LZX_MAINTREE_MAXSYMBOLS (LZX_NUM_CHARS + 50*8)
 #define LZX_MAINTREE_TABLEBITS  (12)
 #define LZX_LENGTH_MAXSYMBOLS   (LZX_NUM_SECONDARY_LENGTHS+1)
@@ -187,8 +190,11 @@ struct QTMstate {
 
 #define LZX_LENTABLE_SAFETY (64) /* we allow length table decoding overruns */
 
+/* the first level table is followed by at most one second level table per
+ * symbol, each one resolving the remaining bits of the longest codes */
 #define LZX_DECLARE_TABLE(tbl) \
-  cab_UWORD tbl##_table[(1<<LZX_##tbl##_TABLEBITS) + (LZX_##tbl##_MAXSYMBOLS<<1)];\
+  cab_UWORD tbl##_table[(1<<LZX_##tbl##_TABLEBITS) + \
+    (LZX_##tbl##_MAXSYMBOLS<<(LZX_MAX_CODE_LENGTH-LZX_##tbl##_TABLEBITS))];\
   cab_UBYTE tbl##_len  [LZX_##tbl##_MAXSYMBOLS + LZX_LENTABLE_SAFETY]
 
 struct LZXstate {
@@ -214,7 +220,7 @@ struct LZXstate {
 };
 
 struct lzx_bits {
-  cab_ULONG bb;
+  cab_UQUAD bb;
   int bl;
   cab_UBYTE *ip;
 };
@@ -381,16 +387,20 @@ typedef struct cds_forward {
  * READ_BITS(var,n)  takes N bits from the buffer and puts them in var
  *
  * ENSURE_BITS(n)    ensures there are at least N bits in the bit buffer.
- *                   it can guarantee up to 17 bits (i.e. it can read in
- *                   16 new bits when there is down to 1 bit in the buffer,
- *                   and it can read 32 bits when there are 0 bits in the
- *                   buffer).
+ *                   it can guarantee up to 49 bits (i.e. it can read in
+ *                   16 new bits when there are down to 33 bits in the
+ *                   buffer, and it can read 64 bits when there are 0 bits
+ *                   in the buffer).
+ * FILL_BITS         reads in as many 16 bit words as fit in the buffer, so
+ *                   that a whole match can usually be decoded without any
+ *                   further input.
  * PEEK_BITS(n)      extracts (without removing) N bits from the bit buffer
  * REMOVE_BITS(n)    removes N bits from the bit buffer
  *
  * These bit access routines work by using the area beyond the MSB and the
  * LSB as a free source of zeroes. This avoids having to mask any bits.
- * So we have to know the bit width of the bitbuffer variable.
+ * So we have to know the bit width of the bitbuffer variable, which is a
+ * cab_UQUAD for LZX.
  */
 
 #define INIT_BITSTREAM do { bitsleft = 0; bitbuf = 0; } while (0)
@@ -398,11 +408,14 @@ typedef struct cds_forward {
 /* Quantum reads bytes in normal order; LZX is little-endian order */
 #define ENSURE_BITS(n)                                                    \
   while (bitsleft < (n)) {                                                \
-    bitbuf |= ((inpos[1]<<8)|inpos[0]) << (CAB_ULONG_BITS-16 - bitsleft); \
+    bitbuf |= (cab_UQUAD)((inpos[1]<<8)|inpos[0])                         \
+              << (CAB_UQUAD_BITS-16 - bitsleft);                          \
     bitsleft += 16; inpos+=2;                                             \
   }
 
-#define PEEK_BITS(n)   (bitbuf >> (CAB_ULONG_BITS - (n)))
+#define FILL_BITS      ENSURE_BITS(CAB_UQUAD_BITS - 15)
+
+#define PEEK_BITS(n)   (bitbuf >> (CAB_UQUAD_BITS - (n)))
 #define REMOVE_BITS(n) ((bitbuf <<= (n)), (bitsleft -= (n)))
 
 #define READ_BITS(v,n) do {                                             \
@@ -434,17 +447,19 @@ typedef struct cds_forward {
   )) { return DECR_ILLEGALDATA; }
 
 /* READ_HUFFSYM(tablename, var) decodes one huffman symbol from the
- * bitstream using the stated table and puts it in var.
+ * bitstream using the stated table and puts it in var. Codes longer than
+ * the table bits are looked up in the second level table that the first
+ * level entry points to.
  */
+#define SUBTABLEBITS(tbl) (LZX_MAX_CODE_LENGTH - TABLEBITS(tbl))
 #define READ_HUFFSYM(tbl,var) do {                                      \
-  ENSURE_BITS(16);                                                      \
+  ENSURE_BITS(LZX_MAX_CODE_LENGTH);                                     \
   hufftbl = SYMTABLE(tbl);                                              \
   if ((i = hufftbl[PEEK_BITS(TABLEBITS(tbl))]) >= MAXSYMBOLS(tbl)) {    \
-    j = 1 << (CAB_ULONG_BITS - TABLEBITS(tbl));                         \
-    do {                                                                \
-      j >>= 1; i <<= 1; i |= (bitbuf & j) ? 1 : 0;                      \
-      if (!j) { return DECR_ILLEGALDATA; }                              \
-    } while ((i = hufftbl[i]) >= MAXSYMBOLS(tbl));                      \
+    i = hufftbl[(1 << TABLEBITS(tbl)) +                                 \
+                ((i - MAXSYMBOLS(tbl)) << SUBTABLEBITS(tbl)) +          \
+                (PEEK_BITS(LZX_MAX_CODE_LENGTH) &                       \
+                 ((1 << SUBTABLEBITS(tbl)) - 1))];                      \
   }                                                                     \
   j = LENTABLE(tbl)[(var) = i];                                         \
   REMOVE_BITS(j);                                                       \
@@ -142,7 +142,7 @@ typedef struct fdi_cds_fwd {
   cab_UBYTE *outpos;               /* (high level) start of data to use up  */
   cab_UWORD outlen;                /* (high level) amount of data to use up */
   int (*decompress)(int, int, struct fdi_cds_fwd *); /* chosen compress fn  */
-  cab_UBYTE inbuf[CAB_INPUTMAX+2]; /* +2 for lzx bitbuffer overflows!       */
+  cab_UBYTE inbuf[CAB_INPUTMAX+8]; /* +8 for lzx/mszip bitbuffer overflows! */
   cab_UBYTE outbuf[CAB_BLOCKMAX];
   union {
     struct ZIPstate zip;
@@ -166,6 +166,9 @@ typedef struct fdi_cds_fwd {
 #define ZIPNEEDBITS(n) {while(k<(n)){cab_LONG c=*(ZIP(inpos)++);\
     b|=((cab_ULONG)c)<<k;k+=8;}}
 #define ZIPDUMPBITS(n) {b>>=(n);k-=(n);}
+/* fill the bit buffer up to at least 25 bits, so that a whole code and its
+ * extra bits can be decoded without any further input check */
+#define ZIPFILLBITS {while(k<=24){b|=((cab_ULONG)*(ZIP(inpos)++))<<k;k+=8;}}
 
 /* endian-neutral reading of little-endian data */
 #define EndGetI32(a)  ((((a)[3])<<24)|(((a)[2])<<16)|(((a)[1])<<8)|((a)[0]))
@@ -184,6 +187,19 @@ typedef struct fdi_cds_fwd {
 #define DECR_OUTPUT       (6)
 #define DECR_USERABORT    (7)
 
+/* Copies a LZ77 match. When the source overlaps the destination (offset
+ * smaller than the length), the last bytes get repeated, so it has to be
+ * copied byte by byte.
+ */
+static inline void copy_match(cab_UBYTE *dst, const cab_UBYTE *src, int len)
+{
+  if (len <= 0) return;
+  if (src > dst || dst - src >= len)
+    memmove(dst, src, len);
+  else
+    while (len--) *dst++ = *src++;
+}
+
 static void set_error( FDI_Int *fdi, int oper, int err )
 {
     fdi->perf->erfOper = oper;
@@ -262,8 +278,13 @@ static void QTMupdatemodel(struct QTMmodel *model, int sym) {
 /*************************************************************************
  * make_decode_table (internal)
  *
- * This function was coded by David Tritscher. It builds a fast huffman
- * decoding table out of just a canonical huffman code lengths table.
+ * This function was originally coded by David Tritscher. It builds a fast
+ * huffman decoding table out of just a canonical huffman code lengths table.
+ *
+ * Codes of up to nbits bits are decoded in one lookup of the first level
+ * table. The first level entries of longer codes hold nsyms plus the index
+ * of a second level table, which is indexed by the next 16 - nbits bits.
+ * The second level tables follow the first level one.
  *
  * PARAMS
  *   nsyms:  total number of symbols in this huffman tree.
@@ -278,72 +299,50 @@ static void QTMupdatemodel(struct QTMmodel *model, int sym) {
  */
 static int make_decode_table(cab_ULONG nsyms, cab_ULONG nbits,
                              const cab_UBYTE *length, cab_UWORD *table) {
-  register cab_UWORD sym;
+  register cab_ULONG sym;
   register cab_ULONG leaf;
-  register cab_UBYTE bit_num = 1;
-  cab_ULONG fill;
-  cab_ULONG pos         = 0; /* the current position in the decode table */
-  cab_ULONG table_mask  = 1 << nbits;
-  cab_ULONG bit_mask    = table_mask >> 1; /* don't do 0 length codes */
-  cab_ULONG next_symbol = bit_mask; /* base of allocation for long codes */
-
-  /* fill entries for codes short enough for a direct mapping */
-  while (bit_num <= nbits) {
+  cab_ULONG bit_num, fill, step;
+  cab_ULONG pos       = 0; /* the current code, left aligned on 16 bits */
+  cab_ULONG table_end = 1 << LZX_MAX_CODE_LENGTH;
+  cab_ULONG sub_bits  = LZX_MAX_CODE_LENGTH - nbits;
+  cab_ULONG prefix    = table_end; /* first level entry of the current subtable */
+  cab_ULONG next_sub  = 0;
+  cab_UWORD *subtable = NULL;
+
+  for (bit_num = 1; bit_num <= LZX_MAX_CODE_LENGTH; bit_num++) {
+    step = 1 << (LZX_MAX_CODE_LENGTH - bit_num);
+
     for (sym = 0; sym < nsyms; sym++) {
-      if (length[sym] == bit_num) {
-        leaf = pos;
+      if (length[sym] != bit_num) continue;
 
-        if((pos += bit_mask) > table_mask) return 1; /* table overrun */
+      if (pos + step > table_end) return 1; /* table overrun */
 
+      if (bit_num <= nbits) {
         /* fill all possible lookups of this symbol with the symbol itself */
-        fill = bit_mask;
-        while (fill-- > 0) table[leaf++] = sym;
+        leaf = pos >> sub_bits;
+        for (fill = step >> sub_bits; fill > 0; fill--) table[leaf++] = sym;
       }
-    }
-    bit_mask >>= 1;
-    bit_num++;
-  }
-
-  /* if there are any codes longer than nbits */
-  if (pos != table_mask) {
-    /* clear the remainder of the table */
-    for (sym = pos; sym < table_mask; sym++) table[sym] = 0;
-
-    /* give ourselves room for codes to grow by up to 16 more bits */
-    pos <<= 16;
-    table_mask <<= 16;
-    bit_mask = 1 << 15;
-
-    while (bit_num <= 16) {
-      for (sym = 0; sym < nsyms; sym++) {
-        if (length[sym] == bit_num) {
-          leaf = pos >> 16;
-          for (fill = 0; fill < bit_num - nbits; fill++) {
-            /* if this path hasn't been taken yet, 'allocate' two entries */
-            if (table[leaf] == 0) {
-              table[(next_symbol << 1)] = 0;
-              table[(next_symbol << 1) + 1] = 0;
-              table[leaf] = next_symbol++;
-            }
-            /* follow the path and select either left or right for next bit */
-            leaf = table[leaf] << 1;
-            if ((pos >> (15-fill)) & 1) leaf++;
-          }
-          table[leaf] = sym;
-
-          if ((pos += bit_mask) > table_mask) return 1; /* table overflow */
+      else {
+        /* codes are sorted, so all the codes sharing a prefix are next
+         * to each other and completely fill their second level table */
+        if ((pos >> sub_bits) != prefix) {
+          prefix = pos >> sub_bits;
+          table[prefix] = nsyms + next_sub;
+          subtable = table + (1 << nbits) + (next_sub++ << sub_bits);
         }
+        leaf = pos & ((1 << sub_bits) - 1);
+        for (fill = step; fill > 0; fill--) subtable[leaf++] = sym;
       }
-      bit_mask >>= 1;
-      bit_num++;
+      pos += step;
     }
   }
 
   /* full table? */
-  if (pos == table_mask) return 0;
+  if (pos == table_end) return 0;
 
   /* either erroneous table, or all elements are 0 - let's find out. */
   for (sym = 0; sym < nsyms; sym++) if (length[sym]) return 1;
+  for (sym = 0; sym < (1 << nbits); sym++) table[sym] = 0;
   return 0;
 }
 
@@ -1080,7 +1079,7 @@ static cab_LONG fdi_Zipinflate_codes(const struct Ziphuft *tl, const struct Ziph
 
   for(;;)
   {
-    ZIPNEEDBITS((cab_ULONG)bl)
+    ZIPFILLBITS
     if((e = (t = tl + (b & ml))->e) > 16)
       do
       {
@@ -1105,7 +1104,7 @@ static cab_LONG fdi_Zipinflate_codes(const struct Ziphuft *tl, const struct Ziph
       ZIPDUMPBITS(e);
 
       /* decode distance of block to copy */
-      ZIPNEEDBITS((cab_ULONG)bd)
+      ZIPFILLBITS
       if ((e = (t = td + (b & md))->e) > 16)
         do {
           if (e == 99)
@@ -1124,10 +1123,9 @@ static cab_LONG fdi_Zipinflate_codes(const struct Ziphuft *tl, const struct Ziph
         e = ZIPWSIZE - max(d, w);
         e = min(e, n);
         n -= e;
-        do
-        {
-          CAB(outbuf)[w++] = CAB(outbuf)[d++];
-        } while (--e);
+        copy_match(CAB(outbuf) + w, CAB(outbuf) + d, e);
+        w += e;
+        d += e;
       } while (n);
     }
   }
@@ -1170,13 +1168,18 @@ static cab_LONG fdi_Zipinflate_stored(fdi_decomp_state *decomp_state)
     return 1;                   /* error in compressed data */
   ZIPDUMPBITS(16)
 
-  /* read and output the compressed data */
-  while(n--)
+  if (w + n > ZIPWSIZE)
+    return 1;                   /* error in compressed data */
+
+  /* output the bytes already in the bit buffer, then copy the rest */
+  for (; n && k; n--)
   {
-    ZIPNEEDBITS(8)
     CAB(outbuf)[w++] = (cab_UBYTE)b;
     ZIPDUMPBITS(8)
   }
+  memcpy(CAB(outbuf) + w, ZIP(inpos), n);
+  ZIP(inpos) += n;
+  w += n;
 
   /* restore the globals from the locals */
   ZIP(window_posn) = w;              /* restore global window pointer */
@@ -1530,14 +1533,15 @@ static int QTMfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
         if (copy_length < match_length) {
           match_length -= copy_length;
           window_posn += copy_length;
-          while (copy_length-- > 0) *rundest++ = *runsrc++;
+          copy_match(rundest, runsrc, copy_length);
+          rundest += copy_length;
           runsrc = window;
         }
       }
       window_posn += match_length;
 
       /* copy match data - no worries about destination wraps */
-      while (match_length-- > 0) *rundest++ = *runsrc++;
+      copy_match(rundest, runsrc, match_length);
     }
   } /* while (togo > 0) */
 
@@ -1561,7 +1565,7 @@ static int fdi_lzx_read_lens(cab_UBYTE *lens, cab_ULONG first, cab_ULONG last, s
   cab_ULONG i,j, x,y;
   int z;
 
-  register cab_ULONG bitbuf = lb->bb;
+  register cab_UQUAD bitbuf = lb->bb;
   register int bitsleft = lb->bl;
   cab_UBYTE *inpos = lb->ip;
   cab_UWORD *hufftbl;
@@ -1616,7 +1620,7 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
   cab_ULONG R1 = LZX(R1);
   cab_ULONG R2 = LZX(R2);
 
-  register cab_ULONG bitbuf;
+  register cab_UQUAD bitbuf;
   register int bitsleft;
   cab_ULONG match_offset, i,j,k; /* ijk used in READ_HUFFSYM macro */
   struct lzx_bits lb; /* used in READ_LENGTHS macro */
@@ -1669,7 +1673,7 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
       case LZX_BLOCKTYPE_UNCOMPRESSED:
         LZX(intel_started) = 1; /* because we can't assume otherwise */
         ENSURE_BITS(16); /* get up to 16 pad bits into the buffer */
-        if (bitsleft > 16) inpos -= 2; /* and align the bitstream! */
+        inpos -= ((bitsleft - 1) >> 4) << 1; /* and align the bitstream! */
         R0 = inpos[0]|(inpos[1]<<8)|(inpos[2]<<16)|(inpos[3]<<24);inpos+=4;
         R1 = inpos[0]|(inpos[1]<<8)|(inpos[2]<<16)|(inpos[3]<<24);inpos+=4;
         R2 = inpos[0]|(inpos[1]<<8)|(inpos[2]<<16)|(inpos[3]<<24);inpos+=4;
@@ -1686,11 +1690,11 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
        * 16 bits in size. In this case, the READ_HUFFSYM() macro used
        * in building the tables will exhaust the buffer, so we should
        * allow for this, but not allow those accidentally read bits to
-       * be used (so we check that there are at least 16 bits
-       * remaining - in this boundary case they aren't really part of
-       * the compressed data)
+       * be used (so we check that the words read past the end are still
+       * entirely in the bit buffer - in this boundary case they aren't
+       * really part of the compressed data)
        */
-      if (inpos > (endinp+2) || bitsleft < 16) return DECR_ILLEGALDATA;
+      if (inpos - ((bitsleft >> 4) << 1) > endinp) return DECR_ILLEGALDATA;
     }
 
     while ((this_run = LZX(block_remaining)) > 0 && togo > 0) {
@@ -1708,6 +1712,7 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
 
       case LZX_BLOCKTYPE_VERBATIM:
         while (this_run > 0) {
+          FILL_BITS;
           READ_HUFFSYM(MAINTREE, main_element);
 
           if (main_element < LZX_NUM_CHARS) {
@@ -1768,20 +1773,22 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
               if (copy_length < match_length) {
                 match_length -= copy_length;
                 window_posn += copy_length;
-                while (copy_length-- > 0) *rundest++ = *runsrc++;
+                copy_match(rundest, runsrc, copy_length);
+                rundest += copy_length;
                 runsrc = window;
               }
             }
             window_posn += match_length;
 
             /* copy match data - no worries about destination wraps */
-            while (match_length-- > 0) *rundest++ = *runsrc++;
+            copy_match(rundest, runsrc, match_length);
           }
         }
         break;
 
       case LZX_BLOCKTYPE_ALIGNED:
         while (this_run > 0) {
+          FILL_BITS;
           READ_HUFFSYM(MAINTREE, main_element);
   
           if (main_element < LZX_NUM_CHARS) {
@@ -1857,14 +1864,15 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
               if (copy_length < match_length) {
                 match_length -= copy_length;
                 window_posn += copy_length;
-                while (copy_length-- > 0) *rundest++ = *runsrc++;
+                copy_match(rundest, runsrc, copy_length);
+                rundest += copy_length;
                 runsrc = window;
               }
             }
             window_posn += match_length;
 
             /* copy match data - no worries about destination wraps */
-            while (match_length-- > 0) *rundest++ = *runsrc++;
+            copy_match(rundest, runsrc, match_length);
           }
         }
         break;
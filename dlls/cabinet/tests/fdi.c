@@ -942,10 +942,330 @@ static void test_FDICopy(void)
 }
 
 
+#define BENCH_SIZE  (8 * 1024 * 1024)
+
+/* extracted data is compared against check_data as it is written */
+static char *check_data;
+static LONG check_pos, check_size;
+
+static void fill_bench_data(char *buf, DWORD size)
+{
+    static const char *words[] =
+    {
+        "cabinet ", "folder ", "MSZIP ", "LZX ", "Quantum ", "inflate ",
+        "huffman ", "window ", "block ", "checksum ", "\r\n", "0x1225 ",
+    };
+    DWORD seed = 0x1225, pos = 0, len;
+    const char *word;
+
+    /* a mix of repeated words and noise, so that both literal and
+     * match decoding show up in the profile */
+    while (pos < size)
+    {
+        seed = seed * 1103515245 + 12345;
+        if ((seed >> 16) & 7)
+        {
+            word = words[(seed >> 20) % ARRAY_SIZE(words)];
+            len = min(strlen(word), size - pos);
+            memcpy(buf + pos, word, len);
+            pos += len;
+        }
+        else buf[pos++] = seed >> 24;
+    }
+}
+
+static UINT CDECL fdi_check_write(INT_PTR hf, void *pv, UINT cb)
+{
+    if (hf != 0x12345678) return fdi_write(hf, pv, cb);
+
+    if (check_pos + cb > check_size || memcmp(pv, check_data + check_pos, cb))
+    {
+        ok(0, "data mismatch at %d\n", check_pos);
+        return -1;
+    }
+    check_pos += cb;
+    return cb;
+}
+
+static int CDECL fdi_check_close(INT_PTR hf)
+{
+    if (hf == 0x12345678) return 0;
+    return fdi_close(hf);
+}
+
+static INT_PTR CDECL fdi_check_notify(FDINOTIFICATIONTYPE fdint, FDINOTIFICATION *info)
+{
+    switch (fdint)
+    {
+    case fdintCOPY_FILE:
+        ok(info->cb == check_size, "expected %d, got %d\n", check_size, info->cb);
+        return 0x12345678; /* decompressed data is checked in write() */
+    case fdintCLOSE_FILE_INFO:
+        return TRUE;
+    default:
+        return 0;
+    }
+}
+
+static void test_FDICopy_benchmark(void)
+{
+    static char bench_txt[] = "bench.txt";
+    char name[] = "extract.cab";
+    char path[MAX_PATH];
+    LARGE_INTEGER freq, start, end;
+    CCAB cabParams;
+    HANDLE file;
+    DWORD written;
+    HFDI hfdi;
+    HFCI hfci;
+    ERF erf;
+    BOOL ret;
+
+    check_data = HeapAlloc(GetProcessHeap(), 0, BENCH_SIZE);
+    check_size = BENCH_SIZE;
+    fill_bench_data(check_data, BENCH_SIZE);
+
+    file = CreateFileA(bench_txt, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "Failure to open file %s\n", bench_txt);
+    WriteFile(file, check_data, BENCH_SIZE, &written, NULL);
+    CloseHandle(file);
+
+    set_cab_parameters(&cabParams);
+    hfci = FCICreate(&erf, file_placed, mem_alloc, mem_free, fci_open,
+                     fci_read, fci_write, fci_close, fci_seek,
+                     fci_delete, get_temp_file, &cabParams, NULL);
+    ok(hfci != NULL, "Failed to create an FCI context\n");
+    add_file(hfci, bench_txt);
+    ret = FCIFlushCabinet(hfci, FALSE, get_next_cabinet, progress);
+    ok(ret, "Failed to flush the cabinet\n");
+    FCIDestroy(hfci);
+    DeleteFileA(bench_txt);
+
+    lstrcpyA(path, CURR_DIR);
+    lstrcatA(path, "\\");
+
+    hfdi = FDICreate(fdi_alloc, fdi_free, fdi_open, fdi_read,
+                     fdi_check_write, fdi_check_close, fdi_seek,
+                     cpuUNKNOWN, &erf);
+    ok(hfdi != NULL, "FDICreate error %d\n", erf.erfOper);
+
+    check_pos = 0;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    ret = FDICopy(hfdi, name, path, 0, fdi_check_notify, NULL, 0);
+    QueryPerformanceCounter(&end);
+    ok(ret, "FDICopy error %d\n", erf.erfOper);
+    ok(check_pos == BENCH_SIZE, "expected %u bytes, got %d\n", BENCH_SIZE, check_pos);
+
+    if (ret && end.QuadPart > start.QuadPart)
+        trace("MSZIP extraction: %u bytes in %u ms, %u KB/s\n", BENCH_SIZE,
+              (DWORD)((end.QuadPart - start.QuadPart) * 1000 / freq.QuadPart),
+              (DWORD)((ULONGLONG)BENCH_SIZE * freq.QuadPart / (end.QuadPart - start.QuadPart) / 1024));
+
+    FDIDestroy(hfdi);
+    DeleteFileA(name);
+    HeapFree(GetProcessHeap(), 0, check_data);
+}
+
+/* LZX:16 cabinet holding 40000 bytes of fill_cab_data(), in two CFDATA
+ * blocks. It has a verbatim, an uncompressed and an aligned block, and
+ * some Huffman codes of 13 to 16 bits. */
+static const BYTE lzx_cab[] =
+{
+    0x4d, 0x53, 0x43, 0x46, 0x00, 0x00, 0x00, 0x00, 0xba, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x2c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x01, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x25, 0x12, 0x00, 0x00, 0x44, 0x00, 0x00, 0x00, 0x02, 0x00, 0x03, 0x10, 0x40, 0x9c, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0x50, 0x00, 0x00, 0x20, 0x00, 0x6c, 0x7a, 0x78, 0x2e,
+    0x74, 0x78, 0x74, 0x00, 0xe8, 0xba, 0x63, 0x06, 0x46, 0x05, 0x00, 0x80, 0x04, 0x10, 0x04, 0xe2,
+    0x44, 0x44, 0x44, 0x44, 0x45, 0x44, 0x55, 0x55, 0x5c, 0x55, 0x7f, 0x7f, 0x2e, 0x5e, 0xfd, 0xf1,
+    0x63, 0xdf, 0x7a, 0x1d, 0xf2, 0x09, 0xa0, 0x63, 0x0c, 0xe0, 0x0a, 0x00, 0xd2, 0x09, 0x18, 0xff,
+    0x60, 0x0c, 0xec, 0x0f, 0x7d, 0x00, 0x7f, 0x8f, 0xf4, 0xdf, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+    0x55, 0x15, 0x55, 0x55, 0x78, 0x7a, 0xe3, 0xe9, 0xc7, 0xcd, 0x5d, 0x9a, 0xf2, 0xf1, 0xdf, 0xc7,
+    0xfb, 0xf7, 0x88, 0xc8, 0x88, 0x88, 0x88, 0x88, 0xaa, 0x8a, 0xaa, 0xaa, 0xff, 0xbe, 0xe8, 0xbf,
+    0xdf, 0xef, 0x37, 0xf2, 0x73, 0xe4, 0x29, 0xff, 0x31, 0x03, 0xb7, 0x0a, 0x43, 0x22, 0xd8, 0x4b,
+    0x40, 0x74, 0xb3, 0x6a, 0xff, 0x11, 0xfd, 0xbf, 0xc3, 0xff, 0x8e, 0x23, 0xfa, 0x3f, 0x74, 0x64,
+    0xd1, 0xa6, 0x8f, 0x95, 0xff, 0x37, 0xfc, 0xd1, 0x90, 0x36, 0x1b, 0xe8, 0x6a, 0xd3, 0x52, 0x46,
+    0xff, 0x23, 0x98, 0xf9, 0x22, 0xb9, 0x64, 0x04, 0x84, 0x7f, 0xff, 0x1f, 0xa8, 0xe4, 0x90, 0xa2,
+    0xff, 0x3f, 0xaa, 0xd0, 0x9d, 0xa2, 0x55, 0xd5, 0x3b, 0x45, 0xaa, 0xea, 0x78, 0x8a, 0x55, 0x55,
+    0xf1, 0x14, 0xaa, 0xaa, 0xe5, 0x29, 0x54, 0x55, 0xce, 0x53, 0xa8, 0xaa, 0xa5, 0xa7, 0x51, 0x55,
+    0x5a, 0x4f, 0xa2, 0xaa, 0xd5, 0x9e, 0x45, 0x55, 0xd5, 0x30, 0x14, 0x55, 0xaa, 0xf7, 0x29, 0xaa,
+    0x55, 0xf1, 0x53, 0x54, 0x55, 0x15, 0x4f, 0x51, 0xaa, 0x9a, 0x9f, 0xa2, 0x55, 0x55, 0x3e, 0x45,
+    0xaa, 0xea, 0x7e, 0x8a, 0x55, 0x55, 0xfd, 0x14, 0xaa, 0xaa, 0xfc, 0x29, 0x00, 0xc0, 0x00, 0xfa,
+    0x50, 0x00, 0x00, 0x00, 0x40, 0x01, 0x00, 0x00, 0x24, 0x00, 0x00, 0x00, 0x54, 0x68, 0x65, 0x20,
+    0x63, 0x61, 0x62, 0x69, 0x6e, 0x65, 0x74, 0x20, 0x66, 0x6f, 0x6c, 0x64, 0x65, 0x72, 0x20, 0x68,
+    0x6f, 0x6c, 0x64, 0x73, 0x20, 0x4c, 0x5a, 0x58, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x51, 0x75, 0x61,
+    0x6e, 0x74, 0x75, 0x6d, 0x20, 0x62, 0x6c, 0x6f, 0x63, 0x6b, 0x73, 0x2c, 0x20, 0x6d, 0x61, 0x64,
+    0x65, 0x20, 0x6f, 0x66, 0x20, 0x6d, 0x61, 0x74, 0x63, 0x68, 0x65, 0x73, 0x20, 0x61, 0x6e, 0x64,
+    0x20, 0x6c, 0x69, 0x74, 0x65, 0x72, 0x61, 0x6c, 0x73, 0x2e, 0x0d, 0x0a, 0x54, 0x68, 0x65, 0x20,
+    0x63, 0x61, 0x62, 0x69, 0x6e, 0x65, 0x74, 0x20, 0x66, 0x6f, 0x6c, 0x64, 0x65, 0x72, 0x20, 0x68,
+    0x6f, 0x6c, 0x64, 0x73, 0x20, 0x4c, 0x5a, 0x58, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x51, 0x75, 0x61,
+    0x6e, 0x74, 0x75, 0x6d, 0x20, 0x62, 0x6c, 0x6f, 0x63, 0x6b, 0x73, 0x2c, 0x20, 0x6d, 0x61, 0x64,
+    0x65, 0x20, 0x6f, 0x66, 0x20, 0x6d, 0x61, 0x74, 0x63, 0x68, 0x65, 0x73, 0x20, 0x61, 0x6e, 0x64,
+    0x20, 0x6c, 0x69, 0x74, 0x65, 0x72, 0x61, 0x6c, 0x73, 0x2e, 0x0d, 0x0a, 0x54, 0x68, 0x65, 0x20,
+    0x63, 0x61, 0x62, 0x69, 0x6e, 0x65, 0x74, 0x20, 0x66, 0x6f, 0x6c, 0x64, 0x65, 0x72, 0x20, 0x68,
+    0x6f, 0x6c, 0x64, 0x73, 0x20, 0x4c, 0x5a, 0x58, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x51, 0x75, 0x61,
+    0x6e, 0x74, 0x75, 0x6d, 0x20, 0x62, 0x6c, 0x6f, 0x63, 0x6b, 0x73, 0x2c, 0x20, 0x6d, 0x61, 0x64,
+    0x65, 0x20, 0x6f, 0x66, 0x20, 0x6d, 0x61, 0x74, 0x63, 0x68, 0x65, 0x73, 0x20, 0x61, 0x6e, 0x64,
+    0x20, 0x6c, 0x69, 0x74, 0x65, 0x72, 0x61, 0x6c, 0x73, 0x2e, 0x0d, 0x0a, 0x54, 0x68, 0x65, 0x20,
+    0x63, 0x61, 0x62, 0x69, 0x6e, 0x65, 0x74, 0x20, 0x66, 0x6f, 0x6c, 0x64, 0x65, 0x72, 0x20, 0x68,
+    0x6f, 0x6c, 0x64, 0x73, 0x20, 0x4c, 0x5a, 0x58, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x51, 0x75, 0x61,
+    0x6e, 0x74, 0x75, 0x6d, 0x20, 0x62, 0x6c, 0x6f, 0x63, 0x6b, 0x73, 0x2c, 0x20, 0x6d, 0x61, 0x64,
+    0x65, 0x20, 0x6f, 0x66, 0x20, 0x6d, 0x61, 0x74, 0x63, 0x68, 0x65, 0x73, 0x20, 0x61, 0x6e, 0x64,
+    0x20, 0x6c, 0x69, 0x74, 0x65, 0x72, 0x61, 0x6c, 0x73, 0x2e, 0x0d, 0x0a, 0x54, 0x68, 0x65, 0x20,
+    0x63, 0x61, 0x62, 0x69, 0x6e, 0x65, 0x74, 0x20, 0x66, 0x6f, 0x6c, 0x64, 0x65, 0x72, 0x20, 0x68,
+    0x6f, 0x6c, 0x64, 0x73, 0x20, 0x4c, 0x5a, 0x58, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x51, 0x75, 0x61,
+    0x6e, 0x74, 0x75, 0x6d, 0x20, 0x62, 0x6c, 0x6f, 0x63, 0x6b, 0x73, 0x2c, 0x20, 0x6d, 0x61, 0x64,
+    0x65, 0x20, 0x6f, 0x66, 0x20, 0x6d, 0x61, 0x74, 0x63, 0x68, 0x65, 0x73, 0x20, 0x61, 0x6e, 0x64,
+    0x20, 0x6c, 0x69, 0x74, 0x65, 0x72, 0x61, 0x6c, 0x73, 0x2e, 0x0d, 0x0a, 0x54, 0x68, 0x65, 0x20,
+    0x63, 0x61, 0x62, 0x69, 0x6e, 0x65, 0x74, 0x20, 0x66, 0x6f, 0x6c, 0x64, 0x65, 0x72, 0x20, 0x68,
+    0x6f, 0x6c, 0x64, 0x73, 0x20, 0x4c, 0x5a, 0x58, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x51, 0x75, 0x61,
+    0x6e, 0x74, 0x75, 0x6d, 0x20, 0x62, 0x6c, 0x6f, 0x63, 0x6b, 0x73, 0x2c, 0x20, 0x6d, 0x61, 0x64,
+    0x65, 0x20, 0x6f, 0x66, 0x20, 0x6d, 0x61, 0x74, 0x63, 0x68, 0x65, 0x73, 0x20, 0x61, 0x6e, 0x64,
+    0x20, 0x6c, 0x69, 0x74, 0x65, 0x72, 0x61, 0x6c, 0x73, 0x2e, 0x0d, 0x0a, 0x54, 0x68, 0x65, 0x20,
+    0x63, 0x61, 0x62, 0x69, 0x6e, 0x65, 0x74, 0x20, 0x66, 0x6f, 0x6c, 0x64, 0x65, 0x72, 0x20, 0x68,
+    0x6f, 0x6c, 0x64, 0x73, 0x20, 0x4c, 0x5a, 0x58, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x51, 0x75, 0x61,
+    0x6e, 0x74, 0x75, 0x6d, 0x20, 0x62, 0x6c, 0x6f, 0x63, 0x6b, 0x73, 0x2c, 0x20, 0x6d, 0x61, 0x64,
+    0x65, 0x20, 0x6f, 0x66, 0x20, 0x6d, 0x61, 0x74, 0x63, 0x68, 0x65, 0x73, 0x20, 0x61, 0x6e, 0x64,
+    0x20, 0x6c, 0x69, 0x74, 0x65, 0x72, 0x61, 0x6c, 0x73, 0x2e, 0x0d, 0x0a, 0x54, 0x68, 0x65, 0x20,
+    0x63, 0x61, 0x62, 0x69, 0x6e, 0x65, 0x74, 0x20, 0x66, 0x6f, 0x6c, 0x64, 0x65, 0x72, 0x20, 0x68,
+    0x6f, 0x6c, 0x64, 0x73, 0x20, 0x4c, 0x5a, 0x58, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x51, 0x75, 0x61,
+    0x6e, 0x74, 0x75, 0x6d, 0x20, 0x62, 0x6c, 0x6f, 0x63, 0x6b, 0x73, 0x2c, 0x20, 0x6d, 0x61, 0x64,
+    0x65, 0x20, 0x6f, 0x66, 0x20, 0x6d, 0x61, 0x74, 0x63, 0x68, 0x65, 0x73, 0x20, 0x61, 0x6e, 0x64,
+    0x20, 0x6c, 0x69, 0x74, 0x65, 0x72, 0x61, 0x6c, 0x73, 0x2e, 0x0d, 0x0a, 0x54, 0x68, 0x65, 0x20,
+    0x63, 0x61, 0x62, 0x69, 0x6e, 0x65, 0x74, 0x20, 0x66, 0x6f, 0x6c, 0x64, 0x65, 0x72, 0x20, 0x68,
+    0x6f, 0x6c, 0x64, 0x73, 0x20, 0x4c, 0x5a, 0x58, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x51, 0x75, 0x61,
+    0x6e, 0x74, 0x75, 0x6d, 0x20, 0x62, 0x6c, 0x6f, 0x63, 0x6b, 0x73, 0x2c, 0x20, 0x6d, 0x61, 0x64,
+    0x65, 0x20, 0x6f, 0x66, 0x20, 0x6d, 0x61, 0x74, 0x63, 0x68, 0x65, 0x73, 0x20, 0x61, 0x6e, 0x64,
+    0x20, 0x6c, 0x69, 0x74, 0x65, 0x72, 0x61, 0x6c, 0x73, 0x2e, 0x0d, 0x0a, 0x54, 0x68, 0x65, 0x20,
+    0x63, 0x61, 0x62, 0x69, 0x6e, 0x65, 0x74, 0x20, 0x66, 0x6f, 0x6c, 0x64, 0x65, 0x72, 0x20, 0x68,
+    0x6f, 0x6c, 0x64, 0x73, 0x20, 0x4c, 0x5a, 0x58, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x51, 0x75, 0x61,
+    0x6e, 0x74, 0x75, 0x6d, 0x20, 0x62, 0x6c, 0x6f, 0x63, 0x6b, 0x73, 0x2c, 0x20, 0x6d, 0x61, 0x64,
+    0x65, 0x20, 0x6f, 0x66, 0x20, 0x6d, 0x61, 0x74, 0x63, 0x68, 0x65, 0x73, 0x20, 0x61, 0x6e, 0x64,
+    0x20, 0x6c, 0x69, 0x74, 0x65, 0x72, 0x61, 0x6c, 0x73, 0x2e, 0x0d, 0x0a, 0x54, 0x68, 0x65, 0x20,
+    0x63, 0x61, 0x62, 0x69, 0x6e, 0x65, 0x74, 0x20, 0x66, 0x6f, 0x6c, 0x64, 0x65, 0x72, 0x20, 0x68,
+    0x6f, 0x6c, 0x64, 0x73, 0x20, 0x4c, 0x5a, 0x58, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x51, 0x75, 0x61,
+    0x6e, 0x74, 0x75, 0x6d, 0x20, 0x62, 0x6c, 0x6f, 0x63, 0x6b, 0x73, 0x2c, 0x20, 0x6d, 0x61, 0x64,
+    0x65, 0x20, 0x6f, 0x66, 0x20, 0x6d, 0x61, 0x74, 0x63, 0x68, 0x65, 0x73, 0x20, 0x61, 0x6e, 0x64,
+    0x20, 0x6c, 0x69, 0x74, 0x65, 0x72, 0x61, 0x6c, 0x73, 0x2e, 0x0d, 0x0a, 0x54, 0x68, 0x65, 0x20,
+    0x63, 0x61, 0x62, 0x69, 0x6e, 0x65, 0x74, 0x20, 0x66, 0x6f, 0x6c, 0x64, 0x65, 0x72, 0x20, 0x68,
+    0x6f, 0x6c, 0x64, 0x73, 0x20, 0x4c, 0x5a, 0x58, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x51, 0x75, 0x61,
+    0x6e, 0x74, 0x75, 0x6d, 0x20, 0x62, 0x6c, 0x6f, 0x63, 0x6b, 0x73, 0x2c, 0x20, 0x6d, 0x61, 0x64,
+    0x65, 0x20, 0x6f, 0x66, 0x20, 0x6d, 0x61, 0x74, 0x63, 0x68, 0x65, 0x73, 0x20, 0x61, 0x6e, 0x64,
+    0x20, 0x6c, 0x69, 0x74, 0x65, 0x72, 0x61, 0x6c, 0x73, 0x2e, 0x0d, 0x0a, 0x54, 0x68, 0x65, 0x20,
+    0x63, 0x61, 0x62, 0x69, 0x6e, 0x65, 0x74, 0x20, 0x66, 0x6f, 0x6c, 0x64, 0x65, 0x72, 0x20, 0x68,
+    0x6f, 0x6c, 0x64, 0x73, 0x20, 0x4c, 0x5a, 0x58, 0x20, 0x61, 0x6e, 0x64, 0x20, 0x51, 0x75, 0x61,
+    0x6e, 0x74, 0x75, 0x14, 0x09, 0x40, 0x04, 0x47, 0x00, 0x80, 0x88, 0x08, 0x88, 0x88, 0x88, 0x88,
+    0xaa, 0x8a, 0xaa, 0xaa, 0x0f, 0xbe, 0xce, 0xfa, 0xa6, 0x2e, 0xca, 0x30, 0x42, 0x86, 0xff, 0x3e,
+    0xef, 0xbf, 0xfd, 0xfb, 0x44, 0x84, 0x44, 0x44, 0x44, 0x44, 0x55, 0x45, 0x55, 0x55, 0x99, 0x5e,
+    0xcb, 0x74, 0xf7, 0xdf, 0xff, 0xfd, 0xd0, 0x7f, 0x44, 0x44, 0x44, 0x44, 0x44, 0x44, 0x55, 0x55,
+    0x55, 0x55, 0xfd, 0xf7, 0x7f, 0xff, 0xed, 0xdf, 0x06, 0x80, 0x2d, 0xfc, 0x73, 0x80, 0xbd, 0x7b,
+    0xf7, 0x06, 0x1d, 0x7a, 0xf4, 0xee, 0xdd, 0x5b, 0xf7, 0xe8, 0xd2, 0xbb, 0x77, 0x6f, 0x6f, 0xa7,
+    0xa7, 0x77, 0xbb, 0xb7, 0xed, 0xd3, 0xf4, 0xee, 0xbd, 0xfd, 0x9f, 0xde, 0xdd, 0xdb, 0xfe, 0xe9,
+    0xec, 0xde, 0x90, 0x13, 0xf7, 0x9f, 0x20, 0x00, 0x40, 0x1c, 0xfd, 0xaf, 0xde, 0xbd, 0xfb, 0x9f,
+    0xbd, 0x7b, 0xfb, 0x3f, 0xbd, 0x7b, 0xfd, 0x3f, 0xde, 0xbd, 0xff, 0x9f, 0x77, 0x6f, 0xff, 0xa7,
+    0xee, 0xed, 0xff, 0xf4, 0xde, 0xfe, 0x4f, 0xef, 0xf0, 0xff,
+};
+
+/* Quantum cabinet (level 4, 64K window) holding the same data */
+static const BYTE quantum_cab[] =
+{
+    0x4d, 0x53, 0x43, 0x46, 0x00, 0x00, 0x00, 0x00, 0x9c, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x2c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x01, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00,
+    0x25, 0x12, 0x00, 0x00, 0x48, 0x00, 0x00, 0x00, 0x02, 0x00, 0x42, 0x10, 0x40, 0x9c, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x21, 0x50, 0x00, 0x00, 0x20, 0x00, 0x71, 0x75, 0x61, 0x6e,
+    0x74, 0x75, 0x6d, 0x2e, 0x74, 0x78, 0x74, 0x00, 0xf6, 0x38, 0xd1, 0x64, 0x14, 0x01, 0x00, 0x80,
+    0xcf, 0xba, 0x70, 0xa9, 0xe3, 0xd6, 0x98, 0xda, 0x62, 0x70, 0x05, 0x8d, 0x75, 0x45, 0x6c, 0x84,
+    0xc8, 0xb9, 0xbd, 0x8a, 0x61, 0x23, 0x7d, 0x85, 0x00, 0x91, 0x83, 0x60, 0x55, 0xc9, 0x0c, 0x34,
+    0xf0, 0x78, 0x02, 0x13, 0x21, 0xaf, 0xde, 0xcd, 0xe8, 0xe8, 0x79, 0x75, 0xe4, 0xfa, 0x2d, 0x0d,
+    0x30, 0xfc, 0xf8, 0xc6, 0x99, 0x55, 0x08, 0x0b, 0xc3, 0x83, 0x6f, 0x30, 0xb4, 0x85, 0xc7, 0xf4,
+    0x9f, 0x2c, 0x78, 0x7a, 0xbb, 0xeb, 0xf4, 0xa4, 0xfc, 0x53, 0xc0, 0xf4, 0x87, 0x6f, 0x23, 0xa7,
+    0x2f, 0xc8, 0xff, 0x7a, 0xbd, 0xde, 0xc9, 0x86, 0xff, 0xaf, 0x6f, 0x3b, 0x67, 0xc9, 0x4f, 0xbf,
+    0xb7, 0xbb, 0xdb, 0x7b, 0xc1, 0x3a, 0x7f, 0xe7, 0xb7, 0x8b, 0x6f, 0xc4, 0xbd, 0x7e, 0x9e, 0x9f,
+    0xed, 0xbe, 0x23, 0x53, 0xfd, 0x7d, 0x7d, 0xed, 0xe0, 0x6b, 0x5f, 0x83, 0xc7, 0x93, 0x6f, 0x61,
+    0x56, 0xfe, 0x7c, 0x7f, 0x6c, 0xfe, 0x45, 0xdf, 0xd7, 0xb7, 0xfe, 0xdf, 0xb7, 0x5f, 0x87, 0xc7,
+    0xbd, 0xef, 0x91, 0x19, 0xff, 0x7e, 0xf5, 0xb3, 0xec, 0xa5, 0xbf, 0x9f, 0xbd, 0xb6, 0xfa, 0x2f,
+    0x7e, 0xbc, 0xbd, 0xf6, 0xfc, 0x9a, 0x5f, 0xcf, 0xaf, 0x6d, 0xbc, 0x92, 0x97, 0xfd, 0xe7, 0xdb,
+    0x6f, 0x6d, 0xb9, 0xfa, 0xf8, 0xfd, 0xb3, 0xd1, 0x80, 0xfd, 0xbf, 0x7b, 0xdd, 0xe3, 0x67, 0x3f,
+    0xaf, 0xdf, 0xb6, 0xf6, 0x46, 0x6f, 0xd7, 0x8f, 0xdb, 0xbe, 0xbe, 0x37, 0xf3, 0xdb, 0xf6, 0xde,
+    0xc3, 0x99, 0xfa, 0xf3, 0xf6, 0xdf, 0xdb, 0xb1, 0xfb, 0x7d, 0xfb, 0x67, 0xee, 0x00, 0xfe, 0x3e,
+    0xf1, 0xb3, 0xf8, 0xa1, 0x7f, 0x5f, 0x7c, 0xdd, 0xe5, 0xde, 0xbf, 0xde, 0x7a, 0xec, 0xf0, 0x3c,
+    0x1f, 0xef, 0x1f, 0xec, 0xf5, 0x20, 0xaf, 0xcf, 0x2f, 0x76, 0xfb, 0x4c, 0xb7, 0xf7, 0xcf, 0x9b,
+    0x78, 0x2e, 0xc7, 0xf7, 0xaf, 0x3b, 0x79, 0x83, 0x2b, 0xf5, 0xe7, 0xdd, 0x9f, 0xc5, 0x53, 0xf1,
+    0xe0, 0x05, 0xcf, 0x00, 0x3a, 0x31, 0xc9, 0x5b, 0x30, 0x00, 0x40, 0x1c, 0x68, 0xf5, 0xe4, 0x87,
+    0xf3, 0x1f, 0x9e, 0xbe, 0x6d, 0xf3, 0x83, 0xdf, 0xaf, 0xdf, 0xec, 0xfb, 0x8a, 0xef, 0xcf, 0x1e,
+    0xf6, 0x7e, 0x36, 0x6f, 0xc7, 0x8f, 0x3b, 0x7b, 0x38, 0x57, 0xe7, 0xef, 0xbb, 0x7a, 0x89, 0x47,
+    0xf7, 0x8f, 0xdb, 0x3f, 0x07, 0x77, 0xeb, 0xc7, 0x9b, 0x3c, 0x00, 0x00,
+};
+
+
+static void fill_cab_data(char *buf, DWORD size)
+{
+    static const char text[] = "The cabinet folder holds LZX and Quantum blocks, made of matches and literals.\r\n";
+    DWORD i;
+
+    for (i = 0; i < size; i++)
+        buf[i] = (i % 1000 == 999) ? i / 1000 : text[i % (sizeof(text) - 1)];
+}
+
+static void test_FDICopy_compressed(void)
+{
+    static const struct
+    {
+        const char *name;
+        const BYTE *cab;
+        DWORD size;
+    }
+    tests[] =
+    {
+        {"lzx.cab", lzx_cab, sizeof(lzx_cab)},
+        {"quantum.cab", quantum_cab, sizeof(quantum_cab)},
+    };
+    char name[MAX_PATH], path[MAX_PATH];
+    HANDLE file;
+    DWORD written, i;
+    HFDI hfdi;
+    ERF erf;
+    BOOL ret;
+
+    check_size = 40000;
+    check_data = HeapAlloc(GetProcessHeap(), 0, check_size);
+    fill_cab_data(check_data, check_size);
+
+    lstrcpyA(path, CURR_DIR);
+    lstrcatA(path, "\\");
+
+    hfdi = FDICreate(fdi_alloc, fdi_free, fdi_open, fdi_read,
+                     fdi_check_write, fdi_check_close, fdi_seek,
+                     cpuUNKNOWN, &erf);
+    ok(hfdi != NULL, "FDICreate error %d\n", erf.erfOper);
+
+    for (i = 0; i < ARRAY_SIZE(tests); i++)
+    {
+        lstrcpyA(name, tests[i].name);
+        file = CreateFileA(name, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+        ok(file != INVALID_HANDLE_VALUE, "Failure to open file %s\n", name);
+        WriteFile(file, tests[i].cab, tests[i].size, &written, NULL);
+        CloseHandle(file);
+
+        check_pos = 0;
+        ret = FDICopy(hfdi, name, path, 0, fdi_check_notify, NULL, 0);
+        ok(ret, "%s: FDICopy error %d\n", name, erf.erfOper);
+        ok(check_pos == check_size, "%s: expected %d bytes, got %d\n", name, check_size, check_pos);
+
+        DeleteFileA(name);
+    }
+
+    FDIDestroy(hfdi);
+    HeapFree(GetProcessHeap(), 0, check_data);
+}
+
+
 START_TEST(fdi)
 {
     test_FDICreate();
     test_FDIDestroy();
     test_FDIIsCabinet();
     test_FDICopy();
+    test_FDICopy_compressed();
+    test_FDICopy_benchmark();
 }
@@ -67,6 +67,7 @@ WINE_DEFAULT_DEBUG_CHANNEL(dbghelp);
 
 unsigned   dbghelp_options = SYMOPT_UNDNAME;
 BOOL       dbghelp_opt_native = FALSE;
+BOOL       dbghelp_opt_lazy_dwarf = FALSE;
 SYSTEM_INFO sysinfo;
 
 static struct process* process_first /* = NULL */;
@@ -560,6 +561,10 @@ BOOL WINAPI SymSetExtendedOption(IMAGEHLP_EXTENDED_OPTIONS option, BOOL value)
             old = dbghelp_opt_native;
             dbghelp_opt_native = value;
             break;
+        case SYMOPT_EX_WINE_LAZY_DWARF:
+            old = dbghelp_opt_lazy_dwarf;
+            dbghelp_opt_lazy_dwarf = value;
+            break;
         default:
             FIXME("Unsupported option %d with value %d\n", option, value);
     }
@@ -577,6 +582,8 @@ BOOL WINAPI SymGetExtendedOption(IMAGEHLP_EXTENDED_OPTIONS option)
     {
         case SYMOPT_EX_WINE_NATIVE_MODULES:
             return dbghelp_opt_native;
+        case SYMOPT_EX_WINE_LAZY_DWARF:
+            return dbghelp_opt_lazy_dwarf;
         default:
             FIXME("Unsupported option %d\n", option);
     }
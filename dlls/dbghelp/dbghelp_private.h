@@ -46,6 +46,7 @@ struct pool /* poor's man */
 void     pool_init(struct pool* a, size_t arena_size) DECLSPEC_HIDDEN;
 void     pool_destroy(struct pool* a) DECLSPEC_HIDDEN;
 void*    pool_alloc(struct pool* a, size_t len) DECLSPEC_HIDDEN;
+size_t   pool_get_size(const struct pool* a) DECLSPEC_HIDDEN;
 char*    pool_strdup(struct pool* a, const char* str) DECLSPEC_HIDDEN;
 
 struct vector
@@ -114,6 +115,7 @@ void*    hash_table_iter_up(struct hash_table_iter* hti) DECLSPEC_HIDDEN;
 
 extern unsigned dbghelp_options DECLSPEC_HIDDEN;
 extern BOOL     dbghelp_opt_native DECLSPEC_HIDDEN;
+extern BOOL     dbghelp_opt_lazy_dwarf DECLSPEC_HIDDEN;
 extern SYSTEM_INFO sysinfo DECLSPEC_HIDDEN;
 
 enum location_kind {loc_error,          /* reg is the error code */
@@ -339,6 +341,9 @@ struct module_format
                                                const struct module_format* modfmt,
                                                const struct symt_function* func,
                                                struct location* loc);
+    /* for formats loading their debug information on demand */
+    void                        (*load_at)(struct module_format* modfmt, DWORD64 addr);
+    void                        (*load_name)(struct module_format* modfmt, const char* name);
     union
     {
         struct elf_module_info*         elf_info;
@@ -369,11 +374,15 @@ struct module
     /* symbols & symbol tables */
     struct vector               vsymt;
     int                         sortlist_valid;
-    unsigned                    num_sorttab;    /* number of symbols with addresses */
-    unsigned                    num_symbols;
+    unsigned                    num_sorttab;    /* number of symbols in the main sorted run */
+    unsigned                    num_recent;     /* number of symbols in the second sorted run */
+    unsigned                    num_symbols;    /* number of symbols with addresses */
     unsigned                    sorttab_size;
     struct symt_ht**            addr_sorttab;
     struct hash_table           ht_symbols;
+    struct symt_ht**            name_sorttab;   /* symbols sorted by name (case insensitive) */
+    unsigned                    num_name_sorttab; /* number of ASCII names, the others follow unsorted */
+    unsigned                    name_sorttab_elts; /* ht_symbols.num_elts when name_sorttab was built */
 
     /* types */
     struct hash_table           ht_types;
@@ -592,6 +601,8 @@ extern DWORD calc_crc32(HANDLE handle) DECLSPEC_HIDDEN;
 extern BOOL         elf_read_wine_loader_dbg_info(struct process* pcs, ULONG_PTR addr) DECLSPEC_HIDDEN;
 struct elf_thunk_area;
 extern int          elf_is_in_thunk_area(ULONG_PTR addr, const struct elf_thunk_area* thunks) DECLSPEC_HIDDEN;
+extern struct elf_thunk_area*
+                    elf_dup_thunk_areas(const struct elf_thunk_area* thunks) DECLSPEC_HIDDEN;
 
 /* macho_module.c */
 extern BOOL         macho_read_wine_loader_dbg_info(struct process* pcs, ULONG_PTR addr) DECLSPEC_HIDDEN;
@@ -618,6 +629,8 @@ extern struct module*
                     module_is_already_loaded(const struct process* pcs,
                                              const WCHAR* imgname) DECLSPEC_HIDDEN;
 extern BOOL         module_get_debug(struct module_pair*) DECLSPEC_HIDDEN;
+extern void         module_load_debug_at(struct module* module, DWORD64 addr) DECLSPEC_HIDDEN;
+extern void         module_load_debug_name(struct module* module, const char* name) DECLSPEC_HIDDEN;
 extern struct module*
                     module_new(struct process* pcs, const WCHAR* name,
                                enum module_type type, BOOL virtual,
@@ -689,6 +702,7 @@ struct image_file_map;
 extern BOOL         dwarf2_parse(struct module* module, ULONG_PTR load_offset,
                                  const struct elf_thunk_area* thunks,
                                  struct image_file_map* fmap) DECLSPEC_HIDDEN;
+extern BOOL         dwarf2_is_lazy_address(struct module* module, ULONG_PTR addr) DECLSPEC_HIDDEN;
 extern BOOL dwarf2_virtual_unwind(struct cpu_stack_walk *csw, DWORD_PTR ip,
     union ctx *ctx, DWORD64 *cfa) DECLSPEC_HIDDEN;
 
@@ -185,6 +185,28 @@ typedef struct dwarf2_parse_context_s
     char*                       cpp_name;
 } dwarf2_parse_context_t;
 
+/* indexes used when compilation units are only parsed on demand */
+struct dwarf2_unit_index
+{
+    const unsigned char*        start;          /* unit header in .debug_info */
+    BOOL                        parsed;
+    BOOL                        indexed;        /* got some address ranges */
+};
+
+struct dwarf2_range_index
+{
+    ULONG_PTR                   low;
+    ULONG_PTR                   high;
+    ULONG_PTR                   max_high;       /* highest 'high' up to this entry */
+    unsigned                    unit;
+};
+
+struct dwarf2_name_index
+{
+    const char*                 name;
+    unsigned                    unit;
+};
+
 /* stored in the dbghelp's module internal structure for later reuse */
 struct dwarf2_module_info_s
 {
@@ -192,6 +214,22 @@ struct dwarf2_module_info_s
     dwarf2_section_t            debug_frame;
     dwarf2_section_t            eh_frame;
     unsigned char               word_size;
+
+    /* on demand parsing of compilation units */
+    BOOL                        lazy;
+    dwarf2_section_t            sections[section_max];
+    dwarf2_section_t            debug_pubnames;
+    ULONG_PTR                   load_offset;
+    struct elf_thunk_area*      thunks;
+    struct dwarf2_unit_index*   units;
+    unsigned                    num_units;
+    unsigned                    num_parsed;
+    struct dwarf2_range_index*  ranges;
+    unsigned                    num_ranges;
+    unsigned                    max_ranges;
+    struct dwarf2_name_index*   names;
+    unsigned                    num_names;
+    unsigned                    max_names;
 };
 
 #define loc_dwarf2_location_list        (loc_user + 0)
@@ -3479,10 +3517,440 @@ static inline void dwarf2_fini_section(dwarf2_section_t* section)
         HeapFree(GetProcessHeap(), 0, (void*)section->address);
 }
 
+static inline unsigned dwarf2_elapsed_us(const LARGE_INTEGER* start)
+{
+    LARGE_INTEGER       now, freq;
+
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&freq);
+    return (now.QuadPart - start->QuadPart) * 1000000 / freq.QuadPart;
+}
+
+/******************************************************************
+ *		dwarf2_parse_unit
+ *
+ * Parses (if not done yet) one of the compilation units of a module
+ * whose DWARF information is loaded on demand.
+ */
+static void dwarf2_parse_unit(struct module_format* modfmt, unsigned idx)
+{
+    struct dwarf2_module_info_s*info = modfmt->u.dwarf2_info;
+    dwarf2_traverse_context_t   mod_ctx;
+    unsigned char               word_size = info->word_size;
+    size_t                      pool_size;
+    LARGE_INTEGER               start;
+
+    if (info->units[idx].parsed) return;
+    info->units[idx].parsed = TRUE;
+    info->num_parsed++;
+
+    QueryPerformanceCounter(&start);
+    pool_size = pool_get_size(&modfmt->module->pool);
+
+    mod_ctx.data = info->units[idx].start;
+    mod_ctx.end_data = info->sections[section_debug].address + info->sections[section_debug].size;
+    mod_ctx.word_size = 0;
+    dwarf2_parse_compilation_unit(info->sections, modfmt->module, info->thunks, &mod_ctx, info->load_offset);
+    /* restore the word_size for eh_frame parsing */
+    info->word_size = word_size;
+    modfmt->module->module.NumSyms = modfmt->module->ht_symbols.num_elts;
+
+    TRACE("%s: parsed unit #%u (%u/%u) in %u us, %lu bytes\n",
+          debugstr_w(modfmt->module->module.ModuleName), idx, info->num_parsed, info->num_units,
+          dwarf2_elapsed_us(&start), (ULONG_PTR)(pool_get_size(&modfmt->module->pool) - pool_size));
+}
+
+static void dwarf2_parse_all_units(struct module_format* modfmt)
+{
+    unsigned                    i;
+
+    for (i = 0; i < modfmt->u.dwarf2_info->num_units; i++)
+        dwarf2_parse_unit(modfmt, i);
+}
+
+/******************************************************************
+ *		dwarf2_load_at
+ *
+ * Parses the compilation units covering addr.
+ */
+static void dwarf2_load_at(struct module_format* modfmt, DWORD64 addr)
+{
+    struct dwarf2_module_info_s*info = modfmt->u.dwarf2_info;
+    unsigned                    low = 0, high = info->num_ranges, mid;
+
+    if (info->num_parsed == info->num_units) return;
+
+    /* find the first range starting after addr... */
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        if (info->ranges[mid].low <= addr) low = mid + 1;
+        else high = mid;
+    }
+    /* ...and walk back while the previous ranges can still contain addr */
+    for (; low > 0 && info->ranges[low - 1].max_high > addr; low--)
+    {
+        if (addr < info->ranges[low - 1].high)
+            dwarf2_parse_unit(modfmt, info->ranges[low - 1].unit);
+    }
+}
+
+/******************************************************************
+ *		dwarf2_is_lazy_address
+ *
+ * Tells whether addr is covered by a compilation unit whose parsing is
+ * deferred until it's needed.
+ */
+BOOL dwarf2_is_lazy_address(struct module* module, ULONG_PTR addr)
+{
+    struct module_format*       modfmt = module->format_info[DFI_DWARF];
+    struct dwarf2_module_info_s*info;
+    unsigned                    low = 0, high, mid;
+
+    if (!modfmt || !modfmt->load_at) return FALSE;
+    info = modfmt->u.dwarf2_info;
+    high = info->num_ranges;
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        if (info->ranges[mid].low <= addr) low = mid + 1;
+        else high = mid;
+    }
+    for (; low > 0 && info->ranges[low - 1].max_high > addr; low--)
+    {
+        if (addr < info->ranges[low - 1].high) return TRUE;
+    }
+    return FALSE;
+}
+
+/******************************************************************
+ *		dwarf2_load_name
+ *
+ * Parses the compilation units defining a given public name.
+ * As .debug_pubnames doesn't list static entities, we have to parse
+ * all the units when the name isn't found (or not given).
+ */
+static void dwarf2_load_name(struct module_format* modfmt, const char* name)
+{
+    struct dwarf2_module_info_s*info = modfmt->u.dwarf2_info;
+    unsigned                    low = 0, high = info->num_names, mid;
+    BOOL                        found = FALSE;
+
+    if (info->num_parsed == info->num_units) return;
+
+    if (name)
+    {
+        while (low < high)
+        {
+            mid = low + (high - low) / 2;
+            if (strcmp(info->names[mid].name, name) < 0) low = mid + 1;
+            else high = mid;
+        }
+        for (; low < info->num_names && !strcmp(info->names[low].name, name); low++)
+        {
+            dwarf2_parse_unit(modfmt, info->names[low].unit);
+            found = TRUE;
+        }
+        if (found) return;
+    }
+    dwarf2_parse_all_units(modfmt);
+}
+
+static int dwarf2_find_unit(const struct dwarf2_module_info_s* info, ULONG_PTR offset)
+{
+    const unsigned char*        start = info->sections[section_debug].address + offset;
+    unsigned                    low = 0, high = info->num_units, mid;
+
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        if (info->units[mid].start == start) return mid;
+        if (info->units[mid].start < start) low = mid + 1;
+        else high = mid;
+    }
+    return -1;
+}
+
+static BOOL dwarf2_add_range(struct dwarf2_module_info_s* info, ULONG_PTR low, ULONG_PTR high,
+                             unsigned unit)
+{
+    struct dwarf2_range_index*  new;
+
+    if (low >= high) return TRUE;
+    if (info->num_ranges == info->max_ranges)
+    {
+        unsigned sz = info->max_ranges ? info->max_ranges * 2 : 64;
+
+        if (info->ranges)
+            new = HeapReAlloc(GetProcessHeap(), 0, info->ranges, sz * sizeof(*new));
+        else
+            new = HeapAlloc(GetProcessHeap(), 0, sz * sizeof(*new));
+        if (!new) return FALSE;
+        info->ranges = new;
+        info->max_ranges = sz;
+    }
+    info->ranges[info->num_ranges].low = low;
+    info->ranges[info->num_ranges].high = high;
+    info->ranges[info->num_ranges].unit = unit;
+    info->num_ranges++;
+    info->units[unit].indexed = TRUE;
+    return TRUE;
+}
+
+static BOOL dwarf2_add_name(struct dwarf2_module_info_s* info, const char* name, unsigned unit)
+{
+    struct dwarf2_name_index*   new;
+
+    if (info->num_names == info->max_names)
+    {
+        unsigned sz = info->max_names ? info->max_names * 2 : 256;
+
+        if (info->names)
+            new = HeapReAlloc(GetProcessHeap(), 0, info->names, sz * sizeof(*new));
+        else
+            new = HeapAlloc(GetProcessHeap(), 0, sz * sizeof(*new));
+        if (!new) return FALSE;
+        info->names = new;
+        info->max_names = sz;
+    }
+    info->names[info->num_names].name = name;
+    info->names[info->num_names].unit = unit;
+    info->num_names++;
+    return TRUE;
+}
+
+/******************************************************************
+ *		dwarf2_index_aranges
+ *
+ * Gets the address ranges of the compilation units out of .debug_aranges.
+ */
+static BOOL dwarf2_index_aranges(struct dwarf2_module_info_s* info, const dwarf2_section_t* aranges)
+{
+    dwarf2_traverse_context_t   ctx;
+    const unsigned char*        set_start;
+    const unsigned char*        set_end;
+    ULONG_PTR                   offset, low, len;
+    unsigned short              version;
+    unsigned char               seg_size;
+    unsigned                    align;
+    int                         unit;
+
+    ctx.data = aranges->address;
+    ctx.end_data = aranges->address + aranges->size;
+    while (ctx.data + 12 <= ctx.end_data)
+    {
+        set_start = ctx.data;
+        set_end = ctx.data + 4 + dwarf2_parse_u4(&ctx);
+        version = dwarf2_parse_u2(&ctx);
+        offset = dwarf2_parse_u4(&ctx);
+        ctx.word_size = dwarf2_parse_byte(&ctx);
+        seg_size = dwarf2_parse_byte(&ctx);
+        if (set_end > ctx.end_data) break;
+        if (version != 2 || seg_size || (ctx.word_size != 4 && ctx.word_size != 8))
+        {
+            WARN("Unsupported aranges set (version %u, address size %u)\n", version, ctx.word_size);
+            ctx.data = set_end;
+            continue;
+        }
+        /* tuples are aligned on twice the address size from the start of the set */
+        align = 2 * ctx.word_size;
+        ctx.data = set_start + ((ctx.data - set_start + align - 1) & ~(align - 1));
+        unit = dwarf2_find_unit(info, offset);
+        while (ctx.data + align <= set_end)
+        {
+            low = dwarf2_parse_addr(&ctx);
+            len = dwarf2_parse_addr(&ctx);
+            if (!low && !len) break;
+            if (unit >= 0 &&
+                !dwarf2_add_range(info, info->load_offset + low, info->load_offset + low + len, unit))
+                return FALSE;
+        }
+        ctx.data = set_end;
+    }
+    return TRUE;
+}
+
+/******************************************************************
+ *		dwarf2_index_unit_range
+ *
+ * When a compilation unit isn't listed in .debug_aranges, gets its range
+ * from its root entry (without loading its children).
+ */
+static BOOL dwarf2_index_unit_range(struct module_format* modfmt, unsigned unit)
+{
+    struct dwarf2_module_info_s*info = modfmt->u.dwarf2_info;
+    dwarf2_parse_context_t      ctx;
+    dwarf2_traverse_context_t   cu_ctx, abbrev_ctx;
+    dwarf2_debug_info_t         di;
+    dwarf2_abbrev_entry_attr_t* attr;
+    ULONG_PTR                   cu_length, low, high;
+    unsigned                    i;
+    BOOL                        ret = TRUE;
+
+    cu_ctx.data = info->units[unit].start;
+    cu_length = dwarf2_parse_u4(&cu_ctx);
+    cu_ctx.end_data = cu_ctx.data + cu_length;
+    if (dwarf2_parse_u2(&cu_ctx) != 2) return TRUE;
+    abbrev_ctx.data = info->sections[section_abbrev].address + dwarf2_parse_u4(&cu_ctx);
+    abbrev_ctx.end_data = info->sections[section_abbrev].address + info->sections[section_abbrev].size;
+    abbrev_ctx.word_size = cu_ctx.word_size = dwarf2_parse_byte(&cu_ctx);
+    info->word_size = cu_ctx.word_size;
+
+    memset(&ctx, 0, sizeof(ctx));
+    pool_init(&ctx.pool, 4096);
+    ctx.sections = info->sections;
+    ctx.section = section_debug;
+    ctx.module = modfmt->module;
+    ctx.load_offset = info->load_offset;
+    ctx.ref_offset = info->units[unit].start - info->sections[section_debug].address;
+    dwarf2_parse_abbrev_set(&abbrev_ctx, &ctx.abbrev_table, &ctx.pool);
+    sparse_array_init(&ctx.debug_info_table, sizeof(dwarf2_debug_info_t), 128);
+
+    di.abbrev = dwarf2_abbrev_table_find_entry(&ctx.abbrev_table, dwarf2_leb128_as_unsigned(&cu_ctx));
+    if (di.abbrev && di.abbrev->tag == DW_TAG_compile_unit && di.abbrev->num_attr)
+    {
+        di.symt = NULL;
+        di.parent = NULL;
+        di.data = pool_alloc(&ctx.pool, di.abbrev->num_attr * sizeof(const char*));
+        for (i = 0, attr = di.abbrev->attrs; attr; i++, attr = attr->next)
+        {
+            di.data[i] = cu_ctx.data;
+            dwarf2_swallow_attribute(&cu_ctx, attr);
+        }
+        if (dwarf2_read_range(&ctx, &di, &low, &high))
+            ret = dwarf2_add_range(info, info->load_offset + low, info->load_offset + high, unit);
+    }
+    pool_destroy(&ctx.pool);
+    return ret;
+}
+
+/******************************************************************
+ *		dwarf2_index_pubnames
+ *
+ * Gets the compilation units defining the global names out of .debug_pubnames.
+ */
+static BOOL dwarf2_index_pubnames(struct dwarf2_module_info_s* info, const dwarf2_section_t* pubnames)
+{
+    dwarf2_traverse_context_t   ctx;
+    const unsigned char*        set_end;
+    const char*                 name;
+    unsigned short              version;
+    ULONG_PTR                   offset;
+    int                         unit;
+
+    ctx.data = pubnames->address;
+    ctx.end_data = pubnames->address + pubnames->size;
+    while (ctx.data + 14 <= ctx.end_data)
+    {
+        set_end = ctx.data + 4 + dwarf2_parse_u4(&ctx);
+        version = dwarf2_parse_u2(&ctx);
+        offset = dwarf2_parse_u4(&ctx);
+        ctx.data += 4; /* size of the unit */
+        if (set_end > ctx.end_data) break;
+        if (version == 2 && (unit = dwarf2_find_unit(info, offset)) >= 0)
+        {
+            while (ctx.data + 4 < set_end && dwarf2_parse_u4(&ctx))
+            {
+                name = (const char*)ctx.data;
+                ctx.data += strlen(name) + 1;
+                if (!dwarf2_add_name(info, name, unit)) return FALSE;
+            }
+        }
+        ctx.data = set_end;
+    }
+    return TRUE;
+}
+
+static int __cdecl dwarf2_range_cmp(const void* p1, const void* p2)
+{
+    const struct dwarf2_range_index*    r1 = p1;
+    const struct dwarf2_range_index*    r2 = p2;
+
+    if (r1->low < r2->low) return -1;
+    if (r1->low > r2->low) return 1;
+    return 0;
+}
+
+static int __cdecl dwarf2_name_cmp(const void* p1, const void* p2)
+{
+    return strcmp(((const struct dwarf2_name_index*)p1)->name,
+                  ((const struct dwarf2_name_index*)p2)->name);
+}
+
+/******************************************************************
+ *		dwarf2_build_index
+ *
+ * Instead of parsing all the compilation units at load time, only build
+ * the indexes (by address and by global name) to the units, so that
+ * they can be parsed when first needed.
+ */
+static BOOL dwarf2_build_index(struct module_format* modfmt, const dwarf2_section_t* aranges)
+{
+    struct dwarf2_module_info_s*info = modfmt->u.dwarf2_info;
+    dwarf2_traverse_context_t   mod_ctx;
+    ULONG_PTR                   max_high = 0;
+    unsigned                    i;
+
+    mod_ctx.data = info->sections[section_debug].address;
+    mod_ctx.end_data = mod_ctx.data + info->sections[section_debug].size;
+    for (i = 0; mod_ctx.data + 11 <= mod_ctx.end_data; i++)
+        mod_ctx.data += 4 + dwarf2_parse_u4(&mod_ctx);
+    if (!i) return TRUE;
+    if (!(info->units = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, i * sizeof(*info->units))))
+        return FALSE;
+
+    mod_ctx.data = info->sections[section_debug].address;
+    for (i = 0; mod_ctx.data + 11 <= mod_ctx.end_data; i++)
+    {
+        info->units[i].start = mod_ctx.data;
+        mod_ctx.data += 4 + dwarf2_parse_u4(&mod_ctx);
+    }
+    info->num_units = i;
+
+    if (aranges->address && aranges->address != IMAGE_NO_MAP &&
+        !dwarf2_index_aranges(info, aranges))
+        return FALSE;
+    for (i = 0; i < info->num_units; i++)
+    {
+        if (!info->units[i].indexed && !dwarf2_index_unit_range(modfmt, i))
+            return FALSE;
+    }
+    if (info->num_ranges)
+    {
+        qsort(info->ranges, info->num_ranges, sizeof(info->ranges[0]), dwarf2_range_cmp);
+        for (i = 0; i < info->num_ranges; i++)
+        {
+            if (info->ranges[i].high > max_high) max_high = info->ranges[i].high;
+            info->ranges[i].max_high = max_high;
+        }
+    }
+
+    if (info->debug_pubnames.address && info->debug_pubnames.address != IMAGE_NO_MAP)
+    {
+        if (!dwarf2_index_pubnames(info, &info->debug_pubnames)) return FALSE;
+        if (info->num_names)
+            qsort(info->names, info->num_names, sizeof(info->names[0]), dwarf2_name_cmp);
+    }
+    return TRUE;
+}
+
 static void dwarf2_module_remove(struct process* pcs, struct module_format* modfmt)
 {
-    dwarf2_fini_section(&modfmt->u.dwarf2_info->debug_loc);
-    dwarf2_fini_section(&modfmt->u.dwarf2_info->debug_frame);
+    struct dwarf2_module_info_s*info = modfmt->u.dwarf2_info;
+    unsigned                    i;
+
+    dwarf2_fini_section(&info->debug_loc);
+    dwarf2_fini_section(&info->debug_frame);
+    if (info->lazy)
+    {
+        for (i = 0; i < section_max; i++)
+            dwarf2_fini_section(&info->sections[i]);
+        dwarf2_fini_section(&info->debug_pubnames);
+        HeapFree(GetProcessHeap(), 0, info->thunks);
+        HeapFree(GetProcessHeap(), 0, info->units);
+        HeapFree(GetProcessHeap(), 0, info->ranges);
+        HeapFree(GetProcessHeap(), 0, info->names);
+    }
     HeapFree(GetProcessHeap(), 0, modfmt);
 }
 
@@ -3495,7 +3963,10 @@ BOOL dwarf2_parse(struct module* module, ULONG_PTR load_offset,
     struct image_section_map    debug_sect, debug_str_sect, debug_abbrev_sect,
                                 debug_line_sect, debug_ranges_sect, eh_frame_sect;
     BOOL                ret = TRUE;
+    BOOL                lazy = FALSE;
     struct module_format* dwarf2_modfmt;
+    LARGE_INTEGER       start;
+    size_t              pool_size;
 
     if (!dwarf2_init_section(&eh_frame,                fmap, ".eh_frame",     NULL,             &eh_frame_sect))
         /* lld produces .eh_fram to avoid generating a long name */
@@ -3524,12 +3995,14 @@ BOOL dwarf2_parse(struct module* module, ULONG_PTR load_offset,
     }
 
     TRACE("Loading Dwarf2 information for %s\n", debugstr_w(module->module.ModuleName));
+    QueryPerformanceCounter(&start);
+    pool_size = pool_get_size(&module->pool);
 
     mod_ctx.data = section[section_debug].address;
     mod_ctx.end_data = mod_ctx.data + section[section_debug].size;
     mod_ctx.word_size = 0; /* will be correctly set later on */
 
-    dwarf2_modfmt = HeapAlloc(GetProcessHeap(), 0,
+    dwarf2_modfmt = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY,
                               sizeof(*dwarf2_modfmt) + sizeof(*dwarf2_modfmt->u.dwarf2_info));
     if (!dwarf2_modfmt)
     {
@@ -3539,6 +4012,8 @@ BOOL dwarf2_parse(struct module* module, ULONG_PTR load_offset,
     dwarf2_modfmt->module = module;
     dwarf2_modfmt->remove = dwarf2_module_remove;
     dwarf2_modfmt->loc_compute = dwarf2_location_compute;
+    dwarf2_modfmt->load_at = NULL;
+    dwarf2_modfmt->load_name = NULL;
     dwarf2_modfmt->u.dwarf2_info = (struct dwarf2_module_info_s*)(dwarf2_modfmt + 1);
     dwarf2_modfmt->u.dwarf2_info->word_size = 0; /* will be correctly set later on */
     dwarf2_modfmt->module->format_info[DFI_DWARF] = dwarf2_modfmt;
@@ -3550,9 +4025,50 @@ BOOL dwarf2_parse(struct module* module, ULONG_PTR load_offset,
     dwarf2_init_section(&dwarf2_modfmt->u.dwarf2_info->debug_frame, fmap, ".debug_frame", ".zdebug_frame", NULL);
     dwarf2_modfmt->u.dwarf2_info->eh_frame = eh_frame;
 
-    while (mod_ctx.data < mod_ctx.end_data)
+    if (dbghelp_opt_lazy_dwarf && section[section_debug].address &&
+        section[section_debug].address != IMAGE_NO_MAP)
     {
-        dwarf2_parse_compilation_unit(section, dwarf2_modfmt->module, thunks, &mod_ctx, load_offset);
+        struct dwarf2_module_info_s*info = dwarf2_modfmt->u.dwarf2_info;
+        struct image_section_map    aranges_sect;
+        dwarf2_section_t            aranges;
+
+        /* the sections are kept mapped until the module is removed */
+        lazy = info->lazy = TRUE;
+        memcpy(info->sections, section, sizeof(section));
+        info->load_offset = load_offset;
+        info->thunks = elf_dup_thunk_areas(thunks);
+        dwarf2_init_section(&info->debug_pubnames, fmap, ".debug_pubnames", ".zdebug_pubnames", NULL);
+        dwarf2_init_section(&aranges, fmap, ".debug_aranges", ".zdebug_aranges", &aranges_sect);
+
+        if (dwarf2_build_index(dwarf2_modfmt, &aranges))
+        {
+            dwarf2_modfmt->load_at = dwarf2_load_at;
+            dwarf2_modfmt->load_name = dwarf2_load_name;
+        }
+        else
+        {
+            /* fall back to parsing everything */
+            while (mod_ctx.data < mod_ctx.end_data)
+                dwarf2_parse_compilation_unit(section, dwarf2_modfmt->module, thunks, &mod_ctx, load_offset);
+        }
+
+        dwarf2_fini_section(&aranges);
+        image_unmap_section(&aranges_sect);
+        TRACE("Indexed %u units (%u ranges, %u names) in %s: %u us, %lu bytes\n",
+              info->num_units, info->num_ranges, info->num_names,
+              debugstr_w(module->module.ModuleName), dwarf2_elapsed_us(&start),
+              (ULONG_PTR)(info->num_units * sizeof(*info->units) + info->max_ranges * sizeof(*info->ranges) +
+                          info->max_names * sizeof(*info->names)));
+    }
+    else
+    {
+        while (mod_ctx.data < mod_ctx.end_data)
+        {
+            dwarf2_parse_compilation_unit(section, dwarf2_modfmt->module, thunks, &mod_ctx, load_offset);
+        }
+        TRACE("Parsed Dwarf2 information for %s: %u us, %lu bytes\n",
+              debugstr_w(module->module.ModuleName), dwarf2_elapsed_us(&start),
+              (ULONG_PTR)(pool_get_size(&module->pool) - pool_size));
     }
     dwarf2_modfmt->module->module.SymType = SymDia;
     dwarf2_modfmt->module->module.CVSig = 'D' | ('W' << 8) | ('A' << 16) | ('R' << 24);
@@ -3566,17 +4082,20 @@ BOOL dwarf2_parse(struct module* module, ULONG_PTR load_offset,
     dwarf2_modfmt->u.dwarf2_info->word_size = fmap->addr_size / 8;
 
 leave:
-    dwarf2_fini_section(&section[section_debug]);
-    dwarf2_fini_section(&section[section_abbrev]);
-    dwarf2_fini_section(&section[section_string]);
-    dwarf2_fini_section(&section[section_line]);
-    dwarf2_fini_section(&section[section_ranges]);
-
-    image_unmap_section(&debug_sect);
-    image_unmap_section(&debug_abbrev_sect);
-    image_unmap_section(&debug_str_sect);
-    image_unmap_section(&debug_line_sect);
-    image_unmap_section(&debug_ranges_sect);
+    if (!lazy)
+    {
+        dwarf2_fini_section(&section[section_debug]);
+        dwarf2_fini_section(&section[section_abbrev]);
+        dwarf2_fini_section(&section[section_string]);
+        dwarf2_fini_section(&section[section_line]);
+        dwarf2_fini_section(&section[section_ranges]);
+
+        image_unmap_section(&debug_sect);
+        image_unmap_section(&debug_abbrev_sect);
+        image_unmap_section(&debug_str_sect);
+        image_unmap_section(&debug_line_sect);
+        image_unmap_section(&debug_ranges_sect);
+    }
     if (!ret) image_unmap_section(&eh_frame_sect);
 
     return ret;
@@ -612,6 +612,24 @@ int elf_is_in_thunk_area(ULONG_PTR addr,
     return -1;
 }
 
+/******************************************************************
+ *		elf_dup_thunk_areas
+ *
+ * Copies a thunk area table, for users needing it after the ELF
+ * debug information loading is over.
+ */
+struct elf_thunk_area* elf_dup_thunk_areas(const struct elf_thunk_area* thunks)
+{
+    struct elf_thunk_area*      ret;
+    unsigned                    i = 0;
+
+    if (!thunks) return NULL;
+    while (thunks[i].symname) i++;
+    if ((ret = HeapAlloc(GetProcessHeap(), 0, (i + 1) * sizeof(*ret))))
+        memcpy(ret, thunks, (i + 1) * sizeof(*ret));
+    return ret;
+}
+
 /******************************************************************
  *		elf_hash_symtab
  *
@@ -911,6 +929,7 @@ static int elf_new_wine_thunks(struct module* module, const struct hash_table* h
     struct symtab_elt*          ste;
     DWORD_PTR                   addr;
     struct symt_ht*             symt;
+    struct module_format*       dwarf = module->format_info[DFI_DWARF];
 
     hash_table_iter_init(ht_symtab, &hti, NULL);
     while ((ste = hash_table_iter_up(&hti)))
@@ -925,7 +944,10 @@ static int elf_new_wine_thunks(struct module* module, const struct hash_table* h
             symt_new_thunk(module, ste->compiland, ste->ht_elt.name, thunks[j].ordinal,
                            addr, ste->sym.st_size);
         }
-        else
+        /* when DWARF information is parsed on demand, only the symbols outside
+         * of the indexed units can be told to have no debug information
+         */
+        else if (!dwarf || !dwarf->load_at || !dwarf2_is_lazy_address(module, addr))
         {
             ULONG64     ref_addr;
             struct location loc;
@@ -990,6 +1012,12 @@ static int elf_new_public_symbols(struct module* module, const struct hash_table
     hash_table_iter_init(symtab, &hti, NULL);
     while ((ste = hash_table_iter_up(&hti)))
     {
+        /* don't let the public symbols duplicate the functions and variables
+         * of the DWARF units which haven't been parsed yet
+         */
+        if ((dbghelp_options & SYMOPT_AUTO_PUBLICS) &&
+            dwarf2_is_lazy_address(module, module->reloc_delta + ste->sym.st_value))
+            continue;
         symt_new_public(module, ste->compiland, ste->ht_elt.name,
                         FALSE,
                         module->reloc_delta + ste->sym.st_value,
@@ -1240,6 +1268,8 @@ static BOOL elf_load_file_from_fmap(struct process* pcs, const WCHAR* filename,
         modfmt->module      = elf_info->module;
         modfmt->remove      = elf_module_remove;
         modfmt->loc_compute = NULL;
+        modfmt->load_at     = NULL;
+        modfmt->load_name   = NULL;
         modfmt->u.elf_info  = elf_module_info;
 
         elf_module_info->elf_addr = load_offset;
@@ -1492,6 +1492,8 @@ static BOOL macho_load_file(struct process* pcs, const WCHAR* filename,
         modfmt->module       = macho_info->module;
         modfmt->remove       = macho_module_remove;
         modfmt->loc_compute  = NULL;
+        modfmt->load_at      = NULL;
+        modfmt->load_name    = NULL;
         modfmt->u.macho_info = macho_module_info;
 
         macho_module_info->load_addr = load_addr;
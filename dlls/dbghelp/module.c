@@ -216,7 +216,11 @@ struct module* module_new(struct process* pcs, const WCHAR* name,
     module->sorttab_size      = 0;
     module->addr_sorttab      = NULL;
     module->num_sorttab       = 0;
+    module->num_recent        = 0;
     module->num_symbols       = 0;
+    module->name_sorttab      = NULL;
+    module->num_name_sorttab  = 0;
+    module->name_sorttab_elts = 0;
 
     vector_init(&module->vsymt, sizeof(struct symt*), 128);
     /* FIXME: this seems a bit too high (on a per module basis)
@@ -373,6 +377,42 @@ BOOL module_get_debug(struct module_pair* pair)
     return pair->effective->module.SymType != SymNone;
 }
 
+/******************************************************************
+ *		module_load_debug_at
+ *
+ * Some debug formats only parse their information on demand: make sure
+ * everything covering addr has been loaded into the module.
+ */
+void module_load_debug_at(struct module* module, DWORD64 addr)
+{
+    struct module_format*   modfmt;
+    unsigned                i;
+
+    for (i = 0; i < DFI_LAST; i++)
+    {
+        if ((modfmt = module->format_info[i]) && modfmt->load_at)
+            modfmt->load_at(modfmt, addr);
+    }
+}
+
+/******************************************************************
+ *		module_load_debug_name
+ *
+ * Same as module_load_debug_at, but for a symbol name (NULL requests
+ * all the debug information to be loaded).
+ */
+void module_load_debug_name(struct module* module, const char* name)
+{
+    struct module_format*   modfmt;
+    unsigned                i;
+
+    for (i = 0; i < DFI_LAST; i++)
+    {
+        if ((modfmt = module->format_info[i]) && modfmt->load_name)
+            modfmt->load_name(modfmt, name);
+    }
+}
+
 /***********************************************************************
  *	module_find_by_addr
  *
@@ -851,6 +891,7 @@ BOOL module_remove(struct process* pcs, struct module* module)
     hash_table_destroy(&module->ht_types);
     HeapFree(GetProcessHeap(), 0, module->sources);
     HeapFree(GetProcessHeap(), 0, module->addr_sorttab);
+    HeapFree(GetProcessHeap(), 0, module->name_sorttab);
     HeapFree(GetProcessHeap(), 0, module->real_path);
     pool_destroy(&module->pool);
     /* native dbghelp doesn't invoke registered callback(,CBA_SYMBOLS_UNLOADED,) here
@@ -1275,7 +1316,10 @@ void module_reset_debug_info(struct module* module)
     module->sortlist_valid = TRUE;
     module->sorttab_size = 0;
     module->addr_sorttab = NULL;
-    module->num_sorttab = module->num_symbols = 0;
+    module->num_sorttab = module->num_recent = module->num_symbols = 0;
+    HeapFree(GetProcessHeap(), 0, module->name_sorttab);
+    module->name_sorttab = NULL;
+    module->num_name_sorttab = module->name_sorttab_elts = 0;
     hash_table_destroy(&module->ht_symbols);
     module->ht_symbols.num_buckets = 0;
     module->ht_symbols.buckets = NULL;
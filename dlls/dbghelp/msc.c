@@ -2876,6 +2876,8 @@ static BOOL pdb_process_file(const struct process* pcs,
     modfmt->module      = msc_dbg->module;
     modfmt->remove      = pdb_module_remove;
     modfmt->loc_compute = NULL;
+    modfmt->load_at     = NULL;
+    modfmt->load_name   = NULL;
     modfmt->u.pdb_info  = pdb_module_info;
 
     memset(cv_zmodules, 0, sizeof(cv_zmodules));
@@ -121,6 +121,19 @@ void* pool_alloc(struct pool* pool, size_t len)
     return ret;
 }
 
+/* returns the number of bytes handed out by the pool so far */
+size_t pool_get_size(const struct pool* pool)
+{
+    struct pool_arena*  arena;
+    size_t              used = 0;
+
+    LIST_FOR_EACH_ENTRY( arena, &pool->arena_list, struct pool_arena, entry )
+        used += arena->current - (char*)(arena + 1);
+    LIST_FOR_EACH_ENTRY( arena, &pool->arena_full, struct pool_arena, entry )
+        used += arena->current - (char*)(arena + 1);
+    return used;
+}
+
 char* pool_strdup(struct pool* pool, const char* str)
 {
     char* ret;
@@ -373,9 +386,35 @@ void hash_table_destroy(struct hash_table* ht)
 #endif
 }
 
+/* grow the bucket array, keeping the insertion order of elements with the same name */
+static void hash_table_grow(struct hash_table* ht, unsigned num_buckets)
+{
+    struct hash_table_bucket*   buckets;
+    struct hash_table_elt*      elt;
+    struct hash_table_elt*      next;
+    unsigned                    i, hash;
+
+    if (!(buckets = pool_alloc(ht->pool, num_buckets * sizeof(struct hash_table_bucket)))) return;
+    memset(buckets, 0, num_buckets * sizeof(struct hash_table_bucket));
+    for (i = 0; i < ht->num_buckets; i++)
+    {
+        for (elt = ht->buckets[i].first; elt; elt = next)
+        {
+            next = elt->next;
+            hash = hash_table_hash(elt->name, num_buckets);
+            if (!buckets[hash].first) buckets[hash].first = elt;
+            else buckets[hash].last->next = elt;
+            buckets[hash].last = elt;
+            elt->next = NULL;
+        }
+    }
+    ht->buckets = buckets;
+    ht->num_buckets = num_buckets;
+}
+
 void hash_table_add(struct hash_table* ht, struct hash_table_elt* elt)
 {
-    unsigned                    hash = hash_table_hash(elt->name, ht->num_buckets);
+    unsigned                    hash;
 
     if (!ht->buckets)
     {
@@ -383,6 +422,12 @@ void hash_table_add(struct hash_table* ht, struct hash_table_elt* elt)
         assert(ht->buckets);
         memset(ht->buckets, 0, ht->num_buckets * sizeof(struct hash_table_bucket));
     }
+    /* keep chains short for modules with lots of symbols; the old bucket array stays
+     * in the pool, but it's at most a quarter of the new one
+     */
+    else if (ht->num_elts >= ht->num_buckets * 4)
+        hash_table_grow(ht, ht->num_buckets * 4);
+    hash = hash_table_hash(elt->name, ht->num_buckets);
 
     /* in some cases, we need to get back the symbols of same name in the order
      * in which they've been inserted. So insert new elements at the end of the list.
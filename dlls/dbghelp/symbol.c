@@ -734,105 +734,280 @@ static BOOL send_symbol(const struct sym_enum* se, struct module_pair* pair,
     return !se->cb(se->sym_info, se->sym_info->Size, se->user);
 }
 
+static inline unsigned char fold_name_char(unsigned char ch)
+{
+    return (ch >= 'a' && ch <= 'z') ? ch - 'a' + 'A' : ch;
+}
+
+/* compare at most len characters of two names, ignoring the case of ASCII letters */
+static int cmp_name_nocase(const char* name1, const char* name2, size_t len)
+{
+    unsigned char c1, c2;
+
+    for (; len; len--)
+    {
+        c1 = fold_name_char(*name1++);
+        c2 = fold_name_char(*name2++);
+        if (c1 != c2) return c1 - c2;
+        if (!c1) break;
+    }
+    return 0;
+}
+
+static BOOL is_ascii_name(const char* name)
+{
+    for (; *name; name++) if ((unsigned char)*name >= 0x80) return FALSE;
+    return TRUE;
+}
+
+struct sorted_name
+{
+    struct symt_ht*     sym;
+    unsigned            seq;
+};
+
+static int __cdecl sorted_name_cmp(const void* p1, const void* p2)
+{
+    const struct sorted_name* n1 = p1;
+    const struct sorted_name* n2 = p2;
+    int ret = cmp_name_nocase(n1->sym->hash_elt.name, n2->sym->hash_elt.name, ~(size_t)0);
+
+    /* keep symbols of the same name in hash table order */
+    return ret ? ret : (n1->seq > n2->seq) - (n1->seq < n2->seq);
+}
+
+/******************************************************************
+ *		build_name_sorttab
+ *
+ * (Re)build the index of the module symbols sorted by name. Symbols with
+ * non ASCII names can't be reliably compared without case, they're stored
+ * (unsorted) after the sorted ones.
+ */
+static BOOL build_name_sorttab(struct module* module)
+{
+    unsigned                    count = 0, num_ascii = 0, num_other = 0;
+    struct sorted_name*         names;
+    struct symt_ht**            sorttab;
+    struct symt_ht*             sym;
+    struct hash_table_iter      hti;
+    void*                       ptr;
+    unsigned                    i;
+
+    if (module->name_sorttab && module->name_sorttab_elts == module->ht_symbols.num_elts) return TRUE;
+
+    hash_table_iter_init(&module->ht_symbols, &hti, NULL);
+    while ((ptr = hash_table_iter_up(&hti)))
+    {
+        sym = CONTAINING_RECORD(ptr, struct symt_ht, hash_elt);
+        if (!is_ascii_name(sym->hash_elt.name)) num_other++;
+        count++;
+    }
+    if (!count) return FALSE;
+
+    if (!(sorttab = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*sorttab)))) return FALSE;
+    if (!(names = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*names))))
+    {
+        HeapFree(GetProcessHeap(), 0, sorttab);
+        return FALSE;
+    }
+    i = count - num_other;
+    /* the non ASCII ones go at the end, in hash table order */
+    hash_table_iter_init(&module->ht_symbols, &hti, NULL);
+    while ((ptr = hash_table_iter_up(&hti)))
+    {
+        sym = CONTAINING_RECORD(ptr, struct symt_ht, hash_elt);
+        if (is_ascii_name(sym->hash_elt.name))
+        {
+            names[num_ascii].sym = sym;
+            names[num_ascii].seq = num_ascii;
+            num_ascii++;
+        }
+        else sorttab[i++] = sym;
+    }
+    qsort(names, num_ascii, sizeof(*names), sorted_name_cmp);
+    for (i = 0; i < num_ascii; i++) sorttab[i] = names[i].sym;
+    HeapFree(GetProcessHeap(), 0, names);
+
+    HeapFree(GetProcessHeap(), 0, module->name_sorttab);
+    module->name_sorttab = sorttab;
+    module->num_name_sorttab = num_ascii;
+    module->name_sorttab_elts = count;
+    return TRUE;
+}
+
+/* get the leading characters of a SymMatchString expression which have to match literally */
+static size_t get_match_prefix(const WCHAR* match, char* prefix, size_t size)
+{
+    size_t len;
+
+    for (len = 0; len < size - 1 && match[len] && match[len] < 0x80; len++)
+    {
+        switch (match[len])
+        {
+        case '*': case '?': case '[': case ']': case '+': case '#': case '\\':
+            goto done;
+        }
+        prefix[len] = match[len];
+    }
+done:
+    /* '+' and '#' apply to the previous character */
+    if (len && (match[len] == '+' || match[len] == '#')) len--;
+    prefix[len] = 0;
+    return len;
+}
+
+static BOOL symt_enum_match(struct module_pair* pair, struct symt_ht* sym, const WCHAR* match,
+                            const struct sym_enum* se)
+{
+    WCHAR*      nameW;
+    BOOL        ret;
+
+    nameW = symt_get_nameW(&sym->symt);
+    ret = SymMatchStringW(nameW, match, FALSE);
+    HeapFree(GetProcessHeap(), 0, nameW);
+    if (ret)
+    {
+        se->sym_info->SizeOfStruct = sizeof(SYMBOL_INFO);
+        se->sym_info->MaxNameLen = sizeof(se->buffer) - sizeof(SYMBOL_INFO);
+        if (send_symbol(se, pair, NULL, &sym->symt)) return TRUE;
+    }
+    return FALSE;
+}
+
 static BOOL symt_enum_module(struct module_pair* pair, const WCHAR* match,
                              const struct sym_enum* se)
 {
+    struct module*              module = pair->effective;
     void*                       ptr;
     struct symt_ht*             sym = NULL;
     struct hash_table_iter      hti;
-    WCHAR*                      nameW;
-    BOOL                        ret;
+    char                        prefix[256];
+    size_t                      len;
+    unsigned                    low, high, mid, i;
 
-    hash_table_iter_init(&pair->effective->ht_symbols, &hti, NULL);
-    while ((ptr = hash_table_iter_up(&hti)))
+    module_load_debug_name(module, NULL);
+
+    /* when the expression starts with some plain characters, only look at the
+     * range of the name index starting with them
+     */
+    if ((len = get_match_prefix(match, prefix, sizeof(prefix))) && build_name_sorttab(module))
     {
-        sym = CONTAINING_RECORD(ptr, struct symt_ht, hash_elt);
-        nameW = symt_get_nameW(&sym->symt);
-        ret = SymMatchStringW(nameW, match, FALSE);
-        HeapFree(GetProcessHeap(), 0, nameW);
-        if (ret)
+        low = 0;
+        high = module->num_name_sorttab;
+        while (low < high)
+        {
+            mid = low + (high - low) / 2;
+            if (cmp_name_nocase(module->name_sorttab[mid]->hash_elt.name, prefix, len) < 0)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        for (i = low; i < module->num_name_sorttab; i++)
         {
-            se->sym_info->SizeOfStruct = sizeof(SYMBOL_INFO);
-            se->sym_info->MaxNameLen = sizeof(se->buffer) - sizeof(SYMBOL_INFO);
-            if (send_symbol(se, pair, NULL, &sym->symt)) return TRUE;
+            sym = module->name_sorttab[i];
+            if (cmp_name_nocase(sym->hash_elt.name, prefix, len)) break;
+            if (symt_enum_match(pair, sym, match, se)) return TRUE;
         }
+        for (i = module->num_name_sorttab; i < module->name_sorttab_elts; i++)
+            if (symt_enum_match(pair, module->name_sorttab[i], match, se)) return TRUE;
+        return FALSE;
+    }
+
+    hash_table_iter_init(&module->ht_symbols, &hti, NULL);
+    while ((ptr = hash_table_iter_up(&hti)))
+    {
+        sym = CONTAINING_RECORD(ptr, struct symt_ht, hash_elt);
+        if (symt_enum_match(pair, sym, match, se)) return TRUE;
     }
     return FALSE;
 }
 
-static inline unsigned where_to_insert(struct module* module, unsigned high, const struct symt_ht* elt)
+struct sorted_symt
+{
+    ULONG64             addr;
+    struct symt_ht*     sym;
+};
+
+static int __cdecl sorted_symt_cmp(const void* p1, const void* p2)
+{
+    const struct sorted_symt* s1 = p1;
+    const struct sorted_symt* s2 = p2;
+
+    return cmp_addr(s1->addr, s2->addr);
+}
+
+/* merge the sorted symbols in elts into the sorted run of count symbols starting at first,
+ * the addr_sorttab must have room for them after the run
+ */
+static void merge_symbols(struct module* module, unsigned first, unsigned count,
+                          const struct sorted_symt* elts, unsigned num_elts)
 {
-    unsigned    low = 0, mid = high / 2;
-    ULONG64     addr;
+    struct symt_ht**    run = &module->addr_sorttab[first];
+    int                 i = count - 1, j = num_elts - 1, k = count + num_elts - 1;
+    ULONG64             addr = 0;
 
-    if (!high) return 0;
-    symt_get_address(&elt->symt, &addr);
-    do
+    if (i >= 0) symt_get_address(&run[i]->symt, &addr);
+    while (j >= 0)
     {
-        switch (cmp_sorttab_addr(module, mid, addr))
+        if (i >= 0 && addr > elts[j].addr)
         {
-        case 0: return mid;
-        case -1: low = mid + 1; break;
-        case 1: high = mid; break;
+            run[k--] = run[i--];
+            if (i >= 0) symt_get_address(&run[i]->symt, &addr);
         }
-        mid = low + (high - low) / 2;
-    } while (low < high);
-    return mid;
+        else run[k--] = elts[j--].sym;
+    }
+}
+
+static struct sorted_symt* get_sorted_symbols(struct module* module, unsigned first, unsigned count, BOOL sort)
+{
+    struct sorted_symt* elts;
+    unsigned            i;
+
+    if (!(elts = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*elts)))) return NULL;
+    for (i = 0; i < count; i++)
+    {
+        elts[i].sym = module->addr_sorttab[first + i];
+        symt_get_address(&elts[i].sym->symt, &elts[i].addr);
+    }
+    if (sort) qsort(elts, count, sizeof(*elts), sorted_symt_cmp);
+    return elts;
 }
 
 /***********************************************************************
  *              resort_symbols
  *
  * Rebuild sorted list of symbols for a module.
+ *
+ * The table holds a main sorted run, followed by a second (smaller) sorted run, followed
+ * by the symbols added since the last rebuild. The new symbols are only merged into the
+ * second run, which is merged into the main one once it gets big enough, so that
+ * interleaving symbol additions and lookups doesn't move the whole table every time.
  */
 static BOOL resort_symbols(struct module* module)
 {
-    int delta;
+    unsigned            first = module->num_sorttab + module->num_recent;
+    unsigned            delta = module->num_symbols - first;
+    struct sorted_symt* elts;
 
     if (!(module->module.NumSyms = module->num_symbols))
         return FALSE;
 
-    /* we know that set from 0 up to num_sorttab is already sorted
-     * so sort the remaining (new) symbols, and merge the two sets
-     * (unless the first set is empty)
-     */
-    delta = module->num_symbols - module->num_sorttab;
-    qsort(&module->addr_sorttab[module->num_sorttab], delta, sizeof(struct symt_ht*), symt_cmp_addr);
-    if (module->num_sorttab)
+    if (delta)
     {
-        int     i, ins_idx = module->num_sorttab, prev_ins_idx;
-        static struct symt_ht** tmp;
-        static unsigned num_tmp;
-
-        if (num_tmp < delta)
-        {
-            static struct symt_ht** new;
-            if (tmp)
-                new = HeapReAlloc(GetProcessHeap(), 0, tmp, delta * sizeof(struct symt_ht*));
-            else
-                new = HeapAlloc(GetProcessHeap(), 0, delta * sizeof(struct symt_ht*));
-            if (!new)
-            {
-                module->num_sorttab = 0;
-                return resort_symbols(module);
-            }
-            tmp = new;
-            num_tmp = delta;
-        }
-        memcpy(tmp, &module->addr_sorttab[module->num_sorttab], delta * sizeof(struct symt_ht*));
-        qsort(tmp, delta, sizeof(struct symt_ht*), symt_cmp_addr);
-
-        for (i = delta - 1; i >= 0; i--)
-        {
-            prev_ins_idx = ins_idx;
-            ins_idx = where_to_insert(module, ins_idx, tmp[i]);
-            memmove(&module->addr_sorttab[ins_idx + i + 1],
-                    &module->addr_sorttab[ins_idx],
-                    (prev_ins_idx - ins_idx) * sizeof(struct symt_ht*));
-            module->addr_sorttab[ins_idx + i] = tmp[i];
-        }
+        if (!(elts = get_sorted_symbols(module, first, delta, TRUE))) return FALSE;
+        merge_symbols(module, module->num_sorttab, module->num_recent, elts, delta);
+        HeapFree(GetProcessHeap(), 0, elts);
+        module->num_recent += delta;
+    }
+    if (module->num_recent > 1024 && module->num_recent > module->num_sorttab / 16)
+    {
+        if (!(elts = get_sorted_symbols(module, module->num_sorttab, module->num_recent, FALSE)))
+            return FALSE;
+        merge_symbols(module, 0, module->num_sorttab, elts, module->num_recent);
+        HeapFree(GetProcessHeap(), 0, elts);
+        module->num_sorttab += module->num_recent;
+        module->num_recent = 0;
     }
-    module->num_sorttab = module->num_symbols;
     return module->sortlist_valid = TRUE;
 }
 
@@ -849,21 +1024,21 @@ static void symt_get_length(struct module* module, const struct symt* symt, ULON
 }
 
 /* needed by symt_find_nearest */
-static int symt_get_best_at(struct module* module, int idx_sorttab)
+static int symt_get_best_at(struct module* module, int idx_sorttab, int first, int end)
 {
     ULONG64 ref_addr;
     int idx_sorttab_orig = idx_sorttab;
     if (module->addr_sorttab[idx_sorttab]->symt.tag == SymTagPublicSymbol)
     {
         symt_get_address(&module->addr_sorttab[idx_sorttab]->symt, &ref_addr);
-        while (idx_sorttab > 0 &&
+        while (idx_sorttab > first &&
                module->addr_sorttab[idx_sorttab]->symt.tag == SymTagPublicSymbol &&
                !cmp_sorttab_addr(module, idx_sorttab - 1, ref_addr))
             idx_sorttab--;
         if (module->addr_sorttab[idx_sorttab]->symt.tag == SymTagPublicSymbol)
         {
             idx_sorttab = idx_sorttab_orig;
-            while (idx_sorttab < module->num_sorttab - 1 &&
+            while (idx_sorttab < end - 1 &&
                    module->addr_sorttab[idx_sorttab]->symt.tag == SymTagPublicSymbol &&
                    !cmp_sorttab_addr(module, idx_sorttab + 1, ref_addr))
                 idx_sorttab++;
@@ -875,55 +1050,83 @@ static int symt_get_best_at(struct module* module, int idx_sorttab)
     return idx_sorttab;
 }
 
+/* find the closest symbol at or below addr in the sorted run [first, end), -1 if none */
+static int symt_find_nearest_in_run(struct module* module, int first, int end, ULONG64 addr)
+{
+    int         low = first, high = end, mid;
+
+    if (first == end) return -1;
+    /* binary search for the first symbol at or above addr */
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        if (cmp_sorttab_addr(module, mid, addr) < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    if (low == end || cmp_sorttab_addr(module, low, addr) > 0)
+    {
+        if (low == first) return -1;
+        low--;
+    }
+    /* If found symbol is a public symbol, check if there are any other entries that
+     * might also have the same address, but would get better information
+     */
+    return symt_get_best_at(module, low, first, end);
+}
+
 /* assume addr is in module */
 struct symt_ht* symt_find_nearest(struct module* module, DWORD_PTR addr)
 {
-    int         mid, high, low;
-    ULONG64     ref_addr, ref_size;
+    int         main_end, recent_end, idx, idx_recent;
+    ULONG64     ref_addr, ref_size, recent_addr;
 
     if (!module->sortlist_valid || !module->addr_sorttab)
     {
         if (!resort_symbols(module)) return NULL;
     }
+    main_end = module->num_sorttab;
+    recent_end = module->num_sorttab + module->num_recent;
+    if (!recent_end) return NULL;
 
-    /*
-     * Binary search to find closest symbol.
-     */
-    low = 0;
-    high = module->num_sorttab;
-
-    symt_get_address(&module->addr_sorttab[0]->symt, &ref_addr);
-    if (addr <= ref_addr)
+    /* check against the end of the highest symbol of both runs */
+    idx = recent_end - 1;
+    if (module->num_recent && main_end)
     {
-        low = symt_get_best_at(module, 0);
-        return module->addr_sorttab[low];
+        symt_get_address(&module->addr_sorttab[main_end - 1]->symt, &ref_addr);
+        if (cmp_sorttab_addr(module, recent_end - 1, ref_addr) < 0) idx = main_end - 1;
     }
+    symt_get_address(&module->addr_sorttab[idx]->symt, &ref_addr);
+    symt_get_length(module, &module->addr_sorttab[idx]->symt, &ref_size);
+    if (addr >= ref_addr + ref_size) return NULL;
 
-    if (high)
-    {
-        symt_get_address(&module->addr_sorttab[high - 1]->symt, &ref_addr);
-        symt_get_length(module, &module->addr_sorttab[high - 1]->symt, &ref_size);
-        if (addr >= ref_addr + ref_size) return NULL;
-    }
-    
-    while (high > low + 1)
+    idx = symt_find_nearest_in_run(module, 0, main_end, addr);
+    idx_recent = symt_find_nearest_in_run(module, main_end, recent_end, addr);
+    if (idx == -1 && idx_recent == -1)
     {
-        mid = (high + low) / 2;
-        if (cmp_sorttab_addr(module, mid, addr) < 0)
-            low = mid;
-        else
-            high = mid;
-    }
-    if (low != high && high != module->num_sorttab &&
-        cmp_sorttab_addr(module, high, addr) <= 0)
-        low = high;
+        /* addr is below all symbols, return the lowest one */
+        int first = 0, end = main_end;
 
-    /* If found symbol is a public symbol, check if there are any other entries that
-     * might also have the same address, but would get better information
-     */
-    low = symt_get_best_at(module, low);
+        if (!main_end || (module->num_recent &&
+                          symt_get_address(&module->addr_sorttab[0]->symt, &ref_addr) &&
+                          cmp_sorttab_addr(module, main_end, ref_addr) < 0))
+        {
+            first = main_end;
+            end = recent_end;
+        }
+        return module->addr_sorttab[symt_get_best_at(module, first, first, end)];
+    }
+    if (idx == -1) return module->addr_sorttab[idx_recent];
+    if (idx_recent == -1) return module->addr_sorttab[idx];
 
-    return module->addr_sorttab[low];
+    /* pick the closest one, or the best one if both runs have a symbol at that address */
+    symt_get_address(&module->addr_sorttab[idx]->symt, &ref_addr);
+    symt_get_address(&module->addr_sorttab[idx_recent]->symt, &recent_addr);
+    if (recent_addr > ref_addr ||
+        (recent_addr == ref_addr && module->addr_sorttab[idx]->symt.tag == SymTagPublicSymbol))
+        idx = idx_recent;
+    return module->addr_sorttab[idx];
 }
 
 static BOOL symt_enum_locals_helper(struct module_pair* pair,
@@ -986,6 +1189,7 @@ static BOOL symt_enum_locals(struct process* pcs, const WCHAR* mask,
     pair.pcs = pcs;
     pair.requested = module_find_by_addr(pair.pcs, pc, DMT_UNKNOWN);
     if (!module_get_debug(&pair)) return FALSE;
+    module_load_debug_at(pair.effective, pc);
     if ((sym = symt_find_nearest(pair.effective, pc)) == NULL) return FALSE;
 
     if (sym->symt.tag == SymTagFunction)
@@ -1246,6 +1450,7 @@ BOOL WINAPI SymFromAddr(HANDLE hProcess, DWORD64 Address,
     if (!pair.pcs) return FALSE;
     pair.requested = module_find_by_addr(pair.pcs, Address, DMT_UNKNOWN);
     if (!module_get_debug(&pair)) return FALSE;
+    module_load_debug_at(pair.effective, Address);
     if ((sym = symt_find_nearest(pair.effective, Address)) == NULL) return FALSE;
 
     symt_fill_sym_info(&pair, NULL, &sym->symt, Symbol);
@@ -1346,6 +1551,7 @@ static BOOL find_name(struct process* pcs, struct module* module, const char* na
     pair.pcs = pcs;
     if (!(pair.requested = module)) return FALSE;
     if (!module_get_debug(&pair)) return FALSE;
+    module_load_debug_name(pair.effective, name);
 
     hash_table_iter_init(&pair.effective->ht_symbols, &hti, name);
     while ((ptr = hash_table_iter_up(&hti)))
@@ -1617,6 +1823,7 @@ BOOL WINAPI SymGetLineFromAddr64(HANDLE hProcess, DWORD64 dwAddr,
     if (!pair.pcs) return FALSE;
     pair.requested = module_find_by_addr(pair.pcs, dwAddr, DMT_UNKNOWN);
     if (!module_get_debug(&pair)) return FALSE;
+    module_load_debug_at(pair.effective, dwAddr);
     if ((symt = symt_find_nearest(pair.effective, dwAddr)) == NULL) return FALSE;
 
     if (symt->symt.tag != SymTagFunction) return FALSE;
@@ -2121,6 +2328,7 @@ BOOL WINAPI SymAddSymbolW(HANDLE hProcess, ULONG64 BaseOfDll, PCWSTR name,
                           DWORD64 addr, DWORD size, DWORD flags)
 {
     struct module_pair  pair;
+    char                nameA[MAX_SYM_NAME];
 
     TRACE("(%p %s %s %u)\n", hProcess, wine_dbgstr_w(name), wine_dbgstr_longlong(addr), size);
 
@@ -2129,8 +2337,9 @@ BOOL WINAPI SymAddSymbolW(HANDLE hProcess, ULONG64 BaseOfDll, PCWSTR name,
     pair.requested = module_find_by_addr(pair.pcs, BaseOfDll, DMT_UNKNOWN);
     if (!module_get_debug(&pair)) return FALSE;
 
-    SetLastError(ERROR_CALL_NOT_IMPLEMENTED);
-    return FALSE;
+    if (flags) FIXME("Unsupported flags %x\n", flags);
+    WideCharToMultiByte(CP_ACP, 0, name, -1, nameA, sizeof(nameA), NULL, NULL);
+    return symt_new_public(pair.effective, NULL, nameA, FALSE, addr, size) != NULL;
 }
 
 /******************************************************************
@@ -2170,6 +2379,7 @@ BOOL WINAPI SymEnumLines(HANDLE hProcess, ULONG64 base, PCSTR compiland,
     if (compiland) FIXME("Unsupported yet (filtering on compiland %s)\n", compiland);
     pair.requested = module_find_by_addr(pair.pcs, base, DMT_UNKNOWN);
     if (!module_get_debug(&pair)) return FALSE;
+    module_load_debug_name(pair.effective, NULL);
     if (!(srcmask = file_regex(srcfile))) return FALSE;
 
     sci.SizeOfStruct = sizeof(sci);
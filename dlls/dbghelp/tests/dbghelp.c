@@ -16,6 +16,7 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
  */
 
+#include <stdio.h>
 #include "windef.h"
 #include "verrsrc.h"
 #include "dbghelp.h"
@@ -132,12 +133,153 @@ static void test_stack_walk(void)
 
 #endif /* __i386__ || __x86_64__ */
 
+static BOOL CALLBACK count_symbols_cb(SYMBOL_INFO *info, ULONG size, void *user)
+{
+    (*(unsigned int *)user)++;
+    return TRUE;
+}
+
+static double elapsed_ms(LARGE_INTEGER start, LARGE_INTEGER end, LARGE_INTEGER freq)
+{
+    return (double)(end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart;
+}
+
+static void test_symbol_index(void)
+{
+    static const unsigned int count = 100000;
+    char si_buf[sizeof(SYMBOL_INFO) + 64], name[32];
+    SYMBOL_INFO *si = (SYMBOL_INFO *)si_buf;
+    LARGE_INTEGER freq, start, end;
+    unsigned int i, n, found, errors = 0;
+    DWORD64 base, disp;
+    void *region;
+    BOOL ret;
+
+    /* reserve the range so that it can't overlap a real module */
+    region = VirtualAlloc(NULL, count * 16, MEM_RESERVE, PAGE_NOACCESS);
+    ok(region != NULL, "VirtualAlloc failed\n");
+    base = (DWORD_PTR)region;
+    ret = !!SymLoadModuleEx(GetCurrentProcess(), NULL, "synthetic", NULL, base, count * 16, NULL, SLMFLAG_VIRTUAL);
+    ok(ret, "SymLoadModuleEx failed, error %u\n", GetLastError());
+
+    si->SizeOfStruct = sizeof(*si);
+    si->MaxNameLen = sizeof(si_buf) - sizeof(*si);
+    QueryPerformanceFrequency(&freq);
+
+    /* add the symbols in a scattered order, interleaving lookups with the additions */
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < count; i++)
+    {
+        n = ((ULONGLONG)i * 7919) % count;
+        sprintf(name, "sym_%06x", n);
+        ret = SymAddSymbol(GetCurrentProcess(), base, name, base + n * 16, 16, 0);
+        if (!ret)
+        {
+            ok(0, "SymAddSymbol failed, error %u\n", GetLastError());
+            break;
+        }
+        if (i % 100 == 99)
+        {
+            ret = SymFromAddr(GetCurrentProcess(), base + n * 16 + 3, &disp, si);
+            if (!ret || strcmp(si->Name, name) || disp != 3) errors++;
+        }
+    }
+    QueryPerformanceCounter(&end);
+    ok(!errors, "got %u errors while adding symbols\n", errors);
+    trace("added %u symbols with %u lookups in %.1f ms\n", count, count / 100, elapsed_ms(start, end, freq));
+
+    QueryPerformanceCounter(&start);
+    for (i = errors = 0; i < count; i++)
+    {
+        n = ((ULONGLONG)i * 48271) % count;
+        ret = SymFromAddr(GetCurrentProcess(), base + n * 16 + i % 16, &disp, si);
+        if (!ret || si->Address != base + n * 16 || disp != i % 16) errors++;
+    }
+    QueryPerformanceCounter(&end);
+    ok(!errors, "got %u lookup errors\n", errors);
+    trace("symbolized %u addresses in %.1f ms\n", count, elapsed_ms(start, end, freq));
+
+    found = 0;
+    QueryPerformanceCounter(&start);
+    ret = SymEnumSymbols(GetCurrentProcess(), base, "SYM_0001*", count_symbols_cb, &found);
+    QueryPerformanceCounter(&end);
+    ok(ret, "SymEnumSymbols failed, error %u\n", GetLastError());
+    ok(found == 0x100, "found %u symbols\n", found);
+    trace("enumerated by prefix in %.3f ms\n", elapsed_ms(start, end, freq));
+
+    found = 0;
+    ret = SymEnumSymbols(GetCurrentProcess(), base, "*_00abc?", count_symbols_cb, &found);
+    ok(ret, "SymEnumSymbols failed, error %u\n", GetLastError());
+    ok(found == 0x10, "found %u symbols\n", found);
+
+    ret = SymFromName(GetCurrentProcess(), "synthetic!sym_00abcd", si);
+    ok(ret, "SymFromName failed, error %u\n", GetLastError());
+    if (ret) ok(si->Address == base + 0xabcd * 16, "got address %s\n", wine_dbgstr_longlong(si->Address));
+
+    ret = SymUnloadModule64(GetCurrentProcess(), base);
+    ok(ret, "SymUnloadModule64 failed, error %u\n", GetLastError());
+    VirtualFree(region, 0, MEM_RELEASE);
+}
+
+static void test_lazy_dwarf(void)
+{
+    char si_buf[sizeof(SYMBOL_INFO) + 64];
+    SYMBOL_INFO *si = (SYMBOL_INFO *)si_buf;
+    IMAGEHLP_LINE64 line, ref_line;
+    DWORD64 addr = (DWORD_PTR)test_lazy_dwarf;
+    DWORD disp;
+    BOOL ret;
+
+    memset(&ref_line, 0, sizeof(ref_line));
+    ref_line.SizeOfStruct = sizeof(ref_line);
+    if (!SymGetLineFromAddr64(GetCurrentProcess(), addr, &disp, &ref_line))
+    {
+        skip("no line information for the test module\n");
+        return;
+    }
+
+    /* reload the modules with DWARF units only parsed on demand */
+    ret = SymCleanup(GetCurrentProcess());
+    ok(ret, "got error %u\n", GetLastError());
+    SymSetExtendedOption(SYMOPT_EX_WINE_LAZY_DWARF, TRUE);
+    ret = SymInitialize(GetCurrentProcess(), NULL, TRUE);
+    ok(ret, "got error %u\n", GetLastError());
+
+    memset(&line, 0, sizeof(line));
+    line.SizeOfStruct = sizeof(line);
+    ret = SymGetLineFromAddr64(GetCurrentProcess(), addr, &disp, &line);
+    ok(ret, "SymGetLineFromAddr64 failed, error %u\n", GetLastError());
+    if (ret)
+    {
+        ok(line.LineNumber == ref_line.LineNumber, "got line %u, expected %u\n",
+           line.LineNumber, ref_line.LineNumber);
+        ok(!strcmp(line.FileName, ref_line.FileName), "got file %s, expected %s\n",
+           line.FileName, ref_line.FileName);
+    }
+
+    si->SizeOfStruct = sizeof(*si);
+    si->MaxNameLen = sizeof(si_buf) - sizeof(*si);
+    ret = SymFromName(GetCurrentProcess(), "test_symbol_index", si);
+    ok(ret, "SymFromName failed, error %u\n", GetLastError());
+    if (ret)
+        ok(si->Address == (DWORD_PTR)test_symbol_index, "got address %s\n", wine_dbgstr_longlong(si->Address));
+
+    ret = SymCleanup(GetCurrentProcess());
+    ok(ret, "got error %u\n", GetLastError());
+    SymSetExtendedOption(SYMOPT_EX_WINE_LAZY_DWARF, FALSE);
+    ret = SymInitialize(GetCurrentProcess(), NULL, TRUE);
+    ok(ret, "got error %u\n", GetLastError());
+}
+
 START_TEST(dbghelp)
 {
     BOOL ret = SymInitialize(GetCurrentProcess(), NULL, TRUE);
     ok(ret, "got error %u\n", GetLastError());
 
     test_stack_walk();
+    test_symbol_index();
+    if (!strcmp(winetest_platform, "wine"))
+        test_lazy_dwarf();
 
     ret = SymCleanup(GetCurrentProcess());
     ok(ret, "got error %u\n", GetLastError());
@@ -18688,6 +18688,78 @@ static void run_for_each_device_type(void (*test_func)(const GUID *))
     test_func(&IID_IDirect3DRGBDevice);
 }
 
+static void test_cs_throughput(void)
+{
+    static const unsigned int blt_count = 20000, lock_count = 500;
+    IDirectDrawSurface7 *surface;
+    LARGE_INTEGER freq, start, end;
+    DDSURFACEDESC2 surface_desc;
+    IDirectDraw7 *ddraw;
+    unsigned int i;
+    ULONG refcount;
+    double elapsed;
+    DDBLTFX fx;
+    HRESULT hr;
+
+    /* Colour fills and locks of an offscreen surface go through the wined3d
+     * command stream but don't need a 3D device, so this also works with
+     * the "no3d" renderer. */
+    ddraw = create_ddraw();
+    ok(!!ddraw, "Failed to create a ddraw object.\n");
+    hr = IDirectDraw7_SetCooperativeLevel(ddraw, NULL, DDSCL_NORMAL);
+    ok(SUCCEEDED(hr), "Failed to set cooperative level, hr %#x.\n", hr);
+
+    memset(&surface_desc, 0, sizeof(surface_desc));
+    surface_desc.dwSize = sizeof(surface_desc);
+    surface_desc.dwFlags = DDSD_CAPS | DDSD_WIDTH | DDSD_HEIGHT;
+    surface_desc.ddsCaps.dwCaps = DDSCAPS_OFFSCREENPLAIN;
+    surface_desc.dwWidth = 16;
+    surface_desc.dwHeight = 16;
+    hr = IDirectDraw7_CreateSurface(ddraw, &surface_desc, &surface, NULL);
+    ok(SUCCEEDED(hr), "Failed to create surface, hr %#x.\n", hr);
+
+    QueryPerformanceFrequency(&freq);
+
+    memset(&fx, 0, sizeof(fx));
+    fx.dwSize = sizeof(fx);
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < blt_count; ++i)
+    {
+        U5(fx).dwFillColor = i;
+        hr = IDirectDrawSurface7_Blt(surface, NULL, NULL, NULL, DDBLT_COLORFILL | DDBLT_WAIT, &fx);
+        if (FAILED(hr))
+            break;
+    }
+    ok(SUCCEEDED(hr), "Failed to fill surface, hr %#x.\n", hr);
+    QueryPerformanceCounter(&end);
+    elapsed = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+    trace("%u colour fills in %.3f s, %.0f ops/s, %.2f us per submit.\n",
+            i, elapsed, i / elapsed, elapsed * 1000000.0 / i);
+
+    /* Each lock has to wait for the command stream to catch up. */
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < lock_count; ++i)
+    {
+        U5(fx).dwFillColor = i;
+        hr = IDirectDrawSurface7_Blt(surface, NULL, NULL, NULL, DDBLT_COLORFILL | DDBLT_WAIT, &fx);
+        ok(SUCCEEDED(hr), "Failed to fill surface, hr %#x.\n", hr);
+        hr = IDirectDrawSurface7_Lock(surface, NULL, &surface_desc, DDLOCK_READONLY | DDLOCK_WAIT, NULL);
+        ok(SUCCEEDED(hr), "Failed to lock surface, hr %#x.\n", hr);
+        if (FAILED(hr))
+            break;
+        hr = IDirectDrawSurface7_Unlock(surface, NULL);
+        ok(SUCCEEDED(hr), "Failed to unlock surface, hr %#x.\n", hr);
+    }
+    QueryPerformanceCounter(&end);
+    elapsed = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+    trace("%u fill + lock round trips in %.3f s, %.2f us each.\n",
+            i, elapsed, elapsed * 1000000.0 / max(i, 1));
+
+    IDirectDrawSurface7_Release(surface);
+    refcount = IDirectDraw7_Release(ddraw);
+    ok(!refcount, "Got unexpected refcount %u.\n", refcount);
+}
+
 START_TEST(ddraw7)
 {
     DDDEVICEIDENTIFIER2 identifier;
@@ -18859,4 +18931,5 @@ START_TEST(ddraw7)
     test_window_position();
     test_get_display_mode();
     run_for_each_device_type(test_texture_wrong_caps);
+    test_cs_throughput();
 }
@@ -329,6 +329,28 @@ void mixieee32(float *src, float *dst, unsigned samples)
         *(dst++) += *(src++);
 }
 
+/* Same as mixieee32, applying a per channel volume on the fly.
+ * The volumes are expanded to a block of 4 frames, so that the inner loop
+ * runs on contiguous samples with a fixed pattern and can be vectorized.
+ */
+void mixieee32_vol(const float *src, float *dst, unsigned frames, unsigned channels, const float *vols)
+{
+    float pattern[4 * DS_MAX_CHANNELS];
+    unsigned i, block = 4 * channels;
+
+    TRACE("%p - %p %u %u\n", src, dst, frames, channels);
+
+    for (i = 0; i < block; i++)
+        pattern[i] = vols[i % channels];
+
+    for (; frames >= 4; frames -= 4, src += block, dst += block)
+        for (i = 0; i < block; i++)
+            dst[i] += src[i] * pattern[i];
+
+    for (i = 0; i < frames * channels; i++)
+        dst[i] += src[i] * pattern[i];
+}
+
 static void norm8(float *src, unsigned char *dst, unsigned samples)
 {
     TRACE("%p - %p %d\n", src, dst, samples);
@@ -295,6 +295,25 @@ static UINT cp_fields_noresample(IDirectSoundBufferImpl *dsb, UINT count)
     return count;
 }
 
+/**
+ * Dot product of the interpolated FIR with the input samples.
+ * Four partial sums are kept, so that the compiler can map them to vector
+ * registers without having to reorder the floating point additions itself.
+ */
+static inline float fir_dot(const float *coefs, const float *samples, int count)
+{
+    float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    int j, k;
+
+    for (j = 0; j + 4 <= count; j += 4)
+        for (k = 0; k < 4; k++)
+            sum[k] += coefs[j + k] * samples[j + k];
+    for (; j < count; j++)
+        sum[0] += coefs[j] * samples[j];
+
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
 static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *freqAccNum)
 {
     UINT i, channel;
@@ -344,22 +363,19 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
 
         UINT idx = (ipos + 1) * dsbfirstep - int_fir_steps - 1;
         float rem = int_fir_steps + 1.0 - total_fir_steps;
+        float rem_inv = 1.0f - rem;
 
         int fir_used = 0;
         while (idx < fir_len - 1) {
-            fir_copy[fir_used++] = fir[idx] * (1.0 - rem) + fir[idx + 1] * rem;
-            idx += dsb->firstep;
+            fir_copy[fir_used++] = fir[idx] * rem_inv + fir[idx + 1] * rem;
+            idx += dsbfirstep;
         }
 
         assert(fir_used <= fir_cachesize);
         assert(ipos + fir_used <= required_input);
 
-        for (channel = 0; channel < dsb->mix_channels; channel++) {
-            int j;
-            float sum = 0.0;
-            float* cache = &intermediate[channel * required_input + ipos];
-            for (j = 0; j < fir_used; j++)
-                sum += fir_copy[j] * cache[j];
+        for (channel = 0; channel < channels; channel++) {
+            float sum = fir_dot(fir_copy, &intermediate[channel * required_input + ipos], fir_used);
             dsb->put(dsb, i * ostride, channel, sum * dsb->firgain);
         }
     }
@@ -451,35 +467,32 @@ static void DSOUND_MixToTemporary(IDirectSoundBufferImpl *dsb, DWORD frames)
 	}
 }
 
-static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
+/**
+ * Get the per channel volumes to apply to the buffer while mixing it.
+ * Returns FALSE when the buffer is mixed at full volume.
+ */
+static BOOL DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, float *vols)
 {
-	INT	i;
-	float vols[DS_MAX_CHANNELS];
-	UINT channels = dsb->device->pwfx->nChannels, chan;
+	UINT channels = dsb->device->pwfx->nChannels, i;
 
-	TRACE("(%p,%d)\n",dsb,frames);
+	TRACE("(%p)\n",dsb);
 	TRACE("left = %x, right = %x\n", dsb->volpan.dwTotalAmpFactor[0],
 		dsb->volpan.dwTotalAmpFactor[1]);
 
 	if ((!(dsb->dsbd.dwFlags & DSBCAPS_CTRLPAN) || (dsb->volpan.lPan == 0)) &&
 	    (!(dsb->dsbd.dwFlags & DSBCAPS_CTRLVOLUME) || (dsb->volpan.lVolume == 0)) &&
 	     !(dsb->dsbd.dwFlags & DSBCAPS_CTRL3D))
-		return; /* Nothing to do */
+		return FALSE; /* Nothing to do */
 
 	if (channels > DS_MAX_CHANNELS)
 	{
 		FIXME("There is no support for %u channels\n", channels);
-		return;
+		return FALSE;
 	}
 
 	for (i = 0; i < channels; ++i)
 		vols[i] = dsb->volpan.dwTotalAmpFactor[i] / ((float)0xFFFF);
-
-	for(i = 0; i < frames; ++i){
-		for(chan = 0; chan < channels; ++chan){
-			dsb->device->tmp_buffer[i * channels + chan] *= vols[chan];
-		}
-	}
+	return TRUE;
 }
 
 /**
@@ -497,6 +510,8 @@ static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
 static DWORD DSOUND_MixInBuffer(IDirectSoundBufferImpl *dsb, float *mix_buffer, DWORD frames)
 {
 	float *ibuf;
+	float vols[DS_MAX_CHANNELS];
+	UINT channels = dsb->device->pwfx->nChannels;
 	DWORD oldpos;
 
 	TRACE("sec_mixpos=%d/%d\n", dsb->sec_mixpos, dsb->buflen);
@@ -507,10 +522,11 @@ static DWORD DSOUND_MixInBuffer(IDirectSoundBufferImpl *dsb, float *mix_buffer,
 	DSOUND_MixToTemporary(dsb, frames);
 	ibuf = dsb->device->tmp_buffer;
 
-	/* Apply volume if needed */
-	DSOUND_MixerVol(dsb, frames);
-
-	mixieee32(ibuf, mix_buffer, frames * dsb->device->pwfx->nChannels);
+	/* Apply volume if needed, while accumulating into the mix buffer */
+	if (DSOUND_MixerVol(dsb, vols))
+		mixieee32_vol(ibuf, mix_buffer, frames, channels, vols);
+	else
+		mixieee32(ibuf, mix_buffer, frames * channels);
 
 	/* check for notification positions */
 	if (dsb->dsbd.dwFlags & DSBCAPS_CTRLPOSITIONNOTIFY &&
@@ -657,7 +673,7 @@ static void DSOUND_WaveQueue(DirectSoundDevice *device, LPBYTE pos, DWORD bytes)
  *
  * secondary->buffer (secondary format)
  *   =[Resample]=> device->tmp_buffer (float format)
- *   =[Volume]=> device->tmp_buffer (float format)
+ *   =[Volume, Mix]=> device->buffer (float format)
  *   =[Reformat]=> device->buffer (device format, skipped on float)
  */
 static void DSOUND_PerformMix(DirectSoundDevice *device)
@@ -29,6 +29,7 @@
 #define NONAMELESSUNION
 #include <windows.h>
 #include <stdio.h>
+#include <math.h>
 
 #include "wine/test.h"
 #include "mmsystem.h"
@@ -1231,6 +1232,9 @@ static BOOL testdmo_input_type_set, testdmo_output_type_set;
 static unsigned int got_Discontinuity;
 static HANDLE got_Process;
 
+/* When set, the test DMO accepts any format and passes the processed data on. */
+static void (*testdmo_process_hook)(BYTE *data, ULONG size);
+
 static HRESULT WINAPI dmo_QueryInterface(IMediaObject *iface, REFIID iid, void **out)
 {
     if (winetest_debug > 1) trace("QueryInterface(%s)\n", wine_dbgstr_guid(iid));
@@ -1292,6 +1296,9 @@ static HRESULT WINAPI dmo_SetInputType(IMediaObject *iface, DWORD index, const D
 
     if (winetest_debug > 1) trace("SetInputType()\n");
 
+    if (testdmo_process_hook)
+        return S_OK;
+
     ok(!index, "Got unexpected index %u.\n", index);
     ok(!flags, "Got unexpected flags %#x.\n", flags);
 
@@ -1318,6 +1325,9 @@ static HRESULT WINAPI dmo_SetOutputType(IMediaObject *iface, DWORD index, const
 {
     if (winetest_debug > 1) trace("SetOutputType()\n");
 
+    if (testdmo_process_hook)
+        return S_OK;
+
     ok(!index, "Got unexpected index %u.\n", index);
     ok(!flags, "Got unexpected flags %#x.\n", flags);
 
@@ -1477,7 +1487,10 @@ static HRESULT WINAPI dmo_inplace_Process(IMediaObjectInPlace *iface, ULONG size
     ok(!start, "Got start time %s.\n", wine_dbgstr_longlong(start));
     ok(!flags, "Got flags %#x.\n", flags);
 
-    SetEvent(got_Process);
+    if (testdmo_process_hook)
+        testdmo_process_hook(data, size);
+    else
+        SetEvent(got_Process);
 
     return S_FALSE;
 }
@@ -1882,6 +1895,236 @@ static void test_AcquireResources(void)
     IDirectSound_Release(dsound);
 }
 
+static float resampled[256];
+static unsigned int resampled_count;
+static HANDLE resampled_event;
+
+static void capture_resampled(BYTE *data, ULONG size)
+{
+    if (!WaitForSingleObject(resampled_event, 0))
+        return;
+
+    size = min(size, sizeof(resampled));
+    memcpy(resampled, data, size);
+    resampled_count = size / sizeof(float);
+    SetEvent(resampled_event);
+}
+
+static void test_resampler_output(void)
+{
+    DSBUFFERDESC buffer_desc = {.dwSize = sizeof(buffer_desc)};
+    DSEFFECTDESC effect = {.dwSize = sizeof(effect)};
+    IDirectSoundBuffer8 *buffer8;
+    IDirectSoundBuffer *buffer;
+    IDirectSound8 *dsound;
+    DWORD size1, size2, result;
+    void *ptr1, *ptr2;
+    WAVEFORMATEX wfx;
+    unsigned int i;
+    HRESULT hr;
+
+    /* Wine hands the effects the resampled float data, in the device layout. */
+    if (strcmp(winetest_platform, "wine"))
+    {
+        skip("Resampled data layout is Wine specific.\n");
+        return;
+    }
+
+    hr = DirectSoundCreate8(NULL, &dsound, NULL);
+    ok(hr == DS_OK || hr == DSERR_NODRIVER, "Got hr %#x.\n", hr);
+    if (FAILED(hr))
+        return;
+
+    hr = IDirectSound8_SetCooperativeLevel(dsound, get_hwnd(), DSSCL_PRIORITY);
+    ok(hr == DS_OK, "Got hr %#x.\n", hr);
+
+    init_format(&wfx, WAVE_FORMAT_PCM, 11025, 8, 1);
+    buffer_desc.dwFlags = DSBCAPS_CTRLFX | DSBCAPS_CTRLVOLUME | DSBCAPS_GLOBALFOCUS;
+    buffer_desc.dwBufferBytes = align(wfx.nAvgBytesPerSec / 4, wfx.nBlockAlign);
+    buffer_desc.lpwfxFormat = &wfx;
+    hr = IDirectSound8_CreateSoundBuffer(dsound, &buffer_desc, &buffer, NULL);
+    ok(hr == DS_OK, "Got hr %#x.\n", hr);
+    hr = IDirectSoundBuffer_QueryInterface(buffer, &IID_IDirectSoundBuffer8, (void **)&buffer8);
+    ok(hr == DS_OK, "Got hr %#x.\n", hr);
+
+    /* a constant signal must go through the FIR with unity gain */
+    hr = IDirectSoundBuffer8_Lock(buffer8, 0, 0, &ptr1, &size1, &ptr2, &size2, DSBLOCK_ENTIREBUFFER);
+    ok(hr == DS_OK, "Got hr %#x.\n", hr);
+    memset(ptr1, 0xc0, size1);
+    hr = IDirectSoundBuffer8_Unlock(buffer8, ptr1, size1, ptr2, size2);
+    ok(hr == DS_OK, "Got hr %#x.\n", hr);
+
+    /* the volume is applied after the effects, it must not show up here */
+    hr = IDirectSoundBuffer8_SetVolume(buffer8, -600);
+    ok(hr == DS_OK, "Got hr %#x.\n", hr);
+
+    resampled_event = CreateEventA(NULL, TRUE, FALSE, NULL);
+    testdmo_process_hook = capture_resampled;
+
+    effect.guidDSFXClass = testdmo_clsid;
+    hr = IDirectSoundBuffer8_SetFX(buffer8, 1, &effect, &result);
+    ok(hr == DS_OK, "Got hr %#x.\n", hr);
+
+    hr = IDirectSoundBuffer8_Play(buffer8, 0, 0, DSBPLAY_LOOPING);
+    ok(hr == DS_OK, "Got hr %#x.\n", hr);
+    ok(!WaitForSingleObject(resampled_event, 1000), "Wait timed out.\n");
+    hr = IDirectSoundBuffer8_Stop(buffer8);
+    ok(hr == DS_OK, "Got hr %#x.\n", hr);
+
+    ok(resampled_count, "Got no resampled data.\n");
+    for (i = 0; i < resampled_count; i++)
+        if (fabs(resampled[i] - 0.5f) > 0.01f) break;
+    ok(i == resampled_count, "Got sample %u: %.8e.\n", i, i < resampled_count ? resampled[i] : 0.0f);
+
+    testdmo_process_hook = NULL;
+    CloseHandle(resampled_event);
+    IDirectSoundBuffer8_Release(buffer8);
+    IDirectSoundBuffer_Release(buffer);
+    IDirectSound8_Release(dsound);
+}
+
+static struct
+{
+    HANDLE done;
+    BOOL started, finished;
+    ULONGLONG cpu_start, cpu_end;
+    DWORD tick_start, tick_end;
+} mixer_probe;
+
+static ULONGLONG get_thread_cpu_time(void)
+{
+    FILETIME create_time, exit_time, kernel_time, user_time;
+
+    GetThreadTimes(GetCurrentThread(), &create_time, &exit_time, &kernel_time, &user_time);
+    return (((ULONGLONG)kernel_time.dwHighDateTime << 32) | kernel_time.dwLowDateTime) +
+           (((ULONGLONG)user_time.dwHighDateTime << 32) | user_time.dwLowDateTime);
+}
+
+/* Called on the mixer thread once per mixing period, after all the buffers
+ * played before the probe have been mixed. */
+static void mixer_probe_process(BYTE *data, ULONG size)
+{
+    if (mixer_probe.finished)
+        return;
+
+    if (!mixer_probe.started)
+    {
+        mixer_probe.cpu_start = get_thread_cpu_time();
+        mixer_probe.tick_start = GetTickCount();
+        mixer_probe.started = TRUE;
+    }
+    else if (GetTickCount() - mixer_probe.tick_start >= 500)
+    {
+        mixer_probe.cpu_end = get_thread_cpu_time();
+        mixer_probe.tick_end = GetTickCount();
+        mixer_probe.finished = TRUE;
+        SetEvent(mixer_probe.done);
+    }
+}
+
+static void test_mixer_benchmark(void)
+{
+    DSBUFFERDESC buffer_desc = {.dwSize = sizeof(buffer_desc)};
+    DSEFFECTDESC effect = {.dwSize = sizeof(effect)};
+    IDirectSoundBuffer *buffers[64], *probe;
+    IDirectSoundBuffer8 *probe8;
+    IDirectSound8 *dsound;
+    DWORD size1, size2, elapsed, count, result, i, j;
+    void *ptr1, *ptr2;
+    WAVEFORMATEX wfx;
+    HRESULT hr;
+
+    hr = DirectSoundCreate8(NULL, &dsound, NULL);
+    ok(hr == DS_OK || hr == DSERR_NODRIVER, "Got hr %#x.\n", hr);
+    if (FAILED(hr))
+        return;
+
+    hr = IDirectSound8_SetCooperativeLevel(dsound, get_hwnd(), DSSCL_PRIORITY);
+    ok(hr == DS_OK, "Got hr %#x.\n", hr);
+
+    /* not at the device rate, so that all the buffers go through the resampler */
+    init_format(&wfx, WAVE_FORMAT_PCM, 22050, 16, 2);
+    buffer_desc.dwFlags = DSBCAPS_CTRLVOLUME | DSBCAPS_CTRLPAN | DSBCAPS_GLOBALFOCUS;
+    buffer_desc.dwBufferBytes = wfx.nAvgBytesPerSec;
+    buffer_desc.lpwfxFormat = &wfx;
+
+    for (count = 0; count < ARRAY_SIZE(buffers); count++)
+    {
+        hr = IDirectSound8_CreateSoundBuffer(dsound, &buffer_desc, &buffers[count], NULL);
+        ok(hr == DS_OK, "Got hr %#x.\n", hr);
+        if (FAILED(hr))
+            break;
+
+        hr = IDirectSoundBuffer_Lock(buffers[count], 0, 0, &ptr1, &size1, &ptr2, &size2, DSBLOCK_ENTIREBUFFER);
+        ok(hr == DS_OK, "Got hr %#x.\n", hr);
+        for (j = 0; j < size1 / sizeof(SHORT); j++)
+            ((SHORT *)ptr1)[j] = (SHORT)(j * (count + 1) * 64);
+        hr = IDirectSoundBuffer_Unlock(buffers[count], ptr1, size1, ptr2, size2);
+        ok(hr == DS_OK, "Got hr %#x.\n", hr);
+
+        hr = IDirectSoundBuffer_SetVolume(buffers[count], -600);
+        ok(hr == DS_OK, "Got hr %#x.\n", hr);
+        hr = IDirectSoundBuffer_SetPan(buffers[count], ((LONG)(count % 5) - 2) * 1000);
+        ok(hr == DS_OK, "Got hr %#x.\n", hr);
+    }
+
+    /* A silent buffer with the test DMO as effect. Its Process() method runs
+     * on the mixer thread, which lets us measure the CPU time of that thread
+     * alone instead of the whole process. */
+    init_format(&wfx, WAVE_FORMAT_PCM, 11025, 8, 1);
+    buffer_desc.dwFlags = DSBCAPS_CTRLFX | DSBCAPS_GLOBALFOCUS;
+    buffer_desc.dwBufferBytes = align(wfx.nAvgBytesPerSec / 4, wfx.nBlockAlign);
+    hr = IDirectSound8_CreateSoundBuffer(dsound, &buffer_desc, &probe, NULL);
+    ok(hr == DS_OK, "Got hr %#x.\n", hr);
+    hr = IDirectSoundBuffer_QueryInterface(probe, &IID_IDirectSoundBuffer8, (void **)&probe8);
+    ok(hr == DS_OK, "Got hr %#x.\n", hr);
+
+    hr = IDirectSoundBuffer8_Lock(probe8, 0, 0, &ptr1, &size1, &ptr2, &size2, DSBLOCK_ENTIREBUFFER);
+    ok(hr == DS_OK, "Got hr %#x.\n", hr);
+    memset(ptr1, 0x80, size1);
+    hr = IDirectSoundBuffer8_Unlock(probe8, ptr1, size1, ptr2, size2);
+    ok(hr == DS_OK, "Got hr %#x.\n", hr);
+
+    memset(&mixer_probe, 0, sizeof(mixer_probe));
+    mixer_probe.done = CreateEventA(NULL, TRUE, FALSE, NULL);
+    testdmo_process_hook = mixer_probe_process;
+
+    effect.guidDSFXClass = testdmo_clsid;
+    hr = IDirectSoundBuffer8_SetFX(probe8, 1, &effect, &result);
+    ok(hr == DS_OK, "Got hr %#x.\n", hr);
+
+    for (i = 0; i < count; i++)
+    {
+        hr = IDirectSoundBuffer_Play(buffers[i], 0, 0, DSBPLAY_LOOPING);
+        ok(hr == DS_OK, "Got hr %#x.\n", hr);
+    }
+    hr = IDirectSoundBuffer8_Play(probe8, 0, 0, DSBPLAY_LOOPING);
+    ok(hr == DS_OK, "Got hr %#x.\n", hr);
+
+    ok(!WaitForSingleObject(mixer_probe.done, 5000), "Wait timed out.\n");
+    if (mixer_probe.finished)
+    {
+        elapsed = mixer_probe.tick_end - mixer_probe.tick_start;
+        trace("mixing %u buffers: %u ms of mixer thread CPU time per second of audio\n", count,
+              elapsed ? (DWORD)((mixer_probe.cpu_end - mixer_probe.cpu_start) / 10 / elapsed) : 0);
+    }
+
+    hr = IDirectSoundBuffer8_Stop(probe8);
+    ok(hr == DS_OK, "Got hr %#x.\n", hr);
+    for (i = 0; i < count; i++)
+    {
+        hr = IDirectSoundBuffer_Stop(buffers[i]);
+        ok(hr == DS_OK, "Got hr %#x.\n", hr);
+        IDirectSoundBuffer_Release(buffers[i]);
+    }
+
+    testdmo_process_hook = NULL;
+    CloseHandle(mixer_probe.done);
+    IDirectSoundBuffer8_Release(probe8);
+    IDirectSoundBuffer_Release(probe);
+    IDirectSound8_Release(dsound);
+}
+
 START_TEST(dsound8)
 {
     DWORD cookie;
@@ -1902,6 +2145,8 @@ START_TEST(dsound8)
     ok(hr == S_OK, "Failed to register class, hr %#x.\n", hr);
 
     test_effects();
+    test_resampler_output();
+    test_mixer_benchmark();
 
     CoRevokeClassObject(cookie);
 
@@ -22,6 +22,7 @@
 
 #include "gdi_private.h"
 #include "dibdrv.h"
+#include "winreg.h"
 
 #include "wine/debug.h"
 
@@ -1196,111 +1197,272 @@ static DWORD calc_1d_stretch_params( INT dst_start, INT dst_length, INT dst_vis_
 }
 
 
-DWORD stretch_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bitblt_coords *src,
-                          const BITMAPINFO *dst_info, void *dst_bits, struct bitblt_coords *dst,
-                          INT mode )
+#define MAX_BANDS        64
+#define BAND_MIN_ROWS    16
+#define BAND_MIN_PIXELS  (512 * 512)
+
+static int band_threads = -1;
+
+/* number of threads used for large stretches and conversions, 1 disables threading */
+static int get_band_threads(void)
 {
-    dib_info src_dib, dst_dib;
-    POINT dst_start, src_start, dst_end, src_end;
-    RECT rect;
-    BOOL hstretch, vstretch;
-    struct stretch_params v_params, h_params;
-    int err;
-    DWORD ret;
-    void (* row_fn)(const dib_info *dst_dib, const POINT *dst_start,
-                    const dib_info *src_dib, const POINT *src_start,
-                    const struct stretch_params *params, int mode, BOOL keep_dst);
+    SYSTEM_INFO info;
+    HKEY key;
+    DWORD type, value, size = sizeof(value);
 
-    TRACE("dst %d, %d - %d x %d visrect %s src %d, %d - %d x %d visrect %s\n",
-          dst->x, dst->y, dst->width, dst->height, wine_dbgstr_rect(&dst->visrect),
-          src->x, src->y, src->width, src->height, wine_dbgstr_rect(&src->visrect));
+    if (band_threads != -1) return band_threads;
 
-    init_dib_info_from_bitmapinfo( &src_dib, src_info, src_bits );
-    init_dib_info_from_bitmapinfo( &dst_dib, dst_info, dst_bits );
+    GetSystemInfo( &info );
+    value = info.dwNumberOfProcessors;
+    /* @@ Wine registry key: HKCU\Software\Wine\Gdi */
+    if (!RegOpenKeyW( HKEY_CURRENT_USER, L"Software\\Wine\\Gdi", &key ))
+    {
+        if (RegQueryValueExW( key, L"RenderThreads", NULL, &type, (BYTE *)&value, &size ) || type != REG_DWORD)
+            value = info.dwNumberOfProcessors;
+        RegCloseKey( key );
+    }
+    value = max( 1, min( value, MAX_BANDS ));
+    TRACE( "using %u threads\n", value );
+    return band_threads = value;
+}
 
-    /* v */
-    ret = calc_1d_stretch_params( dst->y, dst->height, dst->visrect.top, dst->visrect.bottom,
-                                  src->y, src->height, src->visrect.top, src->visrect.bottom,
-                                  &dst_start.y, &src_start.y, &dst_end.y, &src_end.y,
-                                  &v_params, &vstretch );
-    if (ret) return ret;
+/* number of row bands to split an operation on width x height pixels into */
+int get_band_count( int width, int height )
+{
+    int threads = get_band_threads();
 
-    /* h */
-    ret = calc_1d_stretch_params( dst->x, dst->width, dst->visrect.left, dst->visrect.right,
-                                  src->x, src->width, src->visrect.left, src->visrect.right,
-                                  &dst_start.x, &src_start.x, &dst_end.x, &src_end.x,
-                                  &h_params, &hstretch );
-    if (ret) return ret;
+    if (threads <= 1 || height < 2 * BAND_MIN_ROWS || (LONGLONG)width * height < BAND_MIN_PIXELS) return 1;
+    return min( min( threads * 2, MAX_BANDS ), height / BAND_MIN_ROWS );
+}
 
-    TRACE("got dst start %d, %d inc %d, %d. src start %d, %d inc %d, %d len %d x %d\n",
-          dst_start.x, dst_start.y, h_params.dst_inc, v_params.dst_inc,
-          src_start.x, src_start.y, h_params.src_inc, v_params.src_inc,
-          h_params.length, v_params.length);
+struct band_job
+{
+    LONG  next;
+    int   count;
+    void (*func)( void *context, int band );
+    void *context;
+};
 
-    get_bounding_rect( &rect, dst_start.x, dst_start.y, dst_end.x - dst_start.x, dst_end.y - dst_start.y );
-    intersect_rect( &dst->visrect, &dst->visrect, &rect );
+static void CALLBACK band_job_callback( TP_CALLBACK_INSTANCE *instance, void *context, TP_WORK *work )
+{
+    struct band_job *job = context;
+    int band;
 
-    dst_start.x -= dst->visrect.left;
-    dst_start.y -= dst->visrect.top;
+    while ((band = InterlockedIncrement( &job->next ) - 1) < job->count) job->func( job->context, band );
+}
+
+/* process the bands on the calling thread, helped by the thread pool when there are several */
+void run_bands( int count, void (*func)( void *context, int band ), void *context )
+{
+    struct band_job job = { 0, count, func, context };
+    TP_WORK *work = NULL;
+    int i, threads = min( count, get_band_threads() );
+
+    if (threads > 1 && (work = CreateThreadpoolWork( band_job_callback, &job, NULL )))
+        for (i = 1; i < threads; i++) SubmitThreadpoolWork( work );
+
+    band_job_callback( NULL, &job, NULL );
+
+    if (work)
+    {
+        /* all the bands have been taken, only wait for the ones still running */
+        WaitForThreadpoolWorkCallbacks( work, TRUE );
+        CloseThreadpoolWork( work );
+    }
+}
+
+struct stretch_band
+{
+    POINT        dst_start, src_start;
+    int          err;
+    unsigned int length;
+};
+
+struct stretch_job
+{
+    dib_info dst_dib, src_dib;
+    struct stretch_params v_params, h_params;
+    BOOL vstretch;
+    int mode;
+    int width;
+    void (* row_fn)(const dib_info *dst_dib, const POINT *dst_start,
+                    const dib_info *src_dib, const POINT *src_start,
+                    const struct stretch_params *params, int mode, BOOL keep_dst);
+    struct stretch_band bands[MAX_BANDS];
+};
 
-    err = v_params.err_start;
+/* Walk the vertical steps to find the state at the start of each band. Bands start on a
+ * new destination row, and stretching bands regenerate their first row instead of copying
+ * it from the previous band, so the output doesn't depend on the number of bands. */
+static int split_stretch_bands( struct stretch_job *job, POINT dst_start, POINT src_start, int count )
+{
+    const struct stretch_params *v_params = &job->v_params;
+    unsigned int i, next = 0, band_rows = (v_params->length + count - 1) / count;
+    int err = v_params->err_start, n = 0;
+    BOOL new_row = TRUE;
+
+    for (i = 0; i < v_params->length; i++)
+    {
+        if (i >= next && new_row)
+        {
+            job->bands[n].dst_start = dst_start;
+            job->bands[n].src_start = src_start;
+            job->bands[n].err       = err;
+            job->bands[n].length    = i;  /* converted below */
+            n++;
+            next = i + band_rows;
+        }
+
+        if (job->vstretch)
+        {
+            if (err > 0)
+            {
+                src_start.y += v_params->src_inc;
+                err += v_params->err_add_1;
+            }
+            else err += v_params->err_add_2;
+            dst_start.y += v_params->dst_inc;
+        }
+        else
+        {
+            new_row = err > 0;
+            if (err > 0)
+            {
+                dst_start.y += v_params->dst_inc;
+                err += v_params->err_add_1;
+            }
+            else err += v_params->err_add_2;
+            src_start.y += v_params->src_inc;
+        }
+    }
+
+    for (i = 0; i < n; i++)
+        job->bands[i].length = (i + 1 < n ? job->bands[i + 1].length : v_params->length) - job->bands[i].length;
+    return n;
+}
 
-    row_fn = hstretch ? dst_dib.funcs->stretch_row : dst_dib.funcs->shrink_row;
+static void stretch_band_rows( void *context, int band )
+{
+    struct stretch_job *job = context;
+    const struct stretch_params *v_params = &job->v_params;
+    POINT dst_start = job->bands[band].dst_start, src_start = job->bands[band].src_start;
+    unsigned int length = job->bands[band].length;
+    int err = job->bands[band].err;
 
-    if (vstretch)
+    if (job->vstretch)
     {
         BOOL need_row = TRUE;
         RECT last_row, this_row;
-        if (hstretch) mode = STRETCH_DELETESCANS;
         last_row.left = 0;
-        last_row.right = dst->visrect.right - dst->visrect.left;
+        last_row.right = job->width;
 
-        while (v_params.length--)
+        while (length--)
         {
             if (need_row)
             {
-                row_fn( &dst_dib, &dst_start, &src_dib, &src_start, &h_params, mode, FALSE );
+                job->row_fn( &job->dst_dib, &dst_start, &job->src_dib, &src_start, &job->h_params, job->mode, FALSE );
                 need_row = FALSE;
             }
             else
             {
-                last_row.top = dst_start.y - v_params.dst_inc;
+                last_row.top = dst_start.y - v_params->dst_inc;
                 last_row.bottom = last_row.top + 1;
                 this_row = last_row;
-                offset_rect( &this_row, 0, v_params.dst_inc );
-                copy_rect( &dst_dib, &this_row, &dst_dib, &last_row, NULL, R2_COPYPEN );
+                offset_rect( &this_row, 0, v_params->dst_inc );
+                copy_rect( &job->dst_dib, &this_row, &job->dst_dib, &last_row, NULL, R2_COPYPEN );
             }
 
             if (err > 0)
             {
-                src_start.y += v_params.src_inc;
+                src_start.y += v_params->src_inc;
                 need_row = TRUE;
-                err += v_params.err_add_1;
+                err += v_params->err_add_1;
             }
-            else err += v_params.err_add_2;
-            dst_start.y += v_params.dst_inc;
+            else err += v_params->err_add_2;
+            dst_start.y += v_params->dst_inc;
         }
     }
     else
     {
         int merged_rows = 0;
 
-        while (v_params.length--)
+        while (length--)
         {
-            if (mode != STRETCH_DELETESCANS || !merged_rows)
-                row_fn( &dst_dib, &dst_start, &src_dib, &src_start, &h_params, mode, merged_rows != 0 );
+            if (job->mode != STRETCH_DELETESCANS || !merged_rows)
+                job->row_fn( &job->dst_dib, &dst_start, &job->src_dib, &src_start, &job->h_params,
+                             job->mode, merged_rows != 0 );
             merged_rows++;
 
             if (err > 0)
             {
-                dst_start.y += v_params.dst_inc;
+                dst_start.y += v_params->dst_inc;
                 merged_rows = 0;
-                err += v_params.err_add_1;
+                err += v_params->err_add_1;
             }
-            else err += v_params.err_add_2;
-            src_start.y += v_params.src_inc;
+            else err += v_params->err_add_2;
+            src_start.y += v_params->src_inc;
         }
     }
+}
+
+DWORD stretch_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bitblt_coords *src,
+                          const BITMAPINFO *dst_info, void *dst_bits, struct bitblt_coords *dst,
+                          INT mode )
+{
+    struct stretch_job job;
+    POINT dst_start, src_start, dst_end, src_end;
+    RECT rect;
+    BOOL hstretch;
+    int count;
+    DWORD ret;
+
+    TRACE("dst %d, %d - %d x %d visrect %s src %d, %d - %d x %d visrect %s\n",
+          dst->x, dst->y, dst->width, dst->height, wine_dbgstr_rect(&dst->visrect),
+          src->x, src->y, src->width, src->height, wine_dbgstr_rect(&src->visrect));
+
+    init_dib_info_from_bitmapinfo( &job.src_dib, src_info, src_bits );
+    init_dib_info_from_bitmapinfo( &job.dst_dib, dst_info, dst_bits );
+
+    /* v */
+    ret = calc_1d_stretch_params( dst->y, dst->height, dst->visrect.top, dst->visrect.bottom,
+                                  src->y, src->height, src->visrect.top, src->visrect.bottom,
+                                  &dst_start.y, &src_start.y, &dst_end.y, &src_end.y,
+                                  &job.v_params, &job.vstretch );
+    if (ret) return ret;
+
+    /* h */
+    ret = calc_1d_stretch_params( dst->x, dst->width, dst->visrect.left, dst->visrect.right,
+                                  src->x, src->width, src->visrect.left, src->visrect.right,
+                                  &dst_start.x, &src_start.x, &dst_end.x, &src_end.x,
+                                  &job.h_params, &hstretch );
+    if (ret) return ret;
+
+    TRACE("got dst start %d, %d inc %d, %d. src start %d, %d inc %d, %d len %d x %d\n",
+          dst_start.x, dst_start.y, job.h_params.dst_inc, job.v_params.dst_inc,
+          src_start.x, src_start.y, job.h_params.src_inc, job.v_params.src_inc,
+          job.h_params.length, job.v_params.length);
+
+    get_bounding_rect( &rect, dst_start.x, dst_start.y, dst_end.x - dst_start.x, dst_end.y - dst_start.y );
+    intersect_rect( &dst->visrect, &dst->visrect, &rect );
+
+    dst_start.x -= dst->visrect.left;
+    dst_start.y -= dst->visrect.top;
+
+    job.row_fn = hstretch ? job.dst_dib.funcs->stretch_row : job.dst_dib.funcs->shrink_row;
+    job.mode = (job.vstretch && hstretch) ? STRETCH_DELETESCANS : mode;
+    job.width = dst->visrect.right - dst->visrect.left;
+
+    count = get_band_count( max( job.width, job.h_params.length ), job.v_params.length );
+    if (count > 1)
+        count = split_stretch_bands( &job, dst_start, src_start, count );
+    else
+    {
+        job.bands[0].dst_start = dst_start;
+        job.bands[0].src_start = src_start;
+        job.bands[0].err       = job.v_params.err_start;
+        job.bands[0].length    = job.v_params.length;
+    }
+    run_bands( count, stretch_band_rows, &job );
 
     /* update coordinates, the destination rectangle is always stored at 0,0 */
     *src = *dst;
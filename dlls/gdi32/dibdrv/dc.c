@@ -216,28 +216,60 @@ void copy_dib_color_info(dib_info *dst, const dib_info *src)
     dst->color_table      = src->color_table;
 }
 
-DWORD convert_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bitblt_coords *src,
-                          const BITMAPINFO *dst_info, void *dst_bits )
+struct convert_job
 {
-    dib_info src_dib, dst_dib;
-    DWORD ret;
+    dib_info dst_dib, src_dib;
+    RECT     rect;
+    int      band_rows;
+    LONG     failed;
+};
+
+static void convert_band( void *context, int band )
+{
+    struct convert_job *job = context;
+    dib_info dst_dib = job->dst_dib;
+    RECT rect = job->rect;
 
-    init_dib_info_from_bitmapinfo( &src_dib, src_info, src_bits );
-    init_dib_info_from_bitmapinfo( &dst_dib, dst_info, dst_bits );
+    /* the destination rows start at 0 so move its origin down to the band */
+    rect.top += band * job->band_rows;
+    rect.bottom = min( rect.top + job->band_rows, job->rect.bottom );
+    dst_dib.rect.top += rect.top - job->rect.top;
 
     __TRY
     {
-        dst_dib.funcs->convert_to( &dst_dib, &src_dib, &src->visrect, FALSE );
-        ret = TRUE;
+        dst_dib.funcs->convert_to( &dst_dib, &job->src_dib, &rect, FALSE );
     }
     __EXCEPT_PAGE_FAULT
     {
-        WARN( "invalid bits pointer %p\n", src_bits );
-        ret = FALSE;
+        InterlockedExchange( &job->failed, TRUE );
     }
     __ENDTRY
+}
 
-    if(!ret) return ERROR_BAD_FORMAT;
+DWORD convert_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bitblt_coords *src,
+                          const BITMAPINFO *dst_info, void *dst_bits )
+{
+    struct convert_job job;
+    int count, height = src->visrect.bottom - src->visrect.top;
+
+    init_dib_info_from_bitmapinfo( &job.src_dib, src_info, src_bits );
+    init_dib_info_from_bitmapinfo( &job.dst_dib, dst_info, dst_bits );
+    job.rect = src->visrect;
+    job.failed = FALSE;
+
+    job.band_rows = height;
+    if ((count = get_band_count( src->visrect.right - src->visrect.left, height )) > 1)
+    {
+        job.band_rows = (height + count - 1) / count;
+        count = (height + job.band_rows - 1) / job.band_rows;
+    }
+    run_bands( count, convert_band, &job );
+
+    if (job.failed)
+    {
+        WARN( "invalid bits pointer %p\n", src_bits );
+        return ERROR_BAD_FORMAT;
+    }
 
     /* update coordinates, the destination rectangle is always stored at 0,0 */
     src->x -= src->visrect.left;
@@ -264,6 +264,8 @@ extern int clip_line(const POINT *start, const POINT *end, const RECT *clip,
                      const bres_params *params, POINT *pt1, POINT *pt2) DECLSPEC_HIDDEN;
 extern void release_cached_font( struct cached_font *font ) DECLSPEC_HIDDEN;
 extern BOOL fill_with_pixel( DC *dc, dib_info *dib, DWORD pixel, int num, const RECT *rects, INT rop ) DECLSPEC_HIDDEN;
+extern int get_band_count( int width, int height ) DECLSPEC_HIDDEN;
+extern void run_bands( int count, void (*func)( void *context, int band ), void *context ) DECLSPEC_HIDDEN;
 
 static inline void init_clipped_rects( struct clipped_rects *clip_rects )
 {
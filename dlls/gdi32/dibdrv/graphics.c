@@ -21,10 +21,12 @@
 #include <assert.h>
 #include "gdi_private.h"
 #include "dibdrv.h"
+#include "winreg.h"
 
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(dib);
+WINE_DECLARE_DEBUG_CHANNEL(glyphcache);
 
 struct cached_glyph
 {
@@ -736,6 +738,372 @@ static int get_glyph_depth( UINT aa_flags )
 static const BYTE masks[8] = {0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01};
 static const int padding[4] = {0, 3, 2, 1};
 
+/* Optional glyph cache shared between processes, enabled by setting
+ * HKCU\Software\Wine\Gdi\GlyphCacheSize to a size in megabytes.  It sits below the
+ * per-process cache: a glyph missing from the cached_font is looked up there before
+ * being rasterized, and newly rasterized glyphs are added to it.
+ *
+ * The mapping layout only depends on its size, so that all-zero memory is a valid empty
+ * cache and 32-bit and 64-bit processes can share it.  Lookups are lock-free, each slot
+ * carries a sequence count which is odd while it is being written.  Inserts take a spin
+ * lock holding the owner's process id and give up if it is busy, unless the owner died,
+ * replacing the least recently used of a few sampled slots.
+ */
+
+#define SHARED_GLYPH_MAGIC    0x31484757  /* "WGH1" */
+#define SHARED_GLYPH_CLASSES  4
+#define SHARED_GLYPH_PROBES   8
+#define SHARED_GLYPH_HEADER   0x1000
+#define SHARED_GLYPH_MAX_MB   1024
+
+struct shared_glyph
+{
+    LONG         seq;        /* odd while the slot is being written */
+    LONG         last_used;  /* clock value of the last hit */
+    ULONGLONG    key[2];     /* 0 for a free slot */
+    DWORD        size;
+    GLYPHMETRICS metrics;
+    BYTE         bits[1];
+};
+
+struct shared_glyph_cache
+{
+    LONG         magic;
+    LONG         lock;
+    LONG         clock;
+    LONG         bytes_used;
+    LONG         hand[SHARED_GLYPH_CLASSES];
+    LONG         hits;       /* lookups served from the shared cache, for all processes */
+};
+
+static const DWORD shared_slot_size[SHARED_GLYPH_CLASSES] = { 0x200, 0x800, 0x2000, 0x8000 };
+static const DWORD shared_class_share[SHARED_GLYPH_CLASSES] = { 8, 4, 2, 2 };  /* sixteenths */
+
+static struct
+{
+    struct shared_glyph_cache *cache;
+    DWORD                     *buckets;
+    DWORD                      bucket_mask;
+    BYTE                      *slots[SHARED_GLYPH_CLASSES];
+    DWORD                      first[SHARED_GLYPH_CLASSES + 1];  /* first slot index of each class */
+    DWORD                      size;
+} shared_glyphs;
+
+static LONG shared_glyph_hits, shared_glyph_misses;
+
+static DWORD get_glyph_cache_size(void)
+{
+    HKEY key;
+    DWORD type, value = 0, size = sizeof(value);
+
+    /* @@ Wine registry key: HKCU\Software\Wine\Gdi */
+    if (!RegOpenKeyW( HKEY_CURRENT_USER, L"Software\\Wine\\Gdi", &key ))
+    {
+        if (RegQueryValueExW( key, L"GlyphCacheSize", NULL, &type, (BYTE *)&value, &size ) || type != REG_DWORD)
+            value = 0;
+        RegCloseKey( key );
+    }
+    return min( value, SHARED_GLYPH_MAX_MB );
+}
+
+static void init_shared_glyph_layout( BYTE *base, DWORD size )
+{
+    DWORD i, count, avail = size - SHARED_GLYPH_HEADER;
+    BYTE *ptr;
+
+    /* hash buckets use 1/32 of the space, enough for a load factor below 1/2 */
+    for (count = 1; count * 2 * sizeof(DWORD) <= avail / 32; count *= 2);
+    shared_glyphs.buckets = (DWORD *)(base + SHARED_GLYPH_HEADER);
+    shared_glyphs.bucket_mask = count - 1;
+    avail -= count * sizeof(DWORD);
+
+    ptr = base + SHARED_GLYPH_HEADER + count * sizeof(DWORD);
+    for (i = 0; i < SHARED_GLYPH_CLASSES; i++)
+    {
+        count = avail / 16 * shared_class_share[i] / shared_slot_size[i];
+        shared_glyphs.slots[i] = ptr;
+        shared_glyphs.first[i + 1] = shared_glyphs.first[i] + count;
+        ptr += count * shared_slot_size[i];
+    }
+    shared_glyphs.size = size;
+}
+
+static BOOL WINAPI init_shared_glyph_cache( INIT_ONCE *once, void *param, void **context )
+{
+    MEMORY_BASIC_INFORMATION info;
+    struct shared_glyph_cache *cache;
+    DWORD size = get_glyph_cache_size();
+    HANDLE mapping;
+    LONG magic;
+
+    if (!size) return TRUE;
+    if (!(mapping = CreateFileMappingW( INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, size << 20,
+                                        L"__wine_gdi_glyph_cache" )))
+        return TRUE;
+    cache = MapViewOfFile( mapping, FILE_MAP_WRITE, 0, 0, 0 );
+    CloseHandle( mapping );
+    if (!cache) return TRUE;
+
+    /* another process may have created it with a different size */
+    VirtualQuery( cache, &info, sizeof(info) );
+    magic = InterlockedCompareExchange( &cache->magic, SHARED_GLYPH_MAGIC, 0 );
+    if ((magic && magic != SHARED_GLYPH_MAGIC) || info.RegionSize < 2 * SHARED_GLYPH_HEADER)
+    {
+        WARN( "unusable shared glyph cache, magic %08x size %#x\n", magic, (DWORD)info.RegionSize );
+        UnmapViewOfFile( cache );
+        return TRUE;
+    }
+    init_shared_glyph_layout( (BYTE *)cache, min( info.RegionSize, (SIZE_T)SHARED_GLYPH_MAX_MB << 20 ));
+    shared_glyphs.cache = cache;
+    TRACE_(glyphcache)( "using %u bytes, %u buckets, %u slots\n", shared_glyphs.size,
+                        shared_glyphs.bucket_mask + 1, shared_glyphs.first[SHARED_GLYPH_CLASSES] );
+    return TRUE;
+}
+
+static struct shared_glyph_cache *get_shared_glyph_cache(void)
+{
+    static INIT_ONCE once = INIT_ONCE_STATIC_INIT;
+
+    InitOnceExecuteOnce( &once, init_shared_glyph_cache, NULL, NULL );
+    return shared_glyphs.cache;
+}
+
+static struct shared_glyph *get_shared_slot( DWORD index, DWORD *class )
+{
+    DWORD i;
+
+    for (i = 0; i < SHARED_GLYPH_CLASSES - 1; i++) if (index < shared_glyphs.first[i + 1]) break;
+    if (class) *class = i;
+    return (struct shared_glyph *)(shared_glyphs.slots[i] + (index - shared_glyphs.first[i]) * shared_slot_size[i]);
+}
+
+static ULONGLONG hash_glyph_key( ULONGLONG hash, const void *data, SIZE_T size )
+{
+    const BYTE *ptr = data;
+
+    while (size--) hash = (hash ^ *ptr++) * 0x100000001b3ull;
+    return hash;
+}
+
+/* the key covers everything the rasterized bits depend on: face file, size, transform, AA mode and glyph */
+static BOOL get_shared_glyph_key( DC *dc, const struct cached_font *font, UINT index, UINT flags,
+                                  ULONGLONG key[2] )
+{
+    struct
+    {
+        ULONGLONG face;
+        LOGFONTW  lf;
+        XFORM     xform;
+        DWORD     aa_flags;
+        DWORD     type;
+        DWORD     index;
+    } data;
+    int i;
+
+    memset( &data, 0, sizeof(data) );
+    if (!(data.face = get_font_file_hash( dc ))) return FALSE;  /* memory fonts can't be shared */
+
+    memcpy( &data.lf, &font->lf, FIELD_OFFSET( LOGFONTW, lfFaceName ));
+    for (i = 0; i < LF_FACESIZE - 1 && font->lf.lfFaceName[i]; i++)
+        data.lf.lfFaceName[i] = towupper( font->lf.lfFaceName[i] );
+    data.xform    = font->xform;
+    data.aa_flags = font->aa_flags;
+    data.type     = (flags & ETO_GLYPH_INDEX) ? GLYPH_INDEX : GLYPH_WCHAR;
+    data.index    = index;
+
+    key[0] = hash_glyph_key( 0xcbf29ce484222325ull, &data, sizeof(data) );
+    key[1] = hash_glyph_key( 0x6c62272e07bb0142ull, &data, sizeof(data) );
+    if (!key[0] && !key[1]) key[0] = 1;
+    return TRUE;
+}
+
+static void trace_shared_glyph_stats( BOOL hit )
+{
+    LONG hits, total;
+
+    if (!TRACE_ON(glyphcache)) return;
+    if (hit) hits = InterlockedIncrement( &shared_glyph_hits );
+    else hits = shared_glyph_hits;
+    total = hits + (hit ? shared_glyph_misses : InterlockedIncrement( &shared_glyph_misses ));
+    if (total % 1024) return;
+    TRACE_(glyphcache)( "%d/%d hits (%d%%), %d of %u bytes used\n", hits, total,
+                        (int)((LONGLONG)hits * 100 / total), shared_glyphs.cache->bytes_used,
+                        shared_glyphs.size );
+}
+
+static struct cached_glyph *find_shared_glyph( const ULONGLONG key[2] )
+{
+    struct shared_glyph_cache *cache = shared_glyphs.cache;
+    struct shared_glyph *slot;
+    struct cached_glyph *glyph;
+    DWORD i, ref, class, size;
+    LONG seq;
+
+    for (i = 0; i < SHARED_GLYPH_PROBES; i++)
+    {
+        ref = *(volatile DWORD *)&shared_glyphs.buckets[(key[0] + i) & shared_glyphs.bucket_mask];
+        if (!ref || ref > shared_glyphs.first[SHARED_GLYPH_CLASSES]) continue;
+        slot = get_shared_slot( ref - 1, &class );
+
+        seq = *(volatile LONG *)&slot->seq;
+        if (seq & 1) continue;
+        MemoryBarrier();
+        if (slot->key[0] != key[0] || slot->key[1] != key[1]) continue;
+        size = slot->size;
+        if (size > shared_slot_size[class] - FIELD_OFFSET( struct shared_glyph, bits )) continue;
+
+        if (!(glyph = HeapAlloc( GetProcessHeap(), 0, FIELD_OFFSET( struct cached_glyph, bits[size] ))))
+            return NULL;
+        glyph->metrics = slot->metrics;
+        memcpy( glyph->bits, slot->bits, size );
+        MemoryBarrier();
+        if (*(volatile LONG *)&slot->seq != seq)  /* replaced while we were copying it */
+        {
+            HeapFree( GetProcessHeap(), 0, glyph );
+            continue;
+        }
+        slot->last_used = InterlockedIncrement( &cache->clock );
+        InterlockedIncrement( &cache->hits );
+        trace_shared_glyph_stats( TRUE );
+        return glyph;
+    }
+    trace_shared_glyph_stats( FALSE );
+    return NULL;
+}
+
+/* start writing a slot, caller must hold the cache lock */
+static void begin_shared_slot_write( struct shared_glyph *slot )
+{
+    /* a process that died while writing the slot left the count odd */
+    if (slot->seq & 1) InterlockedIncrement( &slot->seq );
+    InterlockedIncrement( &slot->seq );
+}
+
+/* caller must hold the cache lock */
+static void free_shared_slot( struct shared_glyph *slot, DWORD ref )
+{
+    DWORD i, *bucket;
+
+    for (i = 0; i < SHARED_GLYPH_PROBES; i++)
+    {
+        bucket = &shared_glyphs.buckets[(slot->key[0] + i) & shared_glyphs.bucket_mask];
+        if (*bucket == ref) InterlockedExchange( (LONG *)bucket, 0 );
+    }
+    begin_shared_slot_write( slot );
+    shared_glyphs.cache->bytes_used -= FIELD_OFFSET( struct shared_glyph, bits[slot->size] );
+    slot->key[0] = slot->key[1] = 0;
+    slot->size = 0;
+    InterlockedIncrement( &slot->seq );
+}
+
+static BOOL is_process_dead( DWORD pid )
+{
+    HANDLE process;
+    BOOL ret;
+
+    if (!(process = OpenProcess( SYNCHRONIZE, FALSE, pid ))) return GetLastError() == ERROR_INVALID_PARAMETER;
+    ret = !WaitForSingleObject( process, 0 );
+    CloseHandle( process );
+    return ret;
+}
+
+static void add_shared_glyph( const ULONGLONG key[2], const struct cached_glyph *glyph, DWORD size )
+{
+    struct shared_glyph_cache *cache = shared_glyphs.cache;
+    struct shared_glyph *slot, *victim = NULL;
+    DWORD i, class, count, index, ref, victim_ref = 0, *bucket, *free_bucket = NULL;
+    LONG clock, age, oldest = -1, prev = 0, owner = GetCurrentProcessId();
+
+    for (class = 0; class < SHARED_GLYPH_CLASSES; class++)
+        if (FIELD_OFFSET( struct shared_glyph, bits[size] ) <= shared_slot_size[class]) break;
+    if (class == SHARED_GLYPH_CLASSES) return;
+    if (!(count = shared_glyphs.first[class + 1] - shared_glyphs.first[class])) return;
+
+    for (i = 0; i < 64; i++)
+    {
+        if (!(prev = InterlockedCompareExchange( &cache->lock, owner, 0 ))) break;
+        YieldProcessor();
+    }
+    if (i == 64)
+    {
+        /* busy, somebody else will probably add it, unless the owner died holding the lock */
+        if (!is_process_dead( prev ) || InterlockedCompareExchange( &cache->lock, owner, prev ) != prev)
+            return;
+        WARN( "process %04x died holding the shared glyph cache lock\n", prev );
+    }
+
+    for (i = 0; i < SHARED_GLYPH_PROBES; i++)
+    {
+        bucket = &shared_glyphs.buckets[(key[0] + i) & shared_glyphs.bucket_mask];
+        if (!*bucket)
+        {
+            if (!free_bucket) free_bucket = bucket;
+            continue;
+        }
+        if (*bucket > shared_glyphs.first[SHARED_GLYPH_CLASSES]) continue;
+        slot = get_shared_slot( *bucket - 1, NULL );
+        if (slot->key[0] == key[0] && slot->key[1] == key[1]) goto done;  /* already there */
+    }
+
+    /* sampled LRU: pick a free slot or the oldest of a few consecutive ones */
+    clock = cache->clock;
+    index = (DWORD)InterlockedExchangeAdd( &cache->hand[class], SHARED_GLYPH_PROBES );
+    for (i = 0; i < SHARED_GLYPH_PROBES; i++)
+    {
+        ref = shared_glyphs.first[class] + (index + i) % count + 1;
+        slot = get_shared_slot( ref - 1, NULL );
+        if (!slot->key[0] && !slot->key[1])
+        {
+            victim = slot;
+            victim_ref = ref;
+            break;
+        }
+        age = clock - slot->last_used;
+        if (!victim || age > oldest)
+        {
+            oldest = age;
+            victim = slot;
+            victim_ref = ref;
+        }
+    }
+    if (victim->key[0] || victim->key[1])
+    {
+        free_shared_slot( victim, victim_ref );
+        if (!free_bucket)
+        {
+            for (i = 0; i < SHARED_GLYPH_PROBES; i++)
+            {
+                bucket = &shared_glyphs.buckets[(key[0] + i) & shared_glyphs.bucket_mask];
+                if (!*bucket) break;
+            }
+            if (i < SHARED_GLYPH_PROBES) free_bucket = bucket;
+        }
+    }
+    if (!free_bucket)
+    {
+        /* evict the entry in the first bucket of the probe sequence */
+        bucket = &shared_glyphs.buckets[key[0] & shared_glyphs.bucket_mask];
+        if (*bucket <= shared_glyphs.first[SHARED_GLYPH_CLASSES])
+            free_shared_slot( get_shared_slot( *bucket - 1, NULL ), *bucket );
+        InterlockedExchange( (LONG *)bucket, 0 );
+        free_bucket = bucket;
+    }
+
+    begin_shared_slot_write( victim );
+    victim->key[0]  = key[0];
+    victim->key[1]  = key[1];
+    victim->size    = size;
+    victim->metrics = glyph->metrics;
+    memcpy( victim->bits, glyph->bits, size );
+    victim->last_used = InterlockedIncrement( &cache->clock );
+    InterlockedIncrement( &victim->seq );
+    cache->bytes_used += FIELD_OFFSET( struct shared_glyph, bits[size] );
+    InterlockedExchange( (LONG *)free_bucket, victim_ref );
+
+done:
+    InterlockedExchange( &cache->lock, 0 );
+}
+
 /***********************************************************************
  *         cache_glyph_bitmap
  *
@@ -755,6 +1123,11 @@ static struct cached_glyph *cache_glyph_bitmap( DC *dc, struct cached_font *font
     int pad = 0, stride, bit_count;
     GLYPHMETRICS metrics;
     struct cached_glyph *glyph;
+    ULONGLONG key[2];
+    BOOL shared = get_shared_glyph_cache() && get_shared_glyph_key( dc, font, index, flags, key );
+
+    if (shared && (glyph = find_shared_glyph( key )))
+        return add_cached_glyph( font, index, flags, glyph );
 
     if (flags & ETO_GLYPH_INDEX) ggo_flags |= GGO_GLYPH_INDEX;
     indices[0] = index;
@@ -804,6 +1177,7 @@ static struct cached_glyph *cache_glyph_bitmap( DC *dc, struct cached_font *font
 
 done:
     glyph->metrics = metrics;
+    if (shared) add_shared_glyph( key, glyph, size );
     return add_cached_glyph( font, index, flags, glyph );
 }
 
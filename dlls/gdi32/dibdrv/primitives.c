@@ -137,6 +137,21 @@ static inline void do_rop_32(DWORD *ptr, DWORD and, DWORD xor)
     *ptr = (*ptr & and) ^ xor;
 }
 
+static inline void do_rop_line_32(DWORD *ptr, DWORD and, DWORD xor, int len)
+{
+    UINT64 and64 = and | (UINT64)and << 32;
+    UINT64 xor64 = xor | (UINT64)xor << 32;
+
+    /* process two pixels at a time once the destination is 8-byte aligned */
+    if (len > 0 && ((ULONG_PTR)ptr & 4))
+    {
+        do_rop_32( ptr++, and, xor );
+        len--;
+    }
+    for (; len >= 2; len -= 2, ptr += 2) *(UINT64 *)ptr = (*(UINT64 *)ptr & and64) ^ xor64;
+    if (len > 0) do_rop_32( ptr, and, xor );
+}
+
 static inline void do_rop_16(WORD *ptr, WORD and, WORD xor)
 {
     *ptr = (*ptr & and) ^ xor;
@@ -266,8 +281,8 @@ static inline void memset_16( WORD *start, WORD val, DWORD size )
 
 static void solid_rects_32(const dib_info *dib, int num, const RECT *rc, DWORD and, DWORD xor)
 {
-    DWORD *ptr, *start;
-    int x, y, i;
+    DWORD *start;
+    int y, i;
 
     for(i = 0; i < num; i++, rc++)
     {
@@ -276,8 +291,7 @@ static void solid_rects_32(const dib_info *dib, int num, const RECT *rc, DWORD a
         start = get_pixel_ptr_32(dib, rc->left, rc->top);
         if (and)
             for(y = rc->top; y < rc->bottom; y++, start += dib->stride / 4)
-                for(x = rc->left, ptr = start; x < rc->right; x++)
-                    do_rop_32(ptr++, and, xor);
+                do_rop_line_32( start, and, xor, rc->right - rc->left );
         else
             for(y = rc->top; y < rc->bottom; y++, start += dib->stride / 4)
                 memset_32( start, xor, rc->right - rc->left );
@@ -819,7 +833,7 @@ static void pattern_rects_32(const dib_info *dib, int num, const RECT *rc, const
                              const dib_info *brush, const rop_mask_bits *bits)
 {
     DWORD *ptr, *start, *start_and, *and_ptr, *start_xor, *xor_ptr;
-    int x, y, i, len, brush_x;
+    int x, y, i, j, len, brush_x;
     POINT offset;
 
     for(i = 0; i < num; i++, rc++)
@@ -834,17 +848,13 @@ static void pattern_rects_32(const dib_info *dib, int num, const RECT *rc, const
 
             for(y = rc->top; y < rc->bottom; y++, start += dib->stride / 4)
             {
-                and_ptr = start_and + offset.x;
-                xor_ptr = start_xor + offset.x;
-
-                for(x = rc->left, ptr = start; x < rc->right; x++)
+                for (x = rc->left, brush_x = offset.x, ptr = start; x < rc->right; x += len)
                 {
-                    do_rop_32(ptr++, *and_ptr++, *xor_ptr++);
-                    if(and_ptr == start_and + brush->width)
-                    {
-                        and_ptr = start_and;
-                        xor_ptr = start_xor;
-                    }
+                    len = min( rc->right - x, brush->width - brush_x );
+                    and_ptr = start_and + brush_x;
+                    xor_ptr = start_xor + brush_x;
+                    for (j = 0; j < len; j++) do_rop_32( ptr++, and_ptr[j], xor_ptr[j] );
+                    brush_x = 0;
                 }
 
                 offset.y++;
@@ -1334,6 +1344,8 @@ static void pattern_rects_null(const dib_info *dib, int num, const RECT *rc, con
     return;
 }
 
+/* Each ROP already gets its own branch-free loop here, which the compiler can vectorize,
+ * so unlike the solid and pattern fills these aren't widened by hand. */
 static inline void copy_rect_bits_32( DWORD *dst_start, const DWORD *src_start, const SIZE *size,
                                       int dst_stride, int src_stride, int rop2 )
 {
@@ -4593,44 +4605,44 @@ static inline BYTE blend_color(BYTE dst, BYTE src, DWORD alpha)
     return (src * alpha + dst * (255 - alpha) + 127) / 255;
 }
 
+/* Divide two 16-bit lanes holding values up to 255 * 255 by 255, rounding like (x + 127) / 255. */
+static inline DWORD div255_x2( DWORD val )
+{
+    val += 0x00800080;
+    return ((val + ((val >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+}
+
+/* The argb blend helpers below operate on the blue/red and green/alpha channel pairs at once,
+ * and produce the same results as blending each channel separately with blend_color. */
 static inline DWORD blend_argb_constant_alpha( DWORD dst, DWORD src, DWORD alpha )
 {
-    return (blend_color( dst, src, alpha ) |
-            blend_color( dst >> 8, src >> 8, alpha ) << 8 |
-            blend_color( dst >> 16, src >> 16, alpha ) << 16 |
-            blend_color( dst >> 24, src >> 24, alpha ) << 24);
+    DWORD rb = (src & 0x00ff00ff) * alpha + (dst & 0x00ff00ff) * (255 - alpha);
+    DWORD ag = ((src >> 8) & 0x00ff00ff) * alpha + ((dst >> 8) & 0x00ff00ff) * (255 - alpha);
+    return div255_x2( rb ) | div255_x2( ag ) << 8;
 }
 
 static inline DWORD blend_argb_no_src_alpha( DWORD dst, DWORD src, DWORD alpha )
 {
-    return (blend_color( dst, src, alpha ) |
-            blend_color( dst >> 8, src >> 8, alpha ) << 8 |
-            blend_color( dst >> 16, src >> 16, alpha ) << 16 |
-            blend_color( dst >> 24, 255, alpha ) << 24);
+    return blend_argb_constant_alpha( dst, src | 0xff000000, alpha );
 }
 
 static inline DWORD blend_argb( DWORD dst, DWORD src )
 {
-    BYTE b = (BYTE)src;
-    BYTE g = (BYTE)(src >> 8);
-    BYTE r = (BYTE)(src >> 16);
-    DWORD alpha  = (BYTE)(src >> 24);
-    return ((b     + ((BYTE)dst         * (255 - alpha) + 127) / 255) |
-            (g     + ((BYTE)(dst >> 8)  * (255 - alpha) + 127) / 255) << 8 |
-            (r     + ((BYTE)(dst >> 16) * (255 - alpha) + 127) / 255) << 16 |
-            (alpha + ((BYTE)(dst >> 24) * (255 - alpha) + 127) / 255) << 24);
+    DWORD alpha = src >> 24;
+    DWORD rb, ag;
+
+    if (alpha == 255) return src;
+    if (!src) return dst;
+    /* channels may exceed 255 if the source isn't premultiplied, they are or'ed together then */
+    rb = div255_x2( (dst & 0x00ff00ff) * (255 - alpha) ) + (src & 0x00ff00ff);
+    ag = div255_x2( ((dst >> 8) & 0x00ff00ff) * (255 - alpha) ) + ((src >> 8) & 0x00ff00ff);
+    return rb | ag << 8;
 }
 
 static inline DWORD blend_argb_alpha( DWORD dst, DWORD src, DWORD alpha )
 {
-    BYTE b = ((BYTE)src         * alpha + 127) / 255;
-    BYTE g = ((BYTE)(src >> 8)  * alpha + 127) / 255;
-    BYTE r = ((BYTE)(src >> 16) * alpha + 127) / 255;
-    alpha  = ((BYTE)(src >> 24) * alpha + 127) / 255;
-    return ((b     + ((BYTE)dst         * (255 - alpha) + 127) / 255) |
-            (g     + ((BYTE)(dst >> 8)  * (255 - alpha) + 127) / 255) << 8 |
-            (r     + ((BYTE)(dst >> 16) * (255 - alpha) + 127) / 255) << 16 |
-            (alpha + ((BYTE)(dst >> 24) * (255 - alpha) + 127) / 255) << 24);
+    src = div255_x2( (src & 0x00ff00ff) * alpha ) | div255_x2( ((src >> 8) & 0x00ff00ff) * alpha ) << 8;
+    return blend_argb( dst, src );
 }
 
 static inline DWORD blend_rgb( BYTE dst_r, BYTE dst_g, BYTE dst_b, DWORD src, BLENDFUNCTION blend )
@@ -1194,6 +1194,279 @@ static void remove_face_from_cache( struct gdi_font_face *face )
     RegCloseKey( hkey_family );
 }
 
+/* binary font list cache, holding the faces found in the font directories */
+
+#define FONT_LIST_CACHE_MAGIC   0x4c464e57  /* 'WNFL' */
+#define FONT_LIST_CACHE_VERSION 2
+
+struct font_list_cache_header
+{
+    DWORD     magic;
+    DWORD     version;
+    ULONGLONG stamp;
+    DWORD     size;          /* total size of the file */
+    DWORD     family_count;
+    DWORD     face_count;
+    DWORD     strings;       /* offset of the string data */
+    /* struct font_list_cache_family families[family_count]; */
+    /* struct font_list_cache_face faces[face_count]; */
+    /* WCHAR strings[]; */
+};
+
+struct font_list_cache_family
+{
+    WCHAR family_name[LF_FACESIZE];
+    WCHAR second_name[LF_FACESIZE];
+    DWORD face_count;
+};
+
+struct font_list_cache_face
+{
+    DWORD                   style_name;  /* offsets in WCHARs into the string data */
+    DWORD                   full_name;
+    DWORD                   file;
+    DWORD                   index;
+    DWORD                   flags;
+    DWORD                   ntmflags;
+    DWORD                   version;
+    DWORD                   scalable;
+    struct bitmap_font_size size;
+    FONTSIGNATURE           fs;
+};
+
+static void get_font_list_cache_path( WCHAR *path )
+{
+    GetSystemDirectoryW( path, MAX_PATH - 16 );
+    lstrcatW( path, L"\\fontlist.dat" );
+}
+
+static ULONGLONG hash_font_stamp( ULONGLONG hash, const void *data, SIZE_T size )
+{
+    const BYTE *ptr = data;
+
+    while (size--) hash = (hash ^ *ptr++) * 0x100000001b3ull;
+    return hash;
+}
+
+static ULONGLONG hash_font_dir_stamp( ULONGLONG hash, WCHAR *path )
+{
+    WIN32_FILE_ATTRIBUTE_DATA info;
+    int len = lstrlenW( path );
+
+    if (len > 1 && path[len - 1] == '\\') path[--len] = 0;
+    hash = hash_font_stamp( hash, path, len * sizeof(WCHAR) );
+    if (GetFileAttributesExW( path, GetFileExInfoStandard, &info ))
+        hash = hash_font_stamp( hash, &info.ftLastWriteTime, sizeof(info.ftLastWriteTime) );
+    return hash;
+}
+
+/* compute a stamp that changes whenever the font directories scanned at startup do */
+static ULONGLONG get_font_list_stamp(void)
+{
+    static const WCHAR * const fonts[] = { L"FONTS.FON", L"OEMFONT.FON", L"FIXEDFON.FON" };
+    ULONGLONG backend_stamp, hash = 0xcbf29ce484222325ull;
+    WCHAR *ptr, *next, path[MAX_PATH], value[1024];
+    DWORD i, len, type, version = FONT_LIST_CACHE_VERSION;
+    HKEY hkey;
+
+    if (!(backend_stamp = font_funcs->get_fonts_stamp())) return 0;
+    hash = hash_font_stamp( hash, &version, sizeof(version) );
+    hash = hash_font_stamp( hash, &backend_stamp, sizeof(backend_stamp) );
+
+    if (!RegOpenKeyW( HKEY_CURRENT_CONFIG, L"Software\\Fonts", &hkey ))
+    {
+        for (i = 0; i < ARRAY_SIZE(fonts); i++)
+        {
+            len = sizeof(value);
+            if (!RegQueryValueExW( hkey, fonts[i], 0, &type, (BYTE *)value, &len ) && type == REG_SZ)
+                hash = hash_font_stamp( hash, value, len );
+        }
+        RegCloseKey( hkey );
+    }
+
+    get_fonts_win_dir_path( L"", path );
+    hash = hash_font_dir_stamp( hash, path );
+    get_fonts_data_dir_path( L"", path );
+    hash = hash_font_dir_stamp( hash, path );
+
+    len = sizeof(value);
+    if (!RegQueryValueExW( wine_fonts_key, L"Path", NULL, NULL, (BYTE *)value, &len ))
+    {
+        for (ptr = value; ptr; ptr = next)
+        {
+            if ((next = wcschr( ptr, ';' ))) *next++ = 0;
+            if (next && next - ptr < 2) continue;
+            lstrcpynW( path, ptr, MAX_PATH );
+            hash = hash_font_dir_stamp( hash, path );
+        }
+    }
+    return hash ? hash : 1;
+}
+
+static BOOL load_font_list_from_file_cache( ULONGLONG stamp )
+{
+    const struct font_list_cache_header *header;
+    const struct font_list_cache_family *families;
+    const struct font_list_cache_face *faces, *cached;
+    const WCHAR *strings;
+    struct gdi_font_family *family;
+    struct gdi_font_face *face;
+    WCHAR path[MAX_PATH];
+    HANDLE file, mapping;
+    DWORD i, j, size, string_count;
+    BOOL ret = FALSE;
+
+    get_font_list_cache_path( path );
+    file = CreateFileW( path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, 0, 0 );
+    if (file == INVALID_HANDLE_VALUE) return FALSE;
+    size = GetFileSize( file, NULL );
+    mapping = CreateFileMappingW( file, NULL, PAGE_READONLY, 0, 0, NULL );
+    CloseHandle( file );
+    if (!mapping) return FALSE;
+    header = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+    CloseHandle( mapping );
+    if (!header) return FALSE;
+
+    if (size < sizeof(*header) || header->magic != FONT_LIST_CACHE_MAGIC ||
+        header->version != FONT_LIST_CACHE_VERSION || header->stamp != stamp || header->size != size)
+        goto done;
+    if (header->family_count > size / sizeof(*families) || header->face_count > size / sizeof(*faces) ||
+        header->strings < sizeof(*header) + header->family_count * sizeof(*families) +
+                          header->face_count * sizeof(*faces) ||
+        header->strings >= size || (size - header->strings) % sizeof(WCHAR))
+        goto done;
+
+    families = (const struct font_list_cache_family *)(header + 1);
+    faces = (const struct font_list_cache_face *)(families + header->family_count);
+    strings = (const WCHAR *)((const char *)header + header->strings);
+    string_count = (size - header->strings) / sizeof(WCHAR);
+    if (strings[string_count - 1]) goto done;
+
+    for (i = 0, j = 0; i < header->family_count; i++) j += families[i].face_count;
+    if (j != header->face_count) goto done;
+    for (i = 0; i < header->face_count; i++)
+        if (faces[i].style_name >= string_count || faces[i].full_name >= string_count ||
+            faces[i].file >= string_count)
+            goto done;
+
+    TRACE( "loading %u families from %s\n", header->family_count, debugstr_w(path) );
+
+    for (i = 0, cached = faces; i < header->family_count; i++)
+    {
+        family = create_family( families[i].family_name, families[i].second_name );
+        for (j = 0; j < families[i].face_count; j++, cached++)
+        {
+            if (!(face = create_face( family, strings + cached->style_name, strings + cached->full_name,
+                                      strings + cached->file, NULL, 0, cached->index, cached->fs,
+                                      cached->ntmflags, cached->version, cached->flags,
+                                      cached->scalable ? NULL : &cached->size )))
+                continue;
+            release_face( face );
+        }
+        release_family( family );
+    }
+    ret = TRUE;
+
+done:
+    UnmapViewOfFile( header );
+    return ret;
+}
+
+static DWORD add_font_list_cache_string( WCHAR *strings, DWORD *pos, const WCHAR *str )
+{
+    DWORD ret = *pos, len = lstrlenW( str ) + 1;
+
+    if (strings) memcpy( strings + ret, str, len * sizeof(WCHAR) );
+    *pos += len;
+    return ret;
+}
+
+static void save_font_list_to_file_cache( ULONGLONG stamp )
+{
+    struct font_list_cache_header *header;
+    struct font_list_cache_family *families;
+    struct font_list_cache_face *faces;
+    struct gdi_font_family *family;
+    struct gdi_font_face *face;
+    WCHAR *strings = NULL, path[MAX_PATH], dir[MAX_PATH], tmp[MAX_PATH];
+    DWORD family_count = 0, face_count = 0, string_count = 0, size, written;
+    HANDLE file;
+    BOOL ret;
+
+    WINE_RB_FOR_EACH_ENTRY( family, &family_name_tree, struct gdi_font_family, name_entry )
+    {
+        if (list_empty( &family->faces )) continue;
+        family_count++;
+        LIST_FOR_EACH_ENTRY( face, &family->faces, struct gdi_font_face, entry )
+        {
+            if (!face->file) return;  /* memory fonts can't be cached */
+            face_count++;
+            add_font_list_cache_string( NULL, &string_count, face->style_name );
+            add_font_list_cache_string( NULL, &string_count, face->full_name );
+            add_font_list_cache_string( NULL, &string_count, face->file );
+        }
+    }
+    if (!string_count) return;
+
+    size = sizeof(*header) + family_count * sizeof(*families) + face_count * sizeof(*faces) +
+           string_count * sizeof(WCHAR);
+    if (!(header = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, size ))) return;
+    header->magic        = FONT_LIST_CACHE_MAGIC;
+    header->version      = FONT_LIST_CACHE_VERSION;
+    header->stamp        = stamp;
+    header->size         = size;
+    header->family_count = family_count;
+    header->face_count   = face_count;
+    header->strings      = size - string_count * sizeof(WCHAR);
+
+    families = (struct font_list_cache_family *)(header + 1);
+    faces = (struct font_list_cache_face *)(families + family_count);
+    strings = (WCHAR *)((char *)header + header->strings);
+    string_count = 0;
+
+    WINE_RB_FOR_EACH_ENTRY( family, &family_name_tree, struct gdi_font_family, name_entry )
+    {
+        if (list_empty( &family->faces )) continue;
+        lstrcpyW( families->family_name, family->family_name );
+        lstrcpyW( families->second_name, family->second_name );
+        LIST_FOR_EACH_ENTRY( face, &family->faces, struct gdi_font_face, entry )
+        {
+            faces->style_name = add_font_list_cache_string( strings, &string_count, face->style_name );
+            faces->full_name  = add_font_list_cache_string( strings, &string_count, face->full_name );
+            faces->file       = add_font_list_cache_string( strings, &string_count, face->file );
+            faces->index      = face->face_index;
+            faces->flags      = face->flags;
+            faces->ntmflags   = face->ntmFlags;
+            faces->version    = face->version;
+            faces->scalable   = face->scalable;
+            faces->size       = face->size;
+            faces->fs         = face->fs;
+            families->face_count++;
+            faces++;
+        }
+        families++;
+    }
+
+    /* write to a temporary file and rename it, processes may be mapping the old one */
+    get_font_list_cache_path( path );
+    GetSystemDirectoryW( dir, MAX_PATH );
+    if (GetTempFileNameW( dir, L"fnt", 0, tmp ))
+    {
+        file = CreateFileW( tmp, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, 0 );
+        if (file != INVALID_HANDLE_VALUE)
+        {
+            ret = WriteFile( file, header, size, &written, NULL ) && written == size;
+            CloseHandle( file );
+            if (ret && MoveFileExW( tmp, path, MOVEFILE_REPLACE_EXISTING ))
+                TRACE( "saved %u families to %s\n", family_count, debugstr_w(path) );
+            else
+                DeleteFileW( tmp );
+        }
+        else DeleteFileW( tmp );
+    }
+    HeapFree( GetProcessHeap(), 0, header );
+}
+
 /* font links */
 
 struct gdi_font_link
@@ -7946,6 +8219,7 @@ void font_init(void)
 {
     HANDLE mutex;
     DWORD disposition;
+    ULONGLONG stamp;
 
     if (RegCreateKeyExW( HKEY_CURRENT_USER, L"Software\\Wine\\Fonts", 0, NULL, 0,
                          KEY_ALL_ACCESS, NULL, &wine_fonts_key, NULL ))
@@ -7955,9 +8229,14 @@ void font_init(void)
     update_codepage();
     if (__wine_init_unix_lib( gdi32_module, DLL_PROCESS_ATTACH, &callback_funcs, &font_funcs )) return;
 
-    load_system_bitmap_fonts();
-    load_file_system_fonts();
-    font_funcs->load_fonts();
+    stamp = get_font_list_stamp();
+    if (!stamp || !load_font_list_from_file_cache( stamp ))
+    {
+        load_system_bitmap_fonts();
+        load_file_system_fonts();
+        font_funcs->load_fonts();
+        if (stamp) save_font_list_to_file_cache( stamp );
+    }
 
     if (!(mutex = CreateMutexW( NULL, FALSE, L"__WINE_FONT_MUTEX__" ))) return;
     WaitForSingleObject( mutex, INFINITE );
@@ -8385,6 +8664,33 @@ BOOL WINAPI GetFontFileInfo( DWORD instance_id, DWORD unknown, struct font_filei
     return ret;
 }
 
+/***********************************************************************
+ *           get_font_file_hash
+ *
+ * Hash identifying the face file and simulations of the font selected in a DC,
+ * used to share rendered glyphs between processes. Returns 0 for memory fonts.
+ */
+ULONGLONG get_font_file_hash( DC *dc )
+{
+    PHYSDEV dev = find_dc_driver( dc, &font_driver );
+    struct gdi_font *font;
+    ULONGLONG hash, size;
+    BOOL fake;
+
+    if (!dev || !(font = get_font_dev( dev )->font) || !font->file[0]) return 0;
+
+    hash = hash_font_stamp( 0xcbf29ce484222325ull, font->file, lstrlenW( font->file ) * sizeof(WCHAR) );
+    hash = hash_font_stamp( hash, &font->writetime, sizeof(font->writetime) );
+    size = font->data_size;  /* same key for 32-bit and 64-bit processes */
+    hash = hash_font_stamp( hash, &size, sizeof(size) );
+    hash = hash_font_stamp( hash, &font->face_index, sizeof(font->face_index) );
+    fake = font->fake_bold;
+    hash = hash_font_stamp( hash, &fake, sizeof(fake) );
+    fake = font->fake_italic;
+    hash = hash_font_stamp( hash, &fake, sizeof(fake) );
+    return hash ? hash : 1;
+}
+
 struct realization_info
 {
     DWORD flags;       /* 1 for bitmap fonts, 3 for scalable fonts */
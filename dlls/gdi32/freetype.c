@@ -1954,6 +1954,51 @@ static void CDECL freetype_load_fonts(void)
 #endif
 }
 
+static ULONGLONG hash_stamp( ULONGLONG hash, const void *data, size_t size )
+{
+    const unsigned char *ptr = data;
+
+    while (size--) hash = (hash ^ *ptr++) * 0x100000001b3ull;
+    return hash;
+}
+
+/*************************************************************
+ * freetype_get_fonts_stamp
+ *
+ * Return a value that changes whenever the fonts returned by load_fonts may
+ * have changed, or 0 if that can't be determined.
+ */
+static ULONGLONG CDECL freetype_get_fonts_stamp(void)
+{
+    ULONGLONG hash = 0xcbf29ce484222325ull;
+#ifdef SONAME_LIBFONTCONFIG
+    FcStrList *dir_list;
+    const FcChar8 *dir;
+    FcConfig *config;
+    struct stat st;
+
+    /* face names are localized for the system locale */
+    hash = hash_stamp( hash, &system_lcid, sizeof(system_lcid) );
+    hash = hash_stamp( hash, &default_aa_flags, sizeof(default_aa_flags) );
+    if (!fontconfig_enabled) return hash;
+    if (!(config = pFcConfigGetCurrent())) return 0;
+    if (!(dir_list = pFcConfigGetFontDirs( config ))) return 0;
+    while ((dir = pFcStrListNext( dir_list )))
+    {
+        hash = hash_stamp( hash, dir, strlen( (const char *)dir ));
+        if (stat( (const char *)dir, &st )) continue;
+        hash = hash_stamp( hash, &st.st_mtime, sizeof(st.st_mtime) );
+        hash = hash_stamp( hash, &st.st_ino, sizeof(st.st_ino) );
+    }
+    pFcStrListDone( dir_list );
+    return hash ? hash : 1;
+#elif defined(HAVE_CARBON_CARBON_H) || defined(__ANDROID__)
+    return 0;
+#else
+    return hash_stamp( hash, &system_lcid, sizeof(system_lcid) );
+#endif
+}
+
 /* Some fonts have large usWinDescent values, as a result of storing signed short
    in unsigned field. That's probably caused by sTypoDescent vs usWinDescent confusion in
    some font generation tools. */
@@ -4288,6 +4333,7 @@ static DWORD CDECL freetype_get_kerning_pairs( struct gdi_font *font, KERNINGPAI
 static const struct font_backend_funcs font_funcs =
 {
     freetype_load_fonts,
+    freetype_get_fonts_stamp,
     fontconfig_enum_family_fallbacks,
     freetype_add_font,
     freetype_add_mem_font,
@@ -383,6 +383,7 @@ struct gdi_font
 struct font_backend_funcs
 {
     void  (CDECL *load_fonts)(void);
+    ULONGLONG (CDECL *get_fonts_stamp)(void);
     BOOL  (CDECL *enum_family_fallbacks)( DWORD pitch_and_family, int index, WCHAR buffer[LF_FACESIZE] );
     INT   (CDECL *add_font)( const WCHAR *file, DWORD flags );
     INT   (CDECL *add_mem_font)( void *ptr, SIZE_T size, DWORD flags );
@@ -414,6 +415,7 @@ struct font_callback_funcs
 };
 
 extern void font_init(void) DECLSPEC_HIDDEN;
+extern ULONGLONG get_font_file_hash( DC *dc ) DECLSPEC_HIDDEN;
 
 /* opentype.c */
 
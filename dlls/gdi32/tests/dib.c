@@ -26,6 +26,7 @@
 #include "winbase.h"
 #include "wingdi.h"
 #include "winuser.h"
+#include "winreg.h"
 #include "wincrypt.h"
 #include "mmsystem.h" /* DIBINDEX */
 
@@ -3529,11 +3530,487 @@ static void test_simple_graphics(void)
     DeleteDC(mem_dc);
 }
 
+static DWORD blend_channel_ref( DWORD dst, DWORD src, DWORD alpha )
+{
+    return (src * alpha + dst * (255 - alpha) + 127) / 255;
+}
+
+static DWORD blend_pixel_ref( DWORD dst, DWORD src, BLENDFUNCTION blend )
+{
+    DWORD ret = 0, src_alpha, i;
+
+    if (!(blend.AlphaFormat & AC_SRC_ALPHA))
+    {
+        for (i = 0; i < 32; i += 8)
+            ret |= blend_channel_ref( (BYTE)(dst >> i), (BYTE)(src >> i), blend.SourceConstantAlpha ) << i;
+        return ret;
+    }
+    src_alpha = ((src >> 24) * blend.SourceConstantAlpha + 127) / 255;
+    for (i = 0; i < 32; i += 8)
+        ret |= (((BYTE)(src >> i) * blend.SourceConstantAlpha + 127) / 255 +
+                ((BYTE)(dst >> i) * (255 - src_alpha) + 127) / 255) << i;
+    return ret;
+}
+
+static double get_mpixels( LARGE_INTEGER start, LARGE_INTEGER end, LARGE_INTEGER freq, DWORD pixels )
+{
+    double secs = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+    return secs > 0 ? pixels / secs / 1000000.0 : 0.0;
+}
+
+static void test_blend_rop_32(void)
+{
+    static const int sizes[] = { 64, 256, 512 };
+    static const BYTE alphas[] = { 255, 128 };
+    char bmibuf[sizeof(BITMAPINFO) + 2 * sizeof(RGBQUAD)];
+    BITMAPINFO *bmi = (BITMAPINFO *)bmibuf;
+    BLENDFUNCTION blend = { AC_SRC_OVER, 0, 255, AC_SRC_ALPHA };
+    LARGE_INTEGER freq, start, end;
+    DWORD *src_bits, *dst_bits, *orig, *pat_bits, expect, seed = 0x1234;
+    HBITMAP src_dib, dst_dib, pat_dib, old_src, old_dst;
+    HBRUSH brush, old_brush;
+    HDC src_dc, dst_dc;
+    int i, x, y, iter, count, size;
+    const int width = 1024, height = 1024;
+
+    memset( bmi, 0, sizeof(bmibuf) );
+    bmi->bmiHeader.biSize = sizeof(bmi->bmiHeader);
+    bmi->bmiHeader.biWidth = width;
+    bmi->bmiHeader.biHeight = -height;
+    bmi->bmiHeader.biBitCount = 32;
+    bmi->bmiHeader.biPlanes = 1;
+    bmi->bmiHeader.biCompression = BI_RGB;
+
+    src_dc = CreateCompatibleDC( NULL );
+    dst_dc = CreateCompatibleDC( NULL );
+    src_dib = CreateDIBSection( 0, bmi, DIB_RGB_COLORS, (void **)&src_bits, NULL, 0 );
+    dst_dib = CreateDIBSection( 0, bmi, DIB_RGB_COLORS, (void **)&dst_bits, NULL, 0 );
+    ok( src_dib != NULL && dst_dib != NULL, "CreateDIBSection failed\n" );
+    old_src = SelectObject( src_dc, src_dib );
+    old_dst = SelectObject( dst_dc, dst_dib );
+    orig = HeapAlloc( GetProcessHeap(), 0, width * height * sizeof(DWORD) );
+
+    /* premultiplied source with a mix of transparent, opaque and translucent pixels */
+    for (i = 0; i < width * height; i++)
+    {
+        DWORD alpha, val;
+
+        seed = seed * 1103515245 + 12345;
+        val = seed >> 8;
+        switch (seed >> 29)
+        {
+        case 0: case 1: alpha = 0; break;
+        case 2: case 3: alpha = 255; break;
+        default: alpha = seed >> 24; break;
+        }
+        src_bits[i] = alpha << 24 | ((val & 0xff) * alpha / 255) | (((val >> 8) & 0xff) * alpha / 255) << 8 |
+                      (((val >> 16) & 0xff) * alpha / 255) << 16;
+        orig[i] = seed * 0x9e3779b1;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(alphas); i++)
+    {
+        blend.SourceConstantAlpha = alphas[i];
+        blend.AlphaFormat = AC_SRC_ALPHA;
+        memcpy( dst_bits, orig, width * height * sizeof(DWORD) );
+        GdiAlphaBlend( dst_dc, 1, 3, 257, 100, src_dc, 0, 0, 257, 100, blend );
+        for (y = 0; y < 100; y++)
+            for (x = 0; x < 257; x++)
+            {
+                expect = blend_pixel_ref( orig[(y + 3) * width + x + 1], src_bits[y * width + x], blend );
+                if (dst_bits[(y + 3) * width + x + 1] == expect) continue;
+                ok( 0, "%d,%d alpha %u: got %08x expected %08x\n", x, y, blend.SourceConstantAlpha,
+                    dst_bits[(y + 3) * width + x + 1], expect );
+                y = 100;
+                break;
+            }
+
+        blend.AlphaFormat = 0;
+        memcpy( dst_bits, orig, width * height * sizeof(DWORD) );
+        GdiAlphaBlend( dst_dc, 1, 3, 257, 100, src_dc, 0, 0, 257, 100, blend );
+        for (y = 0; y < 100; y++)
+            for (x = 0; x < 257; x++)
+            {
+                expect = blend_pixel_ref( orig[(y + 3) * width + x + 1], src_bits[y * width + x], blend ) & 0xffffff;
+                if ((dst_bits[(y + 3) * width + x + 1] & 0xffffff) == expect) continue;
+                ok( 0, "%d,%d constant alpha %u: got %08x expected %08x\n", x, y, blend.SourceConstantAlpha,
+                    dst_bits[(y + 3) * width + x + 1], expect );
+                y = 100;
+                break;
+            }
+    }
+
+    /* solid and pattern ROPs at odd offsets and widths */
+    memcpy( dst_bits, orig, width * height * sizeof(DWORD) );
+    brush = CreateSolidBrush( RGB(0x12, 0x34, 0x56) );
+    old_brush = SelectObject( dst_dc, brush );
+    PatBlt( dst_dc, 1, 0, 7, 2, PATINVERT );
+    PatBlt( dst_dc, 10, 0, 8, 2, PATINVERT );
+    for (y = 0; y < 2; y++)
+        for (x = 0; x < 20; x++)
+        {
+            expect = orig[y * width + x];
+            if ((x >= 1 && x < 8) || (x >= 10 && x < 18)) expect ^= 0x123456;
+            ok( (dst_bits[y * width + x] & 0xffffff) == (expect & 0xffffff), "%d,%d: got %08x expected %08x\n",
+                x, y, dst_bits[y * width + x], expect );
+        }
+    DeleteObject( SelectObject( dst_dc, old_brush ));
+
+    bmi->bmiHeader.biWidth = 5;
+    bmi->bmiHeader.biHeight = -3;
+    pat_dib = CreateDIBSection( 0, bmi, DIB_RGB_COLORS, (void **)&pat_bits, NULL, 0 );
+    for (i = 0; i < 15; i++) pat_bits[i] = 0x010203 * (i + 1);
+    brush = CreatePatternBrush( pat_dib );
+    old_brush = SelectObject( dst_dc, brush );
+    memcpy( dst_bits, orig, width * height * sizeof(DWORD) );
+    SetBrushOrgEx( dst_dc, 2, 1, NULL );
+    PatBlt( dst_dc, 3, 2, 13, 4, PATINVERT );
+    for (y = 2; y < 6; y++)
+        for (x = 3; x < 16; x++)
+        {
+            expect = orig[y * width + x] ^ pat_bits[((y + 2) % 3) * 5 + (x + 3) % 5];
+            ok( (dst_bits[y * width + x] & 0xffffff) == (expect & 0xffffff), "%d,%d: got %08x expected %08x\n",
+                x, y, dst_bits[y * width + x], expect );
+        }
+
+    QueryPerformanceFrequency( &freq );
+    for (i = 0; i < ARRAY_SIZE(sizes); i++)
+    {
+        size = sizes[i];
+        count = max( 1, (512 * 512) / (size * size) );
+
+        SelectObject( dst_dc, GetStockObject( BLACK_BRUSH ));
+        blend.SourceConstantAlpha = 255;
+        blend.AlphaFormat = AC_SRC_ALPHA;
+        QueryPerformanceCounter( &start );
+        for (iter = 0; iter < count; iter++)
+            GdiAlphaBlend( dst_dc, 0, 0, size, size, src_dc, 0, 0, size, size, blend );
+        QueryPerformanceCounter( &end );
+        trace( "%4dx%-4d AlphaBlend per-pixel alpha: %.1f Mpixels/s\n", size, size,
+               get_mpixels( start, end, freq, count * size * size ));
+
+        blend.SourceConstantAlpha = 128;
+        QueryPerformanceCounter( &start );
+        for (iter = 0; iter < count; iter++)
+            GdiAlphaBlend( dst_dc, 0, 0, size, size, src_dc, 0, 0, size, size, blend );
+        QueryPerformanceCounter( &end );
+        trace( "%4dx%-4d AlphaBlend constant alpha:  %.1f Mpixels/s\n", size, size,
+               get_mpixels( start, end, freq, count * size * size ));
+
+        SelectObject( dst_dc, GetStockObject( GRAY_BRUSH ));
+        QueryPerformanceCounter( &start );
+        for (iter = 0; iter < count; iter++) PatBlt( dst_dc, 1, 0, size - 1, size, PATINVERT );
+        QueryPerformanceCounter( &end );
+        trace( "%4dx%-4d PatBlt solid PATINVERT:     %.1f Mpixels/s\n", size, size,
+               get_mpixels( start, end, freq, count * (size - 1) * size ));
+
+        SelectObject( dst_dc, brush );
+        QueryPerformanceCounter( &start );
+        for (iter = 0; iter < count; iter++) PatBlt( dst_dc, 1, 0, size - 1, size, PATINVERT );
+        QueryPerformanceCounter( &end );
+        trace( "%4dx%-4d PatBlt pattern PATINVERT:   %.1f Mpixels/s\n", size, size,
+               get_mpixels( start, end, freq, count * (size - 1) * size ));
+
+        QueryPerformanceCounter( &start );
+        for (iter = 0; iter < count; iter++) BitBlt( dst_dc, 0, 0, size, size, src_dc, 0, 0, SRCINVERT );
+        QueryPerformanceCounter( &end );
+        trace( "%4dx%-4d BitBlt SRCINVERT:           %.1f Mpixels/s\n", size, size,
+               get_mpixels( start, end, freq, count * size * size ));
+    }
+
+    DeleteObject( SelectObject( dst_dc, old_brush ));
+    DeleteObject( pat_dib );
+    HeapFree( GetProcessHeap(), 0, orig );
+    DeleteObject( SelectObject( src_dc, old_src ));
+    DeleteObject( SelectObject( dst_dc, old_dst ));
+    DeleteDC( src_dc );
+    DeleteDC( dst_dc );
+}
+
+static void test_stretch_convert(void)
+{
+    static const int src_width = 1920, src_height = 1080;
+    char bmibuf[sizeof(BITMAPINFO) + 2 * sizeof(RGBQUAD)];
+    BITMAPINFO *bmi = (BITMAPINFO *)bmibuf;
+    LARGE_INTEGER freq, start, end;
+    DWORD *src_bits, *dst_bits, seed = 0x4321;
+    BYTE *buffer;
+    HBITMAP src_dib, dst_dib, old_src, old_dst;
+    HDC src_dc, dst_dc;
+    int i, x, y, iter, count = 8, errors = 0, stride24;
+
+    memset( bmi, 0, sizeof(bmibuf) );
+    bmi->bmiHeader.biSize = sizeof(bmi->bmiHeader);
+    bmi->bmiHeader.biWidth = src_width;
+    bmi->bmiHeader.biHeight = -src_height;
+    bmi->bmiHeader.biBitCount = 32;
+    bmi->bmiHeader.biPlanes = 1;
+    bmi->bmiHeader.biCompression = BI_RGB;
+
+    src_dc = CreateCompatibleDC( NULL );
+    dst_dc = CreateCompatibleDC( NULL );
+    src_dib = CreateDIBSection( 0, bmi, DIB_RGB_COLORS, (void **)&src_bits, NULL, 0 );
+    bmi->bmiHeader.biWidth = 2 * src_width;
+    bmi->bmiHeader.biHeight = -2 * src_height;
+    dst_dib = CreateDIBSection( 0, bmi, DIB_RGB_COLORS, (void **)&dst_bits, NULL, 0 );
+    ok( src_dib != NULL && dst_dib != NULL, "CreateDIBSection failed\n" );
+    old_src = SelectObject( src_dc, src_dib );
+    old_dst = SelectObject( dst_dc, dst_dib );
+
+    for (i = 0; i < src_width * src_height; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        src_bits[i] = (seed >> 8) & 0xffffff;
+    }
+
+    SetStretchBltMode( dst_dc, COLORONCOLOR );
+    StretchBlt( dst_dc, 0, 0, 2 * src_width, 2 * src_height, src_dc, 0, 0, src_width, src_height, SRCCOPY );
+    for (y = 0; y < 2 * src_height && errors < 5; y++)
+        for (x = 0; x < 2 * src_width && errors < 5; x++)
+            if (dst_bits[y * 2 * src_width + x] != src_bits[(y / 2) * src_width + x / 2])
+            {
+                ok( 0, "%d,%d: got %08x expected %08x\n", x, y, dst_bits[y * 2 * src_width + x],
+                    src_bits[(y / 2) * src_width + x / 2] );
+                errors++;
+            }
+
+    /* large conversion from 32 to 24 bpp */
+    stride24 = (src_width * 3 + 3) & ~3;
+    buffer = HeapAlloc( GetProcessHeap(), 0, stride24 * src_height );
+    bmi->bmiHeader.biWidth = src_width;
+    bmi->bmiHeader.biHeight = -src_height;
+    bmi->bmiHeader.biBitCount = 24;
+    SelectObject( src_dc, old_src );
+    i = GetDIBits( src_dc, src_dib, 0, src_height, buffer, bmi, DIB_RGB_COLORS );
+    ok( i == src_height, "got %d\n", i );
+    for (y = 0, errors = 0; y < src_height && errors < 5; y++)
+        for (x = 0; x < src_width && errors < 5; x++)
+        {
+            BYTE *ptr = buffer + y * stride24 + x * 3;
+            DWORD val = ptr[0] | ptr[1] << 8 | ptr[2] << 16;
+            if (val == src_bits[y * src_width + x]) continue;
+            ok( 0, "%d,%d: got %06x expected %06x\n", x, y, val, src_bits[y * src_width + x] );
+            errors++;
+        }
+
+    QueryPerformanceFrequency( &freq );
+    SelectObject( src_dc, src_dib );
+    QueryPerformanceCounter( &start );
+    for (iter = 0; iter < count; iter++)
+        StretchBlt( dst_dc, 0, 0, 2 * src_width, 2 * src_height, src_dc, 0, 0, src_width, src_height, SRCCOPY );
+    QueryPerformanceCounter( &end );
+    trace( "StretchBlt %dx%d -> %dx%d: %.1f Mpixels/s\n", src_width, src_height, 2 * src_width, 2 * src_height,
+           get_mpixels( start, end, freq, count * 4 * src_width * src_height ));
+
+    SetStretchBltMode( src_dc, COLORONCOLOR );
+    QueryPerformanceCounter( &start );
+    for (iter = 0; iter < count; iter++)
+        StretchBlt( src_dc, 0, 0, src_width, src_height, dst_dc, 0, 0, 2 * src_width, 2 * src_height, SRCCOPY );
+    QueryPerformanceCounter( &end );
+    trace( "StretchBlt %dx%d -> %dx%d: %.1f Mpixels/s\n", 2 * src_width, 2 * src_height, src_width, src_height,
+           get_mpixels( start, end, freq, count * src_width * src_height ));
+
+    SelectObject( src_dc, old_src );
+    QueryPerformanceCounter( &start );
+    for (iter = 0; iter < count; iter++)
+        GetDIBits( src_dc, src_dib, 0, src_height, buffer, bmi, DIB_RGB_COLORS );
+    QueryPerformanceCounter( &end );
+    trace( "GetDIBits 32 -> 24 bpp %dx%d: %.1f Mpixels/s\n", src_width, src_height,
+           get_mpixels( start, end, freq, count * src_width * src_height ));
+
+    HeapFree( GetProcessHeap(), 0, buffer );
+    DeleteObject( src_dib );
+    DeleteObject( SelectObject( dst_dc, old_dst ));
+    DeleteDC( src_dc );
+    DeleteDC( dst_dc );
+}
+
+static void test_text_out( const char *output )
+{
+    static const WCHAR text[] = L"The quick brown fox jumps over the lazy dog 0123456789";
+    static const int width = 1024, height = 768, len = ARRAY_SIZE(text) - 1;
+    char bmibuf[sizeof(BITMAPINFO)];
+    BITMAPINFO *bmi = (BITMAPINFO *)bmibuf;
+    LARGE_INTEGER freq, start, end;
+    DWORD *bits, *copy;
+    HBITMAP dib, old_dib;
+    HFONT font, old_font;
+    LOGFONTW lf;
+    HDC dc;
+    int size, iter, y, count = 20;
+    double secs;
+
+    memset( bmi, 0, sizeof(bmibuf) );
+    bmi->bmiHeader.biSize = sizeof(bmi->bmiHeader);
+    bmi->bmiHeader.biWidth = width;
+    bmi->bmiHeader.biHeight = -height;
+    bmi->bmiHeader.biBitCount = 32;
+    bmi->bmiHeader.biPlanes = 1;
+    bmi->bmiHeader.biCompression = BI_RGB;
+
+    dc = CreateCompatibleDC( NULL );
+    dib = CreateDIBSection( 0, bmi, DIB_RGB_COLORS, (void **)&bits, NULL, 0 );
+    ok( dib != NULL, "CreateDIBSection failed\n" );
+    old_dib = SelectObject( dc, dib );
+    copy = HeapAlloc( GetProcessHeap(), 0, width * height * 4 );
+    SetTextColor( dc, RGB( 0x20, 0x40, 0x80 ));
+    SetBkMode( dc, TRANSPARENT );
+
+    memset( &lf, 0, sizeof(lf) );
+    lf.lfQuality = ANTIALIASED_QUALITY;
+    lstrcpyW( lf.lfFaceName, L"Arial" );
+    QueryPerformanceFrequency( &freq );
+
+    /* the first pass rasterizes every glyph, the second one must draw the same pixels from the cache */
+    for (iter = 0; iter < 2; iter++)
+    {
+        memset( bits, 0xff, width * height * 4 );
+        QueryPerformanceCounter( &start );
+        for (size = 8, y = 0; size < 40; size++, y += size)
+        {
+            lf.lfHeight = -size;
+            font = CreateFontIndirectW( &lf );
+            old_font = SelectObject( dc, font );
+            ExtTextOutW( dc, 0, y, 0, NULL, text, len, NULL );
+            DeleteObject( SelectObject( dc, old_font ));
+        }
+        QueryPerformanceCounter( &end );
+        secs = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+        trace( "ExtTextOut %s glyphs: %.0f glyphs/s\n", iter ? "cached" : "new",
+               secs > 0 ? 32 * len / secs : 0.0 );
+        if (!iter) memcpy( copy, bits, width * height * 4 );
+        else ok( !memcmp( copy, bits, width * height * 4 ), "cached glyphs differ\n" );
+    }
+
+    if (output)
+    {
+        DWORD written = 0;
+        HANDLE file = CreateFileA( output, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL );
+
+        ok( file != INVALID_HANDLE_VALUE, "failed to create %s, error %u\n", output, GetLastError() );
+        WriteFile( file, copy, width * height * 4, &written, NULL );
+        ok( written == width * height * 4, "wrote %u bytes\n", written );
+        CloseHandle( file );
+    }
+
+    lf.lfHeight = -16;
+    font = CreateFontIndirectW( &lf );
+    old_font = SelectObject( dc, font );
+    QueryPerformanceCounter( &start );
+    for (iter = 0; iter < count; iter++)
+        for (y = 0; y < height; y += 16) ExtTextOutW( dc, 0, y, 0, NULL, text, len, NULL );
+    QueryPerformanceCounter( &end );
+    secs = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+    trace( "ExtTextOut 16px antialiased: %.0f glyphs/s\n", secs > 0 ? count * (height / 16) * len / secs : 0.0 );
+
+    DeleteObject( SelectObject( dc, old_font ));
+    HeapFree( GetProcessHeap(), 0, copy );
+    DeleteObject( SelectObject( dc, old_dib ));
+    DeleteDC( dc );
+}
+
+static BOOL read_text_out( const char *name, DWORD *bits, DWORD size )
+{
+    DWORD read = 0;
+    HANDLE file = CreateFileA( name, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL );
+
+    if (file == INVALID_HANDLE_VALUE) return FALSE;
+    ReadFile( file, bits, size, &read, NULL );
+    CloseHandle( file );
+    DeleteFileA( name );
+    return read == size;
+}
+
+/* runs test_text_out in child processes with the Wine shared glyph cache enabled */
+static void test_shared_glyph_cache(void)
+{
+    static const DWORD cache_mb = 4, size = 1024 * 768 * 4;
+    char cmdline[MAX_PATH * 2], tmp_path[MAX_PATH], tmp_name[2][MAX_PATH];
+    DWORD old_value, old_size = sizeof(old_value), *bits[2];
+    PROCESS_INFORMATION info;
+    STARTUPINFOA startup;
+    HANDLE mapping;
+    LONG *header, hits = 0;
+    BOOL had_key, had_value;
+    char **argv;
+    HKEY key;
+    int i;
+
+    had_key = !RegOpenKeyA( HKEY_CURRENT_USER, "Software\\Wine\\Gdi", &key );
+    if (had_key) RegCloseKey( key );
+    if (RegCreateKeyA( HKEY_CURRENT_USER, "Software\\Wine\\Gdi", &key ))
+    {
+        skip( "can't create the Gdi key\n" );
+        return;
+    }
+    had_value = !RegQueryValueExA( key, "GlyphCacheSize", NULL, NULL, (BYTE *)&old_value, &old_size );
+    RegSetValueExA( key, "GlyphCacheSize", 0, REG_DWORD, (const BYTE *)&cache_mb, sizeof(cache_mb) );
+
+    /* keep the cache alive between the child processes */
+    mapping = CreateFileMappingW( INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, cache_mb << 20,
+                                  L"__wine_gdi_glyph_cache" );
+    ok( mapping != NULL, "CreateFileMapping failed, error %u\n", GetLastError() );
+    header = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+
+    winetest_get_mainargs( &argv );
+    GetTempPathA( MAX_PATH, tmp_path );
+    for (i = 0; i < 2; i++)
+    {
+        GetTempFileNameA( tmp_path, "dib", 0, tmp_name[i] );
+        sprintf( cmdline, "%s dib text_out %s", argv[0], tmp_name[i] );
+        memset( &startup, 0, sizeof(startup) );
+        startup.cb = sizeof(startup);
+        ok( CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &startup, &info ),
+            "CreateProcess failed, error %u\n", GetLastError() );
+        wait_child_process( info.hProcess );
+        CloseHandle( info.hProcess );
+        CloseHandle( info.hThread );
+        /* the first child filled the cache, the second one draws from it */
+        if (!header) continue;
+        if (!i)
+        {
+            ok( header[0] == 0x31484757, "shared glyph cache not used, magic %08x\n", header[0] );
+            hits = header[8];
+        }
+        else ok( header[8] > hits, "second process didn't read from the shared cache, %d hits\n", header[8] );
+    }
+
+    bits[0] = HeapAlloc( GetProcessHeap(), 0, size );
+    bits[1] = HeapAlloc( GetProcessHeap(), 0, size );
+    ok( read_text_out( tmp_name[0], bits[0], size ), "failed to read the first output\n" );
+    ok( read_text_out( tmp_name[1], bits[1], size ), "failed to read the second output\n" );
+    ok( !memcmp( bits[0], bits[1], size ), "glyphs from the shared cache differ\n" );
+    HeapFree( GetProcessHeap(), 0, bits[0] );
+    HeapFree( GetProcessHeap(), 0, bits[1] );
+
+    if (header) UnmapViewOfFile( header );
+    CloseHandle( mapping );
+    if (had_value) RegSetValueExA( key, "GlyphCacheSize", 0, REG_DWORD, (const BYTE *)&old_value, sizeof(old_value) );
+    else RegDeleteValueA( key, "GlyphCacheSize" );
+    RegCloseKey( key );
+    if (!had_key) RegDeleteKeyA( HKEY_CURRENT_USER, "Software\\Wine\\Gdi" );
+}
+
 START_TEST(dib)
 {
+    char **argv;
+    int argc;
+
+    argc = winetest_get_mainargs( &argv );
+    if (argc >= 4 && !strcmp( argv[2], "text_out" ))
+    {
+        test_text_out( argv[3] );
+        return;
+    }
+
     CryptAcquireContextW(&crypt_prov, NULL, NULL, PROV_RSA_FULL, CRYPT_VERIFYCONTEXT);
 
     test_simple_graphics();
+    test_blend_rop_32();
+    test_stretch_convert();
+    test_text_out( NULL );
+    if (!strcmp( winetest_platform, "wine" ))
+        test_shared_glyph_cache();
 
     CryptReleaseContext(crypt_prov, 0);
 }
@@ -5209,6 +5209,170 @@ todo_wine
     ReleaseDC(NULL, hdc);
 }
 
+static int CALLBACK count_families_proc( const LOGFONTA *lf, const TEXTMETRICA *tm, DWORD type, LPARAM lparam )
+{
+    (*(int *)lparam)++;
+    return 1;
+}
+
+struct font_list_signature
+{
+    int count;
+    ULONGLONG hash;
+};
+
+static int CALLBACK font_list_signature_face_proc( const LOGFONTA *lf, const TEXTMETRICA *tm, DWORD type, LPARAM lparam )
+{
+    const ENUMLOGFONTEXA *elf = (const ENUMLOGFONTEXA *)lf;
+    struct font_list_signature *sig = (struct font_list_signature *)lparam;
+    ULONGLONG hash = 0xcbf29ce484222325ull;
+    const BYTE *ptr;
+
+    for (ptr = elf->elfFullName; *ptr; ptr++) hash = (hash ^ *ptr) * 0x100000001b3ull;
+    for (ptr = elf->elfStyle; *ptr; ptr++) hash = (hash ^ *ptr) * 0x100000001b3ull;
+    hash = (hash ^ lf->lfCharSet) * 0x100000001b3ull;
+    hash = (hash ^ type) * 0x100000001b3ull;
+    /* order independent, faces may be enumerated in a different order */
+    sig->hash += hash;
+    sig->count++;
+    return 1;
+}
+
+static int CALLBACK font_list_signature_family_proc( const LOGFONTA *lf, const TEXTMETRICA *tm, DWORD type, LPARAM lparam )
+{
+    HDC hdc = CreateCompatibleDC( 0 );
+    LOGFONTA family;
+
+    memset( &family, 0, sizeof(family) );
+    family.lfCharSet = DEFAULT_CHARSET;
+    strcpy( family.lfFaceName, lf->lfFaceName );
+    EnumFontFamiliesExA( hdc, &family, font_list_signature_face_proc, lparam, 0 );
+    DeleteDC( hdc );
+    return 1;
+}
+
+static void get_font_list_signature( HDC hdc, struct font_list_signature *sig )
+{
+    LOGFONTA lf;
+
+    memset( &lf, 0, sizeof(lf) );
+    lf.lfCharSet = DEFAULT_CHARSET;
+    sig->count = 0;
+    sig->hash = 0;
+    EnumFontFamiliesExA( hdc, &lf, font_list_signature_family_proc, (LPARAM)sig, 0 );
+}
+
+static double elapsed_ms( LARGE_INTEGER start, LARGE_INTEGER end, LARGE_INTEGER freq )
+{
+    return (end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart;
+}
+
+static void create_and_enum_fonts( HDC hdc, int *count )
+{
+    LOGFONTA lf;
+    HFONT font;
+
+    memset( &lf, 0, sizeof(lf) );
+    lf.lfHeight = -12;
+    lf.lfCharSet = DEFAULT_CHARSET;
+    strcpy( lf.lfFaceName, "Arial" );
+    font = CreateFontIndirectA( &lf );
+    ok( font != NULL, "CreateFontIndirect failed\n" );
+    DeleteObject( SelectObject( hdc, font ));
+
+    lf.lfFaceName[0] = 0;
+    *count = 0;
+    EnumFontFamiliesExA( hdc, &lf, count_families_proc, (LPARAM)count, 0 );
+}
+
+/* runs in a child process, so that the first call includes loading the font list */
+static void test_font_list_speed( const char *output )
+{
+    struct font_list_signature sig;
+    LARGE_INTEGER freq, start, end;
+    int i, count;
+    double first;
+    DWORD written;
+    HANDLE file;
+    HDC hdc;
+
+    QueryPerformanceFrequency( &freq );
+    hdc = CreateCompatibleDC( 0 );
+
+    QueryPerformanceCounter( &start );
+    create_and_enum_fonts( hdc, &count );
+    QueryPerformanceCounter( &end );
+    first = elapsed_ms( start, end, freq );
+    ok( count > 0, "no font families\n" );
+
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < 10; i++) create_and_enum_fonts( hdc, &count );
+    QueryPerformanceCounter( &end );
+    trace( "CreateFontIndirect + EnumFontFamiliesEx, %d entries: first %.2f ms, then %.2f ms\n",
+           count, first, elapsed_ms( start, end, freq ) / 10 );
+
+    get_font_list_signature( hdc, &sig );
+    file = CreateFileA( output, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL );
+    ok( file != INVALID_HANDLE_VALUE, "failed to create %s, error %u\n", output, GetLastError() );
+    WriteFile( file, &sig, sizeof(sig), &written, NULL );
+    ok( written == sizeof(sig), "wrote %u bytes\n", written );
+    CloseHandle( file );
+
+    DeleteDC( hdc );
+}
+
+static void test_font_startup_time(void)
+{
+    struct font_list_signature sig[2];
+    PROCESS_INFORMATION info;
+    STARTUPINFOA startup;
+    LARGE_INTEGER freq, start, end;
+    char path_name[MAX_PATH * 2], tmp_path[MAX_PATH], tmp_name[MAX_PATH], cache[MAX_PATH];
+    char **argv;
+    DWORD size;
+    HANDLE file;
+    int i;
+
+    winetest_get_mainargs( &argv );
+    QueryPerformanceFrequency( &freq );
+    GetTempPathA( MAX_PATH, tmp_path );
+    GetTempFileNameA( tmp_path, "fnt", 0, tmp_name );
+    sprintf( path_name, "%s font font_list_speed %s", argv[0], tmp_name );
+
+    /* make the first start scan the font directories, the second one should find them cached */
+    GetSystemDirectoryA( cache, MAX_PATH - 16 );
+    strcat( cache, "\\fontlist.dat" );
+    if (!DeleteFileA( cache ) && GetLastError() != ERROR_FILE_NOT_FOUND)
+        trace( "failed to delete %s, error %u\n", cache, GetLastError() );
+
+    for (i = 0; i < 2; i++)
+    {
+        memset( &startup, 0, sizeof(startup) );
+        startup.cb = sizeof(startup);
+        QueryPerformanceCounter( &start );
+        ok( CreateProcessA( NULL, path_name, NULL, NULL, FALSE, 0, NULL, NULL, &startup, &info ),
+            "CreateProcess failed\n" );
+        wait_child_process( info.hProcess );
+        QueryPerformanceCounter( &end );
+        trace( "%s process run: %.1f ms\n", i ? "warm" : "cold", elapsed_ms( start, end, freq ));
+        CloseHandle( info.hProcess );
+        CloseHandle( info.hThread );
+
+        memset( &sig[i], 0, sizeof(sig[i]) );
+        file = CreateFileA( tmp_name, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL );
+        ok( file != INVALID_HANDLE_VALUE, "failed to open %s, error %u\n", tmp_name, GetLastError() );
+        ReadFile( file, &sig[i], sizeof(sig[i]), &size, NULL );
+        ok( size == sizeof(sig[i]), "read %u bytes\n", size );
+        CloseHandle( file );
+    }
+    DeleteFileA( tmp_name );
+
+    /* the cached font list must match the one from a fresh scan */
+    ok( sig[0].count > 0, "no fonts enumerated\n" );
+    ok( sig[0].count == sig[1].count, "got %d fonts, then %d fonts\n", sig[0].count, sig[1].count );
+    ok( sig[0].hash == sig[1].hash, "font lists differ\n" );
+}
+
 static void test_AddFontMemResource(void)
 {
     char ttf_name[MAX_PATH];
@@ -7738,6 +7902,8 @@ START_TEST(font)
     {
         if (!strcmp(argv[2], "AddFontMemResource"))
             test_AddFontMemResource();
+        else if (!strcmp(argv[2], "font_list_speed") && argc >= 4)
+            test_font_list_speed(argv[3]);
         return;
     }
 
@@ -7806,6 +7972,7 @@ START_TEST(font)
     test_ttf_names();
     test_lang_names();
     test_char_width();
+    test_font_startup_time();
 
     /* These tests should be last test until RemoveFontResource
      * is properly implemented.
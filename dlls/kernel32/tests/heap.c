@@ -889,15 +889,182 @@ static void test_HeapQueryInformation(void)
     ok(info == 0 || info == 1 || info == 2, "expected 0, 1 or 2, got %u\n", info);
 }
 
+static void test_low_fragmentation_heap(void)
+{
+    PROCESS_HEAP_ENTRY entry;
+    ULONG info;
+    HANDLE heap;
+    void *ptrs[64];
+    BOOL ret;
+    int i, busy;
+
+    if (!pHeapQueryInformation)
+    {
+        win_skip("HeapQueryInformation is not available\n");
+        return;
+    }
+
+    heap = HeapCreate( 0, 0, 0 );
+    ok( heap != NULL, "HeapCreate failed\n" );
+
+    info = 2;
+    ret = HeapSetInformation( heap, HeapCompatibilityInformation, &info, sizeof(info) );
+    ok( ret, "HeapSetInformation error %u\n", GetLastError() );
+    info = 0xdeadbeef;
+    ret = pHeapQueryInformation( heap, HeapCompatibilityInformation, &info, sizeof(info), NULL );
+    ok( ret, "HeapQueryInformation error %u\n", GetLastError() );
+    ok( info == 2, "expected 2, got %u\n", info );
+
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++)
+    {
+        ptrs[i] = HeapAlloc( heap, 0, 16 + (i % 8) * 24 );
+        ok( ptrs[i] != NULL, "HeapAlloc failed\n" );
+        memset( ptrs[i], 0xcc, 16 + (i % 8) * 24 );
+    }
+    for (i = 0; i < ARRAY_SIZE(ptrs); i += 2)
+    {
+        ret = HeapFree( heap, 0, ptrs[i] );
+        ok( ret, "HeapFree failed\n" );
+    }
+    ret = HeapValidate( heap, 0, NULL );
+    ok( ret, "HeapValidate failed\n" );
+    ret = HeapValidate( heap, 0, ptrs[1] );
+    ok( ret, "HeapValidate failed\n" );
+
+    busy = 0;
+    memset( &entry, 0, sizeof(entry) );
+    while (HeapWalk( heap, &entry ))
+    {
+        for (i = 1; i < ARRAY_SIZE(ptrs); i += 2)
+            if (entry.lpData == ptrs[i]) busy++;
+    }
+    ok( busy == ARRAY_SIZE(ptrs) / 2, "found %d of %d allocated blocks\n", busy, ARRAY_SIZE(ptrs) / 2 );
+
+    /* blocks are reused, and zeroed when requested */
+    for (i = 0; i < ARRAY_SIZE(ptrs); i += 2)
+    {
+        ptrs[i] = HeapAlloc( heap, HEAP_ZERO_MEMORY, 16 + (i % 8) * 24 );
+        ok( ptrs[i] != NULL, "HeapAlloc failed\n" );
+        ok( !*(DWORD *)ptrs[i], "block not zeroed\n" );
+        ok( HeapSize( heap, 0, ptrs[i] ) == 16 + (i % 8) * 24, "wrong size %lu\n", HeapSize( heap, 0, ptrs[i] ) );
+    }
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++) HeapFree( heap, 0, ptrs[i] );
+
+    /* invalid frees are still caught, Windows may terminate the process instead */
+    if (!strcmp( winetest_platform, "wine" ))
+    {
+        HANDLE heap2 = HeapCreate( 0, 0, 0 );
+        void *ptr = HeapAlloc( heap2, 0, 32 );
+
+        SetLastError( 0xdeadbeef );
+        ret = HeapFree( heap, 0, ptr );
+        ok( !ret, "HeapFree succeeded\n" );
+        ok( GetLastError() == ERROR_INVALID_PARAMETER, "got error %u\n", GetLastError() );
+        ret = HeapFree( heap2, 0, ptr );
+        ok( ret, "HeapFree failed\n" );
+        HeapDestroy( heap2 );
+
+        ptr = HeapAlloc( heap, 0, 32 );
+        ret = HeapFree( heap, 0, ptr );
+        ok( ret, "HeapFree failed\n" );
+        SetLastError( 0xdeadbeef );
+        ret = HeapFree( heap, 0, ptr );
+        ok( !ret, "HeapFree succeeded\n" );
+        ok( GetLastError() == ERROR_INVALID_PARAMETER, "got error %u\n", GetLastError() );
+    }
+
+    ret = HeapDestroy( heap );
+    ok( ret, "HeapDestroy failed\n" );
+
+    /* cached blocks are given back and coalesced before the heap gives up */
+    heap = HeapCreate( 0, 0x10000, 0x10000 );
+    ok( heap != NULL, "HeapCreate failed\n" );
+    info = 2;
+    ret = HeapSetInformation( heap, HeapCompatibilityInformation, &info, sizeof(info) );
+    ok( ret, "HeapSetInformation error %u\n", GetLastError() );
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++) ptrs[i] = HeapAlloc( heap, 0, 0x200 );
+    for (i = 0; i < ARRAY_SIZE(ptrs); i++) HeapFree( heap, 0, ptrs[i] );
+    ptrs[0] = HeapAlloc( heap, 0, 0x8000 );
+    ok( ptrs[0] != NULL, "HeapAlloc failed\n" );
+    ret = HeapValidate( heap, 0, NULL );
+    ok( ret, "HeapValidate failed\n" );
+    ret = HeapDestroy( heap );
+    ok( ret, "HeapDestroy failed\n" );
+}
+
+#define ALLOC_ROUNDS 200000
+
+struct alloc_thread_params
+{
+    HANDLE heap;
+    HANDLE start;
+};
+
+static DWORD WINAPI alloc_thread( void *arg )
+{
+    struct alloc_thread_params *params = arg;
+    void *ptrs[16];
+    int i;
+
+    WaitForSingleObject( params->start, INFINITE );
+    memset( ptrs, 0, sizeof(ptrs) );
+    for (i = 0; i < ALLOC_ROUNDS; i++)
+    {
+        HeapFree( params->heap, 0, ptrs[i % 16] );
+        ptrs[i % 16] = HeapAlloc( params->heap, 0, 8 + (i % 32) * 8 );
+    }
+    for (i = 0; i < 16; i++) HeapFree( params->heap, 0, ptrs[i] );
+    return 0;
+}
+
+static void test_alloc_throughput( ULONG compat )
+{
+    static const int counts[] = { 1, 4, 16 };
+    struct alloc_thread_params params;
+    HANDLE threads[16];
+    DWORD start;
+    int i, j;
+
+    params.heap = HeapCreate( 0, 0, 0 );
+    ok( params.heap != NULL, "HeapCreate failed\n" );
+    if (compat) HeapSetInformation( params.heap, HeapCompatibilityInformation, &compat, sizeof(compat) );
+
+    for (i = 0; i < ARRAY_SIZE(counts); i++)
+    {
+        params.start = CreateEventA( NULL, TRUE, FALSE, NULL );
+        for (j = 0; j < counts[i]; j++)
+            threads[j] = CreateThread( NULL, 0, alloc_thread, &params, 0, NULL );
+        start = GetTickCount();
+        SetEvent( params.start );
+        WaitForMultipleObjects( counts[i], threads, TRUE, INFINITE );
+        trace( "compat %u, %d threads: %u allocations in %u ms\n",
+               compat, counts[i], counts[i] * ALLOC_ROUNDS, GetTickCount() - start );
+        for (j = 0; j < counts[i]; j++) CloseHandle( threads[j] );
+        CloseHandle( params.start );
+    }
+    ok( HeapValidate( params.heap, 0, NULL ), "HeapValidate failed\n" );
+    HeapDestroy( params.heap );
+}
+
 static void test_heap_checks( DWORD flags )
 {
     BYTE old, *p, *p2;
+    HANDLE heap;
+    ULONG info;
     BOOL ret;
     SIZE_T i, size, large_size = 3000 * 1024 + 37;
 
     if (flags & HEAP_PAGE_ALLOCS) return;  /* no tests for that case yet */
     trace( "testing heap flags %08x\n", flags );
 
+    /* enabling the low fragmentation heap succeeds with debugging flags too */
+    heap = HeapCreate( 0, 0, 0 );
+    ok( heap != NULL, "HeapCreate failed\n" );
+    info = 2;
+    ret = HeapSetInformation( heap, HeapCompatibilityInformation, &info, sizeof(info) );
+    ok( ret, "HeapSetInformation error %u\n", GetLastError() );
+    HeapDestroy( heap );
+
     p = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, 17 );
     ok( p != NULL, "HeapAlloc failed\n" );
 
@@ -1245,6 +1412,9 @@ START_TEST(heap)
     test_sized_HeapReAlloc((1 << 20), 1);
 
     test_HeapQueryInformation();
+    test_low_fragmentation_heap();
+    test_alloc_throughput( 0 );
+    test_alloc_throughput( 2 );
     test_GetPhysicallyInstalledSystemMemory();
 
     if (pRtlGetNtGlobalFlags)
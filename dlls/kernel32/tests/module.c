@@ -310,6 +310,41 @@ static void testGetProcAddress_Wrong(void)
     ok( GetLastError() == ERROR_MOD_NOT_FOUND, "Expected ERROR_MOD_NOT_FOUND, got %d\n", GetLastError() );
 }
 
+static void testGetProcAddress_Names(void)
+{
+    HMODULE module = GetModuleHandleA( "ntdll.dll" );
+    const IMAGE_NT_HEADERS *nt = (const IMAGE_NT_HEADERS *)((const char *)module + ((const IMAGE_DOS_HEADER *)module)->e_lfanew);
+    const IMAGE_DATA_DIRECTORY *dir = &nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_EXPORT];
+    const IMAGE_EXPORT_DIRECTORY *exports = (const IMAGE_EXPORT_DIRECTORY *)((const char *)module + dir->VirtualAddress);
+    const DWORD *names = (const DWORD *)((const char *)module + exports->AddressOfNames);
+    const DWORD *functions = (const DWORD *)((const char *)module + exports->AddressOfFunctions);
+    const WORD *ordinals = (const WORD *)((const char *)module + exports->AddressOfNameOrdinals);
+    char name[256];
+    FARPROC fp;
+    DWORD i, rva;
+
+    ok( exports->NumberOfNames > 1000, "got %u names\n", exports->NumberOfNames );
+
+    for (i = 0; i < exports->NumberOfNames; i++)
+    {
+        const char *ename = (const char *)module + names[i];
+
+        fp = GetProcAddress( module, ename );
+        ok( fp != NULL, "%s not found\n", ename );
+        rva = functions[ordinals[i]];
+        if (rva < dir->VirtualAddress || rva >= dir->VirtualAddress + dir->Size)  /* not forwarded */
+            ok( fp == (FARPROC)((const char *)module + rva), "%s: got %p\n", ename, fp );
+    }
+
+    /* names are case sensitive */
+    strcpy( name, "RTLALLOCATEHEAP" );
+    fp = GetProcAddress( module, name );
+    ok( !fp, "%s should not be found\n", name );
+    strcpy( name, "RtlAllocateHea" );
+    fp = GetProcAddress( module, name );
+    ok( !fp, "%s should not be found\n", name );
+}
+
 static void testLoadLibraryEx(void)
 {
     CHAR path[MAX_PATH];
@@ -1176,6 +1211,7 @@ START_TEST(module)
     testNestedLoadLibraryA();
     testLoadLibraryA_Wrong();
     testGetProcAddress_Wrong();
+    testGetProcAddress_Names();
     testLoadLibraryEx();
     test_LoadLibraryEx_search_flags();
     testGetModuleHandleEx();
@@ -230,6 +230,7 @@ static Scheduler* (__cdecl *p_Scheduler_Create)(SchedulerPolicy*);
 static Scheduler* (__cdecl *p_CurrentScheduler_Get)(void);
 static void (__cdecl *p_CurrentScheduler_Detach)(void);
 static unsigned int (__cdecl *p_CurrentScheduler_Id)(void);
+static void (__cdecl *p_CurrentScheduler_ScheduleTask)(void (__cdecl*)(void*), void*);
 
 static int (__cdecl *p__memicmp)(const char*, const char*, size_t);
 static int (__cdecl *p__memicmp_l)(const char*, const char*, size_t,_locale_t);
@@ -318,6 +319,7 @@ static BOOL init(void)
         SET(p_SchedulerPolicy_dtor, "??1SchedulerPolicy@Concurrency@@QEAA@XZ");
         SET(p_Scheduler_Create, "?Create@Scheduler@Concurrency@@SAPEAV12@AEBVSchedulerPolicy@2@@Z");
         SET(p_CurrentScheduler_Get, "?Get@CurrentScheduler@Concurrency@@SAPEAVScheduler@2@XZ");
+        SET(p_CurrentScheduler_ScheduleTask, "?ScheduleTask@CurrentScheduler@Concurrency@@SAXP6AXPEAX@Z0@Z");
     } else {
         SET(pSpinWait_ctor_yield, "??0?$_SpinWait@$00@details@Concurrency@@QAE@P6AXXZ@Z");
         SET(pSpinWait_dtor, "??_F?$_SpinWait@$00@details@Concurrency@@QAEXXZ");
@@ -359,6 +361,7 @@ static BOOL init(void)
         SET(p_SchedulerPolicy_dtor, "??1SchedulerPolicy@Concurrency@@QAE@XZ");
         SET(p_Scheduler_Create, "?Create@Scheduler@Concurrency@@SAPAV12@ABVSchedulerPolicy@2@@Z");
         SET(p_CurrentScheduler_Get, "?Get@CurrentScheduler@Concurrency@@SAPAVScheduler@2@XZ");
+        SET(p_CurrentScheduler_ScheduleTask, "?ScheduleTask@CurrentScheduler@Concurrency@@SAXP6AXPAX@Z0@Z");
     }
 
     init_thiscall_thunk();
@@ -989,6 +992,82 @@ static void test_Scheduler(void)
     call_func1(p_SchedulerPolicy_dtor, &policy);
 }
 
+#define SCHEDULE_TASK_COUNT 100000
+#define SCHEDULE_TASK_DEPTH 12
+
+static LONG schedule_task_count;
+static HANDLE schedule_task_done;
+
+static void __cdecl schedule_task_proc(void *arg)
+{
+    if (InterlockedDecrement(&schedule_task_count) == 0)
+        SetEvent(schedule_task_done);
+}
+
+static void __cdecl schedule_task_spawn_proc(void *arg)
+{
+    INT_PTR depth = (INT_PTR)arg;
+
+    if (depth) {
+        p_CurrentScheduler_ScheduleTask(schedule_task_spawn_proc, (void*)(depth - 1));
+        p_CurrentScheduler_ScheduleTask(schedule_task_spawn_proc, (void*)(depth - 1));
+    }
+    schedule_task_proc(NULL);
+}
+
+static void CALLBACK schedule_task_threadpool_proc(TP_CALLBACK_INSTANCE *instance, void *arg)
+{
+    schedule_task_proc(arg);
+}
+
+static void test_ScheduleTask(void)
+{
+    LARGE_INTEGER freq, start, end;
+    double sched_time, tp_time;
+    DWORD ret;
+    int i;
+
+    QueryPerformanceFrequency(&freq);
+    schedule_task_done = CreateEventW(NULL, FALSE, FALSE, NULL);
+
+    /* parallel_for style: one producer, many small tasks */
+    schedule_task_count = SCHEDULE_TASK_COUNT;
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < SCHEDULE_TASK_COUNT; i++)
+        p_CurrentScheduler_ScheduleTask(schedule_task_proc, NULL);
+    ret = WaitForSingleObject(schedule_task_done, 20000);
+    QueryPerformanceCounter(&end);
+    ok(ret == WAIT_OBJECT_0, "WaitForSingleObject returned %u, %d tasks left\n",
+            ret, schedule_task_count);
+    sched_time = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+
+    schedule_task_count = SCHEDULE_TASK_COUNT;
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < SCHEDULE_TASK_COUNT; i++)
+        TrySubmitThreadpoolCallback(schedule_task_threadpool_proc, NULL, NULL);
+    ret = WaitForSingleObject(schedule_task_done, 20000);
+    QueryPerformanceCounter(&end);
+    ok(ret == WAIT_OBJECT_0, "WaitForSingleObject returned %u, %d tasks left\n",
+            ret, schedule_task_count);
+    tp_time = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
+
+    trace("%u tasks: ScheduleTask %.0f tasks/s, threadpool %.0f tasks/s\n", SCHEDULE_TASK_COUNT,
+            SCHEDULE_TASK_COUNT / sched_time, SCHEDULE_TASK_COUNT / tp_time);
+
+    /* tasks spawning tasks, exercises the worker deques and stealing */
+    schedule_task_count = (2 << SCHEDULE_TASK_DEPTH) - 1;
+    QueryPerformanceCounter(&start);
+    p_CurrentScheduler_ScheduleTask(schedule_task_spawn_proc, (void*)(INT_PTR)SCHEDULE_TASK_DEPTH);
+    ret = WaitForSingleObject(schedule_task_done, 20000);
+    QueryPerformanceCounter(&end);
+    ok(ret == WAIT_OBJECT_0, "WaitForSingleObject returned %u, %d tasks left\n",
+            ret, schedule_task_count);
+    trace("%u spawned tasks: %.0f tasks/s\n", (2 << SCHEDULE_TASK_DEPTH) - 1,
+            ((2 << SCHEDULE_TASK_DEPTH) - 1) * (double)freq.QuadPart / (end.QuadPart - start.QuadPart));
+
+    CloseHandle(schedule_task_done);
+}
+
 static void test__memicmp(void)
 {
     static const char *s1 = "abc";
@@ -1113,6 +1192,7 @@ START_TEST(msvcr100)
 
     test_ExternalContextBase();
     test_Scheduler();
+    test_ScheduleTask();
     test_wmemcpy_s();
     test_wmemmove_s();
     test_fread_s();
@@ -24,6 +24,8 @@
 #include "windef.h"
 #include "winternl.h"
 #include "wine/debug.h"
+#include "wine/exception.h"
+#include "wine/list.h"
 #include "msvcrt.h"
 #include "cppexcept.h"
 #include "cxx.h"
@@ -87,11 +89,14 @@ struct scheduler_list {
     struct scheduler_list *next;
 };
 
+struct scheduler_worker;
+
 typedef struct {
     Context context;
     struct scheduler_list scheduler;
     unsigned int id;
     union allocator_cache_entry *allocator_cache[8];
+    struct scheduler_worker *worker;
 } ExternalContextBase;
 extern const vtable_ptr ExternalContextBase_vtable;
 static void ExternalContextBase_ctor(ExternalContextBase*);
@@ -123,6 +128,41 @@ typedef struct Scheduler {
         void, (Scheduler*,void (__cdecl*)(void*),void*), (this,proc,data))
 #endif
 
+struct scheduled_task {
+    struct list entry;
+    void (__cdecl *proc)(void*);
+    void *data;
+    Scheduler *scheduler;
+};
+
+/* One worker per virtual processor. The owner pushes and pops tasks at the
+ * head of its deque, idle workers steal the oldest tasks from the tail. */
+struct scheduler_worker {
+    CRITICAL_SECTION cs;
+    struct list tasks;
+    struct scheduler_pool *pool;
+    unsigned int id;
+    HANDLE thread;
+    DWORD tid;
+};
+
+/* The pool outlives its scheduler until the last worker has exited, so a
+ * task may release the final scheduler reference. */
+struct scheduler_pool {
+    LONG ref;
+    Scheduler *scheduler;
+    unsigned int size;
+    unsigned int min_workers;
+    unsigned int started;
+    LONG next;
+    LONG pending;
+    LONG idle;
+    BOOL shutdown;
+    CRITICAL_SECTION cs;
+    CONDITION_VARIABLE cv;
+    struct scheduler_worker workers[1];
+};
+
 typedef struct {
     Scheduler scheduler;
     LONG ref;
@@ -133,6 +173,7 @@ typedef struct {
     int shutdown_size;
     HANDLE *shutdown_events;
     CRITICAL_SECTION cs;
+    struct scheduler_pool *pool;
 } ThreadScheduler;
 extern const vtable_ptr ThreadScheduler_vtable;
 
@@ -145,6 +186,7 @@ typedef struct {
 } _CurrentScheduler;
 
 static int context_tls_index = TLS_OUT_OF_INDEXES;
+static HMODULE scheduler_module;
 
 static CRITICAL_SECTION default_scheduler_cs;
 static CRITICAL_SECTION_DEBUG default_scheduler_cs_debug =
@@ -611,11 +653,242 @@ void __thiscall SchedulerPolicy_dtor(SchedulerPolicy *this)
     operator_delete(this->policy_container);
 }
 
+static void scheduler_pool_release(struct scheduler_pool *pool)
+{
+    unsigned int i;
+
+    if (InterlockedDecrement(&pool->ref))
+        return;
+
+    for (i = 0; i < pool->size; i++) {
+        pool->workers[i].cs.DebugInfo->Spare[0] = 0;
+        DeleteCriticalSection(&pool->workers[i].cs);
+    }
+    pool->cs.DebugInfo->Spare[0] = 0;
+    DeleteCriticalSection(&pool->cs);
+    operator_delete(pool);
+}
+
+static struct scheduler_pool* scheduler_pool_create(Scheduler *scheduler,
+        unsigned int size, unsigned int min_workers)
+{
+    struct scheduler_pool *pool;
+    unsigned int i;
+
+    pool = operator_new(FIELD_OFFSET(struct scheduler_pool, workers[size]));
+    memset(pool, 0, FIELD_OFFSET(struct scheduler_pool, workers[size]));
+    pool->ref = 1;
+    pool->scheduler = scheduler;
+    pool->size = size;
+    pool->min_workers = min_workers;
+    InitializeCriticalSection(&pool->cs);
+    pool->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": scheduler_pool.cs");
+    InitializeConditionVariable(&pool->cv);
+
+    for (i = 0; i < size; i++) {
+        struct scheduler_worker *worker = &pool->workers[i];
+
+        InitializeCriticalSection(&worker->cs);
+        worker->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": scheduler_worker.cs");
+        list_init(&worker->tasks);
+        worker->pool = pool;
+        worker->id = i;
+    }
+    return pool;
+}
+
+static struct scheduled_task* scheduler_worker_pop(struct scheduler_worker *worker, BOOL steal)
+{
+    struct list *entry;
+
+    if (list_empty(&worker->tasks))
+        return NULL;
+
+    EnterCriticalSection(&worker->cs);
+    entry = steal ? list_tail(&worker->tasks) : list_head(&worker->tasks);
+    if (entry)
+        list_remove(entry);
+    LeaveCriticalSection(&worker->cs);
+
+    return entry ? LIST_ENTRY(entry, struct scheduled_task, entry) : NULL;
+}
+
+static struct scheduled_task* scheduler_pool_get_task(struct scheduler_pool *pool,
+        struct scheduler_worker *worker)
+{
+    struct scheduled_task *task;
+    unsigned int i, started;
+
+    if (!(task = scheduler_worker_pop(worker, FALSE))) {
+        started = pool->started;
+        for (i = 1; i < started; i++) {
+            task = scheduler_worker_pop(&pool->workers[(worker->id + i) % started], TRUE);
+            if (task) break;
+        }
+    }
+
+    if (task)
+        InterlockedDecrement(&pool->pending);
+    return task;
+}
+
+static void CALLBACK scheduler_task_cleanup(BOOL normal, void *scheduler)
+{
+    call_Scheduler_Release(scheduler);
+}
+
+static DWORD WINAPI scheduler_worker_proc(void *arg)
+{
+    struct scheduler_worker *worker = arg;
+    struct scheduler_pool *pool = worker->pool;
+    struct scheduler_list *last;
+    ExternalContextBase *context;
+    struct scheduled_task *task;
+    BOOL shutdown;
+
+    TRACE("(%p) starting worker %u\n", pool, worker->id);
+
+    /* The worker context doesn't hold a scheduler reference, every queued
+     * task does instead. */
+    context = operator_new(sizeof(*context));
+    memset(context, 0, sizeof(*context));
+    context->context.vtable = &ExternalContextBase_vtable;
+    context->id = InterlockedIncrement(&context_id);
+    context->scheduler.scheduler = pool->scheduler;
+    context->worker = worker;
+    TlsSetValue(context_tls_index, context);
+
+    for (;;) {
+        if ((task = scheduler_pool_get_task(pool, worker))) {
+            void (__cdecl *proc)(void*) = task->proc;
+            void *data = task->data;
+            Scheduler *scheduler = task->scheduler;
+
+            /* Return the task to this thread's allocator cache before running
+             * it, so tasks spawned by it reuse the memory. */
+            Concurrency_Free(task);
+            /* Exceptions raised by the task aren't handled, like on native;
+             * only the scheduler reference is released on the way out. */
+            __TRY
+            {
+                proc(data);
+            }
+            __FINALLY_CTX(scheduler_task_cleanup, scheduler)
+            continue;
+        }
+
+        EnterCriticalSection(&pool->cs);
+        InterlockedIncrement(&pool->idle);
+        while (!pool->pending && !pool->shutdown)
+            SleepConditionVariableCS(&pool->cv, &pool->cs, INFINITE);
+        InterlockedDecrement(&pool->idle);
+        shutdown = pool->shutdown;
+        LeaveCriticalSection(&pool->cs);
+        if (shutdown) break;
+    }
+
+    TRACE("(%p) stopping worker %u\n", pool, worker->id);
+
+    /* Drop the unreferenced pool scheduler, it's always the last on the list. */
+    last = &context->scheduler;
+    if (!last->next) {
+        last->scheduler = NULL;
+    }else {
+        while (last->next->next) last = last->next;
+        operator_delete(last->next);
+        last->next = NULL;
+    }
+    context->worker = NULL;
+
+    scheduler_pool_release(pool);
+    FreeLibraryAndExitThread(scheduler_module, 0);
+}
+
+/* Called with pool->cs held. */
+static BOOL scheduler_pool_start_worker(struct scheduler_pool *pool)
+{
+    struct scheduler_worker *worker = &pool->workers[pool->started];
+    HMODULE module;
+
+    /* Every worker holds a module reference, so the DLL can't be unloaded
+     * while a worker is still running. */
+    if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS,
+                (const WCHAR *)scheduler_worker_proc, &module)) {
+        WARN("failed to get module handle: %u\n", GetLastError());
+        return FALSE;
+    }
+
+    InterlockedIncrement(&pool->ref);
+    worker->thread = CreateThread(NULL, 0, scheduler_worker_proc, worker, 0, &worker->tid);
+    if (!worker->thread) {
+        WARN("failed to start worker: %u\n", GetLastError());
+        InterlockedDecrement(&pool->ref);
+        FreeLibrary(module);
+        return FALSE;
+    }
+    pool->started++;
+    return TRUE;
+}
+
+static void scheduler_pool_push(struct scheduler_pool *pool, struct scheduled_task *task)
+{
+    ExternalContextBase *context = (ExternalContextBase*)try_get_current_context();
+    struct scheduler_worker *worker;
+
+    if (pool->started < pool->min_workers || (!pool->idle && pool->started < pool->size)) {
+        EnterCriticalSection(&pool->cs);
+        while (pool->started < pool->min_workers && scheduler_pool_start_worker(pool));
+        if (!pool->idle && pool->started < pool->size)
+            scheduler_pool_start_worker(pool);
+        LeaveCriticalSection(&pool->cs);
+
+        if (!pool->started)
+            throw_exception(EXCEPTION_SCHEDULER_RESOURCE_ALLOCATION_ERROR,
+                    HRESULT_FROM_WIN32(GetLastError()), NULL);
+    }
+
+    if (context && context->context.vtable == &ExternalContextBase_vtable
+            && context->worker && context->worker->pool == pool)
+        worker = context->worker;
+    else
+        worker = &pool->workers[(unsigned int)InterlockedIncrement(&pool->next) % pool->started];
+
+    EnterCriticalSection(&worker->cs);
+    list_add_head(&worker->tasks, &task->entry);
+    LeaveCriticalSection(&worker->cs);
+
+    InterlockedIncrement(&pool->pending);
+    if (pool->idle) {
+        EnterCriticalSection(&pool->cs);
+        WakeConditionVariable(&pool->cv);
+        LeaveCriticalSection(&pool->cs);
+    }
+}
+
+static void scheduler_pool_shutdown(struct scheduler_pool *pool, BOOL wait)
+{
+    DWORD tid = GetCurrentThreadId();
+    unsigned int i;
+
+    EnterCriticalSection(&pool->cs);
+    pool->shutdown = TRUE;
+    WakeAllConditionVariable(&pool->cv);
+    LeaveCriticalSection(&pool->cs);
+
+    for (i = 0; i < pool->started; i++) {
+        if (wait && pool->workers[i].tid != tid)
+            WaitForSingleObject(pool->workers[i].thread, INFINITE);
+        CloseHandle(pool->workers[i].thread);
+    }
+    scheduler_pool_release(pool);
+}
+
 static void ThreadScheduler_dtor(ThreadScheduler *this)
 {
     int i;
 
     if(this->ref != 0) WARN("ref = %d\n", this->ref);
+    if(this->pool) scheduler_pool_shutdown(this->pool, TRUE);
     SchedulerPolicy_dtor(&this->policy);
 
     for(i=0; i<this->shutdown_count; i++)
@@ -730,18 +1003,42 @@ DEFINE_THISCALL_WRAPPER(ThreadScheduler_CreateScheduleGroup, 4)
     return NULL;
 }
 
+DEFINE_THISCALL_WRAPPER(ThreadScheduler_ScheduleTask, 12)
+void __thiscall ThreadScheduler_ScheduleTask(ThreadScheduler *this,
+        void (__cdecl *proc)(void*), void* data)
+{
+    struct scheduled_task *task;
+
+    TRACE("(%p %p %p)\n", this, proc, data);
+
+    if(!this->pool) {
+        EnterCriticalSection(&this->cs);
+        if(!this->pool) {
+            unsigned int min_workers = SchedulerPolicy_GetPolicyValue(&this->policy, MinConcurrency);
+
+            if(min_workers > this->virt_proc_no) min_workers = this->virt_proc_no;
+            if(!min_workers) min_workers = 1;
+            this->pool = scheduler_pool_create(&this->scheduler, this->virt_proc_no, min_workers);
+        }
+        LeaveCriticalSection(&this->cs);
+    }
+
+    task = Concurrency_Alloc(sizeof(*task));
+    task->proc = proc;
+    task->data = data;
+    task->scheduler = &this->scheduler;
+    ThreadScheduler_Reference(this);
+    scheduler_pool_push(this->pool, task);
+}
+
 DEFINE_THISCALL_WRAPPER(ThreadScheduler_ScheduleTask_loc, 16)
 void __thiscall ThreadScheduler_ScheduleTask_loc(ThreadScheduler *this,
         void (__cdecl *proc)(void*), void* data, /*location*/void *placement)
 {
-    FIXME("(%p %p %p %p) stub\n", this, proc, data, placement);
-}
+    static int once;
 
-DEFINE_THISCALL_WRAPPER(ThreadScheduler_ScheduleTask, 12)
-void __thiscall ThreadScheduler_ScheduleTask(ThreadScheduler *this,
-        void (__cdecl *proc)(void*), void* data)
-{
-    FIXME("(%p %p %p) stub\n", this, proc, data);
+    if(!once++) FIXME("(%p %p %p %p) placement ignored\n", this, proc, data, placement);
+    ThreadScheduler_ScheduleTask(this, proc, data);
 }
 
 DEFINE_THISCALL_WRAPPER(ThreadScheduler_IsAvailableLocation, 8)
@@ -791,6 +1088,7 @@ static ThreadScheduler* ThreadScheduler_ctor(ThreadScheduler *this,
 
     this->shutdown_count = this->shutdown_size = 0;
     this->shutdown_events = NULL;
+    this->pool = NULL;
 
     InitializeCriticalSection(&this->cs);
     this->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": ThreadScheduler");
@@ -1140,6 +1438,7 @@ __ASM_BLOCK_END
 
 void msvcrt_init_scheduler(void *base)
 {
+    scheduler_module = base;
 #ifdef __x86_64__
     init_Context_rtti(base);
     init_ContextBase_rtti(base);
@@ -1157,6 +1456,11 @@ void msvcrt_free_scheduler(void)
     if(default_scheduler_policy.policy_container)
         SchedulerPolicy_dtor(&default_scheduler_policy);
     if(default_scheduler) {
+        /* Workers pin the module, so none of them can be running here. */
+        if(default_scheduler->pool) {
+            scheduler_pool_shutdown(default_scheduler->pool, FALSE);
+            default_scheduler->pool = NULL;
+        }
         ThreadScheduler_dtor(default_scheduler);
         operator_delete(default_scheduler);
     }
@@ -1497,13 +1497,29 @@ int CDECL _atoldbl(_LDOUBLE *value, char *str)
     return _atoldbl_l( (MSVCRT__LDOUBLE*)value, str, NULL );
 }
 
+/* The string and memory scanning functions below check a whole word at a time.
+ * Aligned loads never cross a page boundary, so reading past the terminator
+ * within the last word is safe. */
+#define WORD_ONES  ((size_t)~0 / 0xff)  /* 0x0101...01 */
+#define WORD_HIGHS (WORD_ONES * 0x80)   /* 0x8080...80 */
+
+/* non-zero if one of the bytes in the word is zero */
+static inline size_t has_zero_byte( size_t x )
+{
+    return (x - WORD_ONES) & ~x & WORD_HIGHS;
+}
+
 /*********************************************************************
  *              strlen (MSVCRT.@)
  */
 size_t __cdecl strlen(const char *str)
 {
     const char *s = str;
-    while (*s) s++;
+    const size_t *w;
+
+    for (; (ULONG_PTR)s % sizeof(size_t); s++) if (!*s) return s - str;
+    for (w = (const size_t *)s; !has_zero_byte( *w ); w++) ;
+    for (s = (const char *)w; *s; s++) ;
     return s - str;
 }
 
@@ -1512,12 +1528,16 @@ size_t __cdecl strlen(const char *str)
  */
 size_t CDECL strnlen(const char *s, size_t maxlen)
 {
-    size_t i;
+    const char *p = s, *end = s + maxlen;
+    const size_t *w;
 
-    for(i=0; i<maxlen; i++)
-        if(!s[i]) break;
+    if (maxlen > (ULONG_PTR)-1 - (ULONG_PTR)s) end = (const char *)(ULONG_PTR)-1;
 
-    return i;
+    for (; p < end && (ULONG_PTR)p % sizeof(size_t); p++) if (!*p) return p - s;
+    for (w = (const size_t *)p; (size_t)(end - (const char *)w) >= sizeof(size_t); w++)
+        if (has_zero_byte( *w )) break;
+    for (p = (const char *)w; p < end; p++) if (!*p) break;
+    return p - s;
 }
 
 /*********************************************************************
@@ -2459,11 +2479,35 @@ int CDECL I10_OUTPUT(MSVCRT__LDOUBLE ld80, int prec, int flag, struct _I10_OUTPU
 /*********************************************************************
  *                  memcmp (MSVCRT.@)
  */
+#if defined(__i386__) || defined(__x86_64__) || defined(__aarch64__)
+typedef size_t __attribute__((aligned(1))) unaligned_size_t;  /* unaligned loads are cheap */
+#endif
+
 int __cdecl memcmp(const void *ptr1, const void *ptr2, size_t n)
 {
-    const unsigned char *p1, *p2;
+    const unsigned char *p1 = ptr1, *p2 = ptr2;
 
-    for (p1 = ptr1, p2 = ptr2; n; n--, p1++, p2++)
+    if (n >= 2 * sizeof(size_t))
+    {
+        /* skip the identical words, the mismatching one is compared below */
+        for (; (ULONG_PTR)p1 % sizeof(size_t); n--, p1++, p2++)
+            if (*p1 != *p2) return *p1 < *p2 ? -1 : 1;
+
+        if (!((ULONG_PTR)p2 % sizeof(size_t)))
+        {
+            for (; n >= sizeof(size_t); n -= sizeof(size_t), p1 += sizeof(size_t), p2 += sizeof(size_t))
+                if (*(const size_t *)p1 != *(const size_t *)p2) break;
+        }
+#if defined(__i386__) || defined(__x86_64__) || defined(__aarch64__)
+        else
+        {
+            for (; n >= sizeof(size_t); n -= sizeof(size_t), p1 += sizeof(size_t), p2 += sizeof(size_t))
+                if (*(const size_t *)p1 != *(const unaligned_size_t *)p2) break;
+        }
+#endif
+    }
+
+    for (; n; n--, p1++, p2++)
     {
         if (*p1 < *p2) return -1;
         if (*p1 > *p2) return 1;
@@ -2722,6 +2766,38 @@ __ASM_GLOBAL_FUNC( sse2_memmove,
         MEMMOVE_CLEANUP
         "ret" )
 
+/* fill n bytes with a 32-bit pattern, dst and n must be multiples of 32 */
+void __cdecl sse2_memset_aligned_32(unsigned char *dst, unsigned int v, size_t n);
+#ifdef __i386__
+__ASM_GLOBAL_FUNC( sse2_memset_aligned_32,
+        "movl 4(%esp), %edx\n\t"
+        "movd 8(%esp), %xmm0\n\t"
+        "movl 12(%esp), %ecx\n\t"
+        "pshufd $0, %xmm0, %xmm0\n\t"
+        "addl %edx, %ecx\n\t"
+        "cmpl %ecx, %edx\n\t"
+        "jae 2f\n\t"
+        "1:\tmovdqa %xmm0, (%edx)\n\t"
+        "movdqa %xmm0, 16(%edx)\n\t"
+        "addl $32, %edx\n\t"
+        "cmpl %ecx, %edx\n\t"
+        "jb 1b\n"
+        "2:\tret" )
+#else
+__ASM_GLOBAL_FUNC( sse2_memset_aligned_32,
+        "movd %edx, %xmm0\n\t"
+        "pshufd $0, %xmm0, %xmm0\n\t"
+        "addq %rcx, %r8\n\t"
+        "cmpq %r8, %rcx\n\t"
+        "jae 2f\n\t"
+        "1:\tmovdqa %xmm0, (%rcx)\n\t"
+        "movdqa %xmm0, 16(%rcx)\n\t"
+        "addq $32, %rcx\n\t"
+        "cmpq %r8, %rcx\n\t"
+        "jb 1b\n"
+        "2:\tret" )
+#endif
+
 #endif
 
 /*********************************************************************
@@ -2848,10 +2924,75 @@ void * __cdecl memcpy(void *dst, const void *src, size_t n)
 /*********************************************************************
  *		    memset (MSVCRT.@)
  */
+/* the volatile stores avoid gcc turning the loops into memset calls */
+typedef volatile UINT64 __attribute__((aligned(1))) unaligned_uint64;
+typedef volatile UINT32 __attribute__((aligned(1))) unaligned_uint32;
+typedef volatile UINT16 __attribute__((aligned(1))) unaligned_uint16;
+
+static inline void memset_aligned_32(unsigned char *d, UINT64 v, size_t n)
+{
+#ifdef __x86_64__
+    sse2_memset_aligned_32( d, v, n );
+#else
+    unsigned char *end = d + n;
+
+#ifdef __i386__
+    if (sse2_supported)
+    {
+        sse2_memset_aligned_32( d, v, n );
+        return;
+    }
+#endif
+    for (; d < end; d += 32)
+    {
+        *(volatile UINT64 *)(d + 0) = v;
+        *(volatile UINT64 *)(d + 8) = v;
+        *(volatile UINT64 *)(d + 16) = v;
+        *(volatile UINT64 *)(d + 24) = v;
+    }
+#endif
+}
+
 void* __cdecl memset(void *dst, int c, size_t n)
 {
-    volatile unsigned char *d = dst;  /* avoid gcc optimizations */
-    while (n--) *d++ = c;
+    UINT64 v = 0x101010101010101ull * (unsigned char)c;
+    unsigned char *d = dst;
+    size_t a = 0x20 - ((ULONG_PTR)d & 0x1f);
+
+    /* small and unaligned sizes are covered with overlapping stores */
+    if (n >= 16)
+    {
+        *(unaligned_uint64 *)(d + 0) = v;
+        *(unaligned_uint64 *)(d + 8) = v;
+        *(unaligned_uint64 *)(d + n - 16) = v;
+        *(unaligned_uint64 *)(d + n - 8) = v;
+        if (n <= 32) return dst;
+        *(unaligned_uint64 *)(d + 16) = v;
+        *(unaligned_uint64 *)(d + 24) = v;
+        *(unaligned_uint64 *)(d + n - 32) = v;
+        *(unaligned_uint64 *)(d + n - 24) = v;
+        if (n <= 64) return dst;
+
+        n = (n - a) & ~0x1f;
+        memset_aligned_32( d + a, v, n );
+        return dst;
+    }
+    if (n >= 8)
+    {
+        *(unaligned_uint64 *)d = v;
+        *(unaligned_uint64 *)(d + n - 8) = v;
+    }
+    else if (n >= 4)
+    {
+        *(unaligned_uint32 *)d = v;
+        *(unaligned_uint32 *)(d + n - 4) = v;
+    }
+    else if (n >= 2)
+    {
+        *(unaligned_uint16 *)d = v;
+        *(unaligned_uint16 *)(d + n - 2) = v;
+    }
+    else if (n) *(volatile unsigned char *)d = v;
     return dst;
 }
 
@@ -2860,11 +3001,20 @@ void* __cdecl memset(void *dst, int c, size_t n)
  */
 char* __cdecl strchr(const char *str, int c)
 {
-    do
+    size_t mask = WORD_ONES * (unsigned char)c;
+    const size_t *w;
+
+    for (; (ULONG_PTR)str % sizeof(size_t); str++)
     {
         if (*str == (char)c) return (char*)str;
-    } while (*str++);
-    return NULL;
+        if (!*str) return NULL;
+    }
+    for (w = (const size_t *)str; !has_zero_byte( *w ) && !has_zero_byte( *w ^ mask ); w++) ;
+    for (str = (const char *)w; ; str++)
+    {
+        if (*str == (char)c) return (char*)str;
+        if (!*str) return NULL;
+    }
 }
 
 /*********************************************************************
@@ -2882,9 +3032,16 @@ char* __cdecl strrchr(const char *str, int c)
  */
 void* __cdecl memchr(const void *ptr, int c, size_t n)
 {
+    size_t mask = WORD_ONES * (unsigned char)c;
     const unsigned char *p = ptr;
-
-    for (p = ptr; n; n--, p++) if (*p == (unsigned char)c) return (void *)(ULONG_PTR)p;
+    const size_t *w;
+
+    for (; n && (ULONG_PTR)p % sizeof(size_t); n--, p++)
+        if (*p == (unsigned char)c) return (void *)(ULONG_PTR)p;
+    for (w = (const size_t *)p; n >= sizeof(size_t); n -= sizeof(size_t), w++)
+        if (has_zero_byte( *w ^ mask )) break;
+    for (p = (const unsigned char *)w; n; n--, p++)
+        if (*p == (unsigned char)c) return (void *)(ULONG_PTR)p;
     return NULL;
 }
 
@@ -57,7 +57,12 @@ static char *buf_to_string(const unsigned char *bin, int len, int nr)
 static void* (__cdecl *pmemcpy)(void *, const void *, size_t n);
 static int (__cdecl *p_memcpy_s)(void *, size_t, const void *, size_t);
 static int (__cdecl *p_memmove_s)(void *, size_t, const void *, size_t);
-static int* (__cdecl *pmemcmp)(void *, const void *, size_t n);
+static int (__cdecl *pmemcmp)(const void *, const void *, size_t n);
+static void* (__cdecl *pmemset)(void *, int, size_t);
+static void* (__cdecl *pmemchr)(const void *, int, size_t);
+static size_t (__cdecl *pstrlen)(const char *);
+static char* (__cdecl *pstrchr)(const char *, int);
+static size_t (__cdecl *pwcslen)(const wchar_t *);
 static int (__cdecl *p_strcmp)(const char *, const char *);
 static int (__cdecl *p_strncmp)(const char *, const char *, size_t);
 static int (__cdecl *p_strcpy)(char *dst, const char *src);
@@ -4405,6 +4410,115 @@ static void test_SpecialCasing(void)
 }
 
 
+static void test_mem_str_functions(void)
+{
+    static const size_t sizes[] = { 8, 64, 512, 4096, 65536, 1 << 20 };
+    unsigned char *buf = malloc( (1 << 20) + 64 ), *buf2 = malloc( (1 << 20) + 64 );
+    LARGE_INTEGER start, end, freq;
+    unsigned int i, n, off, count;
+    size_t len;
+    wchar_t *wstr;
+    char *str;
+
+    ok( buf && buf2, "malloc failed\n" );
+
+    for (off = 0; off < 16; off++)
+    {
+        for (n = 0; n < 150; n++)
+        {
+            memset( buf, 0x55, 200 );
+            pmemset( buf + off + 8, 0xa7, n );
+            for (i = 0; i < 200; i++)
+                if (buf[i] != ((i >= off + 8 && i < off + 8 + n) ? 0xa7 : 0x55)) break;
+            ok( i == 200, "memset(%u, %u) wrong at %u\n", off, n, i );
+
+            memcpy( buf2 + 3, buf + off + 8, n );
+            ok( !pmemcmp( buf + off + 8, buf2 + 3, n ), "memcmp(%u, %u) failed\n", off, n );
+            if (n)
+            {
+                buf2[3 + n - 1] = 0xa8;
+                ok( pmemcmp( buf + off + 8, buf2 + 3, n ) < 0, "memcmp(%u, %u) failed\n", off, n );
+                buf2[3 + n - 1] = 0x01;
+                ok( pmemcmp( buf + off + 8, buf2 + 3, n ) > 0, "memcmp(%u, %u) failed\n", off, n );
+
+                ok( pmemchr( buf + off + 8, 0xa7, n ) == buf + off + 8, "memchr(%u, %u) failed\n", off, n );
+                buf[off + 8 + n - 1] = 0x80;
+                ok( pmemchr( buf + off + 8, 0x80, n ) == buf + off + 8 + n - 1, "memchr(%u, %u) failed\n", off, n );
+            }
+            ok( !pmemchr( buf + off + 8, 0x55, n ), "memchr(%u, %u) failed\n", off, n );
+
+            str = (char *)buf + off;
+            memset( str, 'x', 200 );
+            str[n] = 0;
+            if (n) str[n - 1] = 'y';
+            ok( pstrlen( str ) == n, "strlen(%u, %u) returned %u\n", off, n, (UINT)pstrlen( str ) );
+            ok( p_strnlen( str, n / 2 ) == n / 2, "strnlen(%u, %u) failed\n", off, n );
+            ok( p_strnlen( str, n + 10 ) == n, "strnlen(%u, %u) failed\n", off, n );
+            ok( pstrchr( str, 'y' ) == (n ? str + n - 1 : NULL), "strchr(%u, %u) failed\n", off, n );
+            ok( pstrchr( str, 0 ) == str + n, "strchr(%u, %u) failed\n", off, n );
+            ok( !pstrchr( str, 'z' ), "strchr(%u, %u) failed\n", off, n );
+
+            wstr = (wchar_t *)(buf + off * sizeof(wchar_t));
+            for (i = 0; i < n; i++) wstr[i] = 0x8000 | i;
+            wstr[n] = 0;
+            wstr[n + 1] = 'x';
+            ok( pwcslen( wstr ) == n, "wcslen(%u, %u) returned %u\n", off, n, (UINT)pwcslen( wstr ) );
+        }
+    }
+
+    /* throughput, mostly useful for comparing implementations */
+    QueryPerformanceFrequency( &freq );
+    for (i = 0; i < ARRAY_SIZE(sizes); i++)
+    {
+        len = sizes[i];
+        count = (16 << 20) / len;
+        memset( buf, 'x', len + 1 );
+        memcpy( buf2, buf, len + 1 );
+        buf[len - 1] = buf2[len - 1] = 0;
+
+        QueryPerformanceCounter( &start );
+        for (n = 0; n < count; n++) pmemset( buf2, 'x', len - 1 );
+        QueryPerformanceCounter( &end );
+        trace( "memset %7Iu bytes: %8.1f MB/s\n", len, (double)len * count * freq.QuadPart / (end.QuadPart - start.QuadPart + 1) / 1e6 );
+
+        QueryPerformanceCounter( &start );
+        for (n = 0; n < count; n++) if (pmemcmp( buf, buf2, len )) break;
+        QueryPerformanceCounter( &end );
+        ok( n == count, "memcmp failed\n" );
+        trace( "memcmp %7Iu bytes: %8.1f MB/s\n", len, (double)len * count * freq.QuadPart / (end.QuadPart - start.QuadPart + 1) / 1e6 );
+
+        QueryPerformanceCounter( &start );
+        for (n = 0; n < count; n++) if (pmemchr( buf, 'y', len )) break;
+        QueryPerformanceCounter( &end );
+        ok( n == count, "memchr failed\n" );
+        trace( "memchr %7Iu bytes: %8.1f MB/s\n", len, (double)len * count * freq.QuadPart / (end.QuadPart - start.QuadPart + 1) / 1e6 );
+
+        QueryPerformanceCounter( &start );
+        for (n = 0; n < count; n++) if (pstrlen( (char *)buf ) != len - 1) break;
+        QueryPerformanceCounter( &end );
+        ok( n == count, "strlen failed\n" );
+        trace( "strlen %7Iu bytes: %8.1f MB/s\n", len, (double)len * count * freq.QuadPart / (end.QuadPart - start.QuadPart + 1) / 1e6 );
+
+        QueryPerformanceCounter( &start );
+        for (n = 0; n < count; n++) if (pstrchr( (char *)buf, 'y' )) break;
+        QueryPerformanceCounter( &end );
+        ok( n == count, "strchr failed\n" );
+        trace( "strchr %7Iu bytes: %8.1f MB/s\n", len, (double)len * count * freq.QuadPart / (end.QuadPart - start.QuadPart + 1) / 1e6 );
+
+        wstr = (wchar_t *)buf;
+        for (n = 0; n < len / sizeof(wchar_t); n++) wstr[n] = 'x';
+        wstr[len / sizeof(wchar_t) - 1] = 0;
+        QueryPerformanceCounter( &start );
+        for (n = 0; n < count; n++) if (pwcslen( wstr ) != len / sizeof(wchar_t) - 1) break;
+        QueryPerformanceCounter( &end );
+        ok( n == count, "wcslen failed\n" );
+        trace( "wcslen %7Iu bytes: %8.1f MB/s\n", len, (double)len * count * freq.QuadPart / (end.QuadPart - start.QuadPart + 1) / 1e6 );
+    }
+
+    free( buf );
+    free( buf2 );
+}
+
 static void test__mbbtype(void)
 {
     static const char *test_locales[] =
@@ -4471,6 +4585,11 @@ START_TEST(string)
     p_memcpy_s = (void*)GetProcAddress( hMsvcrt, "memcpy_s" );
     p_memmove_s = (void*)GetProcAddress( hMsvcrt, "memmove_s" );
     SET(pmemcmp,"memcmp");
+    SET(pmemset,"memset");
+    SET(pmemchr,"memchr");
+    SET(pstrlen,"strlen");
+    SET(pstrchr,"strchr");
+    SET(pwcslen,"wcslen");
     SET(p_mbctype,"_mbctype");
     SET(p__mb_cur_max,"__mb_cur_max");
     SET(p_strcpy, "strcpy");
@@ -4612,4 +4731,5 @@ START_TEST(string)
     test___STRINGTOLD();
     test_SpecialCasing();
     test__mbbtype();
+    test_mem_str_functions();
 }
@@ -2835,7 +2835,17 @@ wchar_t* CDECL wcsrchr(const wchar_t *str, wchar_t ch)
  */
 size_t CDECL wcslen(const wchar_t *str)
 {
+    static const size_t ones = (size_t)~0 / 0xffff;  /* 0x00010001... */
     const wchar_t *s = str;
+    const size_t *w;
+
+    /* check a whole word at a time once the string is aligned */
+    if (!((ULONG_PTR)s % sizeof(wchar_t)))
+    {
+        for (; (ULONG_PTR)s % sizeof(size_t); s++) if (!*s) return s - str;
+        for (w = (const size_t *)s; !((*w - ones) & ~*w & (ones * 0x8000)); w++) ;
+        s = (const wchar_t *)w;
+    }
     while (*s) s++;
     return s - str;
 }
@@ -78,6 +78,7 @@ typedef struct
 #define ARENA_PENDING_MAGIC    0xbedead
 #define ARENA_FREE_MAGIC       0x45455246
 #define ARENA_LARGE_MAGIC      0x6752614c
+#define ARENA_LFH_MAGIC        0x48464c
 
 #define ARENA_INUSE_FILLER     0x55
 #define ARENA_TAIL_FILLER      0xab
@@ -119,6 +120,22 @@ static const SIZE_T HEAP_freeListSizes[] =
 };
 #define HEAP_NB_FREE_LISTS (ARRAY_SIZE( HEAP_freeListSizes ) + HEAP_NB_SMALL_FREE_LISTS)
 
+/* Low fragmentation heap: blocks up to this size are cached in per-size bins,
+ * with a separate set of bins for each thread affinity slot */
+#define HEAP_LFH_MAX_SIZE      0x400
+#define HEAP_LFH_NB_BINS       (HEAP_LFH_MAX_SIZE / ALIGNMENT + 1)
+#define HEAP_LFH_NB_SLOTS      16  /* number of affinity slots */
+#define HEAP_LFH_MAX_DEPTH     32  /* max number of blocks cached in a bin */
+#define HEAP_LFH_REFILL_COUNT  8   /* number of blocks carved at once for an empty bin */
+
+typedef union
+{
+    ARENA_INUSE arena;
+    LONGLONG    value;
+} ARENA_INUSE_HEADER;
+
+C_ASSERT( sizeof(ARENA_INUSE) == sizeof(LONGLONG) );
+
 typedef union
 {
     ARENA_FREE  arena;
@@ -163,6 +180,7 @@ typedef struct tagHEAP
     ARENA_INUSE    **pending_free;  /* Ring buffer for pending free requests */
     RTL_CRITICAL_SECTION critSection; /* Critical section for serialization */
     FREE_LIST_ENTRY *freeList;      /* Free lists */
+    SLIST_HEADER    *lfh_bins;      /* Low fragmentation heap bins for all slots, if enabled */
 } HEAP;
 
 #define HEAP_MAGIC       ((DWORD)('H' | ('E'<<8) | ('A'<<16) | ('P'<<24)))
@@ -295,7 +313,8 @@ static void subheap_notify_free_all(SUBHEAP const *subheap)
         {
             ARENA_INUSE const *pArena = (ARENA_INUSE const *)ptr;
             if (pArena->magic == ARENA_INUSE_MAGIC) notify_free(pArena + 1);
-            else if (pArena->magic != ARENA_PENDING_MAGIC) ERR("bad inuse_magic @%p\n", pArena);
+            else if (pArena->magic != ARENA_PENDING_MAGIC && pArena->magic != ARENA_LFH_MAGIC)
+                ERR("bad inuse_magic @%p\n", pArena);
             ptr += sizeof(*pArena) + (pArena->size & ARENA_SIZE_MASK);
         }
     }
@@ -667,6 +686,10 @@ static void HEAP_MakeInUseBlockFree( SUBHEAP *subheap, ARENA_INUSE *pArena )
     if ((char *)pFree + size < (char *)subheap->base + subheap->size)
         return;  /* Not the last block, so nothing more to do */
 
+    /* The low fragmentation heap looks up subheaps and reads block headers
+     * without the heap lock, so keep them around and committed. */
+    if (heap->lfh_bins) return;
+
     /* Free the whole sub-heap if it's empty and not the original one */
 
     if (((char *)pFree == (char *)subheap->base + subheap->headerSize) &&
@@ -715,6 +738,158 @@ static void HEAP_ShrinkBlock(SUBHEAP *subheap, ARENA_INUSE *pArena, SIZE_T size)
 }
 
 
+/***********************************************************************
+ *           lfh_get_slot
+ *
+ * Threads are spread over the affinity slots by thread id, so that they
+ * mostly work on bins of their own.
+ */
+static inline unsigned int lfh_get_slot(void)
+{
+    return ((ULONG_PTR)NtCurrentTeb()->ClientId.UniqueThread / 4) % HEAP_LFH_NB_SLOTS;
+}
+
+static inline SLIST_HEADER *lfh_get_bin( HEAP *heap, unsigned int slot, SIZE_T size )
+{
+    return &heap->lfh_bins[slot * HEAP_LFH_NB_BINS + size / ALIGNMENT];
+}
+
+
+/***********************************************************************
+ *           lfh_alloc_block
+ *
+ * Take a block of the given size from the low fragmentation heap bins of the
+ * current slot, or from the bins of the other slots if it is empty.
+ * This doesn't need the heap lock.
+ */
+static ARENA_INUSE *lfh_alloc_block( HEAP *heap, SIZE_T size )
+{
+    unsigned int i, slot = lfh_get_slot();
+    ARENA_INUSE *arena;
+    SLIST_ENTRY *entry;
+    SLIST_HEADER *bin;
+
+    if (size > HEAP_LFH_MAX_SIZE) return NULL;
+    if (!(entry = RtlInterlockedPopEntrySList( lfh_get_bin( heap, slot, size ) )))
+    {
+        for (i = 1; i < HEAP_LFH_NB_SLOTS && !entry; i++)
+        {
+            bin = lfh_get_bin( heap, (slot + i) % HEAP_LFH_NB_SLOTS, size );
+            if (RtlFirstEntrySList( bin )) entry = RtlInterlockedPopEntrySList( bin );
+        }
+        if (!entry) return NULL;
+    }
+    arena = (ARENA_INUSE *)entry - 1;
+    arena->magic = ARENA_INUSE_MAGIC;
+    return arena;
+}
+
+
+/***********************************************************************
+ *           lfh_free_block
+ *
+ * Put a freed block into the low fragmentation heap bins, without taking the
+ * heap lock. The block stays allocated as far as the heap is concerned, it is
+ * only marked with a different magic so that it can't be freed twice.
+ */
+static BOOL lfh_free_block( HEAP *heap, void *ptr )
+{
+    ARENA_INUSE *arena = (ARENA_INUSE *)ptr - 1;
+    ARENA_INUSE_HEADER old, new;
+    SLIST_HEADER *bin;
+    SUBHEAP *subheap;
+    SIZE_T size;
+
+    /* Make sure that the block is inside this heap before looking at it,
+     * anything else is left to the regular validation. Subheaps are only
+     * ever added to the list while the bins are enabled, and are neither
+     * released nor decommitted. */
+    if ((ULONG_PTR)ptr % ALIGNMENT) return FALSE;
+    if (!(subheap = HEAP_FindSubHeap( heap, arena ))) return FALSE;
+    if ((char *)arena < (char *)subheap->base + subheap->headerSize) return FALSE;
+    if ((char *)ptr > (char *)subheap->base + subheap->commitSize) return FALSE;
+
+    old.value = *(volatile LONGLONG *)arena;
+    if (old.arena.magic != ARENA_INUSE_MAGIC || (old.arena.size & ARENA_FLAG_FREE)) return FALSE;
+    if ((size = old.arena.size & ARENA_SIZE_MASK) > HEAP_LFH_MAX_SIZE) return FALSE;
+    if ((char *)ptr + size > (char *)subheap->base + subheap->commitSize) return FALSE;
+
+    bin = lfh_get_bin( heap, lfh_get_slot(), size );
+    if (RtlQueryDepthSList( bin ) >= HEAP_LFH_MAX_DEPTH) return FALSE;
+
+    new = old;
+    new.arena.magic = ARENA_LFH_MAGIC;
+    if (InterlockedCompareExchange64( (LONGLONG *)arena, new.value, old.value ) != old.value) return FALSE;
+    RtlInterlockedPushEntrySList( bin, ptr );
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           lfh_flush_bins
+ *
+ * Give all the blocks cached in the low fragmentation heap bins back to the
+ * heap. The heap lock must be held. Other threads may still be popping from
+ * the bins, but HEAP_MakeInUseBlockFree keeps the memory of the blocks
+ * committed, so the entries they look at remain readable.
+ */
+static void lfh_flush_bins( HEAP *heap )
+{
+    ARENA_INUSE *arena;
+    SLIST_ENTRY *entry;
+    SUBHEAP *subheap;
+    unsigned int i;
+
+    for (i = 0; i < HEAP_LFH_NB_SLOTS * HEAP_LFH_NB_BINS; i++)
+    {
+        while ((entry = RtlInterlockedPopEntrySList( &heap->lfh_bins[i] )))
+        {
+            arena = (ARENA_INUSE *)entry - 1;
+            arena->magic = ARENA_INUSE_MAGIC;
+            if ((subheap = HEAP_FindSubHeap( heap, arena ))) HEAP_MakeInUseBlockFree( subheap, arena );
+            else WARN( "Heap %p: cached block %p is not inside heap\n", heap, arena + 1 );
+        }
+    }
+}
+
+
+/***********************************************************************
+ *           lfh_enable
+ */
+static NTSTATUS lfh_enable( HEAP *heap )
+{
+    SLIST_HEADER *bins;
+    unsigned int i;
+
+    if (heap->lfh_bins) return STATUS_SUCCESS;
+    if (heap->flags & HEAP_NO_SERIALIZE) return STATUS_UNSUCCESSFUL;
+    /* the bins would bypass the debugging checks, keep the standard heap then */
+    if (heap->flags & (HEAP_TAIL_CHECKING_ENABLED | HEAP_FREE_CHECKING_ENABLED |
+                       HEAP_VALIDATE | HEAP_VALIDATE_ALL | HEAP_VALIDATE_PARAMS))
+    {
+        TRACE( "heap %p: ignoring low fragmentation heap request for debug flags %08x\n", heap, heap->flags );
+        return STATUS_SUCCESS;
+    }
+
+    if (!(bins = RtlAllocateHeap( GetProcessHeap(), 0, HEAP_LFH_NB_SLOTS * HEAP_LFH_NB_BINS * sizeof(*bins) )))
+        return STATUS_NO_MEMORY;
+    for (i = 0; i < HEAP_LFH_NB_SLOTS * HEAP_LFH_NB_BINS; i++) RtlInitializeSListHead( &bins[i] );
+
+    /* enable the bins with the lock held, so that no subheap is being released
+     * once the lock-free paths can see them */
+    RtlEnterCriticalSection( &heap->critSection );
+    if (!heap->lfh_bins)
+    {
+        heap->lfh_bins = bins;
+        bins = NULL;
+    }
+    RtlLeaveCriticalSection( &heap->critSection );
+
+    RtlFreeHeap( GetProcessHeap(), 0, bins );
+    return STATUS_SUCCESS;
+}
+
+
 /***********************************************************************
  *           allocate_large_block
  */
@@ -914,6 +1089,10 @@ static SUBHEAP *HEAP_CreateSubHeap( HEAP *heap, LPVOID address, DWORD flags,
         subheap->commitSize = commitSize;
         subheap->magic      = SUBHEAP_MAGIC;
         subheap->headerSize = ROUND_SIZE( sizeof(SUBHEAP) );
+        /* the low fragmentation heap walks the list without the heap lock */
+        subheap->entry.next = heap->subheap_list.next;
+        subheap->entry.prev = &heap->subheap_list;
+        MemoryBarrier();
         list_add_head( &heap->subheap_list, &subheap->entry );
     }
     else
@@ -996,12 +1175,10 @@ static SUBHEAP *HEAP_CreateSubHeap( HEAP *heap, LPVOID address, DWORD flags,
  * Find a free block at least as large as the requested size, and make sure
  * the requested size is committed.
  */
-static ARENA_FREE *HEAP_FindFreeBlock( HEAP *heap, SIZE_T size,
-                                       SUBHEAP **ppSubHeap )
+static ARENA_FREE *find_free_list_block( HEAP *heap, SIZE_T size, SUBHEAP **ppSubHeap )
 {
     SUBHEAP *subheap;
     struct list *ptr;
-    SIZE_T total_size;
     FREE_LIST_ENTRY *pEntry = heap->freeList + get_freelist_index( size + sizeof(ARENA_INUSE) );
 
     /* Find a suitable free list, and in it find a block large enough */
@@ -1020,6 +1197,26 @@ static ARENA_FREE *HEAP_FindFreeBlock( HEAP *heap, SIZE_T size,
             return pArena;
         }
     }
+    return NULL;
+}
+
+static ARENA_FREE *HEAP_FindFreeBlock( HEAP *heap, SIZE_T size,
+                                       SUBHEAP **ppSubHeap )
+{
+    ARENA_FREE *pArena;
+    SUBHEAP *subheap;
+    SIZE_T total_size;
+
+    if ((pArena = find_free_list_block( heap, size, ppSubHeap ))) return pArena;
+
+    /* Give the blocks cached by the low fragmentation heap back first, they
+     * may coalesce into a large enough block */
+
+    if (heap->lfh_bins)
+    {
+        lfh_flush_bins( heap );
+        if ((pArena = find_free_list_block( heap, size, ppSubHeap ))) return pArena;
+    }
 
     /* If no block was found, attempt to grow the heap */
 
@@ -1057,6 +1254,63 @@ static ARENA_FREE *HEAP_FindFreeBlock( HEAP *heap, SIZE_T size,
 }
 
 
+/***********************************************************************
+ *           HEAP_UseFreeBlock
+ *
+ * Turn a free block into an in-use block of the given size.
+ */
+static ARENA_INUSE *HEAP_UseFreeBlock( SUBHEAP *subheap, ARENA_FREE *pArena, SIZE_T size )
+{
+    ARENA_INUSE *pInUse;
+
+    /* Remove the arena from the free list */
+
+    list_remove( &pArena->entry );
+
+    /* Build the in-use arena */
+
+    pInUse = (ARENA_INUSE *)pArena;
+
+    /* in-use arena is smaller than free arena,
+     * so we have to add the difference to the size */
+    pInUse->size  = (pInUse->size & ~ARENA_FLAG_FREE) + sizeof(ARENA_FREE) - sizeof(ARENA_INUSE);
+    pInUse->magic = ARENA_INUSE_MAGIC;
+
+    /* Shrink the block */
+
+    HEAP_ShrinkBlock( subheap, pInUse, size );
+    return pInUse;
+}
+
+
+/***********************************************************************
+ *           lfh_refill_bin
+ *
+ * Carve a few more blocks of the given size out of the existing free lists
+ * into the bin of the current slot, so that the next allocations of that
+ * size don't need the heap lock. The heap lock must be held.
+ */
+static void lfh_refill_bin( HEAP *heap, SIZE_T size )
+{
+    SLIST_HEADER *bin;
+    ARENA_FREE *pArena;
+    ARENA_INUSE *pInUse;
+    SUBHEAP *subheap;
+    unsigned int i;
+
+    if (size > HEAP_LFH_MAX_SIZE) return;
+    bin = lfh_get_bin( heap, lfh_get_slot(), size );
+
+    for (i = 0; i < HEAP_LFH_REFILL_COUNT && RtlQueryDepthSList( bin ) < HEAP_LFH_MAX_DEPTH; i++)
+    {
+        if (!(pArena = find_free_list_block( heap, size, &subheap ))) break;
+        pInUse = HEAP_UseFreeBlock( subheap, pArena, size );
+        pInUse->magic = ARENA_LFH_MAGIC;
+        RtlInterlockedPushEntrySList( bin, (SLIST_ENTRY *)(pInUse + 1) );
+    }
+}
+
+
 /***********************************************************************
  *           HEAP_IsValidArenaPtr
  *
@@ -1213,7 +1467,8 @@ static BOOL HEAP_ValidateInUseArena( const SUBHEAP *subheap, const ARENA_INUSE *
     }
 
     /* Check magic number */
-    if (pArena->magic != ARENA_INUSE_MAGIC && pArena->magic != ARENA_PENDING_MAGIC)
+    if (pArena->magic != ARENA_INUSE_MAGIC && pArena->magic != ARENA_PENDING_MAGIC &&
+        pArena->magic != ARENA_LFH_MAGIC)
     {
         if (quiet == NOISY) {
             ERR("Heap %p: invalid in-use arena magic %08x for %p\n", subheap->heap, pArena->magic, pArena );
@@ -1419,7 +1674,7 @@ static BOOL validate_block_pointer( HEAP *heap, SUBHEAP **ret_subheap, const ARE
         ret = HEAP_ValidateInUseArena( subheap, arena, QUIET );
     else if ((ULONG_PTR)arena % ALIGNMENT != ARENA_OFFSET)
         WARN( "Heap %p: unaligned arena pointer %p\n", subheap->heap, arena );
-    else if (arena->magic == ARENA_PENDING_MAGIC)
+    else if (arena->magic == ARENA_PENDING_MAGIC || arena->magic == ARENA_LFH_MAGIC)
         WARN( "Heap %p: block %p used after free\n", subheap->heap, arena + 1 );
     else if (arena->magic != ARENA_INUSE_MAGIC)
         WARN( "Heap %p: invalid in-use arena magic %08x for %p\n", subheap->heap, arena->magic, arena );
@@ -1624,6 +1879,7 @@ HANDLE WINAPI RtlDestroyHeap( HANDLE heap )
     }
     subheap_notify_free_all(&heapPtr->subheap);
     RtlFreeHeap( GetProcessHeap(), 0, heapPtr->pending_free );
+    RtlFreeHeap( GetProcessHeap(), 0, heapPtr->lfh_bins );
     size = 0;
     addr = heapPtr->subheap.base;
     NtFreeVirtualMemory( NtCurrentProcess(), &addr, &size, MEM_RELEASE );
@@ -1669,6 +1925,15 @@ void * WINAPI DECLSPEC_HOTPATCH RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_
     }
     if (rounded_size < HEAP_MIN_DATA_SIZE) rounded_size = HEAP_MIN_DATA_SIZE;
 
+    if (heapPtr->lfh_bins && (pInUse = lfh_alloc_block( heapPtr, rounded_size )))
+    {
+        pInUse->unused_bytes = (pInUse->size & ARENA_SIZE_MASK) - size;
+        notify_alloc( pInUse + 1, size, flags & HEAP_ZERO_MEMORY );
+        initialize_block( pInUse + 1, size, pInUse->unused_bytes, flags );
+        TRACE("(%p,%08x,%08lx): returning %p\n", heap, flags, size, pInUse + 1 );
+        return pInUse + 1;
+    }
+
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
 
     if (rounded_size >= HEAP_MIN_LARGE_BLOCK_SIZE && (flags & HEAP_GROWABLE))
@@ -1691,22 +1956,8 @@ void * WINAPI DECLSPEC_HOTPATCH RtlAllocateHeap( HANDLE heap, ULONG flags, SIZE_
         return NULL;
     }
 
-    /* Remove the arena from the free list */
-
-    list_remove( &pArena->entry );
-
-    /* Build the in-use arena */
-
-    pInUse = (ARENA_INUSE *)pArena;
-
-    /* in-use arena is smaller than free arena,
-     * so we have to add the difference to the size */
-    pInUse->size  = (pInUse->size & ~ARENA_FLAG_FREE) + sizeof(ARENA_FREE) - sizeof(ARENA_INUSE);
-    pInUse->magic = ARENA_INUSE_MAGIC;
-
-    /* Shrink the block */
-
-    HEAP_ShrinkBlock( subheap, pInUse, rounded_size );
+    pInUse = HEAP_UseFreeBlock( subheap, pArena, rounded_size );
+    if (heapPtr->lfh_bins) lfh_refill_bin( heapPtr, rounded_size );
     pInUse->unused_bytes = (pInUse->size & ARENA_SIZE_MASK) - size;
 
     notify_alloc( pInUse + 1, size, flags & HEAP_ZERO_MEMORY );
@@ -1752,6 +2003,14 @@ BOOLEAN WINAPI DECLSPEC_HOTPATCH RtlFreeHeap( HANDLE heap, ULONG flags, void *pt
 
     flags &= HEAP_NO_SERIALIZE;
     flags |= heapPtr->flags;
+
+    if (heapPtr->lfh_bins && lfh_free_block( heapPtr, ptr ))
+    {
+        notify_free( ptr );
+        TRACE("(%p,%08x,%p): returning TRUE\n", heap, flags, ptr );
+        return TRUE;
+    }
+
     if (!(flags & HEAP_NO_SERIALIZE)) RtlEnterCriticalSection( &heapPtr->critSection );
 
     /* Inform valgrind we are trying to free memory, so it can throw up an error message */
@@ -2119,7 +2378,8 @@ NTSTATUS WINAPI RtlWalkHeap( HANDLE heap, PVOID entry_ptr )
         }
 
         if (((ARENA_INUSE *)ptr - 1)->magic == ARENA_INUSE_MAGIC ||
-            ((ARENA_INUSE *)ptr - 1)->magic == ARENA_PENDING_MAGIC)
+            ((ARENA_INUSE *)ptr - 1)->magic == ARENA_PENDING_MAGIC ||
+            ((ARENA_INUSE *)ptr - 1)->magic == ARENA_LFH_MAGIC)
         {
             ARENA_INUSE *pArena = (ARENA_INUSE *)ptr - 1;
             ptr += pArena->size & ARENA_SIZE_MASK;
@@ -2167,7 +2427,7 @@ NTSTATUS WINAPI RtlWalkHeap( HANDLE heap, PVOID entry_ptr )
         entry->lpData = pArena + 1;
         entry->cbData = pArena->size & ARENA_SIZE_MASK;
         entry->cbOverhead = sizeof(ARENA_INUSE);
-        entry->wFlags = (pArena->magic == ARENA_PENDING_MAGIC) ?
+        entry->wFlags = (pArena->magic == ARENA_PENDING_MAGIC || pArena->magic == ARENA_LFH_MAGIC) ?
                         PROCESS_HEAP_UNCOMMITTED_RANGE : PROCESS_HEAP_ENTRY_BUSY;
         /* FIXME: can't handle PROCESS_HEAP_ENTRY_MOVEABLE
         and PROCESS_HEAP_ENTRY_DDESHARE yet */
@@ -2232,6 +2492,8 @@ ULONG WINAPI RtlGetProcessHeaps( ULONG count, HANDLE *heaps )
 NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS info_class,
                                          PVOID info, SIZE_T size_in, PSIZE_T size_out)
 {
+    HEAP *heapPtr;
+
     switch (info_class)
     {
     case HeapCompatibilityInformation:
@@ -2240,7 +2502,10 @@ NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS inf
         if (size_in < sizeof(ULONG))
             return STATUS_BUFFER_TOO_SMALL;
 
-        *(ULONG *)info = 0; /* standard heap */
+        if ((heapPtr = HEAP_GetPtr( heap )) && heapPtr->lfh_bins)
+            *(ULONG *)info = 2; /* low fragmentation heap */
+        else
+            *(ULONG *)info = 0; /* standard heap */
         return STATUS_SUCCESS;
 
     default:
@@ -2254,6 +2519,26 @@ NTSTATUS WINAPI RtlQueryHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS inf
  */
 NTSTATUS WINAPI RtlSetHeapInformation( HANDLE heap, HEAP_INFORMATION_CLASS info_class, PVOID info, SIZE_T size)
 {
-    FIXME("%p %d %p %ld stub\n", heap, info_class, info, size);
-    return STATUS_SUCCESS;
+    HEAP *heapPtr;
+
+    switch (info_class)
+    {
+    case HeapCompatibilityInformation:
+        if (size < sizeof(ULONG)) return STATUS_BUFFER_TOO_SMALL;
+        if (!(heapPtr = HEAP_GetPtr( heap ))) return STATUS_INVALID_HANDLE;
+
+        switch (*(ULONG *)info)
+        {
+        case 0:  /* standard heap */
+            return heapPtr->lfh_bins ? STATUS_UNSUCCESSFUL : STATUS_SUCCESS;
+        case 2:  /* low fragmentation heap */
+            return lfh_enable( heapPtr );
+        default:
+            return STATUS_UNSUCCESSFUL;
+        }
+
+    default:
+        FIXME("%p %d %p %ld stub\n", heap, info_class, info, size);
+        return STATUS_SUCCESS;
+    }
 }
@@ -120,8 +120,17 @@ typedef struct _wine_modref
     int                   alloc_deps;
     int                   nDeps;
     struct _wine_modref **deps;
+    LIST_ENTRY            hash_entry;        /* entry in the base name hash table */
+    DWORD                *export_hash;       /* hash table of exported names, built on first use */
+    DWORD                 export_hash_mask;
 } WINE_MODREF;
 
+#define MODULE_HASH_SIZE  64
+static LIST_ENTRY module_hash_table[MODULE_HASH_SIZE];
+static unsigned int non_ascii_modules;  /* number of modules with a non-ASCII base name */
+
+#define EXPORT_HASH_MIN_NAMES  32  /* binary search is good enough for smaller export tables */
+
 static UINT tls_module_count;      /* number of modules with TLS directory */
 static IMAGE_TLS_DIRECTORY *tls_dirs;  /* array of TLS directories */
 LIST_ENTRY tls_links = { &tls_links, &tls_links };
@@ -166,7 +175,7 @@ static NTSTATUS load_dll( const WCHAR *load_path, const WCHAR *libname, const WC
 static NTSTATUS process_attach( WINE_MODREF *wm, LPVOID lpReserved );
 static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
                                     DWORD exp_size, DWORD ordinal, LPCWSTR load_path );
-static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
+static FARPROC find_named_export( WINE_MODREF *wm, const IMAGE_EXPORT_DIRECTORY *exports,
                                   DWORD exp_size, const char *name, int hint, LPCWSTR load_path );
 
 /* convert PE image VirtualAddress to Real Address */
@@ -474,6 +483,69 @@ static WINE_MODREF *get_modref( HMODULE hmod )
 }
 
 
+/**********************************************************************
+ *	    hash_basename
+ *
+ * Case-insensitive hash of a module base name. Only ASCII characters are
+ * hashed, since the case mapping of other characters depends on the locale.
+ */
+static ULONG hash_basename( const UNICODE_STRING *name, BOOL *ascii )
+{
+    ULONG i, hash = 0;
+
+    *ascii = TRUE;
+    for (i = 0; i < name->Length / sizeof(WCHAR); i++)
+    {
+        WCHAR ch = name->Buffer[i];
+        if (ch >= 0x80) *ascii = FALSE;
+        else hash = hash * 65599 + ((ch >= 'a' && ch <= 'z') ? ch - 'a' + 'A' : ch);
+    }
+    return hash;
+}
+
+
+/**********************************************************************
+ *	    get_module_hash_bucket
+ */
+static LIST_ENTRY *get_module_hash_bucket( ULONG hash )
+{
+    LIST_ENTRY *bucket = &module_hash_table[hash % MODULE_HASH_SIZE];
+
+    if (!bucket->Flink) InitializeListHead( bucket );
+    return bucket;
+}
+
+
+/**********************************************************************
+ *	    insert_module_hash
+ *
+ * The loader_section must be locked while calling this function
+ */
+static void insert_module_hash( WINE_MODREF *wm )
+{
+    BOOL ascii;
+
+    wm->ldr.BaseNameHashValue = hash_basename( &wm->ldr.BaseDllName, &ascii );
+    if (!ascii) non_ascii_modules++;
+    InsertTailList( get_module_hash_bucket( wm->ldr.BaseNameHashValue ), &wm->hash_entry );
+}
+
+
+/**********************************************************************
+ *	    remove_module_hash
+ *
+ * The loader_section must be locked while calling this function
+ */
+static void remove_module_hash( WINE_MODREF *wm )
+{
+    BOOL ascii;
+
+    hash_basename( &wm->ldr.BaseDllName, &ascii );
+    if (!ascii) non_ascii_modules--;
+    RemoveEntryList( &wm->hash_entry );
+}
+
+
 /**********************************************************************
  *	    find_basename_module
  *
@@ -484,12 +556,29 @@ static WINE_MODREF *find_basename_module( LPCWSTR name )
 {
     PLIST_ENTRY mark, entry;
     UNICODE_STRING name_str;
+    ULONG hash;
+    BOOL ascii;
 
     RtlInitUnicodeString( &name_str, name );
 
     if (cached_modref && RtlEqualUnicodeString( &name_str, &cached_modref->ldr.BaseDllName, TRUE ))
         return cached_modref;
 
+    hash = hash_basename( &name_str, &ascii );
+    if (ascii && !non_ascii_modules)
+    {
+        /* modules are inserted in load order, so the first match is the same as in the full list */
+        mark = get_module_hash_bucket( hash );
+        for (entry = mark->Flink; entry != mark; entry = entry->Flink)
+        {
+            WINE_MODREF *wm = CONTAINING_RECORD( entry, WINE_MODREF, hash_entry );
+            if (wm->ldr.BaseNameHashValue == hash &&
+                RtlEqualUnicodeString( &name_str, &wm->ldr.BaseDllName, TRUE ))
+                return cached_modref = wm;
+        }
+        return NULL;
+    }
+
     mark = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList;
     for (entry = mark->Flink; entry != mark; entry = entry->Flink)
     {
@@ -647,7 +736,7 @@ static FARPROC find_forwarded_export( HMODULE module, const char *forward, LPCWS
             proc = find_ordinal_export( wm->ldr.DllBase, exports, exp_size,
                                         atoi(name+1) - exports->Base, load_path );
         } else
-            proc = find_named_export( wm->ldr.DllBase, exports, exp_size, name, -1, load_path );
+            proc = find_named_export( wm, exports, exp_size, name, -1, load_path );
     }
 
     if (!proc)
@@ -703,17 +792,63 @@ static FARPROC find_ordinal_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY
 }
 
 
+/*************************************************************************
+ *		hash_export_name
+ */
+static inline DWORD hash_export_name( const char *name )
+{
+    DWORD hash = 0;
+
+    while (*name) hash = hash * 65599 + (unsigned char)*name++;
+    return hash;
+}
+
+
+/*************************************************************************
+ *		get_export_hash
+ *
+ * Build the hash table of exported names of a module, if worth it.
+ * Entries are indexes in the names table plus one; zero marks a free slot.
+ * The loader_section must be locked while calling this function.
+ */
+static const DWORD *get_export_hash( WINE_MODREF *wm, const IMAGE_EXPORT_DIRECTORY *exports )
+{
+    HMODULE module = wm->ldr.DllBase;
+    const DWORD *names = get_rva( module, exports->AddressOfNames );
+    DWORD i, size, *table;
+
+    if (wm->export_hash) return wm->export_hash;
+    if (exports->NumberOfNames < EXPORT_HASH_MIN_NAMES) return NULL;
+
+    for (size = 64; size < exports->NumberOfNames * 2; size *= 2) ;
+    if (!(table = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, size * sizeof(*table) )))
+        return NULL;
+
+    for (i = 0; i < exports->NumberOfNames; i++)
+    {
+        DWORD pos = hash_export_name( get_rva( module, names[i] ));
+        while (table[pos & (size - 1)]) pos++;
+        table[pos & (size - 1)] = i + 1;
+    }
+    wm->export_hash = table;
+    wm->export_hash_mask = size - 1;
+    return table;
+}
+
+
 /*************************************************************************
  *		find_named_export
  *
  * Find an exported function by name.
  * The loader_section must be locked while calling this function.
  */
-static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *exports,
+static FARPROC find_named_export( WINE_MODREF *wm, const IMAGE_EXPORT_DIRECTORY *exports,
                                   DWORD exp_size, const char *name, int hint, LPCWSTR load_path )
 {
+    HMODULE module = wm->ldr.DllBase;
     const WORD *ordinals = get_rva( module, exports->AddressOfNameOrdinals );
     const DWORD *names = get_rva( module, exports->AddressOfNames );
+    const DWORD *table;
     int min = 0, max = exports->NumberOfNames - 1;
 
     /* first check the hint */
@@ -724,7 +859,21 @@ static FARPROC find_named_export( HMODULE module, const IMAGE_EXPORT_DIRECTORY *
             return find_ordinal_export( module, exports, exp_size, ordinals[hint], load_path );
     }
 
-    /* then do a binary search */
+    /* then look it up in the hash table */
+    if ((table = get_export_hash( wm, exports )))
+    {
+        DWORD pos;
+
+        for (pos = hash_export_name( name ); table[pos & wm->export_hash_mask]; pos++)
+        {
+            DWORD idx = table[pos & wm->export_hash_mask] - 1;
+            if (!strcmp( get_rva( module, names[idx] ), name ))
+                return find_ordinal_export( module, exports, exp_size, ordinals[idx], load_path );
+        }
+        return NULL;
+    }
+
+    /* otherwise do a binary search */
     while (min <= max)
     {
         int res, pos = (min + max) / 2;
@@ -861,7 +1010,7 @@ static BOOL import_dll( HMODULE module, const IMAGE_IMPORT_DESCRIPTOR *descr, LP
         {
             IMAGE_IMPORT_BY_NAME *pe_name;
             pe_name = get_rva( module, (DWORD)import_list->u1.AddressOfData );
-            thunk_list->u1.Function = (ULONG_PTR)find_named_export( imp_mod, exports, exp_size,
+            thunk_list->u1.Function = (ULONG_PTR)find_named_export( wmImp, exports, exp_size,
                                                                     (const char*)pe_name->Name,
                                                                     pe_name->Hint, load_path );
             if (!thunk_list->u1.Function)
@@ -1085,7 +1234,7 @@ static NTSTATUS fixup_imports_ilonly( WINE_MODREF *wm, LPCWSTR load_path, void *
                                                  IMAGE_DIRECTORY_ENTRY_EXPORT, &exp_size )))
     {
         const char *name = (wm->ldr.Flags & LDR_IMAGE_IS_DLL) ? "_CorDllMain" : "_CorExeMain";
-        proc = find_named_export( imp->ldr.DllBase, exports, exp_size, name, -1, load_path );
+        proc = find_named_export( imp, exports, exp_size, name, -1, load_path );
     }
     if (!proc) return STATUS_PROCEDURE_NOT_FOUND;
     *entry = proc;
@@ -1196,6 +1345,7 @@ static WINE_MODREF *alloc_module( HMODULE hModule, const UNICODE_STRING *nt_name
                    &wm->ldr.InLoadOrderLinks);
     InsertTailList(&NtCurrentTeb()->Peb->LdrData->InMemoryOrderModuleList,
                    &wm->ldr.InMemoryOrderLinks);
+    insert_module_hash( wm );
     /* wait until init is called for inserting into InInitializationOrderModuleList */
 
     if (!(nt->OptionalHeader.DllCharacteristics & IMAGE_DLLCHARACTERISTICS_NX_COMPAT))
@@ -1679,16 +1829,17 @@ NTSTATUS WINAPI LdrGetProcedureAddress(HMODULE module, const ANSI_STRING *name,
 {
     IMAGE_EXPORT_DIRECTORY *exports;
     DWORD exp_size;
+    WINE_MODREF *wm;
     NTSTATUS ret = STATUS_PROCEDURE_NOT_FOUND;
 
     RtlEnterCriticalSection( &loader_section );
 
     /* check if the module itself is invalid to return the proper error */
-    if (!get_modref( module )) ret = STATUS_DLL_NOT_FOUND;
+    if (!(wm = get_modref( module ))) ret = STATUS_DLL_NOT_FOUND;
     else if ((exports = RtlImageDirectoryEntryToData( module, TRUE,
                                                       IMAGE_DIRECTORY_ENTRY_EXPORT, &exp_size )))
     {
-        void *proc = name ? find_named_export( module, exports, exp_size, name->Buffer, -1, NULL )
+        void *proc = name ? find_named_export( wm, exports, exp_size, name->Buffer, -1, NULL )
                           : find_ordinal_export( module, exports, exp_size, ord - exports->Base, NULL );
         if (proc)
         {
@@ -1876,6 +2027,7 @@ static NTSTATUS build_module( LPCWSTR load_path, const UNICODE_STRING *nt_name,
             /* the module has only be inserted in the load & memory order lists */
             RemoveEntryList(&wm->ldr.InLoadOrderLinks);
             RemoveEntryList(&wm->ldr.InMemoryOrderLinks);
+            remove_module_hash( wm );
 
             /* FIXME: there are several more dangling references
              * left. Including dlls loaded by this dll before the
@@ -3261,6 +3413,7 @@ static void free_modref( WINE_MODREF *wm )
 {
     RemoveEntryList(&wm->ldr.InLoadOrderLinks);
     RemoveEntryList(&wm->ldr.InMemoryOrderLinks);
+    remove_module_hash( wm );
     if (wm->ldr.InInitializationOrderLinks.Flink)
         RemoveEntryList(&wm->ldr.InInitializationOrderLinks);
 
@@ -3276,6 +3429,7 @@ static void free_modref( WINE_MODREF *wm )
     if (cached_modref == wm) cached_modref = NULL;
     RtlFreeUnicodeString( &wm->ldr.FullDllName );
     RtlFreeHeap( GetProcessHeap(), 0, wm->deps );
+    RtlFreeHeap( GetProcessHeap(), 0, wm->export_hash );
     RtlFreeHeap( GetProcessHeap(), 0, wm );
 }
 
@@ -3472,7 +3626,10 @@ void WINAPI LdrInitializeThunk( CONTEXT *context, ULONG_PTR unknown2, ULONG_PTR
 
     if (!imports_fixup_done)
     {
+        LARGE_INTEGER start, end, freq;
+
         actctx_init();
+        NtQueryPerformanceCounter( &start, &freq );
         if (wm->ldr.Flags & LDR_COR_ILONLY)
             status = fixup_imports_ilonly( wm, NULL, entry );
         else
@@ -3485,6 +3642,20 @@ void WINAPI LdrInitializeThunk( CONTEXT *context, ULONG_PTR unknown2, ULONG_PTR
             NtTerminateProcess( GetCurrentProcess(), status );
         }
         imports_fixup_done = TRUE;
+
+        if (TRACE_ON(loaddll))
+        {
+            LIST_ENTRY *mark = &NtCurrentTeb()->Peb->LdrData->InLoadOrderModuleList, *mod;
+            ULONGLONG usecs;
+            UINT count = 0;
+
+            NtQueryPerformanceCounter( &end, NULL );
+            usecs = (end.QuadPart - start.QuadPart) * 1000000 / freq.QuadPart;
+            for (mod = mark->Flink; mod != mark; mod = mod->Flink) count++;
+            TRACE_(loaddll)( "Resolved imports of %s: %u modules in %u.%03u ms\n",
+                             debugstr_w(wm->ldr.BaseDllName.Buffer), count,
+                             (UINT)(usecs / 1000), (UINT)(usecs % 1000) );
+        }
     }
 
     RtlAcquirePebLock();
@@ -5006,6 +5006,103 @@ static void test_file_readonly_access(void)
     DeleteFileW(path);
 }
 
+static void scramble_case( char *name, unsigned int seed )
+{
+    for (; *name; name++, seed = seed * 1103515245 + 12345)
+        if (isalpha( *name ) && (seed >> 16) & 1) *name ^= 0x20;
+}
+
+/* the lookup cache skips directories modified in the last second */
+static void backdate_directory( const char *dir, unsigned int seconds )
+{
+    FILETIME ft;
+    ULARGE_INTEGER time;
+    HANDLE handle;
+
+    handle = CreateFileA( dir, FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                          OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, 0 );
+    ok( handle != INVALID_HANDLE_VALUE, "failed to open %s: %u\n", dir, GetLastError() );
+    GetSystemTimeAsFileTime( &ft );
+    time.u.LowPart = ft.dwLowDateTime;
+    time.u.HighPart = ft.dwHighDateTime;
+    time.QuadPart -= (ULONGLONG)seconds * 10000000;
+    ft.dwLowDateTime = time.u.LowPart;
+    ft.dwHighDateTime = time.u.HighPart;
+    ok( SetFileTime( handle, NULL, NULL, &ft ), "SetFileTime failed: %u\n", GetLastError() );
+    CloseHandle( handle );
+}
+
+static void run_case_insensitive_open( unsigned int file_count, unsigned int open_count )
+{
+    char dir[MAX_PATH], path[MAX_PATH];
+    WIN32_FIND_DATAA data;
+    unsigned int i, failures = 0;
+    HANDLE handle;
+    DWORD start;
+
+    GetTempPathA( MAX_PATH, dir );
+    strcat( dir, "winetest_case" );
+    CreateDirectoryA( dir, NULL );
+    for (i = 0; i < file_count; i++)
+    {
+        sprintf( path, "%s\\AssetFile%05u.dat", dir, i );
+        handle = CreateFileA( path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, 0 );
+        ok( handle != INVALID_HANDLE_VALUE, "failed to create %s: %u\n", path, GetLastError() );
+        CloseHandle( handle );
+    }
+    backdate_directory( dir, 7200 );
+
+    start = GetTickCount();
+    for (i = 0; i < open_count; i++)
+    {
+        sprintf( path, "%s\\AssetFile%05u.dat", dir, i % file_count );
+        scramble_case( path + strlen( dir ), i );
+        handle = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, 0 );
+        if (handle == INVALID_HANDLE_VALUE) failures++;
+        else CloseHandle( handle );
+    }
+    trace( "opened %u files with scrambled case in a directory of %u in %u ms\n",
+           open_count, file_count, GetTickCount() - start );
+    ok( !failures, "%u opens failed\n", failures );
+
+    sprintf( path, "%s\\ASSETFILE00042.DAT", dir );
+    handle = FindFirstFileA( path, &data );
+    ok( handle != INVALID_HANDLE_VALUE, "FindFirstFile failed: %u\n", GetLastError() );
+    ok( !strcmp( data.cFileName, "AssetFile00042.dat" ), "got %s\n", data.cFileName );
+    FindClose( handle );
+
+    sprintf( path, "%s\\AssetFile%05u.dat", dir, file_count );
+    handle = CreateFileA( path, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, 0 );
+    ok( handle == INVALID_HANDLE_VALUE, "opened a file that doesn't exist\n" );
+    ok( GetLastError() == ERROR_FILE_NOT_FOUND, "got %u\n", GetLastError() );
+
+    /* a new file changes the directory mtime and drops the cached names */
+    sprintf( path, "%s\\AssetFile%05u.dat", dir, file_count );
+    handle = CreateFileA( path, GENERIC_WRITE, 0, NULL, CREATE_NEW, 0, 0 );
+    ok( handle != INVALID_HANDLE_VALUE, "failed to create %s: %u\n", path, GetLastError() );
+    CloseHandle( handle );
+    backdate_directory( dir, 3600 );
+    scramble_case( path + strlen( dir ), 1 );
+    handle = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, 0 );
+    ok( handle != INVALID_HANDLE_VALUE, "failed to open %s: %u\n", path, GetLastError() );
+    CloseHandle( handle );
+
+    for (i = 0; i <= file_count; i++)
+    {
+        sprintf( path, "%s\\AssetFile%05u.dat", dir, i );
+        DeleteFileA( path );
+    }
+    RemoveDirectoryA( dir );
+}
+
+static void test_case_insensitive_open(void)
+{
+    run_case_insensitive_open( 100, 400 );
+    /* the full benchmark takes a while */
+    if (winetest_interactive) run_case_insensitive_open( 20000, 100000 );
+    else run_case_insensitive_open( 2000, 10000 );
+}
+
 static void test_mailslot_name(void)
 {
     char buffer[1024] = {0};
@@ -5142,4 +5239,5 @@ START_TEST(file)
     test_ioctl();
     test_flush_buffers_file();
     test_mailslot_name();
+    test_case_insensitive_open();
 }
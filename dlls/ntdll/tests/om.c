@@ -1683,6 +1683,66 @@ static void test_query_object(void)
     pNtClose( handle );
 }
 
+static void test_handle_info(void)
+{
+    char tmp_path[MAX_PATH], file[MAX_PATH];
+    OBJECT_DATA_INFORMATION data;
+    FILE_ACCESS_INFORMATION access;
+    FILE_MODE_INFORMATION mode;
+    IO_STATUS_BLOCK io;
+    HANDLE handle, dup;
+    NTSTATUS status;
+    BOOL ret;
+
+    handle = CreateEventA( NULL, FALSE, FALSE, NULL );
+    status = pNtQueryObject( handle, ObjectDataInformation, &data, sizeof(data), NULL );
+    ok( !status, "NtQueryObject failed %x\n", status );
+    ok( !data.InheritHandle, "got inherit %u\n", data.InheritHandle );
+    ok( !data.ProtectFromClose, "got protect %u\n", data.ProtectFromClose );
+
+    ret = SetHandleInformation( handle, HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT );
+    ok( ret, "SetHandleInformation failed %u\n", GetLastError() );
+    status = pNtQueryObject( handle, ObjectDataInformation, &data, sizeof(data), NULL );
+    ok( !status, "NtQueryObject failed %x\n", status );
+    ok( data.InheritHandle, "got inherit %u\n", data.InheritHandle );
+    ok( !data.ProtectFromClose, "got protect %u\n", data.ProtectFromClose );
+    pNtClose( handle );
+
+    /* the same handle value is usually reused, stale information must not be returned */
+    handle = CreateEventA( NULL, FALSE, FALSE, NULL );
+    status = pNtQueryObject( handle, ObjectDataInformation, &data, sizeof(data), NULL );
+    ok( !status, "NtQueryObject failed %x\n", status );
+    ok( !data.InheritHandle, "got inherit %u\n", data.InheritHandle );
+    pNtClose( handle );
+
+    GetTempPathA( MAX_PATH, tmp_path );
+    GetTempFileNameA( tmp_path, "foo", 0, file );
+    handle = CreateFileA( file, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                          FILE_FLAG_WRITE_THROUGH, 0 );
+    ok( handle != INVALID_HANDLE_VALUE, "CreateFile failed (%d)\n", GetLastError() );
+
+    status = pNtQueryInformationFile( handle, &io, &access, sizeof(access), FileAccessInformation );
+    ok( !status, "NtQueryInformationFile failed %x\n", status );
+    ok( io.Information == sizeof(access), "got %u\n", (DWORD)io.Information );
+    ok( access.AccessFlags == (FILE_GENERIC_READ | FILE_GENERIC_WRITE), "got access %x\n", access.AccessFlags );
+
+    status = pNtQueryInformationFile( handle, &io, &mode, sizeof(mode), FileModeInformation );
+    ok( !status, "NtQueryInformationFile failed %x\n", status );
+    ok( mode.Mode == (FILE_WRITE_THROUGH | FILE_SYNCHRONOUS_IO_NONALERT), "got mode %x\n", mode.Mode );
+
+    status = pNtQueryInformationFile( handle, &io, &access, sizeof(access) - 1, FileAccessInformation );
+    ok( status == STATUS_INFO_LENGTH_MISMATCH, "NtQueryInformationFile returned %x\n", status );
+
+    ret = DuplicateHandle( GetCurrentProcess(), handle, GetCurrentProcess(), &dup,
+                           FILE_READ_DATA, FALSE, DUPLICATE_CLOSE_SOURCE );
+    ok( ret, "DuplicateHandle failed %u\n", GetLastError() );
+    status = pNtQueryInformationFile( dup, &io, &access, sizeof(access), FileAccessInformation );
+    ok( !status, "NtQueryInformationFile failed %x\n", status );
+    ok( access.AccessFlags == FILE_READ_DATA, "got access %x\n", access.AccessFlags );
+    pNtClose( dup );
+    DeleteFileA( file );
+}
+
 static void test_type_mismatch(void)
 {
     HANDLE h;
@@ -2320,6 +2380,104 @@ static void test_wait_on_address(void)
     ok(address == 0, "got %s\n", wine_dbgstr_longlong(address));
 }
 
+#define WAIT_ADDR_THREADS 64
+
+/* spaced so that the addresses collide in a small power of two hash */
+struct wait_addr_slot
+{
+    LONG value;
+    LONG ack;
+    LONG spurious;
+    char pad[1024 - 3 * sizeof(LONG)];
+};
+
+static DWORD WINAPI wait_addr_thread( void *arg )
+{
+    struct wait_addr_slot *slot = arg;
+    LONG compare = 0, ack = 0;
+
+    for (;;)
+    {
+        while (slot->value == compare)
+        {
+            pRtlWaitOnAddress( &slot->value, &compare, sizeof(compare), NULL );
+            if (slot->value == compare) InterlockedIncrement( &slot->spurious );
+        }
+        if (slot->value == -1) break;
+        compare = slot->value;
+        InterlockedExchange( &slot->ack, ++ack );
+        pRtlWakeAddressSingle( &slot->ack );
+    }
+    return 0;
+}
+
+static void test_wait_on_address_latency(void)
+{
+    struct wait_addr_slot *slots;
+    HANDLE threads[WAIT_ADDR_THREADS];
+    LARGE_INTEGER start, end, freq;
+    LONG spurious = 0, compare;
+    DWORD i, round, rounds = 50;
+
+    if (!pRtlWaitOnAddress)
+    {
+        win_skip("RtlWaitOnAddress not supported, skipping test\n");
+        return;
+    }
+
+    slots = VirtualAlloc( NULL, WAIT_ADDR_THREADS * sizeof(*slots), MEM_COMMIT, PAGE_READWRITE );
+    for (i = 0; i < WAIT_ADDR_THREADS; i++)
+        threads[i] = CreateThread( NULL, 0, wait_addr_thread, &slots[i], 0, NULL );
+
+    /* wake each waiter in turn while all the others keep waiting */
+    QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &start );
+    for (round = 1; round <= rounds; round++)
+    {
+        for (i = 0; i < WAIT_ADDR_THREADS; i++)
+        {
+            InterlockedExchange( &slots[i].value, round );
+            pRtlWakeAddressSingle( &slots[i].value );
+            compare = round - 1;
+            while (slots[i].ack == compare)
+                pRtlWaitOnAddress( &slots[i].ack, &compare, sizeof(compare), NULL );
+        }
+    }
+    QueryPerformanceCounter( &end );
+
+    for (i = 0; i < WAIT_ADDR_THREADS; i++)
+    {
+        InterlockedExchange( &slots[i].value, -1 );
+        pRtlWakeAddressAll( &slots[i].value );
+    }
+    for (i = 0; i < WAIT_ADDR_THREADS; i++)
+    {
+        ok( !WaitForSingleObject( threads[i], 5000 ), "thread %u didn't exit\n", i );
+        ok( slots[i].ack == rounds, "thread %u got %d wakes\n", i, slots[i].ack );
+        spurious += slots[i].spurious;
+        CloseHandle( threads[i] );
+    }
+    trace( "%u waiters: %.2f us per wake round trip, %d spurious wakes\n", WAIT_ADDR_THREADS,
+           (end.QuadPart - start.QuadPart) * 1000000.0 / freq.QuadPart / (rounds * WAIT_ADDR_THREADS),
+           spurious );
+
+    /* a waiter killed while blocked doesn't stay queued */
+    slots[0].value = slots[0].ack = 0;
+    threads[0] = CreateThread( NULL, 0, wait_addr_thread, &slots[0], 0, NULL );
+    ok( WaitForSingleObject( threads[0], 100 ) == WAIT_TIMEOUT, "thread exited\n" );
+    TerminateThread( threads[0], 0 );
+    WaitForSingleObject( threads[0], 5000 );
+    CloseHandle( threads[0] );
+    threads[0] = CreateThread( NULL, 0, wait_addr_thread, &slots[0], 0, NULL );
+    ok( WaitForSingleObject( threads[0], 100 ) == WAIT_TIMEOUT, "thread exited\n" );
+    InterlockedExchange( &slots[0].value, -1 );
+    pRtlWakeAddressAll( &slots[0].value );
+    ok( !WaitForSingleObject( threads[0], 5000 ), "thread didn't exit\n" );
+    CloseHandle( threads[0] );
+
+    VirtualFree( slots, 0, MEM_RELEASE );
+}
+
 static void test_process(void)
 {
     OBJECT_ATTRIBUTES attr;
@@ -2549,9 +2707,223 @@ static void test_object_types(void)
     }
 }
 
+struct sync_latency_params
+{
+    HANDLE ping;
+    HANDLE pong;
+    BOOL   semaphore;
+    DWORD  count;
+};
+
+static DWORD WINAPI sync_latency_thread( void *arg )
+{
+    struct sync_latency_params *params = arg;
+    DWORD i;
+
+    for (i = 0; i < params->count; i++)
+    {
+        if (WaitForSingleObject( params->ping, 5000 )) break;
+        if (params->semaphore) ReleaseSemaphore( params->pong, 1, NULL );
+        else SetEvent( params->pong );
+    }
+    return i;
+}
+
+static void run_sync_latency( const char *mode, BOOL semaphore )
+{
+    struct sync_latency_params params;
+    LARGE_INTEGER start, end, freq;
+    HANDLE thread;
+    DWORD i, ret;
+
+    params.semaphore = semaphore;
+    params.count = 5000;
+    if (semaphore)
+    {
+        params.ping = CreateSemaphoreA( NULL, 0, 1, NULL );
+        params.pong = CreateSemaphoreA( NULL, 0, 1, NULL );
+    }
+    else
+    {
+        params.ping = CreateEventA( NULL, FALSE, FALSE, NULL );
+        params.pong = CreateEventA( NULL, FALSE, FALSE, NULL );
+    }
+    ok( params.ping && params.pong, "failed to create objects, error %u\n", GetLastError() );
+    thread = CreateThread( NULL, 0, sync_latency_thread, &params, 0, NULL );
+
+    QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < params.count; i++)
+    {
+        if (semaphore) ReleaseSemaphore( params.ping, 1, NULL );
+        else SetEvent( params.ping );
+        if ((ret = WaitForSingleObject( params.pong, 5000 ))) break;
+    }
+    QueryPerformanceCounter( &end );
+    ok( i == params.count, "got %u round trips\n", i );
+
+    WaitForSingleObject( thread, 5000 );
+    GetExitCodeThread( thread, &ret );
+    ok( ret == params.count, "thread did %u round trips\n", ret );
+    trace( "%s %s: %u signal/wait round trips, %.2f us each\n", mode, semaphore ? "semaphore" : "event",
+           params.count, (end.QuadPart - start.QuadPart) * 1000000.0 / freq.QuadPart / params.count );
+
+    CloseHandle( thread );
+    CloseHandle( params.ping );
+    CloseHandle( params.pong );
+}
+
+static DWORD WINAPI sync_wait_thread( void *arg )
+{
+    return WaitForSingleObject( arg, INFINITE );
+}
+
+static void test_remote_dup_child( DWORD pid, HANDLE event )
+{
+    HANDLE process, dup;
+    DWORD ret;
+
+    process = OpenProcess( PROCESS_DUP_HANDLE, FALSE, pid );
+    ok( process != NULL, "OpenProcess failed, error %u\n", GetLastError() );
+    ret = DuplicateHandle( process, event, GetCurrentProcess(), &dup, 0, FALSE, DUPLICATE_SAME_ACCESS );
+    ok( ret, "DuplicateHandle failed, error %u\n", GetLastError() );
+    ret = WaitForSingleObject( dup, 0 );
+    ok( ret == WAIT_OBJECT_0, "got %u\n", ret );
+    ResetEvent( dup );
+    CloseHandle( dup );
+    CloseHandle( process );
+}
+
+static void test_sync_latency( const char *mode )
+{
+    PROCESS_INFORMATION pi;
+    STARTUPINFOA si = { sizeof(si) };
+    char cmdline[MAX_PATH];
+    HANDLE objs[2], event, dup, process, thread;
+    char **argv;
+    LONG prev;
+    DWORD ret;
+
+    run_sync_latency( mode, FALSE );
+    run_sync_latency( mode, TRUE );
+
+    /* objects keep their state when they have to be waited on together with others */
+    objs[0] = event = CreateEventA( NULL, TRUE, TRUE, NULL );
+    objs[1] = CreateMutexA( NULL, TRUE, NULL );
+    ret = WaitForMultipleObjects( 2, objs, TRUE, 0 );
+    ok( ret == WAIT_OBJECT_0, "got %u\n", ret );
+    ret = WaitForSingleObject( GetCurrentProcess(), 0 );
+    ok( ret == WAIT_TIMEOUT, "got %u\n", ret );
+    objs[0] = GetCurrentProcess();
+    ret = WaitForMultipleObjects( 2, objs, FALSE, 0 );
+    ok( ret == WAIT_OBJECT_0 + 1, "got %u\n", ret );
+    ret = ReleaseMutex( objs[1] );
+    ok( ret, "ReleaseMutex failed\n" );
+    ret = ReleaseMutex( objs[1] );
+    ok( ret, "ReleaseMutex failed\n" );
+    ret = ReleaseMutex( objs[1] );
+    ok( ret, "ReleaseMutex failed\n" );
+    ret = ReleaseMutex( objs[1] );
+    ok( !ret, "ReleaseMutex succeeded\n" );
+    CloseHandle( objs[1] );
+    CloseHandle( event );
+
+    objs[0] = CreateSemaphoreA( NULL, 2, 3, NULL );
+    ret = DuplicateHandle( GetCurrentProcess(), objs[0], GetCurrentProcess(), &dup, 0, FALSE, DUPLICATE_SAME_ACCESS );
+    ok( ret, "DuplicateHandle failed\n" );
+    ret = WaitForSingleObject( dup, 0 );
+    ok( ret == WAIT_OBJECT_0, "got %u\n", ret );
+    CloseHandle( objs[0] );
+    ret = ReleaseSemaphore( dup, 2, &prev );
+    ok( ret, "ReleaseSemaphore failed\n" );
+    ok( prev == 1, "got previous count %d\n", prev );
+    ret = ReleaseSemaphore( dup, 1, &prev );
+    ok( !ret, "ReleaseSemaphore succeeded\n" );
+    CloseHandle( dup );
+
+    /* duplication through a real handle to the current process */
+    process = OpenProcess( PROCESS_DUP_HANDLE, FALSE, GetCurrentProcessId() );
+    ok( process != NULL, "OpenProcess failed, error %u\n", GetLastError() );
+    event = CreateEventA( NULL, TRUE, FALSE, NULL );
+    ret = DuplicateHandle( process, event, process, &dup, 0, FALSE, DUPLICATE_SAME_ACCESS );
+    ok( ret, "DuplicateHandle failed\n" );
+    SetEvent( event );
+    ret = WaitForSingleObject( dup, 0 );
+    ok( ret == WAIT_OBJECT_0, "got %u\n", ret );
+    ResetEvent( dup );
+    ret = WaitForSingleObject( event, 0 );
+    ok( ret == WAIT_TIMEOUT, "got %u\n", ret );
+    CloseHandle( dup );
+    CloseHandle( event );
+    CloseHandle( process );
+
+    /* another process duplicating our handle sees the current state */
+    event = CreateEventA( NULL, TRUE, FALSE, NULL );
+    SetEvent( event );
+    winetest_get_mainargs( &argv );
+    sprintf( cmdline, "%s om dup_event %u %x", argv[0], GetCurrentProcessId(), HandleToULong( event ) );
+    ret = CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi );
+    ok( ret, "CreateProcess failed, error %u\n", GetLastError() );
+    winetest_wait_child_process( pi.hProcess );
+    CloseHandle( pi.hProcess );
+    CloseHandle( pi.hThread );
+    ret = WaitForSingleObject( event, 0 );
+    ok( ret == WAIT_TIMEOUT, "got %u\n", ret );
+    CloseHandle( event );
+
+    /* threads killed while waiting don't leave anything behind */
+    event = CreateEventA( NULL, FALSE, FALSE, NULL );
+    objs[0] = CreateMutexA( NULL, FALSE, NULL );
+    thread = CreateThread( NULL, 0, sync_wait_thread, event, 0, NULL );
+    ret = WaitForSingleObject( thread, 100 );
+    ok( ret == WAIT_TIMEOUT, "got %u\n", ret );
+    TerminateThread( thread, 0 );
+    WaitForSingleObject( thread, 5000 );
+    CloseHandle( thread );
+    SetEvent( event );
+    ret = WaitForSingleObject( event, 0 );
+    ok( ret == WAIT_OBJECT_0, "got %u\n", ret );
+    CloseHandle( event );
+
+    WaitForSingleObject( objs[0], 0 );
+    thread = CreateThread( NULL, 0, sync_wait_thread, objs[0], 0, NULL );
+    ret = WaitForSingleObject( thread, 100 );
+    ok( ret == WAIT_TIMEOUT, "got %u\n", ret );
+    TerminateThread( thread, 0 );
+    WaitForSingleObject( thread, 5000 );
+    CloseHandle( thread );
+    ret = ReleaseMutex( objs[0] );
+    ok( ret, "ReleaseMutex failed\n" );
+    ret = WaitForSingleObject( objs[0], 0 );
+    ok( ret == WAIT_OBJECT_0, "got %u\n", ret );
+    ReleaseMutex( objs[0] );
+    CloseHandle( objs[0] );
+}
+
+static void test_fast_sync_child(void)
+{
+    PROCESS_INFORMATION pi;
+    STARTUPINFOA si = { sizeof(si) };
+    char cmdline[MAX_PATH];
+    char **argv;
+    BOOL ret;
+
+    winetest_get_mainargs( &argv );
+    sprintf( cmdline, "%s om fast_sync", argv[0] );
+    SetEnvironmentVariableA( "WINEFASTSYNC", "1" );
+    ret = CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi );
+    SetEnvironmentVariableA( "WINEFASTSYNC", NULL );
+    ok( ret, "CreateProcess failed, error %u\n", GetLastError() );
+    winetest_wait_child_process( pi.hProcess );
+    CloseHandle( pi.hProcess );
+    CloseHandle( pi.hThread );
+}
+
 START_TEST(om)
 {
     HMODULE hntdll = GetModuleHandleA("ntdll.dll");
+    char **argv;
+    int argc;
 
     pNtCreateEvent          = (void *)GetProcAddress(hntdll, "NtCreateEvent");
     pNtCreateJobObject      = (void *)GetProcAddress(hntdll, "NtCreateJobObject");
@@ -2601,6 +2973,21 @@ START_TEST(om)
     pNtOpenProcess          =  (void *)GetProcAddress(hntdll, "NtOpenProcess");
     pNtCreateDebugObject    =  (void *)GetProcAddress(hntdll, "NtCreateDebugObject");
 
+    argc = winetest_get_mainargs( &argv );
+    if (argc >= 3 && !strcmp( argv[2], "fast_sync" ))
+    {
+        test_event();
+        test_mutant();
+        test_semaphore();
+        test_sync_latency( "WINEFASTSYNC" );
+        return;
+    }
+    if (argc >= 5 && !strcmp( argv[2], "dup_event" ))
+    {
+        test_remote_dup_child( strtoul( argv[3], NULL, 10 ), ULongToHandle( strtoul( argv[4], NULL, 16 )));
+        return;
+    }
+
     test_case_sensitive();
     test_namespace_pipe();
     test_name_collisions();
@@ -2608,6 +2995,7 @@ START_TEST(om)
     test_directory();
     test_symboliclink();
     test_query_object();
+    test_handle_info();
     test_type_mismatch();
     test_event();
     test_mutant();
@@ -2615,6 +3003,9 @@ START_TEST(om)
     test_keyed_events();
     test_null_device();
     test_wait_on_address();
+    test_wait_on_address_latency();
     test_process();
     test_object_types();
+    test_sync_latency( "default" );
+    test_fast_sync_child();
 }
@@ -127,6 +127,7 @@ static NTSTATUS (WINAPI * pNtOpenKeyEx)(PHANDLE, ACCESS_MASK, POBJECT_ATTRIBUTES
 static NTSTATUS (WINAPI * pNtClose)(IN HANDLE);
 static NTSTATUS (WINAPI * pNtFlushKey)(HANDLE);
 static NTSTATUS (WINAPI * pNtDeleteKey)(HANDLE);
+static NTSTATUS (WINAPI * pNtEnumerateKey)(HANDLE,ULONG,KEY_INFORMATION_CLASS,void *,DWORD,DWORD *);
 static NTSTATUS (WINAPI * pNtCreateKey)( PHANDLE retkey, ACCESS_MASK access, const OBJECT_ATTRIBUTES *attr,
                              ULONG TitleIndex, const UNICODE_STRING *class, ULONG options,
                              PULONG dispos );
@@ -183,6 +184,7 @@ static BOOL InitFunctionPtrs(void)
     NTDLL_GET_PROC(NtCreateKey)
     NTDLL_GET_PROC(NtFlushKey)
     NTDLL_GET_PROC(NtDeleteKey)
+    NTDLL_GET_PROC(NtEnumerateKey)
     NTDLL_GET_PROC(NtQueryKey)
     NTDLL_GET_PROC(NtQueryValueKey)
     NTDLL_GET_PROC(NtQueryInformationProcess)
@@ -1709,6 +1711,174 @@ static void test_redirection(void)
     pNtClose( key64 );
 }
 
+#define QUERY_PROCESSES 4
+#define QUERY_COUNT     5000
+
+static void query_value_child(void)
+{
+    static const WCHAR deletetestW[] = {'d','e','l','e','t','e','t','e','s','t',0};
+    KEY_VALUE_PARTIAL_INFORMATION *info;
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING name;
+    NTSTATUS status;
+    HANDLE key, event, ready;
+    DWORD i, len, failures = 0;
+    char buffer[64];
+
+    InitializeObjectAttributes(&attr, &winetestpath, 0, 0, 0);
+    status = pNtOpenKey(&key, KEY_READ, &attr);
+    ok(status == STATUS_SUCCESS, "NtOpenKey Failed: 0x%08x\n", status);
+
+    event = OpenEventA(SYNCHRONIZE, FALSE, "winetest_reg_query_start");
+    ok(event != NULL, "OpenEvent failed: %u\n", GetLastError());
+    ready = OpenSemaphoreA(SEMAPHORE_MODIFY_STATE, FALSE, "winetest_reg_query_ready");
+    ok(ready != NULL, "OpenSemaphore failed: %u\n", GetLastError());
+    ReleaseSemaphore(ready, 1, NULL);
+    CloseHandle(ready);
+    WaitForSingleObject(event, INFINITE);
+    CloseHandle(event);
+
+    pRtlInitUnicodeString(&name, deletetestW);
+    info = (KEY_VALUE_PARTIAL_INFORMATION *)buffer;
+    for (i = 0; i < QUERY_COUNT; i++)
+    {
+        if (pNtQueryValueKey(key, &name, KeyValuePartialInformation, info, sizeof(buffer), &len))
+            failures++;
+    }
+    ok(!failures, "%u queries failed\n", failures);
+
+    pNtClose(key);
+}
+
+static void test_query_value_throughput(void)
+{
+    PROCESS_INFORMATION pi[QUERY_PROCESSES];
+    STARTUPINFOA si = { sizeof(si) };
+    char cmdline[MAX_PATH], **argv;
+    HANDLE event, ready;
+    DWORD i, j, start;
+    BOOL ret;
+
+    winetest_get_mainargs(&argv);
+    sprintf(cmdline, "\"%s\" reg query_value", argv[0]);
+    event = CreateEventA(NULL, TRUE, FALSE, "winetest_reg_query_start");
+    ready = CreateSemaphoreA(NULL, 0, QUERY_PROCESSES, "winetest_reg_query_ready");
+
+    /* the server only runs these in parallel when started with WINESERVER_WORKERS set */
+    for (i = 0; i < QUERY_PROCESSES; i++)
+    {
+        ret = CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi[i]);
+        ok(ret, "CreateProcess failed: %u\n", GetLastError());
+        if (!ret) break;
+    }
+
+    /* leave process startup out of the measurement */
+    for (j = 0; j < i; j++)
+        if (WaitForSingleObject(ready, 5000)) break;
+    start = GetTickCount();
+    SetEvent(event);
+    while (i--)
+    {
+        wait_child_process(pi[i].hProcess);
+        CloseHandle(pi[i].hProcess);
+        CloseHandle(pi[i].hThread);
+    }
+    trace("%u processes x %u NtQueryValueKey calls: %u ms\n",
+          QUERY_PROCESSES, QUERY_COUNT, GetTickCount() - start);
+
+    CloseHandle(ready);
+    CloseHandle(event);
+}
+
+#define BULK_KEY_COUNT 20000
+
+static void test_bulk_subkeys(void)
+{
+    static const WCHAR bulkW[] = {'\\','B','u','l','k',0};
+    WCHAR buffer[MAX_PATH], name[32], prev[32];
+    KEY_BASIC_INFORMATION *info = (KEY_BASIC_INFORMATION *)buffer;
+    OBJECT_ATTRIBUTES attr;
+    UNICODE_STRING str;
+    HANDLE key, subkey;
+    NTSTATUS status;
+    unsigned int i, n;
+    DWORD start, len;
+
+    pRtlCreateUnicodeString( &str, winetestpath.Buffer );
+    str.Buffer = pRtlReAllocateHeap( GetProcessHeap(), 0, str.Buffer, str.MaximumLength + sizeof(bulkW) );
+    str.MaximumLength += sizeof(bulkW);
+    pRtlAppendUnicodeToString( &str, bulkW );
+    InitializeObjectAttributes( &attr, &str, 0, 0, 0 );
+    status = pNtCreateKey( &key, KEY_ALL_ACCESS, &attr, 0, 0, 0, 0 );
+    ok( status == STATUS_SUCCESS, "NtCreateKey failed: 0x%08x\n", status );
+    pRtlFreeUnicodeString( &str );
+
+    /* insert the subkeys in scrambled order */
+    start = GetTickCount();
+    for (i = n = 0; i < BULK_KEY_COUNT; i++, n = (n + 7919) % BULK_KEY_COUNT)
+    {
+        swprintf( name, ARRAY_SIZE(name), L"SubKey%05u", n );
+        pRtlInitUnicodeString( &str, name );
+        InitializeObjectAttributes( &attr, &str, 0, key, 0 );
+        status = pNtCreateKey( &subkey, KEY_ALL_ACCESS, &attr, 0, 0, REG_OPTION_VOLATILE, 0 );
+        ok( status == STATUS_SUCCESS, "NtCreateKey failed: 0x%08x\n", status );
+        pNtClose( subkey );
+    }
+    trace( "created %u subkeys in %u ms\n", BULK_KEY_COUNT, GetTickCount() - start );
+
+    start = GetTickCount();
+    for (i = n = 0; i < BULK_KEY_COUNT; i++, n = (n + 104729) % BULK_KEY_COUNT)
+    {
+        swprintf( name, ARRAY_SIZE(name), L"sUBkEY%05u", n );
+        pRtlInitUnicodeString( &str, name );
+        InitializeObjectAttributes( &attr, &str, 0, key, 0 );
+        status = pNtOpenKey( &subkey, KEY_READ, &attr );
+        ok( status == STATUS_SUCCESS, "NtOpenKey failed: 0x%08x\n", status );
+        pNtClose( subkey );
+    }
+    trace( "opened %u subkeys in %u ms\n", BULK_KEY_COUNT, GetTickCount() - start );
+
+    /* enumeration is still sorted */
+    prev[0] = 0;
+    for (i = 0; i < BULK_KEY_COUNT; i++)
+    {
+        status = pNtEnumerateKey( key, i, KeyBasicInformation, info, sizeof(buffer), &len );
+        ok( status == STATUS_SUCCESS, "NtEnumerateKey failed: 0x%08x\n", status );
+        if (status) break;
+        memcpy( name, info->Name, info->NameLength );
+        name[info->NameLength / sizeof(WCHAR)] = 0;
+        ok( wcscmp( prev, name ) < 0, "%s enumerated after %s\n", wine_dbgstr_w(name), wine_dbgstr_w(prev) );
+        wcscpy( prev, name );
+    }
+    status = pNtEnumerateKey( key, BULK_KEY_COUNT, KeyBasicInformation, info, sizeof(buffer), &len );
+    ok( status == STATUS_NO_MORE_ENTRIES, "got 0x%08x\n", status );
+
+    /* delete them the way RegDeleteTree does, always enumerating the first one */
+    start = GetTickCount();
+    for (i = 0; i < BULK_KEY_COUNT; i++)
+    {
+        status = pNtEnumerateKey( key, 0, KeyBasicInformation, info, sizeof(buffer), &len );
+        ok( status == STATUS_SUCCESS, "NtEnumerateKey failed: 0x%08x\n", status );
+        if (status) break;
+        memcpy( name, info->Name, info->NameLength );
+        name[info->NameLength / sizeof(WCHAR)] = 0;
+        swprintf( prev, ARRAY_SIZE(prev), L"SubKey%05u", i );
+        ok( !wcscmp( name, prev ), "got %s, expected %s\n", wine_dbgstr_w(name), wine_dbgstr_w(prev) );
+        pRtlInitUnicodeString( &str, name );
+        InitializeObjectAttributes( &attr, &str, 0, key, 0 );
+        status = pNtOpenKey( &subkey, DELETE, &attr );
+        ok( status == STATUS_SUCCESS, "NtOpenKey failed: 0x%08x\n", status );
+        pNtDeleteKey( subkey );
+        pNtClose( subkey );
+    }
+    trace( "deleted %u subkeys in %u ms\n", BULK_KEY_COUNT, GetTickCount() - start );
+    status = pNtEnumerateKey( key, 0, KeyBasicInformation, info, sizeof(buffer), &len );
+    ok( status == STATUS_NO_MORE_ENTRIES, "got 0x%08x\n", status );
+
+    pNtDeleteKey( key );
+    pNtClose( key );
+}
+
 static void test_long_value_name(void)
 {
     HANDLE key;
@@ -2052,6 +2222,8 @@ static void test_RtlCreateRegistryKey(void)
 START_TEST(reg)
 {
     static const WCHAR winetest[] = {'\\','W','i','n','e','T','e','s','t',0};
+    char **argv;
+
     if(!InitFunctionPtrs())
         return;
     pRtlFormatCurrentUserKeyPath(&winetestpath);
@@ -2061,6 +2233,12 @@ START_TEST(reg)
 
     pRtlAppendUnicodeToString(&winetestpath, winetest);
 
+    if (winetest_get_mainargs(&argv) >= 3 && !strcmp(argv[2], "query_value"))
+    {
+        query_value_child();
+        goto done;
+    }
+
     test_NtCreateKey();
     test_NtOpenKey();
     test_NtSetValueKey();
@@ -2072,6 +2250,8 @@ START_TEST(reg)
     test_NtQueryKey();
     test_NtQueryLicenseKey();
     test_NtQueryValueKey();
+    test_query_value_throughput();
+    test_bulk_subkeys();
     test_long_value_name();
     test_notify();
     test_RtlCreateRegistryKey();
@@ -2079,6 +2259,7 @@ START_TEST(reg)
     test_symlinks();
     test_redirection();
 
+done:
     pRtlFreeUnicodeString(&winetestpath);
 
     FreeLibrary(hntdll);
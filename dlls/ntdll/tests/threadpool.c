@@ -2289,6 +2289,221 @@ static void test_kernel32_tp_io(void)
     pTpReleasePool(pool);
 }
 
+struct simple_perf_info
+{
+    HANDLE event;
+    LONG count;
+    LONG total;
+    LONG order;
+};
+
+static void CALLBACK simple_perf_cb(TP_CALLBACK_INSTANCE *instance, void *userdata)
+{
+    struct simple_perf_info *info = userdata;
+    if (InterlockedIncrement(&info->count) == info->total)
+        SetEvent(info->event);
+}
+
+static void CALLBACK work_perf_cb(TP_CALLBACK_INSTANCE *instance, void *userdata, TP_WORK *work)
+{
+    simple_perf_cb(instance, userdata);
+}
+
+struct work_post_info
+{
+    TP_WORK *work;
+    LONG count;
+    LONG nested;
+};
+
+static void CALLBACK work_nested_cb(TP_CALLBACK_INSTANCE *instance, void *userdata, TP_WORK *work)
+{
+    struct work_post_info *info = userdata;
+    InterlockedIncrement(&info->count);
+    if (InterlockedDecrement(&info->nested) >= 0)
+        pTpPostWork(work);
+}
+
+static DWORD WINAPI work_post_thread(void *arg)
+{
+    struct work_post_info *info = arg;
+    unsigned int i;
+
+    for (i = 0; i < 1000; i++)
+        pTpPostWork(info->work);
+    return 0;
+}
+
+static void CALLBACK simple_block_cb(TP_CALLBACK_INSTANCE *instance, void *userdata)
+{
+    struct simple_perf_info *info = userdata;
+    WaitForSingleObject(info->event, 1000);
+}
+
+static void CALLBACK simple_order_cb(TP_CALLBACK_INSTANCE *instance, void *userdata)
+{
+    struct simple_perf_info *info = (struct simple_perf_info *)((LONG_PTR)userdata & ~3);
+    info->order = info->order * 10 + ((LONG_PTR)userdata & 3);
+    InterlockedIncrement(&info->count);
+}
+
+static void test_tp_simple_perf(void)
+{
+    static const DWORD max_threads[] = {1, 2, 4, 8, 16};
+    TP_CALLBACK_ENVIRON_V3 environment3;
+    TP_CALLBACK_ENVIRON environment;
+    LARGE_INTEGER freq, start, end;
+    struct work_post_info post_info;
+    struct simple_perf_info info;
+    TP_CLEANUP_GROUP *group;
+    HANDLE threads[4];
+    NTSTATUS status;
+    TP_WORK *work;
+    TP_POOL *pool;
+    DWORD result;
+    unsigned int i, j;
+
+    QueryPerformanceFrequency(&freq);
+    info.event = CreateEventA(NULL, FALSE, FALSE, NULL);
+
+    for (i = 0; i < ARRAY_SIZE(max_threads); i++)
+    {
+        pool = NULL;
+        status = pTpAllocPool(&pool, NULL);
+        ok(!status, "TpAllocPool failed with status %x\n", status);
+        pTpSetPoolMaxThreads(pool, max_threads[i]);
+
+        memset(&environment, 0, sizeof(environment));
+        environment.Version = 1;
+        environment.Pool = pool;
+
+        /* throughput of many small callbacks */
+        info.count = 0;
+        info.total = 20000;
+        QueryPerformanceCounter(&start);
+        for (j = 0; j < info.total; j++)
+        {
+            status = pTpSimpleTryPost(simple_perf_cb, &info, &environment);
+            ok(!status, "TpSimpleTryPost failed with status %x\n", status);
+        }
+        result = WaitForSingleObject(info.event, 10000);
+        QueryPerformanceCounter(&end);
+        ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", result);
+        ok(info.count == info.total, "expected %u callbacks, got %u\n", info.total, info.count);
+        trace("%u threads: %u callbacks in %.1f ms\n", max_threads[i], info.total,
+              (end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart);
+
+        /* the same with a work object */
+        work = NULL;
+        status = pTpAllocWork(&work, work_perf_cb, &info, &environment);
+        ok(!status, "TpAllocWork failed with status %x\n", status);
+        info.count = 0;
+        info.total = 20000;
+        QueryPerformanceCounter(&start);
+        for (j = 0; j < info.total; j++)
+            pTpPostWork(work);
+        result = WaitForSingleObject(info.event, 10000);
+        QueryPerformanceCounter(&end);
+        ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", result);
+        pTpWaitForWork(work, FALSE);
+        ok(info.count == info.total, "expected %u callbacks, got %u\n", info.total, info.count);
+        trace("%u threads: %u work callbacks in %.1f ms\n", max_threads[i], info.total,
+              (end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart);
+        pTpReleaseWork(work);
+
+        /* a work object posted from several threads and from its own callback */
+        post_info.work = NULL;
+        status = pTpAllocWork(&post_info.work, work_nested_cb, &post_info, &environment);
+        ok(!status, "TpAllocWork failed with status %x\n", status);
+        post_info.count = 0;
+        post_info.nested = 1000;
+        for (j = 0; j < ARRAY_SIZE(threads); j++)
+            threads[j] = CreateThread(NULL, 0, work_post_thread, &post_info, 0, NULL);
+        for (j = 0; j < ARRAY_SIZE(threads); j++)
+        {
+            result = WaitForSingleObject(threads[j], 10000);
+            ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", result);
+            CloseHandle(threads[j]);
+        }
+        pTpWaitForWork(post_info.work, FALSE);
+        ok(post_info.count == 5000, "expected 5000 callbacks, got %u\n", post_info.count);
+
+        /* cancel the pending callbacks, the object is still usable afterwards */
+        post_info.count = 0;
+        post_info.nested = 0;
+        work_post_thread(&post_info);
+        pTpWaitForWork(post_info.work, TRUE);
+        ok(post_info.count <= 1000, "expected at most 1000 callbacks, got %u\n", post_info.count);
+        post_info.count = 0;
+        pTpPostWork(post_info.work);
+        pTpWaitForWork(post_info.work, FALSE);
+        ok(post_info.count == 1, "expected 1 callback, got %u\n", post_info.count);
+        pTpReleaseWork(post_info.work);
+
+        /* latency from submission until the callback runs */
+        QueryPerformanceCounter(&start);
+        for (j = 0; j < 200; j++)
+        {
+            info.count = 0;
+            info.total = 1;
+            status = pTpSimpleTryPost(simple_perf_cb, &info, &environment);
+            ok(!status, "TpSimpleTryPost failed with status %x\n", status);
+            result = WaitForSingleObject(info.event, 1000);
+            ok(result == WAIT_OBJECT_0, "WaitForSingleObject returned %u\n", result);
+        }
+        QueryPerformanceCounter(&end);
+        trace("%u threads: %.1f us per round trip\n", max_threads[i],
+              (end.QuadPart - start.QuadPart) * 1000000.0 / freq.QuadPart / 200);
+
+        pTpReleasePool(pool);
+    }
+
+    /* callbacks with and without a cleanup group are ordered by priority */
+    pool = NULL;
+    status = pTpAllocPool(&pool, NULL);
+    ok(!status, "TpAllocPool failed with status %x\n", status);
+    pTpSetPoolMaxThreads(pool, 1);
+
+    group = NULL;
+    status = pTpAllocCleanupGroup(&group);
+    ok(!status, "TpAllocCleanupGroup failed with status %x\n", status);
+
+    memset(&environment3, 0, sizeof(environment3));
+    environment3.Version = 3;
+    environment3.Pool = pool;
+    environment3.Size = sizeof(environment3);
+    environment3.CallbackPriority = TP_CALLBACK_PRIORITY_NORMAL;
+    status = pTpSimpleTryPost(simple_block_cb, &info, (TP_CALLBACK_ENVIRON *)&environment3);
+    ok(!status, "TpSimpleTryPost failed with status %x\n", status);
+    Sleep(50);
+
+    info.count = 0;
+    info.order = 0;
+    environment3.CallbackPriority = TP_CALLBACK_PRIORITY_LOW;
+    status = pTpSimpleTryPost(simple_order_cb, (char *)&info + 3, (TP_CALLBACK_ENVIRON *)&environment3);
+    ok(!status, "TpSimpleTryPost failed with status %x\n", status);
+    environment3.CallbackPriority = TP_CALLBACK_PRIORITY_NORMAL;
+    environment3.CleanupGroup = group;
+    status = pTpSimpleTryPost(simple_order_cb, (char *)&info + 2, (TP_CALLBACK_ENVIRON *)&environment3);
+    ok(!status, "TpSimpleTryPost failed with status %x\n", status);
+    environment3.CallbackPriority = TP_CALLBACK_PRIORITY_HIGH;
+    environment3.CleanupGroup = NULL;
+    status = pTpSimpleTryPost(simple_order_cb, (char *)&info + 1, (TP_CALLBACK_ENVIRON *)&environment3);
+    ok(!status, "TpSimpleTryPost failed with status %x\n", status);
+
+    SetEvent(info.event);
+    pTpReleaseCleanupGroupMembers(group, FALSE, NULL);
+    for (i = 0; i < 100 && info.count < 3; i++)
+        Sleep(10);
+    ok(info.count == 3, "expected 3 callbacks, got %u\n", info.count);
+    ok(info.order == 123 || broken(info.order == 321) /* Vista does not support priorities */,
+       "expected order 123, got %u\n", info.order);
+
+    pTpReleaseCleanupGroup(group);
+    pTpReleasePool(pool);
+    CloseHandle(info.event);
+}
+
 START_TEST(threadpool)
 {
     test_RtlQueueWorkItem();
@@ -2310,4 +2525,5 @@ START_TEST(threadpool)
     test_tp_multi_wait();
     test_tp_io();
     test_kernel32_tp_io();
+    test_tp_simple_perf();
 }
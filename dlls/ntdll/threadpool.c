@@ -98,8 +98,29 @@ struct timer_queue
  */
 
 #define THREADPOOL_WORKER_TIMEOUT 5000
+#define THREADPOOL_MAX_NODES 64
 #define MAXIMUM_WAITQUEUE_OBJECTS (MAXIMUM_WAIT_OBJECTS - 1)
 
+/* local queue of simple callbacks and work objects, owned by a worker thread or a NUMA node */
+struct threadpool_queue
+{
+    RTL_SRWLOCK             lock;
+    /* order matches TP_CALLBACK_PRIORITY - high, normal, low */
+    struct list             items[3];
+    /* number of queued objects, changed with .lock held but also read without it */
+    LONG                    num_items;
+};
+
+/* worker thread information, lives on the stack of the worker */
+struct threadpool_worker
+{
+    struct threadpool      *pool;
+    struct threadpool_queue queue;
+    /* entry in pool->workers, locked via pool->workers_lock */
+    struct list             entry;
+    unsigned int            node;
+};
+
 /* internal threadpool representation */
 struct threadpool
 {
@@ -109,14 +130,29 @@ struct threadpool
     CRITICAL_SECTION        cs;
     /* Pools of work items, locked via .cs, order matches TP_CALLBACK_PRIORITY - high, normal, low. */
     struct list             pools[3];
+    /* number of objects in .pools, changed with .cs held but also read without it */
+    LONG                    num_queued[3];
     RTL_CONDITION_VARIABLE  update_event;
     /* information about worker threads, locked via .cs */
     int                     max_workers;
     int                     min_workers;
     int                     num_workers;
     int                     num_busy_workers;
+    int                     num_wakeups;
+    /* changed with .cs held but also read without it */
+    LONG                    num_idle_workers;
     HANDLE                  compl_port;
     TP_POOL_STACK_INFORMATION stack_info;
+    /* Simple callbacks and work objects are queued on the local queue of the
+     * submitting worker thread, or on the queue of the NUMA node of the
+     * submitting thread, and run without taking .cs. */
+    LONG                    num_local[3];
+    LONG                    num_local_busy;
+    RTL_SRWLOCK             workers_lock;
+    struct list             workers;
+    BYTE                    cpu_nodes[sizeof(KAFFINITY) * 8];
+    unsigned int            num_nodes;
+    struct threadpool_queue node_queues[1];
 };
 
 enum threadpool_objtype
@@ -153,7 +189,8 @@ struct threadpool_object
     /* information about the group, locked via .group->cs */
     struct list             group_entry;
     BOOL                    is_group_member;
-    /* information about the pool, locked via .pool->cs */
+    /* information about the pool, locked via .pool->cs, or changed with
+     * interlocked functions for simple callbacks and work objects */
     struct list             pool_entry;
     RTL_CONDITION_VARIABLE  finished_event;
     RTL_CONDITION_VARIABLE  group_finished_event;
@@ -161,6 +198,11 @@ struct threadpool_object
     LONG                    num_pending_callbacks;
     LONG                    num_running_callbacks;
     LONG                    num_associated_callbacks;
+    /* local queue state, .queue is locked via .queue->lock */
+    struct threadpool_queue *queue;
+    LONG                    queued;
+    LONG                    num_finish_waiters;
+    LONG                    finished_seq;
     /* arguments for callback */
     union
     {
@@ -1621,6 +1663,46 @@ static void tp_ioqueue_unlock( struct threadpool_object *io )
     RtlLeaveCriticalSection( &ioqueue.cs );
 }
 
+/***********************************************************************
+ *           get_numa_nodes    (internal)
+ *
+ * Maps the processors to NUMA node indices, returns the number of nodes.
+ */
+static unsigned int get_numa_nodes( BYTE *cpu_nodes, unsigned int num_cpus )
+{
+    LOGICAL_PROCESSOR_RELATIONSHIP relation = RelationNumaNode;
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *info, *ptr;
+    unsigned int i, num_nodes = 0;
+    ULONG size = 0;
+
+    memset( cpu_nodes, 0, num_cpus );
+
+    if (NtQuerySystemInformationEx( SystemLogicalProcessorInformationEx, &relation, sizeof(relation),
+                                    NULL, 0, &size ) != STATUS_INFO_LENGTH_MISMATCH)
+        return 1;
+    if (!(info = RtlAllocateHeap( GetProcessHeap(), 0, size )))
+        return 1;
+
+    if (!NtQuerySystemInformationEx( SystemLogicalProcessorInformationEx, &relation, sizeof(relation),
+                                     info, size, &size ))
+    {
+        for (ptr = info; (char *)ptr < (char *)info + size && num_nodes < THREADPOOL_MAX_NODES;
+             ptr = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)((char *)ptr + ptr->Size))
+        {
+            if (ptr->Relationship != RelationNumaNode) continue;
+            for (i = 0; i < num_cpus; ++i)
+            {
+                if (ptr->u.NumaNode.GroupMask.Mask & ((KAFFINITY)1 << i))
+                    cpu_nodes[i] = num_nodes;
+            }
+            num_nodes++;
+        }
+    }
+
+    RtlFreeHeap( GetProcessHeap(), 0, info );
+    return max( num_nodes, 1 );
+}
+
 /***********************************************************************
  *           tp_threadpool_alloc    (internal)
  *
@@ -1629,10 +1711,12 @@ static void tp_ioqueue_unlock( struct threadpool_object *io )
 static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
 {
     IMAGE_NT_HEADERS *nt = RtlImageNtHeader( NtCurrentTeb()->Peb->ImageBaseAddress );
+    BYTE cpu_nodes[sizeof(KAFFINITY) * 8];
+    unsigned int num_nodes = get_numa_nodes( cpu_nodes, ARRAY_SIZE(cpu_nodes) );
     struct threadpool *pool;
-    unsigned int i;
+    unsigned int i, j;
 
-    pool = RtlAllocateHeap( GetProcessHeap(), 0, sizeof(*pool) );
+    pool = RtlAllocateHeap( GetProcessHeap(), 0, FIELD_OFFSET( struct threadpool, node_queues[num_nodes] ) );
     if (!pool)
         return STATUS_NO_MEMORY;
 
@@ -1644,13 +1728,31 @@ static NTSTATUS tp_threadpool_alloc( struct threadpool **out )
     pool->cs.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": threadpool.cs");
 
     for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
+    {
         list_init( &pool->pools[i] );
+        pool->num_queued[i] = 0;
+        pool->num_local[i] = 0;
+    }
     RtlInitializeConditionVariable( &pool->update_event );
 
     pool->max_workers             = 500;
     pool->min_workers             = 0;
     pool->num_workers             = 0;
     pool->num_busy_workers        = 0;
+    pool->num_wakeups             = 0;
+    pool->num_idle_workers        = 0;
+    pool->num_local_busy          = 0;
+    RtlInitializeSRWLock( &pool->workers_lock );
+    list_init( &pool->workers );
+    memcpy( pool->cpu_nodes, cpu_nodes, sizeof(cpu_nodes) );
+    pool->num_nodes               = num_nodes;
+    for (i = 0; i < num_nodes; ++i)
+    {
+        RtlInitializeSRWLock( &pool->node_queues[i].lock );
+        for (j = 0; j < ARRAY_SIZE(pool->node_queues[i].items); ++j)
+            list_init( &pool->node_queues[i].items[j] );
+        pool->node_queues[i].num_items = 0;
+    }
     pool->stack_info.StackReserve = nt->OptionalHeader.SizeOfStackReserve;
     pool->stack_info.StackCommit  = nt->OptionalHeader.SizeOfStackCommit;
 
@@ -1692,7 +1794,10 @@ static BOOL tp_threadpool_release( struct threadpool *pool )
     assert( pool->shutdown );
     assert( !pool->objcount );
     for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
+    {
         assert( list_empty( &pool->pools[i] ) );
+        assert( !pool->num_local[i] );
+    }
 
     pool->cs.DebugInfo->Spare[0] = 0;
     RtlDeleteCriticalSection( &pool->cs );
@@ -1763,7 +1868,7 @@ static NTSTATUS tp_threadpool_lock( struct threadpool **out, TP_CALLBACK_ENVIRON
     if (status == STATUS_SUCCESS)
     {
         InterlockedIncrement( &pool->refcount );
-        pool->objcount++;
+        InterlockedIncrement( &pool->objcount );
     }
 
     RtlLeaveCriticalSection( &pool->cs );
@@ -1782,9 +1887,9 @@ static NTSTATUS tp_threadpool_lock( struct threadpool **out, TP_CALLBACK_ENVIRON
  */
 static void tp_threadpool_unlock( struct threadpool *pool )
 {
-    RtlEnterCriticalSection( &pool->cs );
-    pool->objcount--;
-    RtlLeaveCriticalSection( &pool->cs );
+    /* The increment happens with pool->cs held, so a worker thread that sees
+     * objcount == 0 with the lock held can still safely terminate. */
+    InterlockedDecrement( &pool->objcount );
     tp_threadpool_release( pool );
 }
 
@@ -1879,6 +1984,10 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
     object->num_pending_callbacks   = 0;
     object->num_running_callbacks   = 0;
     object->num_associated_callbacks = 0;
+    object->queue                   = NULL;
+    object->queued                  = 0;
+    object->num_finish_waiters      = 0;
+    object->finished_seq            = 0;
 
     if (environment)
     {
@@ -1935,9 +2044,254 @@ static void tp_object_initialize( struct threadpool_object *object, struct threa
 static void tp_object_prio_queue( struct threadpool_object *object )
 {
     ++object->pool->num_busy_workers;
+    InterlockedIncrement( &object->pool->num_queued[object->priority] );
     list_add_tail( &object->pool->pools[object->priority], &object->pool_entry );
 }
 
+static void tp_object_prio_dequeue( struct threadpool_object *object )
+{
+    InterlockedDecrement( &object->pool->num_queued[object->priority] );
+    list_remove( &object->pool_entry );
+}
+
+/* Simple callbacks and work objects, with or without a cleanup group, go
+ * through the local queues of the workers and the NUMA nodes. The other
+ * object types are still queued in pool->pools under pool->cs. */
+static BOOL tp_object_is_local( const struct threadpool_object *object )
+{
+    return object->type == TP_OBJECT_TYPE_SIMPLE || object->type == TP_OBJECT_TYPE_WORK;
+}
+
+static BOOL tp_threadpool_has_local( const struct threadpool *pool )
+{
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(pool->num_local); ++i)
+    {
+        if (pool->num_local[i])
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/* Like native, keep the per-thread thread pool data in the TEB. */
+static inline struct threadpool_worker **get_current_worker_ptr(void)
+{
+    return (struct threadpool_worker **)&NtCurrentTeb()->Reserved5[2];
+}
+
+static unsigned int tp_threadpool_current_node( const struct threadpool *pool )
+{
+    ULONG cpu = NtGetCurrentProcessorNumber();
+
+    if (cpu >= ARRAY_SIZE(pool->cpu_nodes)) return 0;
+    return pool->cpu_nodes[cpu];
+}
+
+/***********************************************************************
+ *           tp_threadpool_wake_local    (internal)
+ *
+ * Makes sure that a worker picks up a newly queued local object. Only takes
+ * pool->cs when an idle worker has to be woken up or a new worker thread has
+ * to be started.
+ */
+static void tp_threadpool_wake_local( struct threadpool *pool )
+{
+    /* The interlocked increments of the queue counters pair with the one of
+     * num_idle_workers in threadpool_worker_proc, either the worker sees the
+     * new item or we see the idle worker. */
+    if (!pool->num_idle_workers && (pool->num_workers >= pool->max_workers ||
+        pool->num_busy_workers + pool->num_local_busy < pool->num_workers))
+        return;
+
+    RtlEnterCriticalSection( &pool->cs );
+
+    if (pool->num_idle_workers > pool->num_wakeups)
+    {
+        pool->num_wakeups++;
+        RtlWakeConditionVariable( &pool->update_event );
+    }
+    else if (pool->num_busy_workers + pool->num_local_busy >= pool->num_workers &&
+             pool->num_workers < pool->max_workers)
+    {
+        tp_new_worker_thread( pool );
+    }
+
+    RtlLeaveCriticalSection( &pool->cs );
+}
+
+/***********************************************************************
+ *           tp_object_push_local    (internal)
+ *
+ * Adds a local object to a queue. The caller has set object->queued and
+ * passes its queue reference to the object.
+ */
+static void tp_object_push_local( struct threadpool_object *object, struct threadpool_queue *queue )
+{
+    struct threadpool *pool = object->pool;
+
+    InterlockedIncrement( &pool->num_local_busy );
+
+    RtlAcquireSRWLockExclusive( &queue->lock );
+    list_add_tail( &queue->items[object->priority], &object->pool_entry );
+    object->queue = queue;
+    queue->num_items++;
+    InterlockedIncrement( &pool->num_local[object->priority] );
+    RtlReleaseSRWLockExclusive( &queue->lock );
+}
+
+/* queue->lock has to be held. */
+static void tp_object_remove_local( struct threadpool_object *object )
+{
+    list_remove( &object->pool_entry );
+    object->queue->num_items--;
+    object->queue = NULL;
+    InterlockedDecrement( &object->pool->num_local[object->priority] );
+}
+
+static struct threadpool_object *tp_queue_pop( struct threadpool_queue *queue, unsigned int priority )
+{
+    struct threadpool_object *object = NULL;
+    struct list *ptr;
+
+    if (!queue->num_items)
+        return NULL;
+
+    RtlAcquireSRWLockExclusive( &queue->lock );
+    if ((ptr = list_head( &queue->items[priority] )))
+    {
+        object = LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
+        tp_object_remove_local( object );
+    }
+    RtlReleaseSRWLockExclusive( &queue->lock );
+
+    return object;
+}
+
+/* Takes over one pending callback, fails if they were cancelled meanwhile. */
+static BOOL tp_object_claim_pending( struct threadpool_object *object )
+{
+    LONG pending = object->num_pending_callbacks;
+
+    while (pending > 0)
+    {
+        LONG prev = InterlockedCompareExchange( &object->num_pending_callbacks, pending - 1, pending );
+        if (prev == pending) return TRUE;
+        pending = prev;
+    }
+
+    return FALSE;
+}
+
+/***********************************************************************
+ *           tp_object_requeue_local    (internal)
+ *
+ * Called by the owner of object->queued after removing the object from its
+ * queue. Queues the object again if callbacks are still pending, otherwise
+ * clears object->queued. Returns FALSE if the queue reference has to be
+ * released.
+ */
+static BOOL tp_object_requeue_local( struct threadpool_object *object, struct threadpool_queue *queue )
+{
+    if (!object->num_pending_callbacks)
+    {
+        /* Submitting increments num_pending_callbacks before checking
+         * object->queued, so check again afterwards. */
+        InterlockedExchange( &object->queued, 0 );
+        if (!object->num_pending_callbacks || InterlockedCompareExchange( &object->queued, 1, 0 ))
+            return FALSE;
+    }
+
+    tp_object_push_local( object, queue );
+    tp_threadpool_wake_local( object->pool );
+    return TRUE;
+}
+
+/* Wakes up the threads waiting in tp_object_wait for a local object. */
+static void tp_object_wake_local( struct threadpool_object *object )
+{
+    if (!object->num_finish_waiters)
+        return;
+
+    InterlockedIncrement( &object->finished_seq );
+    RtlWakeAddressAll( &object->finished_seq );
+}
+
+/***********************************************************************
+ *           tp_object_submit_local    (internal)
+ *
+ * Queues a simple callback or work object on the local queue of the current
+ * worker thread, or on the queue of the current NUMA node when called from
+ * outside of the pool. The pending callbacks of an object share a single
+ * queue entry.
+ */
+static void tp_object_submit_local( struct threadpool_object *object )
+{
+    struct threadpool *pool = object->pool;
+    struct threadpool_worker *worker = *get_current_worker_ptr();
+    struct threadpool_queue *queue;
+
+    InterlockedIncrement( &object->refcount );
+    InterlockedIncrement( &object->num_pending_callbacks );
+    if (InterlockedCompareExchange( &object->queued, 1, 0 ))
+        return;
+
+    /* The queue entry holds its own reference. */
+    InterlockedIncrement( &object->refcount );
+    if (worker && worker->pool == pool)
+        queue = &worker->queue;
+    else
+        queue = &pool->node_queues[tp_threadpool_current_node( pool )];
+
+    tp_object_push_local( object, queue );
+    tp_threadpool_wake_local( pool );
+}
+
+/***********************************************************************
+ *           tp_object_cancel_local    (internal)
+ *
+ * Cancels the pending callbacks of a simple callback or work object
+ * without taking pool->cs.
+ */
+static void tp_object_cancel_local( struct threadpool_object *object )
+{
+    struct threadpool *pool = object->pool;
+    struct threadpool_queue *queue;
+    LONG pending_callbacks;
+    BOOL removed = FALSE;
+
+    pending_callbacks = InterlockedExchange( &object->num_pending_callbacks, 0 );
+
+    /* Workers unregister under the exclusive lock, so their queues stay valid. */
+    RtlAcquireSRWLockShared( &pool->workers_lock );
+    if ((queue = object->queue))
+    {
+        RtlAcquireSRWLockExclusive( &queue->lock );
+        if (object->queue == queue)
+        {
+            tp_object_remove_local( object );
+            removed = TRUE;
+        }
+        RtlReleaseSRWLockExclusive( &queue->lock );
+    }
+    RtlReleaseSRWLockShared( &pool->workers_lock );
+
+    /* Otherwise the worker which dequeued the object finds no pending
+     * callbacks and drops the queue entry itself. */
+    if (removed)
+    {
+        InterlockedDecrement( &pool->num_local_busy );
+        if (!tp_object_requeue_local( object, &pool->node_queues[tp_threadpool_current_node( pool )] ))
+            tp_object_release( object );
+    }
+
+    tp_object_wake_local( object );
+
+    while (pending_callbacks--)
+        tp_object_release( object );
+}
+
 /***********************************************************************
  *           tp_object_submit    (internal)
  *
@@ -1952,10 +2306,16 @@ static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
     assert( !object->shutdown );
     assert( !pool->shutdown );
 
+    if (tp_object_is_local( object ))
+    {
+        tp_object_submit_local( object );
+        return;
+    }
+
     RtlEnterCriticalSection( &pool->cs );
 
     /* Start new worker threads if required. */
-    if (pool->num_busy_workers >= pool->num_workers &&
+    if (pool->num_busy_workers + pool->num_local_busy >= pool->num_workers &&
         pool->num_workers < pool->max_workers)
         status = tp_new_worker_thread( pool );
 
@@ -1968,10 +2328,12 @@ static void tp_object_submit( struct threadpool_object *object, BOOL signaled )
     if (object->type == TP_OBJECT_TYPE_WAIT && signaled)
         object->u.wait.signaled++;
 
-    /* No new thread started - wake up one existing thread. */
-    if (status != STATUS_SUCCESS)
+    /* No new thread started - wake up one existing thread, unless all idle
+     * threads have already been woken up and will pick up the item anyway. */
+    if (status != STATUS_SUCCESS && pool->num_idle_workers > pool->num_wakeups)
     {
         assert( pool->num_workers > 0 );
+        pool->num_wakeups++;
         RtlWakeConditionVariable( &pool->update_event );
     }
 
@@ -1988,12 +2350,18 @@ static void tp_object_cancel( struct threadpool_object *object )
     struct threadpool *pool = object->pool;
     LONG pending_callbacks = 0;
 
+    if (tp_object_is_local( object ))
+    {
+        tp_object_cancel_local( object );
+        return;
+    }
+
     RtlEnterCriticalSection( &pool->cs );
     if (object->num_pending_callbacks)
     {
         pending_callbacks = object->num_pending_callbacks;
         object->num_pending_callbacks = 0;
-        list_remove( &object->pool_entry );
+        tp_object_prio_dequeue( object );
 
         if (object->type == TP_OBJECT_TYPE_WAIT)
             object->u.wait.signaled = 0;
@@ -2028,6 +2396,21 @@ static BOOL object_is_finished( struct threadpool_object *object, BOOL group )
 static void tp_object_wait( struct threadpool_object *object, BOOL group_wait )
 {
     struct threadpool *pool = object->pool;
+    LONG seq;
+
+    if (tp_object_is_local( object ))
+    {
+        InterlockedIncrement( &object->num_finish_waiters );
+        for (;;)
+        {
+            seq = object->finished_seq;
+            MemoryBarrier();
+            if (object_is_finished( object, group_wait )) break;
+            RtlWaitOnAddress( &object->finished_seq, &seq, sizeof(seq), NULL );
+        }
+        InterlockedDecrement( &object->num_finish_waiters );
+        return;
+    }
 
     RtlEnterCriticalSection( &pool->cs );
     while (!object_is_finished( object, group_wait ))
@@ -2102,12 +2485,13 @@ static BOOL tp_object_release( struct threadpool_object *object )
 
 static struct list *threadpool_get_next_item( const struct threadpool *pool )
 {
-    struct list *ptr;
+    struct list *ptr = NULL;
     unsigned int i;
 
+    /* Local objects with a higher priority go first. */
     for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
     {
-        if ((ptr = list_head( &pool->pools[i] )))
+        if ((ptr = list_head( &pool->pools[i] )) || pool->num_local[i])
             break;
     }
 
@@ -2115,40 +2499,72 @@ static struct list *threadpool_get_next_item( const struct threadpool *pool )
 }
 
 /***********************************************************************
- *           tp_object_execute    (internal)
+ *           threadpool_get_next_local    (internal)
  *
- * Executes a threadpool object callback, object->pool->cs has to be
- * held.
+ * Dequeues the next local object. The queue of the worker goes first, then
+ * the queue of its NUMA node, the queues of the other workers on the same
+ * node, and finally the other nodes and their workers. Returns NULL when an
+ * object with the same or a higher priority is waiting in pool->pools.
  */
-static void tp_object_execute( struct threadpool_object *object, BOOL wait_thread )
+static struct threadpool_object *threadpool_get_next_local( struct threadpool *pool,
+                                                            struct threadpool_worker *worker )
 {
-    TP_CALLBACK_INSTANCE *callback_instance;
-    struct threadpool_instance instance;
-    struct io_completion completion;
-    struct threadpool *pool = object->pool;
-    TP_WAIT_RESULT wait_result = 0;
-    NTSTATUS status;
-
-    object->num_pending_callbacks--;
+    struct threadpool_object *object;
+    struct threadpool_worker *other;
+    unsigned int i, j, node;
 
-    /* For wait objects check if they were signaled or have timed out. */
-    if (object->type == TP_OBJECT_TYPE_WAIT)
-    {
-        wait_result = object->u.wait.signaled ? WAIT_OBJECT_0 : WAIT_TIMEOUT;
-        if (wait_result == WAIT_OBJECT_0) object->u.wait.signaled--;
-    }
-    else if (object->type == TP_OBJECT_TYPE_IO)
+    for (i = 0; i < ARRAY_SIZE(pool->pools); ++i)
     {
-        assert( object->u.io.completion_count );
-        completion = object->u.io.completions[--object->u.io.completion_count];
-        object->u.io.pending_count--;
+        if (pool->num_queued[i])
+            return NULL;
+        if (!pool->num_local[i])
+            continue;
+
+        if ((object = tp_queue_pop( &worker->queue, i )))
+            return object;
+
+        worker->node = node = tp_threadpool_current_node( pool );
+        if ((object = tp_queue_pop( &pool->node_queues[node], i )))
+            return object;
+
+        RtlAcquireSRWLockShared( &pool->workers_lock );
+        LIST_FOR_EACH_ENTRY( other, &pool->workers, struct threadpool_worker, entry )
+        {
+            if (other == worker || other->node != node) continue;
+            if ((object = tp_queue_pop( &other->queue, i ))) break;
+        }
+        for (j = 1; !object && j < pool->num_nodes; ++j)
+            object = tp_queue_pop( &pool->node_queues[(node + j) % pool->num_nodes], i );
+        if (!object)
+        {
+            LIST_FOR_EACH_ENTRY( other, &pool->workers, struct threadpool_worker, entry )
+            {
+                if (other == worker || other->node == node) continue;
+                if ((object = tp_queue_pop( &other->queue, i ))) break;
+            }
+        }
+        RtlReleaseSRWLockShared( &pool->workers_lock );
+
+        if (object)
+            return object;
     }
 
-    /* Leave critical section and do the actual callback. */
-    object->num_associated_callbacks++;
-    object->num_running_callbacks++;
-    RtlLeaveCriticalSection( &pool->cs );
-    if (wait_thread) RtlLeaveCriticalSection( &waitqueue.cs );
+    return NULL;
+}
+
+/***********************************************************************
+ *           tp_object_run_callback    (internal)
+ *
+ * Runs the callback of a threadpool object and the requested cleanup tasks,
+ * without any locks held. Returns whether the callback is still associated
+ * with the object.
+ */
+static BOOL tp_object_run_callback( struct threadpool_object *object, TP_WAIT_RESULT wait_result,
+                                    struct io_completion *completion )
+{
+    TP_CALLBACK_INSTANCE *callback_instance;
+    struct threadpool_instance instance;
+    NTSTATUS status;
 
     /* Initialize threadpool instance struct. */
     callback_instance = (TP_CALLBACK_INSTANCE *)&instance;
@@ -2205,9 +2621,9 @@ static void tp_object_execute( struct threadpool_object *object, BOOL wait_threa
         {
             TRACE( "executing I/O callback %p(%p, %p, %#lx, %p, %p)\n",
                     object->u.io.callback, callback_instance, object->userdata,
-                    completion.cvalue, &completion.iosb, (TP_IO *)object );
+                    completion->cvalue, &completion->iosb, (TP_IO *)object );
             object->u.io.callback( callback_instance, object->userdata,
-                    (void *)completion.cvalue, &completion.iosb, (TP_IO *)object );
+                    (void *)completion->cvalue, &completion->iosb, (TP_IO *)object );
             TRACE( "callback %p returned\n", object->u.io.callback );
             break;
         }
@@ -2252,6 +2668,45 @@ static void tp_object_execute( struct threadpool_object *object, BOOL wait_threa
     }
 
 skip_cleanup:
+    return instance.associated;
+}
+
+/***********************************************************************
+ *           tp_object_execute    (internal)
+ *
+ * Executes a threadpool object callback, object->pool->cs has to be
+ * held.
+ */
+static void tp_object_execute( struct threadpool_object *object, BOOL wait_thread )
+{
+    struct io_completion completion;
+    struct threadpool *pool = object->pool;
+    TP_WAIT_RESULT wait_result = 0;
+    BOOL associated;
+
+    object->num_pending_callbacks--;
+
+    /* For wait objects check if they were signaled or have timed out. */
+    if (object->type == TP_OBJECT_TYPE_WAIT)
+    {
+        wait_result = object->u.wait.signaled ? WAIT_OBJECT_0 : WAIT_TIMEOUT;
+        if (wait_result == WAIT_OBJECT_0) object->u.wait.signaled--;
+    }
+    else if (object->type == TP_OBJECT_TYPE_IO)
+    {
+        assert( object->u.io.completion_count );
+        completion = object->u.io.completions[--object->u.io.completion_count];
+        object->u.io.pending_count--;
+    }
+
+    /* Leave critical section and do the actual callback. */
+    object->num_associated_callbacks++;
+    object->num_running_callbacks++;
+    RtlLeaveCriticalSection( &pool->cs );
+    if (wait_thread) RtlLeaveCriticalSection( &waitqueue.cs );
+
+    associated = tp_object_run_callback( object, wait_result, &completion );
+
     if (wait_thread) RtlEnterCriticalSection( &waitqueue.cs );
     RtlEnterCriticalSection( &pool->cs );
 
@@ -2266,7 +2721,7 @@ skip_cleanup:
     if (object_is_finished( object, TRUE ))
         RtlWakeAllConditionVariable( &object->group_finished_event );
 
-    if (instance.associated)
+    if (associated)
     {
         object->num_associated_callbacks--;
         if (object_is_finished( object, FALSE ))
@@ -2274,28 +2729,98 @@ skip_cleanup:
     }
 }
 
+/***********************************************************************
+ *           tp_object_execute_local    (internal)
+ *
+ * Executes a local object dequeued by threadpool_get_next_local without
+ * holding object->pool->cs. Takes over the reference of the queue entry.
+ */
+static void tp_object_execute_local( struct threadpool_object *object, struct threadpool_worker *worker )
+{
+    struct threadpool *pool = object->pool;
+    BOOL associated, claimed, requeued;
+
+    /* Count the callback as running before claiming it, so tp_object_wait
+     * never sees it neither pending nor running. */
+    InterlockedIncrement( &object->num_associated_callbacks );
+    InterlockedIncrement( &object->num_running_callbacks );
+    claimed = tp_object_claim_pending( object );
+
+    /* Keep further pending callbacks queued, so that other workers can run
+     * them concurrently. */
+    requeued = tp_object_requeue_local( object, &worker->queue );
+
+    if (claimed)
+    {
+        associated = tp_object_run_callback( object, 0, NULL );
+
+        /* Simple callbacks are automatically shutdown after execution. */
+        if (object->type == TP_OBJECT_TYPE_SIMPLE)
+            object->shutdown = TRUE;
+    }
+    else associated = TRUE;
+
+    InterlockedDecrement( &object->num_running_callbacks );
+    if (associated)
+        InterlockedDecrement( &object->num_associated_callbacks );
+    tp_object_wake_local( object );
+
+    InterlockedDecrement( &pool->num_local_busy );
+
+    if (claimed)
+        tp_object_release( object );
+    if (!requeued)
+        tp_object_release( object );
+}
+
 /***********************************************************************
  *           threadpool_worker_proc    (internal)
  */
 static void CALLBACK threadpool_worker_proc( void *param )
 {
     struct threadpool *pool = param;
+    struct threadpool_worker worker;
+    struct threadpool_object *object;
     LARGE_INTEGER timeout;
     struct list *ptr;
+    NTSTATUS status;
+    unsigned int i;
 
     TRACE( "starting worker thread for pool %p\n", pool );
 
+    worker.pool = pool;
+    RtlInitializeSRWLock( &worker.queue.lock );
+    for (i = 0; i < ARRAY_SIZE(worker.queue.items); ++i)
+        list_init( &worker.queue.items[i] );
+    worker.queue.num_items = 0;
+    worker.node = tp_threadpool_current_node( pool );
+
+    RtlAcquireSRWLockExclusive( &pool->workers_lock );
+    list_add_tail( &pool->workers, &worker.entry );
+    RtlReleaseSRWLockExclusive( &pool->workers_lock );
+    *get_current_worker_ptr() = &worker;
+
     RtlEnterCriticalSection( &pool->cs );
     for (;;)
     {
+        /* Run simple callbacks and work objects without holding the lock,
+         * preferably the ones from the local queue of this thread. */
+        if (tp_threadpool_has_local( pool ))
+        {
+            RtlLeaveCriticalSection( &pool->cs );
+            while ((object = threadpool_get_next_local( pool, &worker )))
+                tp_object_execute_local( object, &worker );
+            RtlEnterCriticalSection( &pool->cs );
+        }
+
         while ((ptr = threadpool_get_next_item( pool )))
         {
-            struct threadpool_object *object = LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
+            object = LIST_ENTRY( ptr, struct threadpool_object, pool_entry );
             assert( object->num_pending_callbacks > 0 );
 
             /* If further pending callbacks are queued, move the work item to
              * the end of the pool list. Otherwise remove it from the pool. */
-            list_remove( &object->pool_entry );
+            tp_object_prio_dequeue( object );
             if (object->num_pending_callbacks > 1)
                 tp_object_prio_queue( object );
 
@@ -2307,18 +2832,35 @@ static void CALLBACK threadpool_worker_proc( void *param )
             tp_object_release( object );
         }
 
+        if (tp_threadpool_has_local( pool ))
+            continue;
+
         /* Shutdown worker thread if requested. */
         if (pool->shutdown)
             break;
 
+        /* Announce that this thread is going to sleep. Submitting a local
+         * object doesn't take the lock, so check again afterwards. */
+        InterlockedIncrement( &pool->num_idle_workers );
+        if (tp_threadpool_has_local( pool ))
+        {
+            InterlockedDecrement( &pool->num_idle_workers );
+            continue;
+        }
+
         /* Wait for new tasks or until the timeout expires. A thread only terminates
          * when no new tasks are available, and the number of threads can be
          * decreased without violating the min_workers limit. An exception is when
          * min_workers == 0, then objcount is used to detect if the last thread
          * can be terminated. */
         timeout.QuadPart = (ULONGLONG)THREADPOOL_WORKER_TIMEOUT * -10000;
-        if (RtlSleepConditionVariableCS( &pool->update_event, &pool->cs, &timeout ) == STATUS_TIMEOUT &&
-            !threadpool_get_next_item( pool ) && (pool->num_workers > max( pool->min_workers, 1 ) ||
+        status = RtlSleepConditionVariableCS( &pool->update_event, &pool->cs, &timeout );
+        InterlockedDecrement( &pool->num_idle_workers );
+        if (pool->num_wakeups)
+            pool->num_wakeups--;
+
+        if (status == STATUS_TIMEOUT && !threadpool_get_next_item( pool ) &&
+            !tp_threadpool_has_local( pool ) && (pool->num_workers > max( pool->min_workers, 1 ) ||
             (!pool->min_workers && !pool->objcount)))
         {
             break;
@@ -2327,6 +2869,14 @@ static void CALLBACK threadpool_worker_proc( void *param )
     pool->num_workers--;
     RtlLeaveCriticalSection( &pool->cs );
 
+    /* Only this thread queues on its local queue, and it only stops when all
+     * local queues are empty. */
+    *get_current_worker_ptr() = NULL;
+    RtlAcquireSRWLockExclusive( &pool->workers_lock );
+    list_remove( &worker.entry );
+    RtlReleaseSRWLockExclusive( &pool->workers_lock );
+    assert( !worker.queue.num_items );
+
     TRACE( "terminating worker thread for pool %p\n", pool );
     tp_threadpool_release( pool );
     RtlExitUserThread( 0 );
@@ -2574,7 +3124,7 @@ NTSTATUS WINAPI TpCallbackMayRunLong( TP_CALLBACK_INSTANCE *instance )
     RtlEnterCriticalSection( &pool->cs );
 
     /* Start new worker threads if required. */
-    if (pool->num_busy_workers >= pool->num_workers)
+    if (pool->num_busy_workers + pool->num_local_busy >= pool->num_workers)
     {
         if (pool->num_workers < pool->max_workers)
         {
@@ -2666,6 +3216,14 @@ VOID WINAPI TpDisassociateCallback( TP_CALLBACK_INSTANCE *instance )
     if (!this->associated)
         return;
 
+    if (tp_object_is_local( object ))
+    {
+        InterlockedDecrement( &object->num_associated_callbacks );
+        tp_object_wake_local( object );
+        this->associated = FALSE;
+        return;
+    }
+
     pool = object->pool;
     RtlEnterCriticalSection( &pool->cs );
 
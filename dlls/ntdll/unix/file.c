@@ -132,6 +132,7 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(file);
 WINE_DECLARE_DEBUG_CHANNEL(winediag);
+WINE_DECLARE_DEBUG_CHANNEL(dircache);
 
 #define MAX_DOS_DRIVES 26
 
@@ -1834,6 +1835,45 @@ static NTSTATUS fill_name_info( const char *unix_name, FILE_NAME_INFORMATION *in
 static NTSTATUS server_get_file_info( HANDLE handle, IO_STATUS_BLOCK *io, void *buffer,
                                       ULONG length, FILE_INFORMATION_CLASS info_class )
 {
+    if (info_class == FileAccessInformation || info_class == FileModeInformation)
+    {
+        /* plain files can be answered from the client-side caches */
+        enum server_fd_type type;
+        unsigned int options, access;
+        int fd, needs_close;
+
+        if (!server_get_unix_fd( handle, 0, &fd, &needs_close, &type, &options ))
+        {
+            if (needs_close) close( fd );
+            if (type == FD_TYPE_FILE || type == FD_TYPE_DIR)
+            {
+                if (info_class == FileAccessInformation)
+                {
+                    FILE_ACCESS_INFORMATION *info = buffer;
+
+                    if (length < sizeof(*info)) return io->u.Status = STATUS_INFO_LENGTH_MISMATCH;
+                    if (!(io->u.Status = server_get_handle_info( handle, &access, NULL )))
+                    {
+                        info->AccessFlags = access;
+                        io->Information = sizeof(*info);
+                    }
+                }
+                else
+                {
+                    FILE_MODE_INFORMATION *info = buffer;
+
+                    if (length < sizeof(*info)) return io->u.Status = STATUS_INFO_LENGTH_MISMATCH;
+                    info->Mode = options & (FILE_WRITE_THROUGH | FILE_SEQUENTIAL_ONLY |
+                                            FILE_NO_INTERMEDIATE_BUFFERING |
+                                            FILE_SYNCHRONOUS_IO_ALERT | FILE_SYNCHRONOUS_IO_NONALERT);
+                    io->u.Status = STATUS_SUCCESS;
+                    io->Information = sizeof(*info);
+                }
+                return io->u.Status;
+            }
+        }
+    }
+
     SERVER_START_REQ( get_file_info )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -2188,6 +2228,255 @@ static NTSTATUS read_directory_data_getattrlist( struct dir_data *data, const ch
 #endif  /* HAVE_GETATTRLIST */
 
 
+/***********************************************************************
+ *           Directory lookup cache
+ *
+ * Case-insensitive lookups of a name that doesn't exist with the exact
+ * case require scanning the whole directory. To avoid doing that over and
+ * over, the long names of recently scanned directories are kept in a hash
+ * table indexed by their upper-cased name. The cache of a directory is
+ * discarded as soon as the modification time of the directory changes.
+ */
+
+struct dir_cache_name
+{
+    struct dir_cache_name *next;        /* next name in hash bucket */
+    unsigned int           hash;        /* hash of the upper-cased name */
+    unsigned int           len;         /* length of the name in chars */
+    const char            *unix_name;   /* real Unix name */
+    WCHAR                  name[1];     /* upper-cased name */
+};
+
+struct dir_cache
+{
+    struct list             entry;      /* entry in LRU list */
+    dev_t                   dev;        /* device of the directory */
+    ino_t                   ino;        /* inode of the directory */
+    time_t                  mtime;      /* modification time when the directory was read */
+    long                    mtime_nsec;
+    unsigned int            count;      /* number of names */
+    unsigned int            hash_size;  /* number of hash buckets */
+    struct dir_cache_name **hash;       /* hash table of names */
+};
+
+#define MAX_DIR_CACHE_ENTRIES 64
+
+static struct list dir_cache_list = LIST_INIT( dir_cache_list );
+static unsigned int dir_cache_count;
+static unsigned int dir_cache_hits, dir_cache_misses, dir_cache_reads;
+static pthread_mutex_t dir_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static inline long get_mtime_nsec( const struct stat *st )
+{
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+    return st->st_mtim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    return st->st_mtimespec.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+static unsigned int hash_dir_cache_name( const WCHAR *name, int len )
+{
+    unsigned int hash = 0;
+    int i;
+
+    for (i = 0; i < len; i++) hash = hash * 33 + towupper( name[i] );
+    return hash;
+}
+
+static void free_dir_cache_names( struct dir_cache *cache )
+{
+    struct dir_cache_name *name, *next;
+    unsigned int i;
+
+    for (i = 0; i < cache->hash_size; i++)
+    {
+        for (name = cache->hash[i]; name; name = next)
+        {
+            next = name->next;
+            free( name );
+        }
+    }
+    free( cache->hash );
+    cache->hash = NULL;
+    cache->hash_size = cache->count = 0;
+}
+
+static BOOL add_dir_cache_name( struct dir_cache *cache, const char *unix_name )
+{
+    WCHAR buffer[MAX_DIR_ENTRY_LEN + 1];
+    struct dir_cache_name *name;
+    unsigned int i, len, hash, unix_len = strlen( unix_name ) + 1;
+
+    len = ntdll_umbstowcs( unix_name, unix_len - 1, buffer, ARRAY_SIZE(buffer) );
+    if (len == ARRAY_SIZE(buffer)) return TRUE;  /* can't be looked up anyway */
+
+    if (cache->count >= cache->hash_size / 2)
+    {
+        unsigned int new_size = max( 64, cache->hash_size * 2 );
+        struct dir_cache_name **new_hash, *next;
+
+        if (!(new_hash = calloc( new_size, sizeof(*new_hash) ))) return FALSE;
+        for (i = 0; i < cache->hash_size; i++)
+        {
+            for (name = cache->hash[i]; name; name = next)
+            {
+                next = name->next;
+                name->next = new_hash[name->hash % new_size];
+                new_hash[name->hash % new_size] = name;
+            }
+        }
+        free( cache->hash );
+        cache->hash = new_hash;
+        cache->hash_size = new_size;
+    }
+
+    /* keep the first name in readdir order, like the directory scan does */
+    hash = hash_dir_cache_name( buffer, len );
+    for (name = cache->hash[hash % cache->hash_size]; name; name = name->next)
+    {
+        if (name->hash != hash || name->len != len) continue;
+        for (i = 0; i < len; i++) if (name->name[i] != towupper( buffer[i] )) break;
+        if (i == len) return TRUE;
+    }
+
+    if (!(name = malloc( offsetof( struct dir_cache_name, name[len] ) + unix_len ))) return FALSE;
+    for (i = 0; i < len; i++) name->name[i] = towupper( buffer[i] );
+    name->len = len;
+    name->hash = hash;
+    name->unix_name = (char *)&name->name[len];
+    memcpy( (char *)name->unix_name, unix_name, unix_len );
+    name->next = cache->hash[name->hash % cache->hash_size];
+    cache->hash[name->hash % cache->hash_size] = name;
+    cache->count++;
+    return TRUE;
+}
+
+static BOOL read_dir_cache( struct dir_cache *cache, const char *dir )
+{
+    struct dirent *de;
+    DIR *dirp;
+
+    if (!(dirp = opendir( dir ))) return FALSE;
+    while ((de = readdir( dirp )))
+    {
+        if (!add_dir_cache_name( cache, de->d_name ))
+        {
+            closedir( dirp );
+            free_dir_cache_names( cache );
+            return FALSE;
+        }
+    }
+    closedir( dirp );
+    dir_cache_reads++;
+    return TRUE;
+}
+
+/***********************************************************************
+ *           lookup_dir_cache
+ *
+ * Look for a name in a directory using the directory cache.
+ * Returns 1 and copies the real name to unix_name if found, 0 if not found,
+ * and -1 if the cache can't be used for that directory.
+ */
+static int lookup_dir_cache( const char *dir, const WCHAR *name, int length, char *unix_name )
+{
+    struct dir_cache *cache;
+    struct dir_cache_name *entry;
+    struct stat st;
+    unsigned int hash;
+    int i, ret = -1;
+
+    if (stat( dir, &st ) == -1) return -1;
+    /* a directory modified in the last second could change again without its mtime changing */
+    if (st.st_mtime >= time( NULL ) - 1) return -1;
+
+    mutex_lock( &dir_cache_mutex );
+
+    LIST_FOR_EACH_ENTRY( cache, &dir_cache_list, struct dir_cache, entry )
+        if (cache->dev == st.st_dev && cache->ino == st.st_ino) break;
+
+    if (&cache->entry == &dir_cache_list)
+    {
+        if (dir_cache_count >= MAX_DIR_CACHE_ENTRIES)
+        {
+            cache = LIST_ENTRY( list_tail( &dir_cache_list ), struct dir_cache, entry );
+            free_dir_cache_names( cache );
+        }
+        else if ((cache = calloc( 1, sizeof(*cache) ))) dir_cache_count++;
+        else goto done;
+        cache->dev = st.st_dev;
+        cache->ino = st.st_ino;
+        cache->mtime = 0;
+    }
+    else if (cache->mtime != st.st_mtime || cache->mtime_nsec != get_mtime_nsec( &st ))
+    {
+        free_dir_cache_names( cache );
+        cache->mtime = 0;
+    }
+    list_remove( &cache->entry );
+    list_add_head( &dir_cache_list, &cache->entry );
+
+    if (!cache->mtime)
+    {
+        if (!read_dir_cache( cache, dir )) goto done;
+        cache->mtime = st.st_mtime;
+        cache->mtime_nsec = get_mtime_nsec( &st );
+    }
+
+    ret = 0;
+    hash = hash_dir_cache_name( name, length );
+    for (entry = cache->hash ? cache->hash[hash % cache->hash_size] : NULL; entry; entry = entry->next)
+    {
+        if (entry->hash != hash || entry->len != length) continue;
+        for (i = 0; i < length; i++) if (entry->name[i] != towupper( name[i] )) break;
+        if (i < length) continue;
+        strcpy( unix_name, entry->unix_name );
+        ret = 1;
+        break;
+    }
+    if (ret) dir_cache_hits++;
+    else dir_cache_misses++;
+
+    if (!((dir_cache_hits + dir_cache_misses) % 1024))
+        TRACE_(dircache)( "%u hits %u misses %u directory reads\n",
+                          dir_cache_hits, dir_cache_misses, dir_cache_reads );
+
+done:
+    mutex_unlock( &dir_cache_mutex );
+    TRACE_(dircache)( "%s %s -> %d %s\n", debugstr_a(dir), debugstr_wn(name, length),
+                      ret, ret > 0 ? debugstr_a(unix_name) : "" );
+    return ret;
+}
+
+
+/***********************************************************************
+ *           read_directory_data_cache
+ *
+ * Look for the file identified by mask in the directory lookup cache.
+ */
+static NTSTATUS read_directory_data_cache( struct dir_data *data, const UNICODE_STRING *mask )
+{
+    char unix_name[MAX_DIR_ENTRY_LEN * 3 + 1];
+    int len = mask->Length / sizeof(WCHAR);
+
+    switch (lookup_dir_cache( ".", mask->Buffer, len, unix_name ))
+    {
+    case 1:
+        if (!append_entry( data, unix_name, NULL, NULL )) return STATUS_NO_MEMORY;
+        return STATUS_SUCCESS;
+    case 0:
+        /* the mask could still match a generated short name */
+        if (is_legal_8dot3_name( mask->Buffer, len )) return STATUS_NO_SUCH_FILE;
+        return STATUS_SUCCESS;
+    default:
+        return STATUS_NO_SUCH_FILE;
+    }
+}
+
+
 /***********************************************************************
  *           read_directory_stat
  *
@@ -2265,6 +2554,7 @@ static NTSTATUS read_directory_data( struct dir_data *data, int fd, const UNICOD
 #endif
             if (!(status = read_directory_data_stat( data, unix_name ))) return status;
         }
+        if (!(status = read_directory_data_cache( data, mask ))) return status;
     }
 
     return read_directory_data_readdir( data, mask );
@@ -2517,6 +2807,15 @@ static NTSTATUS find_file_in_dir( char *unix_name, int pos, const WCHAR *name, i
 
     if (!is_name_8_dot_3 && !get_dir_case_sensitivity( unix_name )) goto not_found;
 
+    /* check the directory cache, it only knows about long names */
+
+    if ((ret = lookup_dir_cache( unix_name, name, length, unix_name + pos )) > 0)
+    {
+        unix_name[pos - 1] = '/';
+        goto success;
+    }
+    if (!ret && !is_name_8_dot_3) goto not_found;
+
     /* now look for it through the directory */
 
 #ifdef VFAT_IOCTL_READDIR_BOTH
@@ -4679,6 +4978,8 @@ static async_data_t server_async( HANDLE handle, struct async_fileio *user, HAND
                                   PIO_APC_ROUTINE apc, void *apc_context, IO_STATUS_BLOCK *io )
 {
     async_data_t async;
+
+    if (event) fast_sync_export( event );
     async.handle      = wine_server_obj_handle( handle );
     async.user        = wine_server_client_ptr( user );
     async.iosb        = wine_server_client_ptr( io );
@@ -6730,9 +7031,11 @@ NTSTATUS WINAPI NtQueryObject( HANDLE handle, OBJECT_INFORMATION_CLASS info_clas
     case ObjectBasicInformation:
     {
         OBJECT_BASIC_INFORMATION *p = ptr;
+        unsigned int generation;
 
         if (len < sizeof(*p)) return STATUS_INVALID_BUFFER_SIZE;
 
+        generation = get_handle_generation( handle );
         SERVER_START_REQ( get_object_info )
         {
             req->handle = wine_server_obj_handle( handle );
@@ -6744,6 +7047,7 @@ NTSTATUS WINAPI NtQueryObject( HANDLE handle, OBJECT_INFORMATION_CLASS info_clas
                 p->PointerCount = reply->ref_count;
                 p->HandleCount = reply->handle_count;
                 if (used_len) *used_len = sizeof(*p);
+                add_handle_info_to_cache( handle, generation, reply->access, reply->flags );
             }
         }
         SERVER_END_REQ;
@@ -6883,23 +7187,16 @@ NTSTATUS WINAPI NtQueryObject( HANDLE handle, OBJECT_INFORMATION_CLASS info_clas
     case ObjectDataInformation:
     {
         OBJECT_DATA_INFORMATION* p = ptr;
+        unsigned int flags;
 
         if (len < sizeof(*p)) return STATUS_INVALID_BUFFER_SIZE;
 
-        SERVER_START_REQ( set_handle_info )
+        if (!(status = server_get_handle_info( handle, NULL, &flags )))
         {
-            req->handle = wine_server_obj_handle( handle );
-            req->flags  = 0;
-            req->mask   = 0;
-            status = wine_server_call( req );
-            if (status == STATUS_SUCCESS)
-            {
-                p->InheritHandle = (reply->old_flags & HANDLE_FLAG_INHERIT) != 0;
-                p->ProtectFromClose = (reply->old_flags & HANDLE_FLAG_PROTECT_FROM_CLOSE) != 0;
-                if (used_len) *used_len = sizeof(*p);
-            }
+            p->InheritHandle = (flags & HANDLE_FLAG_INHERIT) != 0;
+            p->ProtectFromClose = (flags & HANDLE_FLAG_PROTECT_FROM_CLOSE) != 0;
+            if (used_len) *used_len = sizeof(*p);
         }
-        SERVER_END_REQ;
         break;
     }
 
@@ -6930,6 +7227,8 @@ NTSTATUS WINAPI NtSetInformationObject( HANDLE handle, OBJECT_INFORMATION_CLASS
 
         if (len < sizeof(*p)) return STATUS_INVALID_BUFFER_SIZE;
 
+        if (p->InheritHandle || p->ProtectFromClose) fast_sync_export( handle );
+
         SERVER_START_REQ( set_handle_info )
         {
             req->handle = wine_server_obj_handle( handle );
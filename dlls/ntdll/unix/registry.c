@@ -604,6 +604,8 @@ NTSTATUS WINAPI NtNotifyChangeMultipleKeys( HANDLE key, ULONG count, OBJECT_ATTR
         if (ret) return ret;
     }
 
+    fast_sync_export( event );
+
     SERVER_START_REQ( set_registry_notification )
     {
         req->hkey    = wine_server_obj_handle( key );
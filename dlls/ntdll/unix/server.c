@@ -1079,6 +1079,154 @@ done:
 }
 
 
+/***********************************************************************/
+/* handle information cache support */
+
+union handle_cache_entry
+{
+    LONG64 data;
+    struct
+    {
+        unsigned int access;           /* granted access */
+        unsigned int flags : 2;        /* HANDLE_FLAG_* values */
+        unsigned int generation : 30;  /* handle generation when the entry was stored */
+    } s;
+};
+
+C_ASSERT( sizeof(union handle_cache_entry) == sizeof(LONG64) );
+
+#define HANDLE_GENERATION_MASK  0x3fffffff
+
+static union handle_cache_entry *handle_cache[FD_CACHE_ENTRIES];
+static const volatile unsigned int *handle_generations;  /* generation table shared with the server */
+
+
+/***********************************************************************
+ *           init_handle_cache
+ *
+ * Map the handle generation table. The cache stays disabled if this fails.
+ */
+static void init_handle_cache(void)
+{
+    size_t size = HANDLE_GENERATION_COUNT * sizeof(*handle_generations);
+    obj_handle_t fd_handle;
+    sigset_t sigset;
+    void *ptr;
+    int fd = -1;
+
+    server_enter_uninterrupted_section( &fd_cache_mutex, &sigset );
+    SERVER_START_REQ( get_handle_generations )
+    {
+        if (!wine_server_call( req )) fd = receive_fd( &fd_handle );
+    }
+    SERVER_END_REQ;
+    server_leave_uninterrupted_section( &fd_cache_mutex, &sigset );
+
+    if (fd == -1) return;
+    ptr = mmap( NULL, size, PROT_READ, MAP_SHARED, fd, 0 );
+    close( fd );
+    if (ptr != MAP_FAILED) handle_generations = ptr;
+}
+
+
+/***********************************************************************
+ *           get_handle_generation
+ *
+ * Must be called before querying the handle information that will be cached.
+ */
+unsigned int get_handle_generation( HANDLE handle )
+{
+    unsigned int idx = (wine_server_obj_handle( handle ) >> 2) - 1;
+
+    if (!handle_generations) return ~0u;
+    return handle_generations[idx % HANDLE_GENERATION_COUNT] & HANDLE_GENERATION_MASK;
+}
+
+
+/***********************************************************************
+ *           add_handle_info_to_cache
+ */
+void add_handle_info_to_cache( HANDLE handle, unsigned int generation,
+                               unsigned int access, unsigned int flags )
+{
+    unsigned int entry, idx = handle_to_index( handle, &entry );
+    union handle_cache_entry cache;
+    sigset_t sigset;
+
+    if (generation > HANDLE_GENERATION_MASK) return;  /* no generation table */
+    if (entry >= FD_CACHE_ENTRIES) return;
+
+    if (!handle_cache[entry])  /* do we need to allocate a new block of entries? */
+    {
+        server_enter_uninterrupted_section( &fd_cache_mutex, &sigset );
+        if (!handle_cache[entry])
+        {
+            void *ptr = anon_mmap_alloc( FD_CACHE_BLOCK_SIZE * sizeof(union handle_cache_entry),
+                                         PROT_READ | PROT_WRITE );
+            if (ptr != MAP_FAILED) handle_cache[entry] = ptr;
+        }
+        server_leave_uninterrupted_section( &fd_cache_mutex, &sigset );
+        if (!handle_cache[entry]) return;
+    }
+
+    cache.data = 0;
+    cache.s.access = access;
+    cache.s.flags = flags;
+    cache.s.generation = generation;
+    interlocked_xchg64( &handle_cache[entry][idx].data, cache.data );
+}
+
+
+/***********************************************************************
+ *           get_cached_handle_info
+ */
+static inline BOOL get_cached_handle_info( HANDLE handle, unsigned int *access, unsigned int *flags )
+{
+    unsigned int entry, idx = handle_to_index( handle, &entry );
+    union handle_cache_entry cache;
+
+    if (entry >= FD_CACHE_ENTRIES || !handle_cache[entry]) return FALSE;
+
+    cache.data = InterlockedCompareExchange64( &handle_cache[entry][idx].data, 0, 0 );
+    if (!cache.data) return FALSE;
+
+    /* the server bumps the generation when the handle is closed or its flags change */
+    if (cache.s.generation != get_handle_generation( handle )) return FALSE;
+
+    if (access) *access = cache.s.access;
+    if (flags) *flags = cache.s.flags;
+    return TRUE;
+}
+
+
+/***********************************************************************
+ *           server_get_handle_info
+ *
+ * Retrieve the granted access and the flags of a handle.
+ */
+NTSTATUS server_get_handle_info( HANDLE handle, unsigned int *access, unsigned int *flags )
+{
+    unsigned int generation;
+    NTSTATUS ret;
+
+    if (get_cached_handle_info( handle, access, flags )) return STATUS_SUCCESS;
+
+    generation = get_handle_generation( handle );
+    SERVER_START_REQ( get_object_info )
+    {
+        req->handle = wine_server_obj_handle( handle );
+        if (!(ret = wine_server_call( req )))
+        {
+            if (access) *access = reply->access;
+            if (flags) *flags = reply->flags;
+            add_handle_info_to_cache( handle, generation, reply->access, reply->flags );
+        }
+    }
+    SERVER_END_REQ;
+    return ret;
+}
+
+
 /***********************************************************************
  *           wine_server_fd_to_handle
  */
@@ -1625,6 +1773,7 @@ void server_init_process_done(void)
      * send exceptions to the debugger before the create process event that
      * is sent by init_process_done */
     signal_init_process();
+    init_handle_cache();
 
     /* Signal the parent process to continue */
     SERVER_START_REQ( init_process_done )
@@ -1684,6 +1833,31 @@ NTSTATUS WINAPI DbgUiIssueRemoteBreakin( HANDLE process )
 }
 
 
+/* duplicate a handle from within the source process */
+static NTSTATUS dup_handle_in_source( HANDLE source_process, HANDLE source, HANDLE dest_process, HANDLE *dest,
+                                      ACCESS_MASK access, ULONG attributes, ULONG options )
+{
+    apc_call_t call;
+    apc_result_t result;
+    NTSTATUS ret;
+
+    memset( &call, 0, sizeof(call) );
+
+    call.dup_handle.type        = APC_DUP_HANDLE;
+    call.dup_handle.src_handle  = wine_server_obj_handle( source );
+    call.dup_handle.dst_process = wine_server_obj_handle( dest_process );
+    call.dup_handle.access      = access;
+    call.dup_handle.attributes  = attributes;
+    call.dup_handle.options     = options;
+    ret = server_queue_process_apc( source_process, &call, &result );
+    if (ret != STATUS_SUCCESS) return ret;
+
+    if (!result.dup_handle.status && dest)
+        *dest = wine_server_ptr_handle( result.dup_handle.handle );
+    return result.dup_handle.status;
+}
+
+
 /******************************************************************************
  *           NtDuplicateObject
  */
@@ -1692,28 +1866,18 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source, HANDLE
 {
     sigset_t sigset;
     NTSTATUS ret;
+    BOOL from_self, to_self;
     int fd = -1;
 
     if ((options & DUPLICATE_CLOSE_SOURCE) && source_process != NtCurrentProcess())
-    {
-        apc_call_t call;
-        apc_result_t result;
-
-        memset( &call, 0, sizeof(call) );
-
-        call.dup_handle.type        = APC_DUP_HANDLE;
-        call.dup_handle.src_handle  = wine_server_obj_handle( source );
-        call.dup_handle.dst_process = wine_server_obj_handle( dest_process );
-        call.dup_handle.access      = access;
-        call.dup_handle.attributes  = attributes;
-        call.dup_handle.options     = options;
-        ret = server_queue_process_apc( source_process, &call, &result );
-        if (ret != STATUS_SUCCESS) return ret;
+        return dup_handle_in_source( source_process, source, dest_process, dest, access, attributes, options );
 
-        if (!result.dup_handle.status)
-            *dest = wine_server_ptr_handle( result.dup_handle.handle );
-        return result.dup_handle.status;
-    }
+    /* handles going to another process need their state in the server; the
+     * process handles may also be real handles to the current process */
+    from_self = fast_sync_is_current_process( source_process );
+    to_self = fast_sync_is_current_process( dest_process );
+    if (from_self && (!to_self || !(options & DUPLICATE_SAME_ACCESS) || (attributes & OBJ_INHERIT)))
+        fast_sync_export( source );
 
     server_enter_uninterrupted_section( &fd_cache_mutex, &sigset );
 
@@ -1739,7 +1903,14 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source, HANDLE
 
     server_leave_uninterrupted_section( &fd_cache_mutex, &sigset );
 
+    if (!ret && from_self)
+        fast_sync_duplicate( source, to_self && dest ? *dest : 0, options & DUPLICATE_CLOSE_SOURCE );
+
     if (fd != -1) close( fd );
+
+    /* the source process keeps the object state, it has to hand it over to the server first */
+    if (ret == STATUS_MORE_PROCESSING_REQUIRED)
+        return dup_handle_in_source( source_process, source, dest_process, dest, access, attributes, options );
     return ret;
 }
 
@@ -1754,6 +1925,8 @@ NTSTATUS WINAPI NtClose( HANDLE handle )
     NTSTATUS ret;
     int fd;
 
+    fast_sync_close( handle );
+
     server_enter_uninterrupted_section( &fd_cache_mutex, &sigset );
 
     /* always remove the cached fd; if the server request fails we'll just
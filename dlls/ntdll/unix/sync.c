@@ -309,6 +309,863 @@ static NTSTATUS validate_open_object_attributes( const OBJECT_ATTRIBUTES *attr )
 }
 
 
+/***********************************************************************
+ * In-process fast path for events, semaphores and mutexes
+ *
+ * When WINEFASTSYNC is set, unnamed and non-inheritable sync objects keep
+ * their state in the process, and signal and wait operations are done with
+ * futexes instead of a server round trip. The server still holds a
+ * placeholder object behind the handle. As soon as the object has to be
+ * visible outside of the process (mixed or alertable waits, duplication to
+ * another process, inheritance, async I/O events), its state is handed over
+ * to the server, which owns it from then on.
+ *
+ * The placeholder is flagged as client-side in the server, which refuses to
+ * let another process duplicate it directly; NtDuplicateObject then asks the
+ * owning process to do the duplication through an APC, so that the state is
+ * handed over first.
+ */
+
+#ifdef __linux__
+
+enum fast_sync_type
+{
+    FAST_SYNC_EVENT,
+    FAST_SYNC_SEMAPHORE,
+    FAST_SYNC_MUTEX
+};
+
+struct fast_sync_object
+{
+    enum fast_sync_type type;
+    unsigned int        refcount;  /* number of handles and pending waits */
+    BOOL                exported;  /* state has been handed over to the server */
+    struct list         waiters;   /* list of pending waits */
+    struct list         entry;     /* entry in owned mutexes list */
+    union
+    {
+        struct
+        {
+            BOOL manual_reset;
+            BOOL signaled;
+        } event;
+        struct
+        {
+            ULONG count;
+            ULONG max;
+        } semaphore;
+        struct
+        {
+            DWORD owner;
+            ULONG count;
+            BOOL  abandoned;
+        } mutex;
+    } u;
+};
+
+struct fast_sync_wait;
+
+struct fast_sync_wait_entry
+{
+    struct list              entry;  /* entry in object waiters list */
+    struct fast_sync_wait   *wait;
+    struct fast_sync_object *obj;
+};
+
+struct fast_sync_wait
+{
+    int                         signaled;  /* futex, set once the wait has been completed */
+    NTSTATUS                    status;
+    BOOL                        wait_all;
+    DWORD                       tid;
+    DWORD                       count;
+    struct fast_sync_wait_entry entries[MAXIMUM_WAIT_OBJECTS];
+};
+
+#define FAST_SYNC_BLOCK_SIZE  (65536 / sizeof(struct fast_sync_object *))
+#define FAST_SYNC_ENTRIES     128
+
+static struct fast_sync_object **fast_sync_handles[FAST_SYNC_ENTRIES];
+static struct list fast_sync_owned_mutexes = LIST_INIT( fast_sync_owned_mutexes );
+static pthread_mutex_t fast_sync_mutex = PTHREAD_MUTEX_INITIALIZER;
+static DWORD fast_sync_lock_owner;
+
+static BOOL use_fast_sync(void)
+{
+    static int enabled = -1;
+
+    if (enabled == -1)
+    {
+        const char *env = getenv( "WINEFASTSYNC" );
+        enabled = env && atoi( env ) && use_futexes();
+        if (enabled) TRACE( "using in-process sync objects\n" );
+    }
+    return enabled;
+}
+
+static void fast_sync_lock( sigset_t *sigset )
+{
+    server_enter_uninterrupted_section( &fast_sync_mutex, sigset );
+    fast_sync_lock_owner = GetCurrentThreadId();
+}
+
+static void fast_sync_unlock( sigset_t *sigset )
+{
+    fast_sync_lock_owner = 0;
+    server_leave_uninterrupted_section( &fast_sync_mutex, sigset );
+}
+
+static inline unsigned int fast_sync_handle_index( HANDLE handle, unsigned int *entry )
+{
+    unsigned int idx = (wine_server_obj_handle(handle) >> 2) - 1;
+    *entry = idx / FAST_SYNC_BLOCK_SIZE;
+    return idx % FAST_SYNC_BLOCK_SIZE;
+}
+
+/***********************************************************************
+ *           get_fast_sync_object
+ *
+ * Without fast_sync_mutex held, the result may only be used as a hint.
+ */
+static struct fast_sync_object *get_fast_sync_object( HANDLE handle )
+{
+    unsigned int entry, idx = fast_sync_handle_index( handle, &entry );
+    struct fast_sync_object **block;
+
+    if (entry >= FAST_SYNC_ENTRIES || !(block = fast_sync_handles[entry])) return NULL;
+    return ((struct fast_sync_object * volatile *)block)[idx];
+}
+
+/***********************************************************************
+ *           set_fast_sync_object
+ *
+ * Caller must hold fast_sync_mutex.
+ */
+static BOOL set_fast_sync_object( HANDLE handle, struct fast_sync_object *obj )
+{
+    unsigned int entry, idx = fast_sync_handle_index( handle, &entry );
+
+    if (entry >= FAST_SYNC_ENTRIES) return FALSE;
+    if (!fast_sync_handles[entry])
+    {
+        if (!obj) return TRUE;
+        if (!(fast_sync_handles[entry] = calloc( FAST_SYNC_BLOCK_SIZE, sizeof(obj) ))) return FALSE;
+    }
+    fast_sync_handles[entry][idx] = obj;
+    return TRUE;
+}
+
+/* check whether an object about to be created can live in the client */
+static struct fast_sync_object *alloc_fast_sync_object( enum fast_sync_type type, ACCESS_MASK access,
+                                                        const OBJECT_ATTRIBUTES *attr, ACCESS_MASK all_access )
+{
+    struct fast_sync_object *obj;
+
+    if (!use_fast_sync()) return NULL;
+    if (attr && (attr->ObjectName || (attr->Attributes & OBJ_INHERIT))) return NULL;
+    if (!(access & (MAXIMUM_ALLOWED | GENERIC_ALL)) && (access & all_access) != all_access) return NULL;
+
+    if (!(obj = calloc( 1, sizeof(*obj) ))) return NULL;
+    obj->type = type;
+    obj->refcount = 1;
+    list_init( &obj->waiters );
+    return obj;
+}
+
+static struct fast_sync_object *alloc_fast_sync_event( ACCESS_MASK access, const OBJECT_ATTRIBUTES *attr,
+                                                       EVENT_TYPE type, BOOLEAN state )
+{
+    struct fast_sync_object *obj;
+
+    if (!(obj = alloc_fast_sync_object( FAST_SYNC_EVENT, access, attr, EVENT_ALL_ACCESS ))) return NULL;
+    obj->u.event.manual_reset = (type == NotificationEvent);
+    obj->u.event.signaled = !!state;
+    return obj;
+}
+
+static struct fast_sync_object *alloc_fast_sync_semaphore( ACCESS_MASK access, const OBJECT_ATTRIBUTES *attr,
+                                                           LONG initial, LONG max )
+{
+    struct fast_sync_object *obj;
+
+    if (!(obj = alloc_fast_sync_object( FAST_SYNC_SEMAPHORE, access, attr, SEMAPHORE_ALL_ACCESS ))) return NULL;
+    obj->u.semaphore.count = initial;
+    obj->u.semaphore.max = max;
+    return obj;
+}
+
+static struct fast_sync_object *alloc_fast_sync_mutex( ACCESS_MASK access, const OBJECT_ATTRIBUTES *attr,
+                                                       BOOLEAN owned )
+{
+    struct fast_sync_object *obj;
+
+    if (!(obj = alloc_fast_sync_object( FAST_SYNC_MUTEX, access, attr, MUTANT_ALL_ACCESS ))) return NULL;
+    if (owned)
+    {
+        obj->u.mutex.owner = GetCurrentThreadId();
+        obj->u.mutex.count = 1;
+    }
+    return obj;
+}
+
+static void release_fast_sync_object( struct fast_sync_object *obj )
+{
+    if (--obj->refcount) return;
+    assert( list_empty( &obj->waiters ));
+    if (obj->type == FAST_SYNC_MUTEX && obj->u.mutex.count) list_remove( &obj->entry );
+    free( obj );
+}
+
+static BOOL fast_sync_signaled( struct fast_sync_object *obj, DWORD tid )
+{
+    switch (obj->type)
+    {
+    case FAST_SYNC_EVENT:     return obj->u.event.signaled;
+    case FAST_SYNC_SEMAPHORE: return obj->u.semaphore.count != 0;
+    case FAST_SYNC_MUTEX:     return !obj->u.mutex.count || obj->u.mutex.owner == tid;
+    }
+    return FALSE;
+}
+
+/* acquire a signaled object; returns TRUE if it was an abandoned mutex */
+static BOOL fast_sync_satisfied( struct fast_sync_object *obj, DWORD tid )
+{
+    switch (obj->type)
+    {
+    case FAST_SYNC_EVENT:
+        if (!obj->u.event.manual_reset) obj->u.event.signaled = FALSE;
+        break;
+    case FAST_SYNC_SEMAPHORE:
+        obj->u.semaphore.count--;
+        break;
+    case FAST_SYNC_MUTEX:
+        if (!obj->u.mutex.count++)
+        {
+            obj->u.mutex.owner = tid;
+            list_add_head( &fast_sync_owned_mutexes, &obj->entry );
+        }
+        if (obj->u.mutex.abandoned)
+        {
+            obj->u.mutex.abandoned = FALSE;
+            return TRUE;
+        }
+        break;
+    }
+    return FALSE;
+}
+
+static BOOL fast_sync_try_satisfy( struct fast_sync_wait *wait )
+{
+    BOOL abandoned = FALSE;
+    DWORD i;
+
+    if (wait->wait_all)
+    {
+        for (i = 0; i < wait->count; i++)
+            if (!fast_sync_signaled( wait->entries[i].obj, wait->tid )) return FALSE;
+        for (i = 0; i < wait->count; i++)
+            abandoned |= fast_sync_satisfied( wait->entries[i].obj, wait->tid );
+        wait->status = abandoned ? STATUS_ABANDONED_WAIT_0 : STATUS_WAIT_0;
+        return TRUE;
+    }
+
+    for (i = 0; i < wait->count; i++)
+    {
+        if (!fast_sync_signaled( wait->entries[i].obj, wait->tid )) continue;
+        abandoned = fast_sync_satisfied( wait->entries[i].obj, wait->tid );
+        wait->status = (abandoned ? STATUS_ABANDONED_WAIT_0 : STATUS_WAIT_0) + i;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+/* remove a wait from all its objects and wake up the waiting thread; caller must hold the lock */
+static void fast_sync_complete_wait( struct fast_sync_wait *wait, NTSTATUS status )
+{
+    DWORD i;
+
+    for (i = 0; i < wait->count; i++) list_remove( &wait->entries[i].entry );
+    wait->status = status;
+    wait->signaled = 1;
+    futex_wake( &wait->signaled, 1 );
+}
+
+/* satisfy as many pending waits as possible after an object state change */
+static void fast_sync_wake_waiters( struct fast_sync_object *obj )
+{
+    struct fast_sync_wait_entry *entry;
+    BOOL woken;
+
+    do
+    {
+        woken = FALSE;
+        /* a mutex with an owner cannot satisfy anyone, the owner never waits in the queue */
+        if (!fast_sync_signaled( obj, 0 )) break;
+        LIST_FOR_EACH_ENTRY( entry, &obj->waiters, struct fast_sync_wait_entry, entry )
+        {
+            if (!fast_sync_try_satisfy( entry->wait )) continue;
+            fast_sync_complete_wait( entry->wait, entry->wait->status );
+            woken = TRUE;
+            break;
+        }
+    } while (woken);
+}
+
+/***********************************************************************
+ *           fast_sync_export_object
+ *
+ * Hand the object state over to the server. Caller must hold fast_sync_mutex.
+ */
+static void fast_sync_export_object( HANDLE handle, struct fast_sync_object *obj )
+{
+    struct fast_sync_wait_entry *entry;
+    NTSTATUS ret = STATUS_SUCCESS;
+
+    if (obj->exported) return;
+    obj->exported = TRUE;
+
+    TRACE( "handing %p over to the server\n", handle );
+
+    switch (obj->type)
+    {
+    case FAST_SYNC_EVENT:
+        if (!obj->u.event.signaled) break;
+        SERVER_START_REQ( event_op )
+        {
+            req->handle = wine_server_obj_handle( handle );
+            req->op     = SET_EVENT;
+            ret = wine_server_call( req );
+        }
+        SERVER_END_REQ;
+        break;
+    case FAST_SYNC_SEMAPHORE:
+        if (!obj->u.semaphore.count) break;
+        SERVER_START_REQ( release_semaphore )
+        {
+            req->handle = wine_server_obj_handle( handle );
+            req->count  = obj->u.semaphore.count;
+            ret = wine_server_call( req );
+        }
+        SERVER_END_REQ;
+        break;
+    case FAST_SYNC_MUTEX:
+        if (!obj->u.mutex.count && !obj->u.mutex.abandoned) break;
+        SERVER_START_REQ( set_mutex_state )
+        {
+            req->handle    = wine_server_obj_handle( handle );
+            req->owner     = obj->u.mutex.owner;
+            req->count     = obj->u.mutex.count;
+            req->abandoned = obj->u.mutex.abandoned;
+            ret = wine_server_call( req );
+        }
+        SERVER_END_REQ;
+        if (obj->u.mutex.count) list_remove( &obj->entry );
+        obj->u.mutex.count = 0;
+        break;
+    }
+    if (ret) ERR( "failed to hand %p over to the server, status %08x\n", handle, ret );
+
+    /* pending waits are restarted through the server */
+    while (!list_empty( &obj->waiters ))
+    {
+        entry = LIST_ENTRY( list_head( &obj->waiters ), struct fast_sync_wait_entry, entry );
+        fast_sync_complete_wait( entry->wait, STATUS_NOT_IMPLEMENTED );
+    }
+}
+
+/* lock and return the object behind a handle, if it is still handled in the client */
+static struct fast_sync_object *fast_sync_grab( HANDLE handle, enum fast_sync_type type, sigset_t *sigset )
+{
+    struct fast_sync_object *obj;
+
+    if (!get_fast_sync_object( handle )) return NULL;
+
+    fast_sync_lock( sigset );
+    if ((obj = get_fast_sync_object( handle )) && !obj->exported && obj->type == type) return obj;
+    fast_sync_unlock( sigset );
+    return NULL;
+}
+
+/* add a newly created object to the handle table, or pass its initial state to the server */
+static void insert_fast_sync_object( NTSTATUS status, HANDLE handle, struct fast_sync_object *obj )
+{
+    sigset_t sigset;
+
+    if (!obj) return;
+    if (status)
+    {
+        free( obj );
+        return;
+    }
+    fast_sync_lock( &sigset );
+    if (!set_fast_sync_object( handle, obj ))
+    {
+        WARN( "too many handles, not using the fast path for %p\n", handle );
+        fast_sync_export_object( handle, obj );
+        release_fast_sync_object( obj );
+    }
+    else if (obj->type == FAST_SYNC_MUTEX && obj->u.mutex.count)
+        list_add_head( &fast_sync_owned_mutexes, &obj->entry );
+    fast_sync_unlock( &sigset );
+}
+
+/* convert a wait timeout to a deadline in monotonic_counter() units */
+static ULONGLONG fast_sync_deadline( const LARGE_INTEGER *timeout )
+{
+    LARGE_INTEGER now;
+
+    if (timeout->QuadPart <= 0) return monotonic_counter() - timeout->QuadPart;
+    NtQuerySystemTime( &now );
+    if (timeout->QuadPart <= now.QuadPart) return monotonic_counter();
+    return monotonic_counter() + (timeout->QuadPart - now.QuadPart);
+}
+
+static NTSTATUS fast_sync_set_event( HANDLE handle, LONG *prev_state )
+{
+    struct fast_sync_object *obj;
+    sigset_t sigset;
+    LONG prev;
+
+    if (!(obj = fast_sync_grab( handle, FAST_SYNC_EVENT, &sigset ))) return STATUS_NOT_IMPLEMENTED;
+    prev = obj->u.event.signaled;
+    obj->u.event.signaled = TRUE;
+    fast_sync_wake_waiters( obj );
+    fast_sync_unlock( &sigset );
+
+    if (prev_state) *prev_state = prev;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS fast_sync_reset_event( HANDLE handle, LONG *prev_state )
+{
+    struct fast_sync_object *obj;
+    sigset_t sigset;
+    LONG prev;
+
+    if (!(obj = fast_sync_grab( handle, FAST_SYNC_EVENT, &sigset ))) return STATUS_NOT_IMPLEMENTED;
+    prev = obj->u.event.signaled;
+    obj->u.event.signaled = FALSE;
+    fast_sync_unlock( &sigset );
+
+    if (prev_state) *prev_state = prev;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS fast_sync_pulse_event( HANDLE handle, LONG *prev_state )
+{
+    struct fast_sync_object *obj;
+    sigset_t sigset;
+    LONG prev;
+
+    if (!(obj = fast_sync_grab( handle, FAST_SYNC_EVENT, &sigset ))) return STATUS_NOT_IMPLEMENTED;
+    prev = obj->u.event.signaled;
+    obj->u.event.signaled = TRUE;
+    fast_sync_wake_waiters( obj );
+    obj->u.event.signaled = FALSE;
+    fast_sync_unlock( &sigset );
+
+    if (prev_state) *prev_state = prev;
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS fast_sync_query_event( HANDLE handle, EVENT_BASIC_INFORMATION *info )
+{
+    struct fast_sync_object *obj;
+    sigset_t sigset;
+
+    if (!(obj = fast_sync_grab( handle, FAST_SYNC_EVENT, &sigset ))) return STATUS_NOT_IMPLEMENTED;
+    info->EventType  = obj->u.event.manual_reset ? NotificationEvent : SynchronizationEvent;
+    info->EventState = obj->u.event.signaled;
+    fast_sync_unlock( &sigset );
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS fast_sync_release_semaphore( HANDLE handle, ULONG count, ULONG *previous )
+{
+    struct fast_sync_object *obj;
+    NTSTATUS ret = STATUS_SUCCESS;
+    sigset_t sigset;
+    ULONG prev;
+
+    if (!(obj = fast_sync_grab( handle, FAST_SYNC_SEMAPHORE, &sigset ))) return STATUS_NOT_IMPLEMENTED;
+    prev = obj->u.semaphore.count;
+    if (prev + count < prev || prev + count > obj->u.semaphore.max)
+        ret = STATUS_SEMAPHORE_LIMIT_EXCEEDED;
+    else if (count)
+    {
+        obj->u.semaphore.count += count;
+        fast_sync_wake_waiters( obj );
+    }
+    fast_sync_unlock( &sigset );
+
+    if (!ret && previous) *previous = prev;
+    return ret;
+}
+
+static NTSTATUS fast_sync_query_semaphore( HANDLE handle, SEMAPHORE_BASIC_INFORMATION *info )
+{
+    struct fast_sync_object *obj;
+    sigset_t sigset;
+
+    if (!(obj = fast_sync_grab( handle, FAST_SYNC_SEMAPHORE, &sigset ))) return STATUS_NOT_IMPLEMENTED;
+    info->CurrentCount = obj->u.semaphore.count;
+    info->MaximumCount = obj->u.semaphore.max;
+    fast_sync_unlock( &sigset );
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS fast_sync_release_mutant( HANDLE handle, LONG *prev_count )
+{
+    struct fast_sync_object *obj;
+    NTSTATUS ret = STATUS_SUCCESS;
+    sigset_t sigset;
+    ULONG prev = 0;
+
+    if (!(obj = fast_sync_grab( handle, FAST_SYNC_MUTEX, &sigset ))) return STATUS_NOT_IMPLEMENTED;
+    if (!obj->u.mutex.count || obj->u.mutex.owner != GetCurrentThreadId())
+        ret = STATUS_MUTANT_NOT_OWNED;
+    else
+    {
+        prev = obj->u.mutex.count;
+        if (!--obj->u.mutex.count)
+        {
+            list_remove( &obj->entry );
+            obj->u.mutex.owner = 0;
+            fast_sync_wake_waiters( obj );
+        }
+    }
+    fast_sync_unlock( &sigset );
+
+    if (prev_count) *prev_count = 1 - prev;
+    return ret;
+}
+
+static NTSTATUS fast_sync_query_mutant( HANDLE handle, MUTANT_BASIC_INFORMATION *info )
+{
+    struct fast_sync_object *obj;
+    sigset_t sigset;
+
+    if (!(obj = fast_sync_grab( handle, FAST_SYNC_MUTEX, &sigset ))) return STATUS_NOT_IMPLEMENTED;
+    info->CurrentCount   = 1 - obj->u.mutex.count;
+    info->OwnedByCaller  = obj->u.mutex.count && obj->u.mutex.owner == GetCurrentThreadId();
+    info->AbandonedState = obj->u.mutex.abandoned;
+    fast_sync_unlock( &sigset );
+    return STATUS_SUCCESS;
+}
+
+/* hand over all the objects of a wait to the server; caller must hold the lock */
+static void fast_sync_export_handles( DWORD count, const HANDLE *handles )
+{
+    struct fast_sync_object *obj;
+    DWORD i;
+
+    for (i = 0; i < count; i++)
+        if ((obj = get_fast_sync_object( handles[i] ))) fast_sync_export_object( handles[i], obj );
+}
+
+static NTSTATUS fast_sync_wait( DWORD count, const HANDLE *handles, BOOLEAN wait_any,
+                                BOOLEAN alertable, const LARGE_INTEGER *timeout )
+{
+    struct fast_sync_wait wait;
+    struct fast_sync_object *obj;
+    ULONGLONG end = 0, now;
+    struct timespec ts;
+    sigset_t sigset;
+    DWORD i, j;
+
+    for (i = 0; i < count; i++) if (get_fast_sync_object( handles[i] )) break;
+    if (i == count) return STATUS_NOT_IMPLEMENTED;
+
+    if (timeout) end = fast_sync_deadline( timeout );
+
+    fast_sync_lock( &sigset );
+
+    for (i = 0; i < count && !alertable; i++)
+    {
+        if (!(obj = get_fast_sync_object( handles[i] )) || obj->exported) break;
+        /* leave waiting twice on the same object to the server */
+        for (j = 0; !wait_any && j < i; j++) if (wait.entries[j].obj == obj) break;
+        if (!wait_any && j < i) break;
+        wait.entries[i].obj = obj;
+    }
+    if (i < count)
+    {
+        fast_sync_export_handles( count, handles );
+        fast_sync_unlock( &sigset );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+
+    wait.signaled = 0;
+    wait.wait_all = !wait_any;
+    wait.tid      = GetCurrentThreadId();
+    wait.count    = count;
+
+    if (fast_sync_try_satisfy( &wait ))
+    {
+        fast_sync_unlock( &sigset );
+        return wait.status;
+    }
+    if (timeout && end <= monotonic_counter())
+    {
+        fast_sync_unlock( &sigset );
+        NtYieldExecution();
+        return STATUS_TIMEOUT;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        wait.entries[i].wait = &wait;
+        wait.entries[i].obj->refcount++;
+        list_add_tail( &wait.entries[i].obj->waiters, &wait.entries[i].entry );
+    }
+    /* the entries are on our stack, fast_sync_thread_exit() unlinks them if we get killed */
+    ntdll_get_thread_data()->fast_sync_wait = &wait;
+    fast_sync_unlock( &sigset );
+
+    while (!*(volatile int *)&wait.signaled)
+    {
+        if (!timeout)
+        {
+            futex_wait( &wait.signaled, 0, NULL );
+            continue;
+        }
+        if ((now = monotonic_counter()) >= end) break;
+        ts.tv_sec  = (end - now) / TICKSPERSEC;
+        ts.tv_nsec = ((end - now) % TICKSPERSEC) * 100;
+        futex_wait( &wait.signaled, 0, &ts );
+    }
+
+    fast_sync_lock( &sigset );
+    ntdll_get_thread_data()->fast_sync_wait = NULL;
+    if (!wait.signaled)
+    {
+        for (i = 0; i < count; i++) list_remove( &wait.entries[i].entry );
+        wait.status = STATUS_TIMEOUT;
+    }
+    for (i = 0; i < count; i++) release_fast_sync_object( wait.entries[i].obj );
+    fast_sync_unlock( &sigset );
+
+    if (wait.status == STATUS_NOT_IMPLEMENTED)
+    {
+        /* some objects were handed over to the server while we were waiting, retry there */
+        LARGE_INTEGER remaining;
+
+        if (timeout)
+        {
+            now = monotonic_counter();
+            remaining.QuadPart = end > now ? -(LONGLONG)(end - now) : 0;
+        }
+        return NtWaitForMultipleObjects( count, handles, wait_any, FALSE, timeout ? &remaining : NULL );
+    }
+    if (wait.status == STATUS_TIMEOUT) NtYieldExecution();
+    return wait.status;
+}
+
+static NTSTATUS fast_sync_signal_and_wait( HANDLE signal, HANDLE wait, BOOLEAN alertable,
+                                           const LARGE_INTEGER *timeout )
+{
+    struct fast_sync_object *signal_obj, *wait_obj;
+    HANDLE handles[2] = { signal, wait };
+    enum fast_sync_type type;
+    sigset_t sigset;
+    NTSTATUS ret;
+
+    if (!get_fast_sync_object( signal ) && !get_fast_sync_object( wait )) return STATUS_NOT_IMPLEMENTED;
+
+    fast_sync_lock( &sigset );
+    signal_obj = get_fast_sync_object( signal );
+    wait_obj = get_fast_sync_object( wait );
+    if (alertable || !signal_obj || !wait_obj || signal_obj->exported || wait_obj->exported)
+    {
+        fast_sync_export_handles( 2, handles );
+        fast_sync_unlock( &sigset );
+        return STATUS_NOT_IMPLEMENTED;
+    }
+    type = signal_obj->type;
+    fast_sync_unlock( &sigset );
+
+    switch (type)
+    {
+    case FAST_SYNC_EVENT:     ret = fast_sync_set_event( signal, NULL ); break;
+    case FAST_SYNC_SEMAPHORE: ret = fast_sync_release_semaphore( signal, 1, NULL ); break;
+    case FAST_SYNC_MUTEX:     ret = fast_sync_release_mutant( signal, NULL ); break;
+    default:                  ret = STATUS_NOT_IMPLEMENTED; break;
+    }
+    if (ret == STATUS_NOT_IMPLEMENTED) return NtSignalAndWaitForSingleObject( signal, wait, alertable, timeout );
+    if (ret) return ret;
+    return NtWaitForMultipleObjects( 1, &wait, FALSE, FALSE, timeout );
+}
+
+/***********************************************************************
+ *           fast_sync_export
+ *
+ * Make sure the server has the current state of the object, for handles
+ * that are about to be used by the server or by other processes.
+ */
+void fast_sync_export( HANDLE handle )
+{
+    struct fast_sync_object *obj;
+    sigset_t sigset;
+
+    if (!get_fast_sync_object( handle )) return;
+
+    fast_sync_lock( &sigset );
+    if ((obj = get_fast_sync_object( handle ))) fast_sync_export_object( handle, obj );
+    fast_sync_unlock( &sigset );
+}
+
+/***********************************************************************
+ *           fast_sync_is_current_process
+ *
+ * Check if a process handle refers to the current process. Only real
+ * handles need a server call, and only when the fast path is in use.
+ */
+BOOL fast_sync_is_current_process( HANDLE process )
+{
+    PROCESS_BASIC_INFORMATION info;
+
+    if (process == NtCurrentProcess()) return TRUE;
+    if (!use_fast_sync()) return FALSE;
+    if (NtQueryInformationProcess( process, ProcessBasicInformation, &info, sizeof(info), NULL )) return FALSE;
+    return info.UniqueProcessId == HandleToULong( NtCurrentTeb()->ClientId.UniqueProcess );
+}
+
+/***********************************************************************
+ *           fast_sync_duplicate
+ *
+ * Called after a handle has been duplicated inside the current process.
+ */
+void fast_sync_duplicate( HANDLE source, HANDLE dest, BOOL close_source )
+{
+    struct fast_sync_object *obj;
+    sigset_t sigset;
+
+    if (!get_fast_sync_object( source )) return;
+
+    fast_sync_lock( &sigset );
+    if ((obj = get_fast_sync_object( source )))
+    {
+        if (dest && set_fast_sync_object( dest, obj )) obj->refcount++;
+        else if (dest) fast_sync_export_object( source, obj );
+        if (close_source)
+        {
+            set_fast_sync_object( source, NULL );
+            release_fast_sync_object( obj );
+        }
+    }
+    fast_sync_unlock( &sigset );
+}
+
+/***********************************************************************
+ *           fast_sync_close
+ */
+void fast_sync_close( HANDLE handle )
+{
+    struct fast_sync_object *obj;
+    sigset_t sigset;
+
+    if (!get_fast_sync_object( handle )) return;
+
+    fast_sync_lock( &sigset );
+    if ((obj = get_fast_sync_object( handle )))
+    {
+        set_fast_sync_object( handle, NULL );
+        release_fast_sync_object( obj );
+    }
+    fast_sync_unlock( &sigset );
+}
+
+/***********************************************************************
+ *           fast_sync_thread_exit
+ *
+ * Cancel the pending wait of the exiting thread, and abandon its mutexes.
+ */
+void fast_sync_thread_exit(void)
+{
+    struct ntdll_thread_data *thread_data = ntdll_get_thread_data();
+    struct fast_sync_wait *wait = thread_data->fast_sync_wait;
+    struct fast_sync_object *obj, *next;
+    DWORD i, tid = GetCurrentThreadId();
+    sigset_t sigset;
+
+    if (!wait && list_empty( &fast_sync_owned_mutexes )) return;
+    /* we got killed in the middle of an operation, nothing can be trusted */
+    if (fast_sync_lock_owner == tid) return;
+
+    fast_sync_lock( &sigset );
+    if (wait)
+    {
+        /* the thread got killed while blocked, its wait entries are about to go away */
+        if (!wait->signaled)
+            for (i = 0; i < wait->count; i++) list_remove( &wait->entries[i].entry );
+        for (i = 0; i < wait->count; i++) release_fast_sync_object( wait->entries[i].obj );
+        thread_data->fast_sync_wait = NULL;
+    }
+    LIST_FOR_EACH_ENTRY_SAFE( obj, next, &fast_sync_owned_mutexes, struct fast_sync_object, entry )
+    {
+        if (obj->u.mutex.owner != tid) continue;
+        list_remove( &obj->entry );
+        obj->u.mutex.owner = 0;
+        obj->u.mutex.count = 0;
+        obj->u.mutex.abandoned = TRUE;
+        fast_sync_wake_waiters( obj );
+    }
+    fast_sync_unlock( &sigset );
+}
+
+#else  /* __linux__ */
+
+struct fast_sync_object;
+
+static inline struct fast_sync_object *alloc_fast_sync_event( ACCESS_MASK access, const OBJECT_ATTRIBUTES *attr,
+                                                              EVENT_TYPE type, BOOLEAN state )
+{
+    return NULL;
+}
+
+static inline struct fast_sync_object *alloc_fast_sync_semaphore( ACCESS_MASK access, const OBJECT_ATTRIBUTES *attr,
+                                                                  LONG initial, LONG max )
+{
+    return NULL;
+}
+
+static inline struct fast_sync_object *alloc_fast_sync_mutex( ACCESS_MASK access, const OBJECT_ATTRIBUTES *attr,
+                                                              BOOLEAN owned )
+{
+    return NULL;
+}
+
+static inline void insert_fast_sync_object( NTSTATUS status, HANDLE handle, struct fast_sync_object *obj ) {}
+static inline NTSTATUS fast_sync_set_event( HANDLE handle, LONG *prev_state ) { return STATUS_NOT_IMPLEMENTED; }
+static inline NTSTATUS fast_sync_reset_event( HANDLE handle, LONG *prev_state ) { return STATUS_NOT_IMPLEMENTED; }
+static inline NTSTATUS fast_sync_pulse_event( HANDLE handle, LONG *prev_state ) { return STATUS_NOT_IMPLEMENTED; }
+static inline NTSTATUS fast_sync_query_event( HANDLE handle, EVENT_BASIC_INFORMATION *info ) { return STATUS_NOT_IMPLEMENTED; }
+static inline NTSTATUS fast_sync_release_semaphore( HANDLE handle, ULONG count, ULONG *previous ) { return STATUS_NOT_IMPLEMENTED; }
+static inline NTSTATUS fast_sync_query_semaphore( HANDLE handle, SEMAPHORE_BASIC_INFORMATION *info ) { return STATUS_NOT_IMPLEMENTED; }
+static inline NTSTATUS fast_sync_release_mutant( HANDLE handle, LONG *prev_count ) { return STATUS_NOT_IMPLEMENTED; }
+static inline NTSTATUS fast_sync_query_mutant( HANDLE handle, MUTANT_BASIC_INFORMATION *info ) { return STATUS_NOT_IMPLEMENTED; }
+
+static inline NTSTATUS fast_sync_wait( DWORD count, const HANDLE *handles, BOOLEAN wait_any,
+                                       BOOLEAN alertable, const LARGE_INTEGER *timeout )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+static inline NTSTATUS fast_sync_signal_and_wait( HANDLE signal, HANDLE wait, BOOLEAN alertable,
+                                                  const LARGE_INTEGER *timeout )
+{
+    return STATUS_NOT_IMPLEMENTED;
+}
+
+void fast_sync_export( HANDLE handle ) {}
+BOOL fast_sync_is_current_process( HANDLE process ) { return process == NtCurrentProcess(); }
+void fast_sync_duplicate( HANDLE source, HANDLE dest, BOOL close_source ) {}
+void fast_sync_close( HANDLE handle ) {}
+void fast_sync_thread_exit(void) {}
+
+#endif  /* __linux__ */
+
+
 /******************************************************************************
  *              NtCreateSemaphore (NTDLL.@)
  */
@@ -318,21 +1175,26 @@ NTSTATUS WINAPI NtCreateSemaphore( HANDLE *handle, ACCESS_MASK access, const OBJ
     NTSTATUS ret;
     data_size_t len;
     struct object_attributes *objattr;
+    struct fast_sync_object *fast;
 
     if (max <= 0 || initial < 0 || initial > max) return STATUS_INVALID_PARAMETER;
     if ((ret = alloc_object_attributes( attr, &objattr, &len ))) return ret;
 
+    fast = alloc_fast_sync_semaphore( access, attr, initial, max );
+
     SERVER_START_REQ( create_semaphore )
     {
         req->access  = access;
-        req->initial = initial;
+        req->initial = fast ? 0 : initial;
         req->max     = max;
+        req->client_sync = !!fast;
         wine_server_add_data( req, objattr, len );
         ret = wine_server_call( req );
         *handle = wine_server_ptr_handle( reply->handle );
     }
     SERVER_END_REQ;
 
+    insert_fast_sync_object( ret, *handle, fast );
     free( objattr );
     return ret;
 }
@@ -381,6 +1243,12 @@ NTSTATUS WINAPI NtQuerySemaphore( HANDLE handle, SEMAPHORE_INFORMATION_CLASS cla
 
     if (len != sizeof(SEMAPHORE_BASIC_INFORMATION)) return STATUS_INFO_LENGTH_MISMATCH;
 
+    if ((ret = fast_sync_query_semaphore( handle, out )) != STATUS_NOT_IMPLEMENTED)
+    {
+        if (!ret && ret_len) *ret_len = sizeof(SEMAPHORE_BASIC_INFORMATION);
+        return ret;
+    }
+
     SERVER_START_REQ( query_semaphore )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -403,6 +1271,9 @@ NTSTATUS WINAPI NtReleaseSemaphore( HANDLE handle, ULONG count, ULONG *previous
 {
     NTSTATUS ret;
 
+    if ((ret = fast_sync_release_semaphore( handle, count, previous )) != STATUS_NOT_IMPLEMENTED)
+        return ret;
+
     SERVER_START_REQ( release_semaphore )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -426,21 +1297,26 @@ NTSTATUS WINAPI NtCreateEvent( HANDLE *handle, ACCESS_MASK access, const OBJECT_
     NTSTATUS ret;
     data_size_t len;
     struct object_attributes *objattr;
+    struct fast_sync_object *fast;
 
     if (type != NotificationEvent && type != SynchronizationEvent) return STATUS_INVALID_PARAMETER;
     if ((ret = alloc_object_attributes( attr, &objattr, &len ))) return ret;
 
+    fast = alloc_fast_sync_event( access, attr, type, state );
+
     SERVER_START_REQ( create_event )
     {
         req->access = access;
         req->manual_reset = (type == NotificationEvent);
-        req->initial_state = state;
+        req->initial_state = fast ? FALSE : state;
+        req->client_sync = !!fast;
         wine_server_add_data( req, objattr, len );
         ret = wine_server_call( req );
         *handle = wine_server_ptr_handle( reply->handle );
     }
     SERVER_END_REQ;
 
+    insert_fast_sync_object( ret, *handle, fast );
     free( objattr );
     return ret;
 }
@@ -477,6 +1353,8 @@ NTSTATUS WINAPI NtSetEvent( HANDLE handle, LONG *prev_state )
 {
     NTSTATUS ret;
 
+    if ((ret = fast_sync_set_event( handle, prev_state )) != STATUS_NOT_IMPLEMENTED) return ret;
+
     SERVER_START_REQ( event_op )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -496,6 +1374,8 @@ NTSTATUS WINAPI NtResetEvent( HANDLE handle, LONG *prev_state )
 {
     NTSTATUS ret;
 
+    if ((ret = fast_sync_reset_event( handle, prev_state )) != STATUS_NOT_IMPLEMENTED) return ret;
+
     SERVER_START_REQ( event_op )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -525,6 +1405,8 @@ NTSTATUS WINAPI NtPulseEvent( HANDLE handle, LONG *prev_state )
 {
     NTSTATUS ret;
 
+    if ((ret = fast_sync_pulse_event( handle, prev_state )) != STATUS_NOT_IMPLEMENTED) return ret;
+
     SERVER_START_REQ( event_op )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -557,6 +1439,12 @@ NTSTATUS WINAPI NtQueryEvent( HANDLE handle, EVENT_INFORMATION_CLASS class,
 
     if (len != sizeof(EVENT_BASIC_INFORMATION)) return STATUS_INFO_LENGTH_MISMATCH;
 
+    if ((ret = fast_sync_query_event( handle, out )) != STATUS_NOT_IMPLEMENTED)
+    {
+        if (!ret && ret_len) *ret_len = sizeof(EVENT_BASIC_INFORMATION);
+        return ret;
+    }
+
     SERVER_START_REQ( query_event )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -581,19 +1469,24 @@ NTSTATUS WINAPI NtCreateMutant( HANDLE *handle, ACCESS_MASK access, const OBJECT
     NTSTATUS ret;
     data_size_t len;
     struct object_attributes *objattr;
+    struct fast_sync_object *fast;
 
     if ((ret = alloc_object_attributes( attr, &objattr, &len ))) return ret;
 
+    fast = alloc_fast_sync_mutex( access, attr, owned );
+
     SERVER_START_REQ( create_mutex )
     {
         req->access  = access;
-        req->owned   = owned;
+        req->owned   = fast ? FALSE : owned;
+        req->client_sync = !!fast;
         wine_server_add_data( req, objattr, len );
         ret = wine_server_call( req );
         *handle = wine_server_ptr_handle( reply->handle );
     }
     SERVER_END_REQ;
 
+    insert_fast_sync_object( ret, *handle, fast );
     free( objattr );
     return ret;
 }
@@ -630,6 +1523,8 @@ NTSTATUS WINAPI NtReleaseMutant( HANDLE handle, LONG *prev_count )
 {
     NTSTATUS ret;
 
+    if ((ret = fast_sync_release_mutant( handle, prev_count )) != STATUS_NOT_IMPLEMENTED) return ret;
+
     SERVER_START_REQ( release_mutex )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -660,6 +1555,12 @@ NTSTATUS WINAPI NtQueryMutant( HANDLE handle, MUTANT_INFORMATION_CLASS class,
 
     if (len != sizeof(MUTANT_BASIC_INFORMATION)) return STATUS_INFO_LENGTH_MISMATCH;
 
+    if ((ret = fast_sync_query_mutant( handle, out )) != STATUS_NOT_IMPLEMENTED)
+    {
+        if (!ret && ret_len) *ret_len = sizeof(MUTANT_BASIC_INFORMATION);
+        return ret;
+    }
+
     SERVER_START_REQ( query_mutex )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -1424,9 +2325,13 @@ NTSTATUS WINAPI NtWaitForMultipleObjects( DWORD count, const HANDLE *handles, BO
 {
     select_op_t select_op;
     UINT i, flags = SELECT_INTERRUPTIBLE;
+    NTSTATUS ret;
 
     if (!count || count > MAXIMUM_WAIT_OBJECTS) return STATUS_INVALID_PARAMETER_1;
 
+    if ((ret = fast_sync_wait( count, handles, wait_any, alertable, timeout )) != STATUS_NOT_IMPLEMENTED)
+        return ret;
+
     if (alertable) flags |= SELECT_ALERTABLE;
     select_op.wait.op = wait_any ? SELECT_WAIT : SELECT_WAIT_ALL;
     for (i = 0; i < count; i++) select_op.wait.handles[i] = wine_server_obj_handle( handles[i] );
@@ -1451,9 +2356,13 @@ NTSTATUS WINAPI NtSignalAndWaitForSingleObject( HANDLE signal, HANDLE wait,
 {
     select_op_t select_op;
     UINT flags = SELECT_INTERRUPTIBLE;
+    NTSTATUS ret;
 
     if (!signal) return STATUS_INVALID_HANDLE;
 
+    if ((ret = fast_sync_signal_and_wait( signal, wait, alertable, timeout )) != STATUS_NOT_IMPLEMENTED)
+        return ret;
+
     if (alertable) flags |= SELECT_ALERTABLE;
     select_op.signal_and_wait.op = SELECT_SIGNAL_AND_WAIT;
     select_op.signal_and_wait.wait = wine_server_obj_handle( wait );
@@ -2685,68 +3594,167 @@ NTSTATUS CDECL fast_RtlWakeConditionVariable( RTL_CONDITION_VARIABLE *variable,
 
 /* We can't map addresses to futex directly, because an application can wait on
  * 8 bytes, and we can't pass all 8 as the compare value to futex(). Instead we
- * map all addresses to a small fixed table of futexes. This may result in
- * spurious wakes, but the application is already expected to handle those. */
+ * hash addresses to a table of buckets, each holding the list of threads
+ * waiting on addresses in the bucket. Every waiter sleeps on its own futex, so
+ * a wake only reaches threads waiting on that exact address. */
 
-static int addr_futex_table[256];
+struct addr_waiter
+{
+    struct list  entry;
+    const void  *addr;
+    int          woken;
+};
 
-static inline int *hash_addr( const void *addr )
+struct addr_bucket
+{
+    int          lock;
+    struct list  waiters;
+};
+
+#define ADDR_BUCKET_COUNT 1024
+
+static struct addr_bucket addr_bucket_table[ADDR_BUCKET_COUNT];
+
+static inline struct addr_bucket *get_addr_bucket( const void *addr )
 {
     ULONG_PTR val = (ULONG_PTR)addr;
 
-    return &addr_futex_table[(val >> 2) & 255];
+    return &addr_bucket_table[((val >> 2) ^ (val >> 12)) % ADDR_BUCKET_COUNT];
+}
+
+/* lock states: 0 unlocked, 1 locked, 2 locked with waiters */
+static inline void addr_bucket_lock( struct addr_bucket *bucket )
+{
+    int val;
+
+    if (!(val = InterlockedCompareExchange( &bucket->lock, 1, 0 ))) return;
+    if (val != 2) val = InterlockedExchange( &bucket->lock, 2 );
+    while (val)
+    {
+        futex_wait( &bucket->lock, 2, NULL );
+        val = InterlockedExchange( &bucket->lock, 2 );
+    }
+}
+
+static inline void addr_bucket_unlock( struct addr_bucket *bucket )
+{
+    if (InterlockedExchange( &bucket->lock, 0 ) == 2)
+        futex_wake( &bucket->lock, 1 );
 }
 
 static inline NTSTATUS fast_wait_addr( const void *addr, const void *cmp, SIZE_T size,
                                        const LARGE_INTEGER *timeout )
 {
-    int *futex;
-    int val;
+    struct ntdll_thread_data *thread_data = ntdll_get_thread_data();
+    struct addr_bucket *bucket;
+    struct addr_waiter waiter;
     struct timespec timespec;
+    NTSTATUS status = STATUS_SUCCESS;
+    sigset_t sigset;
     int ret;
 
     if (!use_futexes())
         return STATUS_NOT_IMPLEMENTED;
 
-    futex = hash_addr( addr );
+    if (!compare_addr( addr, cmp, size ))
+        return STATUS_SUCCESS;
+
+    bucket = get_addr_bucket( addr );
 
-    /* We must read the previous value of the futex before checking the value
-     * of the address being waited on. That way, if we receive a wake between
-     * now and waiting on the futex, we know that val will have changed.
-     * Use an atomic load so that memory accesses are ordered between this read
-     * and the increment below. */
-    val = InterlockedCompareExchange( futex, 0, 0 );
+    /* The waiter lives on our stack. Signals are blocked while the bucket is
+     * locked, so that addr_wait_thread_exit() can always unlink it if we get
+     * killed. Wakers take the bucket lock too, so checking the value and
+     * queuing ourselves under it can't miss a wake. */
+    pthread_sigmask( SIG_BLOCK, &server_block_set, &sigset );
+    addr_bucket_lock( bucket );
+    /* the zero-initialized list heads are set up on first use */
+    if (!bucket->waiters.next) list_init( &bucket->waiters );
     if (!compare_addr( addr, cmp, size ))
+    {
+        addr_bucket_unlock( bucket );
+        pthread_sigmask( SIG_SETMASK, &sigset, NULL );
         return STATUS_SUCCESS;
+    }
+    waiter.addr  = addr;
+    waiter.woken = 0;
+    list_add_tail( &bucket->waiters, &waiter.entry );
+    thread_data->addr_waiter = &waiter;
+    addr_bucket_unlock( bucket );
+    pthread_sigmask( SIG_SETMASK, &sigset, NULL );
 
     if (timeout)
     {
         timespec_from_timeout( &timespec, timeout );
-        ret = futex_wait( futex, val, &timespec );
+        ret = futex_wait( &waiter.woken, 0, &timespec );
+        if (ret == -1 && errno == ETIMEDOUT) status = STATUS_TIMEOUT;
     }
     else
-        ret = futex_wait( futex, val, NULL );
+    {
+        while (!*(volatile int *)&waiter.woken)
+            futex_wait( &waiter.woken, 0, NULL );
+    }
 
-    if (ret == -1 && errno == ETIMEDOUT)
-        return STATUS_TIMEOUT;
-    return STATUS_SUCCESS;
+    /* Always retake the lock, the waker may still be touching our entry. */
+    pthread_sigmask( SIG_BLOCK, &server_block_set, &sigset );
+    addr_bucket_lock( bucket );
+    if (waiter.woken)
+        status = STATUS_SUCCESS;
+    else
+        list_remove( &waiter.entry );
+    thread_data->addr_waiter = NULL;
+    addr_bucket_unlock( bucket );
+    pthread_sigmask( SIG_SETMASK, &sigset, NULL );
+    return status;
 }
 
-static inline NTSTATUS fast_wake_addr( const void *addr )
+static inline NTSTATUS fast_wake_addr( const void *addr, BOOL all )
 {
-    int *futex;
+    struct addr_bucket *bucket;
+    struct addr_waiter *waiter, *next;
 
     if (!use_futexes())
         return STATUS_NOT_IMPLEMENTED;
 
-    futex = hash_addr( addr );
+    bucket = get_addr_bucket( addr );
 
-    InterlockedIncrement( futex );
+    addr_bucket_lock( bucket );
+    if (bucket->waiters.next)
+    {
+        LIST_FOR_EACH_ENTRY_SAFE( waiter, next, &bucket->waiters, struct addr_waiter, entry )
+        {
+            if (waiter->addr != addr) continue;
 
-    futex_wake( futex, INT_MAX );
+            list_remove( &waiter->entry );
+            waiter->woken = 1;
+            futex_wake( &waiter->woken, 1 );
+            if (!all) break;
+        }
+    }
+    addr_bucket_unlock( bucket );
     return STATUS_SUCCESS;
 }
 
+/***********************************************************************
+ *           addr_wait_thread_exit
+ *
+ * Unlink the pending address wait of a thread that got killed.
+ * Signals must be blocked.
+ */
+void addr_wait_thread_exit(void)
+{
+    struct ntdll_thread_data *thread_data = ntdll_get_thread_data();
+    struct addr_waiter *waiter = thread_data->addr_waiter;
+    struct addr_bucket *bucket;
+
+    if (!waiter) return;
+
+    bucket = get_addr_bucket( waiter->addr );
+    addr_bucket_lock( bucket );
+    if (!waiter->woken) list_remove( &waiter->entry );
+    thread_data->addr_waiter = NULL;
+    addr_bucket_unlock( bucket );
+}
+
 #else
 
 NTSTATUS CDECL fast_RtlTryAcquireSRWLockExclusive( RTL_SRWLOCK *lock )
@@ -2795,11 +3803,15 @@ static inline NTSTATUS fast_wait_addr( const void *addr, const void *cmp, SIZE_T
     return STATUS_NOT_IMPLEMENTED;
 }
 
-static inline NTSTATUS fast_wake_addr( const void *addr )
+static inline NTSTATUS fast_wake_addr( const void *addr, BOOL all )
 {
     return STATUS_NOT_IMPLEMENTED;
 }
 
+void addr_wait_thread_exit(void)
+{
+}
+
 #endif
 
 
@@ -2847,7 +3859,7 @@ NTSTATUS WINAPI RtlWaitOnAddress( const void *addr, const void *cmp, SIZE_T size
  */
 void WINAPI RtlWakeAddressAll( const void *addr )
 {
-    if (fast_wake_addr( addr ) != STATUS_NOT_IMPLEMENTED) return;
+    if (fast_wake_addr( addr, TRUE ) != STATUS_NOT_IMPLEMENTED) return;
 
     mutex_lock( &addr_mutex );
     while (NtReleaseKeyedEvent( 0, addr, 0, &zero_timeout ) == STATUS_SUCCESS) {}
@@ -2859,7 +3871,7 @@ void WINAPI RtlWakeAddressAll( const void *addr )
  */
 void WINAPI RtlWakeAddressSingle( const void *addr )
 {
-    if (fast_wake_addr( addr ) != STATUS_NOT_IMPLEMENTED) return;
+    if (fast_wake_addr( addr, FALSE ) != STATUS_NOT_IMPLEMENTED) return;
 
     mutex_lock( &addr_mutex );
     NtReleaseKeyedEvent( 0, addr, 0, &zero_timeout );
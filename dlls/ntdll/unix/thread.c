@@ -285,6 +285,8 @@ done:
 void abort_thread( int status )
 {
     pthread_sigmask( SIG_BLOCK, &server_block_set, NULL );
+    fast_sync_thread_exit();
+    addr_wait_thread_exit();
     if (InterlockedDecrement( &nb_threads ) <= 0) abort_process( status );
     signal_exit_thread( status, pthread_exit_wrapper );
 }
@@ -308,6 +310,7 @@ static void exit_thread( int status )
     TEB *teb;
 
     pthread_sigmask( SIG_BLOCK, &server_block_set, NULL );
+    fast_sync_thread_exit();
 
     if ((teb = InterlockedExchangePointer( &prev_teb, NtCurrentTeb() )))
     {
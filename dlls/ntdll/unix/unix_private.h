@@ -64,6 +64,8 @@ struct ntdll_thread_data
     struct list        entry;         /* entry in TEB list */
     PRTL_THREAD_START_ROUTINE start;  /* thread entry point */
     void              *param;         /* thread entry point parameter */
+    struct fast_sync_wait *fast_sync_wait; /* pending in-process wait */
+    struct addr_waiter *addr_waiter;  /* pending RtlWaitOnAddress wait */
 };
 
 C_ASSERT( sizeof(struct ntdll_thread_data) <= sizeof(((TEB *)0)->GdiTebBatch) );
@@ -164,6 +166,10 @@ extern unsigned int server_queue_process_apc( HANDLE process, const apc_call_t *
                                               apc_result_t *result ) DECLSPEC_HIDDEN;
 extern int server_get_unix_fd( HANDLE handle, unsigned int wanted_access, int *unix_fd,
                                int *needs_close, enum server_fd_type *type, unsigned int *options ) DECLSPEC_HIDDEN;
+extern NTSTATUS server_get_handle_info( HANDLE handle, unsigned int *access, unsigned int *flags ) DECLSPEC_HIDDEN;
+extern unsigned int get_handle_generation( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void add_handle_info_to_cache( HANDLE handle, unsigned int generation,
+                                      unsigned int access, unsigned int flags ) DECLSPEC_HIDDEN;
 extern size_t server_init_process(void) DECLSPEC_HIDDEN;
 extern void server_init_process_done(void) DECLSPEC_HIDDEN;
 extern void server_init_thread( void *entry_point, BOOL *suspend ) DECLSPEC_HIDDEN;
@@ -180,6 +186,12 @@ extern NTSTATUS set_thread_context( HANDLE handle, const context_t *context, BOO
 extern NTSTATUS get_thread_context( HANDLE handle, context_t *context, unsigned int flags, BOOL *self ) DECLSPEC_HIDDEN;
 extern NTSTATUS alloc_object_attributes( const OBJECT_ATTRIBUTES *attr, struct object_attributes **ret,
                                          data_size_t *ret_len ) DECLSPEC_HIDDEN;
+extern void fast_sync_export( HANDLE handle ) DECLSPEC_HIDDEN;
+extern BOOL fast_sync_is_current_process( HANDLE process ) DECLSPEC_HIDDEN;
+extern void fast_sync_duplicate( HANDLE source, HANDLE dest, BOOL close_source ) DECLSPEC_HIDDEN;
+extern void fast_sync_close( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void fast_sync_thread_exit(void) DECLSPEC_HIDDEN;
+extern void addr_wait_thread_exit(void) DECLSPEC_HIDDEN;
 
 extern void *anon_mmap_fixed( void *start, size_t size, int prot, int flags ) DECLSPEC_HIDDEN;
 extern void *anon_mmap_alloc( size_t size, int prot ) DECLSPEC_HIDDEN;
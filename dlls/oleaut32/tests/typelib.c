@@ -8318,12 +8318,264 @@ static void test_DeleteFuncDesc(void)
     DeleteFileW(filenameW);
 }
 
+static void test_typelib_cache_child(void)
+{
+    WCHAR path[MAX_PATH + 4];
+    ITypeLib *tl;
+    HRESULT hr;
+
+    GetModuleFileNameW(NULL, path, MAX_PATH);
+    lstrcatW(path, L"\\2");
+    hr = LoadTypeLibEx(path, REGKIND_NONE, &tl);
+    ok(hr == S_OK, "Failed to load typelib, hr %#x.\n", hr);
+    if (FAILED(hr)) return;
+    ok(ITypeLib_GetTypeInfoCount(tl) > 0, "Expected type infos.\n");
+    ITypeLib_Release(tl);
+}
+
+static int get_typelib_cache_files(FILETIME *time, BOOL delete)
+{
+    WCHAR dir[MAX_PATH], path[MAX_PATH];
+    WIN32_FIND_DATAW data;
+    HANDLE find;
+    int count = 0;
+
+    GetSystemDirectoryW(dir, MAX_PATH - 32);
+    lstrcatW(dir, L"\\tlbcache\\");
+    lstrcpyW(path, dir);
+    lstrcatW(path, L"*.tlb");
+    find = FindFirstFileW(path, &data);
+    if (find == INVALID_HANDLE_VALUE) return 0;
+    do
+    {
+        if (!count++ && time) *time = data.ftLastWriteTime;
+        if (delete)
+        {
+            lstrcpyW(path, dir);
+            lstrcatW(path, data.cFileName);
+            DeleteFileW(path);
+        }
+    } while (FindNextFileW(find, &data));
+    FindClose(find);
+    return count;
+}
+
+static void run_typelib_cache_child(void)
+{
+    char **argv, cmdline[MAX_PATH + 32];
+    PROCESS_INFORMATION pi;
+    STARTUPINFOA si = { sizeof(si) };
+    BOOL ret;
+
+    winetest_get_mainargs(&argv);
+    sprintf(cmdline, "\"%s\" typelib cache", argv[0]);
+    ret = CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi);
+    ok(ret, "CreateProcess failed, error %u.\n", GetLastError());
+    if (!ret) return;
+    wait_child_process(pi.hProcess);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+}
+
+static void test_typelib_cache(void)
+{
+    FILETIME time, time2;
+    DWORD one = 1;
+    BOOL had_key;
+    HKEY key;
+    LONG ret;
+    int count;
+
+    if (strcmp(winetest_platform, "wine"))
+    {
+        skip("The type library disk cache is specific to Wine.\n");
+        return;
+    }
+
+    had_key = !RegOpenKeyW(HKEY_CURRENT_USER, L"Software\\Wine\\OleAut32", &key);
+    if (had_key) RegCloseKey(key);
+    ret = RegCreateKeyW(HKEY_CURRENT_USER, L"Software\\Wine\\OleAut32", &key);
+    ok(!ret, "RegCreateKey failed, error %d.\n", ret);
+    ret = RegSetValueExW(key, L"TypeLibCache", 0, REG_DWORD, (BYTE *)&one, sizeof(one));
+    ok(!ret, "RegSetValueEx failed, error %d.\n", ret);
+    get_typelib_cache_files(NULL, TRUE);
+
+    /* the first process stores the typelib resource of the module */
+    run_typelib_cache_child();
+    count = get_typelib_cache_files(&time, FALSE);
+    ok(count == 1, "Got %d cache entries.\n", count);
+
+    /* the next one maps it without writing it again */
+    Sleep(20);
+    run_typelib_cache_child();
+    count = get_typelib_cache_files(&time2, FALSE);
+    ok(count == 1, "Got %d cache entries.\n", count);
+    ok(!CompareFileTime(&time, &time2), "The cache entry was written again.\n");
+
+    get_typelib_cache_files(NULL, TRUE);
+    RegDeleteValueW(key, L"TypeLibCache");
+    RegCloseKey(key);
+    if (!had_key) RegDeleteKeyW(HKEY_CURRENT_USER, L"Software\\Wine\\OleAut32");
+}
+
+static void test_invoke_perf(void)
+{
+    static OLECHAR testfuncW[] = L"TestFunc", iW[] = L"I", unknownW[] = L"unknown", invokeW[] = L"Invoke";
+    static OLECHAR mixedW[] = L"tESTfUNC", dispW[] = L"disp", valueW[] = L"Value", value2W[] = L"VALUE";
+    static OLECHAR newW[] = L"New-Member", new2W[] = L"new-member";
+    LARGE_INTEGER freq, start, end;
+    char filenameA[MAX_PATH];
+    WCHAR filenameW[MAX_PATH];
+    ICreateTypeLib2 *ctl;
+    ICreateTypeInfo *cti;
+    FUNCDESC funcdesc;
+    VARDESC vardesc;
+    OLECHAR *names[2];
+    ITypeInfo *typeinfo;
+    DISPID dispids[2];
+    DISPPARAMS dp;
+    ITypeLib *typelib;
+    VARIANT arg, res;
+    WCHAR *filename;
+    HRESULT hr;
+    UINT i;
+
+    filename = create_test_typelib(3, L"TYPELIB");
+    hr = LoadTypeLib(filename, &typelib);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    hr = ITypeLib_GetTypeInfoOfGuid(typelib, &IID_IInvokeTest, &typeinfo);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    names[0] = testfuncW;
+    names[1] = iW;
+    hr = ITypeInfo_GetIDsOfNames(typeinfo, names, 2, dispids);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(dispids[0] == 3, "got %d\n", dispids[0]);
+    ok(dispids[1] == 0, "got %d\n", dispids[1]);
+
+    names[0] = unknownW;
+    hr = ITypeInfo_GetIDsOfNames(typeinfo, names, 1, dispids);
+    ok(hr == DISP_E_UNKNOWNNAME, "got 0x%08x\n", hr);
+    ok(dispids[0] == MEMBERID_NIL, "got %d\n", dispids[0]);
+
+    /* names of inherited interfaces are found as well */
+    names[0] = invokeW;
+    hr = ITypeInfo_GetIDsOfNames(typeinfo, names, 1, dispids);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    names[0] = mixedW;
+    hr = ITypeInfo_GetIDsOfNames(typeinfo, names, 1, dispids);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(dispids[0] == 3, "got %d\n", dispids[0]);
+
+    QueryPerformanceFrequency(&freq);
+
+    names[0] = testfuncW;
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < 100000; i++)
+        ITypeInfo_GetIDsOfNames(typeinfo, names, 1, dispids);
+    QueryPerformanceCounter(&end);
+    ok(dispids[0] == 3, "got %d\n", dispids[0]);
+    trace("GetIDsOfNames: %.0f calls/s\n", 100000.0 * freq.QuadPart / (end.QuadPart - start.QuadPart));
+
+    dp.rgvarg = &arg;
+    dp.rgdispidNamedArgs = NULL;
+    dp.cArgs = 1;
+    dp.cNamedArgs = 0;
+    V_VT(&arg) = VT_INT;
+    V_INT(&arg) = 3;
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < 100000; i++)
+    {
+        ITypeInfo_GetIDsOfNames(typeinfo, names, 1, dispids);
+        V_VT(&res) = VT_EMPTY;
+        hr = ITypeInfo_Invoke(typeinfo, &invoketest, dispids[0], DISPATCH_METHOD, &dp, &res, NULL, NULL);
+        if (hr != S_OK) break;
+    }
+    QueryPerformanceCounter(&end);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(V_VT(&res) == VT_I4, "got %d\n", V_VT(&res));
+    ok(V_I4(&res) == 4, "got %d\n", V_I4(&res));
+    trace("GetIDsOfNames + Invoke: %.0f calls/s\n", 100000.0 * freq.QuadPart / (end.QuadPart - start.QuadPart));
+
+    ITypeInfo_Release(typeinfo);
+    ITypeLib_Release(typelib);
+    DeleteFileW(filename);
+
+    /* functions are found before variables with the same name, and the
+     * lookup follows members added after a previous lookup */
+    GetTempFileNameA(".", "tlb", 0, filenameA);
+    MultiByteToWideChar(CP_ACP, 0, filenameA, -1, filenameW, MAX_PATH);
+    hr = CreateTypeLib2(SYS_WIN32, filenameW, &ctl);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    hr = ICreateTypeLib2_CreateTypeInfo(ctl, dispW, TKIND_DISPATCH, &cti);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    memset(&vardesc, 0, sizeof(vardesc));
+    vardesc.memid = 0x10;
+    vardesc.elemdescVar.tdesc.vt = VT_I4;
+    vardesc.varkind = VAR_DISPATCH;
+    hr = ICreateTypeInfo_AddVarDesc(cti, 0, &vardesc);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    hr = ICreateTypeInfo_SetVarName(cti, 0, valueW);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    memset(&funcdesc, 0, sizeof(funcdesc));
+    funcdesc.memid = 0x20;
+    funcdesc.funckind = FUNC_DISPATCH;
+    funcdesc.invkind = INVOKE_FUNC;
+    funcdesc.callconv = CC_STDCALL;
+    funcdesc.elemdescFunc.tdesc.vt = VT_VOID;
+    hr = ICreateTypeInfo_AddFuncDesc(cti, 0, &funcdesc);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    names[0] = value2W;
+    hr = ICreateTypeInfo_SetFuncAndParamNames(cti, 0, names, 1);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+
+    hr = ICreateTypeInfo_QueryInterface(cti, &IID_ITypeInfo, (void **)&typeinfo);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    names[0] = valueW;
+    hr = ITypeInfo_GetIDsOfNames(typeinfo, names, 1, dispids);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(dispids[0] == 0x20, "got %#x\n", dispids[0]);
+
+    /* the new function shifts the existing one */
+    funcdesc.memid = 0x21;
+    hr = ICreateTypeInfo_AddFuncDesc(cti, 0, &funcdesc);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    hr = ITypeInfo_GetIDsOfNames(typeinfo, names, 1, dispids);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(dispids[0] == 0x20, "got %#x\n", dispids[0]);
+
+    names[0] = newW;
+    hr = ICreateTypeInfo_SetFuncAndParamNames(cti, 0, names, 1);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    names[0] = new2W;
+    hr = ITypeInfo_GetIDsOfNames(typeinfo, names, 1, dispids);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(dispids[0] == 0x21, "got %#x\n", dispids[0]);
+
+    ITypeInfo_Release(typeinfo);
+    ICreateTypeInfo_Release(cti);
+    ICreateTypeLib2_Release(ctl);
+    DeleteFileA(filenameA);
+}
+
 START_TEST(typelib)
 {
     const WCHAR *filename;
+    char **argv;
+    int argc;
 
     init_function_pointers();
 
+    argc = winetest_get_mainargs(&argv);
+    if (argc > 2 && !strcmp(argv[2], "cache"))
+    {
+        test_typelib_cache_child();
+        return;
+    }
+
     ref_count_test(wszStdOle2);
     test_TypeComp();
     test_CreateDispTypeInfo();
@@ -8360,4 +8612,6 @@ START_TEST(typelib)
     test_dep();
     test_DeleteImplType();
     test_DeleteFuncDesc();
+    test_invoke_perf();
+    test_typelib_cache();
 }
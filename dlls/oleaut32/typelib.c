@@ -1242,6 +1242,9 @@ typedef struct tagITypeInfoImpl
 
     struct list *pcustdata_list;
     struct list custdata_list;
+
+    /* hashed function and variable names for GetIDsOfNames, built on first use */
+    struct tlb_name_index *name_index;
 } ITypeInfoImpl;
 
 static inline ITypeInfoImpl *info_impl_from_ITypeComp( ITypeComp *iface )
@@ -1709,6 +1712,149 @@ static inline TLBVarDesc *TLB_get_vardesc_by_name(ITypeInfoImpl *typeinfo, const
     return NULL;
 }
 
+/* Case insensitive hash table of function and variable names. Only names
+ * consisting of printable ASCII characters are hashed, lstrcmpiW might
+ * consider other names equal even if they differ in more than case. The
+ * hyphen and apostrophe are left out too, the word sort ignores them. */
+struct tlb_name_index
+{
+    BOOL usable;
+    UINT mask;
+    struct
+    {
+        ULONG hash;
+        UINT member; /* function index, or variable index + cFuncs */
+    } entries[1];
+};
+
+#define TLB_NAME_INDEX_EMPTY (~0u)
+
+static BOOL TLB_hash_name(const OLECHAR *name, ULONG *hash)
+{
+    ULONG ret = 2166136261u;
+    WCHAR c;
+
+    if (!name)
+        return FALSE;
+
+    while ((c = *name++))
+    {
+        if (c <= ' ' || c >= 0x7f || c == '-' || c == '\'')
+            return FALSE;
+        if (c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        ret = (ret ^ c) * 16777619;
+    }
+
+    *hash = ret;
+    return TRUE;
+}
+
+static inline BSTR TLB_get_member_name(ITypeInfoImpl *typeinfo, UINT member)
+{
+    if (member < typeinfo->typeattr.cFuncs)
+        return TLB_get_bstr(typeinfo->funcdescs[member].Name);
+    return TLB_get_bstr(typeinfo->vardescs[member - typeinfo->typeattr.cFuncs].Name);
+}
+
+static struct tlb_name_index *TLB_build_name_index(ITypeInfoImpl *typeinfo)
+{
+    UINT count = typeinfo->typeattr.cFuncs + typeinfo->typeattr.cVars;
+    struct tlb_name_index *index;
+    UINT size = 8, member, i;
+    ULONG hash;
+
+    while (size < count * 2)
+        size *= 2;
+
+    if (!(index = heap_alloc(FIELD_OFFSET(struct tlb_name_index, entries[size]))))
+        return NULL;
+    index->usable = TRUE;
+    index->mask = size - 1;
+    for (i = 0; i < size; i++)
+        index->entries[i].member = TLB_NAME_INDEX_EMPTY;
+
+    /* Functions are inserted first, and only the first member with a
+     * given name is kept, to match the order of a linear search. */
+    for (member = 0; member < count; member++)
+    {
+        BSTR name = TLB_get_member_name(typeinfo, member);
+
+        if (!name)
+            continue;
+        if (!TLB_hash_name(name, &hash))
+        {
+            index->usable = FALSE;
+            break;
+        }
+
+        for (i = hash & index->mask; index->entries[i].member != TLB_NAME_INDEX_EMPTY; i = (i + 1) & index->mask)
+        {
+            if (index->entries[i].hash == hash &&
+                !lstrcmpiW(TLB_get_member_name(typeinfo, index->entries[i].member), name))
+                break;
+        }
+        if (index->entries[i].member == TLB_NAME_INDEX_EMPTY)
+        {
+            index->entries[i].hash = hash;
+            index->entries[i].member = member;
+        }
+    }
+
+    return index;
+}
+
+static void TLB_invalidate_name_index(ITypeInfoImpl *typeinfo)
+{
+    heap_free(InterlockedExchangePointer((void **)&typeinfo->name_index, NULL));
+}
+
+/* Looks up a function or variable by name. Returns FALSE if the name index
+ * can't be used and the caller has to fall back to a linear search. */
+static BOOL TLB_find_member_by_name(ITypeInfoImpl *typeinfo, const OLECHAR *name,
+        const TLBFuncDesc **func, const TLBVarDesc **var)
+{
+    struct tlb_name_index *index;
+    ULONG hash;
+    UINT i;
+
+    *func = NULL;
+    *var = NULL;
+
+    if (!TLB_hash_name(name, &hash))
+        return FALSE;
+
+    if (!(index = typeinfo->name_index))
+    {
+        if (!(index = TLB_build_name_index(typeinfo)))
+            return FALSE;
+        if (InterlockedCompareExchangePointer((void **)&typeinfo->name_index, index, NULL))
+        {
+            heap_free(index);
+            index = typeinfo->name_index;
+        }
+    }
+
+    if (!index->usable)
+        return FALSE;
+
+    for (i = hash & index->mask; index->entries[i].member != TLB_NAME_INDEX_EMPTY; i = (i + 1) & index->mask)
+    {
+        UINT member = index->entries[i].member;
+
+        if (index->entries[i].hash != hash || lstrcmpiW(TLB_get_member_name(typeinfo, member), name))
+            continue;
+
+        if (member < typeinfo->typeattr.cFuncs)
+            *func = &typeinfo->funcdescs[member];
+        else
+            *var = &typeinfo->vardescs[member - typeinfo->typeattr.cFuncs];
+        break;
+    }
+
+    return TRUE;
+}
+
 static inline TLBCustData *TLB_get_custdata_by_guid(const struct list *custdata_list, REFGUID guid)
 {
     TLBCustData *cust_data;
@@ -3277,6 +3423,151 @@ static HRESULT TLB_Mapping_Open(LPCWSTR path, LPVOID *ppBase, DWORD *pdwTLBLengt
     return TYPE_E_CANTLOADLIBRARY;
 }
 
+/* Optional on-disk cache of the type libraries embedded in PE and NE files,
+ * so that other processes can map them instead of loading the module and
+ * looking up its resources. Entries are keyed by module path and typelib
+ * index, and checked against the module's last write time and size. */
+
+#define TLB_DISK_CACHE_MAGIC   0x43424c54  /* "TLBC" */
+#define TLB_DISK_CACHE_VERSION 1
+
+struct tlb_disk_cache_header
+{
+    DWORD    magic;
+    DWORD    version;
+    FILETIME write_time;   /* last write time of the module */
+    DWORD    size_low;     /* size of the module */
+    DWORD    size_high;
+    INT      index;        /* index of the TYPELIB resource */
+    DWORD    path_len;     /* length of the module path in WCHARs, including the null */
+    DWORD    data_offset;  /* offset of the type library data */
+    DWORD    data_size;
+    /* WCHAR path[path_len]; */
+};
+
+static BOOL tlb_disk_cache_enabled(void)
+{
+    DWORD type, value = 0, size = sizeof(value);
+    HKEY key;
+
+    /* @@ Wine registry key: HKCU\Software\Wine\OleAut32 */
+    if (!RegOpenKeyW( HKEY_CURRENT_USER, L"Software\\Wine\\OleAut32", &key ))
+    {
+        if (RegQueryValueExW( key, L"TypeLibCache", NULL, &type, (BYTE *)&value, &size ) || type != REG_DWORD)
+            value = 0;
+        RegCloseKey( key );
+    }
+    return value != 0;
+}
+
+static void get_tlb_disk_cache_path( const WCHAR *path, INT index, WCHAR *buffer )
+{
+    ULONGLONG hash = 0xcbf29ce484222325ull;
+    const WCHAR *p;
+
+    for (p = path; *p; p++) hash = (hash ^ towupper( *p )) * 0x100000001b3ull;
+    hash = (hash ^ (DWORD)index) * 0x100000001b3ull;
+
+    GetSystemDirectoryW( buffer, MAX_PATH - 32 );
+    swprintf( buffer + lstrlenW( buffer ), 32, L"\\tlbcache\\%08x%08x.tlb",
+              (DWORD)(hash >> 32), (DWORD)hash );
+}
+
+static HRESULT TLB_DiskCache_Open(LPCWSTR path, INT index, LPVOID *ppBase, DWORD *pdwTLBLength, IUnknown **ppFile)
+{
+    const struct tlb_disk_cache_header *header;
+    WIN32_FILE_ATTRIBUTE_DATA info;
+    WCHAR cache_path[MAX_PATH];
+    IUnknown *file;
+    DWORD size;
+    void *base;
+
+    if (!tlb_disk_cache_enabled()) return TYPE_E_CANTLOADLIBRARY;
+    if (!GetFileAttributesExW( path, GetFileExInfoStandard, &info )) return TYPE_E_CANTLOADLIBRARY;
+
+    get_tlb_disk_cache_path( path, index, cache_path );
+    if (FAILED(TLB_Mapping_Open( cache_path, &base, &size, &file ))) return TYPE_E_CANTLOADLIBRARY;
+
+    header = base;
+    if (size >= sizeof(*header) &&
+        header->magic == TLB_DISK_CACHE_MAGIC &&
+        header->version == TLB_DISK_CACHE_VERSION &&
+        !CompareFileTime( &header->write_time, &info.ftLastWriteTime ) &&
+        header->size_low == info.nFileSizeLow &&
+        header->size_high == info.nFileSizeHigh &&
+        header->index == index &&
+        header->path_len && header->path_len <= (size - sizeof(*header)) / sizeof(WCHAR) &&
+        header->data_offset >= sizeof(*header) + header->path_len * sizeof(WCHAR) &&
+        header->data_offset <= size && header->data_size <= size - header->data_offset)
+    {
+        const WCHAR *cached_path = (const WCHAR *)(header + 1);
+
+        if (!cached_path[header->path_len - 1] && !wcsicmp( cached_path, path ))
+        {
+            TRACE("using cached type library %s for %s\n", debugstr_w(cache_path), debugstr_w(path));
+            *ppBase = (char *)base + header->data_offset;
+            *pdwTLBLength = header->data_size;
+            *ppFile = file;
+            return S_OK;
+        }
+    }
+
+    TRACE("stale cached type library %s for %s\n", debugstr_w(cache_path), debugstr_w(path));
+    IUnknown_Release( file );
+    return TYPE_E_CANTLOADLIBRARY;
+}
+
+/* Write through a temporary file and a rename, so that other processes
+ * never map a partially written entry. */
+static void TLB_DiskCache_Store(LPCWSTR path, INT index, const void *data, DWORD size)
+{
+    struct tlb_disk_cache_header header;
+    WIN32_FILE_ATTRIBUTE_DATA info;
+    WCHAR cache_path[MAX_PATH], temp_path[MAX_PATH], *p;
+    DWORD written;
+    HANDLE file;
+    BOOL ret;
+
+    if (!tlb_disk_cache_enabled()) return;
+    if (!GetFileAttributesExW( path, GetFileExInfoStandard, &info )) return;
+
+    get_tlb_disk_cache_path( path, index, cache_path );
+    p = wcsrchr( cache_path, '\\' );
+    *p = 0;
+    CreateDirectoryW( cache_path, NULL );
+    ret = GetTempFileNameW( cache_path, L"tlb", 0, temp_path );
+    *p = '\\';
+    if (!ret) return;
+
+    header.magic       = TLB_DISK_CACHE_MAGIC;
+    header.version     = TLB_DISK_CACHE_VERSION;
+    header.write_time  = info.ftLastWriteTime;
+    header.size_low    = info.nFileSizeLow;
+    header.size_high   = info.nFileSizeHigh;
+    header.index       = index;
+    header.path_len    = lstrlenW( path ) + 1;
+    header.data_offset = (sizeof(header) + header.path_len * sizeof(WCHAR) + 7) & ~7;
+    header.data_size   = size;
+
+    file = CreateFileW( temp_path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL );
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        DeleteFileW( temp_path );
+        return;
+    }
+    ret = WriteFile( file, &header, sizeof(header), &written, NULL ) &&
+          WriteFile( file, path, header.path_len * sizeof(WCHAR), &written, NULL ) &&
+          SetFilePointer( file, header.data_offset, NULL, FILE_BEGIN ) == header.data_offset &&
+          WriteFile( file, data, size, &written, NULL ) && written == size;
+    CloseHandle( file );
+
+    if (!ret || !MoveFileExW( temp_path, cache_path, MOVEFILE_REPLACE_EXISTING ))
+    {
+        WARN("failed to cache type library %s in %s\n", debugstr_w(path), debugstr_w(cache_path));
+        DeleteFileW( temp_path );
+    }
+}
+
 /****************************************************************************
  *	TLB_ReadTypeLib
  *
@@ -3294,6 +3585,7 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
     LPVOID pBase = NULL;
     DWORD dwTLBLength = 0;
     IUnknown *pFile = NULL;
+    BOOL from_module = FALSE;
     HANDLE h;
 
     *ppTypeLib = NULL;
@@ -3354,9 +3646,14 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
 
     /* now actually load and parse the typelib */
 
-    ret = TLB_PEFile_Open(pszPath, index, &pBase, &dwTLBLength, &pFile);
+    ret = TLB_DiskCache_Open(pszPath, index, &pBase, &dwTLBLength, &pFile);
     if (ret == TYPE_E_CANTLOADLIBRARY)
-        ret = TLB_NEFile_Open(pszPath, index, &pBase, &dwTLBLength, &pFile);
+    {
+        ret = TLB_PEFile_Open(pszPath, index, &pBase, &dwTLBLength, &pFile);
+        if (ret == TYPE_E_CANTLOADLIBRARY)
+            ret = TLB_NEFile_Open(pszPath, index, &pBase, &dwTLBLength, &pFile);
+        from_module = SUCCEEDED(ret);
+    }
     if (ret == TYPE_E_CANTLOADLIBRARY)
         ret = TLB_Mapping_Open(pszPath, &pBase, &dwTLBLength, &pFile);
     if (SUCCEEDED(ret))
@@ -3376,6 +3673,8 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
         }
         else
             ret = TYPE_E_CANTLOADLIBRARY;
+        if (*ppTypeLib && from_module)
+            TLB_DiskCache_Store(pszPath, index, pBase, dwTLBLength);
         IUnknown_Release(pFile);
     }
 
@@ -5638,6 +5937,7 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
 
     TLB_FreeCustData(&This->custdata_list);
 
+    heap_free(This->name_index);
     heap_free(This);
 }
 
@@ -6286,6 +6586,7 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
         LPOLESTR  *rgszNames, UINT cNames, MEMBERID  *pMemId)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
+    const TLBFuncDesc *pFDesc;
     const TLBVarDesc *pVDesc;
     HRESULT ret=S_OK;
     UINT i, fdc;
@@ -6297,25 +6598,32 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
     for (i = 0; i < cNames; i++)
         pMemId[i] = MEMBERID_NIL;
 
-    for (fdc = 0; fdc < This->typeattr.cFuncs; ++fdc) {
-        int j;
-        const TLBFuncDesc *pFDesc = &This->funcdescs[fdc];
-        if(!lstrcmpiW(*rgszNames, TLB_get_bstr(pFDesc->Name))) {
-            if(cNames) *pMemId=pFDesc->funcdesc.memid;
-            for(i=1; i < cNames; i++){
-                for(j=0; j<pFDesc->funcdesc.cParams; j++)
-                    if(!lstrcmpiW(rgszNames[i],TLB_get_bstr(pFDesc->pParamDesc[j].Name)))
-                            break;
-                if( j<pFDesc->funcdesc.cParams)
-                    pMemId[i]=j;
-                else
-                   ret=DISP_E_UNKNOWNNAME;
-            };
-            TRACE("-- 0x%08x\n", ret);
-            return ret;
+    if (!TLB_find_member_by_name(This, *rgszNames, &pFDesc, &pVDesc)) {
+        for (fdc = 0; fdc < This->typeattr.cFuncs; ++fdc) {
+            if(!lstrcmpiW(*rgszNames, TLB_get_bstr(This->funcdescs[fdc].Name))) {
+                pFDesc = &This->funcdescs[fdc];
+                break;
+            }
         }
+        if (!pFDesc)
+            pVDesc = TLB_get_vardesc_by_name(This, *rgszNames);
+    }
+
+    if (pFDesc) {
+        int j;
+        if(cNames) *pMemId=pFDesc->funcdesc.memid;
+        for(i=1; i < cNames; i++){
+            for(j=0; j<pFDesc->funcdesc.cParams; j++)
+                if(!lstrcmpiW(rgszNames[i],TLB_get_bstr(pFDesc->pParamDesc[j].Name)))
+                        break;
+            if( j<pFDesc->funcdesc.cParams)
+                pMemId[i]=j;
+            else
+               ret=DISP_E_UNKNOWNNAME;
+        };
+        TRACE("-- 0x%08x\n", ret);
+        return ret;
     }
-    pVDesc = TLB_get_vardesc_by_name(This, *rgszNames);
     if(pVDesc){
         if(cNames)
             *pMemId = pVDesc->vardesc.memid;
@@ -10892,6 +11200,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnAddFuncDesc(ICreateTypeInfo2 *iface,
     list_init(&func_desc->custdata_list);
 
     ++This->typeattr.cFuncs;
+    TLB_invalidate_name_index(This);
 
     This->needs_layout = TRUE;
 
@@ -11048,6 +11357,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnAddVarDesc(ICreateTypeInfo2 *iface,
     var_desc->vardesc = *var_desc->vardesc_create;
 
     ++This->typeattr.cVars;
+    TLB_invalidate_name_index(This);
 
     This->needs_layout = TRUE;
 
@@ -11088,6 +11398,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetFuncAndParamNames(ICreateTypeInfo2 *
     }
 
     func_desc->Name = TLB_append_str(&This->pTypeLib->name_list, *names);
+    TLB_invalidate_name_index(This);
 
     for (i = 1; i < numNames; ++i) {
         TLBParDesc *par_desc = func_desc->pParamDesc + i - 1;
@@ -11111,6 +11422,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetVarName(ICreateTypeInfo2 *iface,
         return TYPE_E_ELEMENTNOTFOUND;
 
     This->vardescs[index].Name = TLB_append_str(&This->pTypeLib->name_list, name);
+    TLB_invalidate_name_index(This);
     return S_OK;
 }
 
@@ -11396,6 +11708,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnDeleteFuncDesc(ICreateTypeInfo2 *iface,
             TLB_relink_custdata(&This->funcdescs[i].custdata_list);
     }
 
+    TLB_invalidate_name_index(This);
     This->needs_layout = TRUE;
 
     return S_OK;
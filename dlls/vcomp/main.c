@@ -44,6 +44,7 @@ static HMODULE vcomp_module;
 static int     vcomp_max_threads;
 static int     vcomp_num_threads;
 static BOOL    vcomp_nested_fork = FALSE;
+static int     vcomp_spin_count;
 
 static RTL_CRITICAL_SECTION vcomp_section;
 static RTL_CRITICAL_SECTION_DEBUG critsect_debug =
@@ -88,7 +89,7 @@ struct vcomp_team_data
 {
     CONDITION_VARIABLE      cond;
     int                     num_threads;
-    int                     finished_threads;
+    int volatile            finished_threads;
 
     /* callback arguments */
     int                     nargs;
@@ -96,8 +97,9 @@ struct vcomp_team_data
     __ms_va_list            valist;
 
     /* barrier */
-    unsigned int            barrier;
-    int                     barrier_count;
+    unsigned int volatile   barrier;
+    LONG                    barrier_count;
+    LONG                    barrier_sleepers;
 };
 
 struct vcomp_task_data
@@ -117,6 +119,8 @@ struct vcomp_task_data
     unsigned int            dynamic_iterations;
     int                     dynamic_step;
     unsigned int            dynamic_chunksize;
+    /* generation in the high, iterations handed out in the low 32 bits */
+    LONG64 volatile         dynamic_next;
 };
 
 static void **ptr_from_va_list(__ms_va_list valist)
@@ -410,6 +414,7 @@ static struct vcomp_thread_data *vcomp_init_thread_data(void)
     data->task.single           = 0;
     data->task.section          = 0;
     data->task.dynamic          = 0;
+    data->task.dynamic_next     = 0;
 
     thread_data = &data->thread;
     thread_data->team           = NULL;
@@ -1056,26 +1061,39 @@ void CDECL _vcomp_flush(void)
 void CDECL _vcomp_barrier(void)
 {
     struct vcomp_team_data *team_data = vcomp_init_thread_data()->team;
+    unsigned int barrier;
+    int i;
 
     TRACE("()\n");
 
     if (!team_data)
         return;
 
-    EnterCriticalSection(&vcomp_section);
-    if (++team_data->barrier_count >= team_data->num_threads)
+    barrier = team_data->barrier;
+    if (InterlockedIncrement(&team_data->barrier_count) >= team_data->num_threads)
     {
-        team_data->barrier++;
         team_data->barrier_count = 0;
-        WakeAllConditionVariable(&team_data->cond);
+        InterlockedIncrement((LONG *)&team_data->barrier);
+        if (team_data->barrier_sleepers)
+        {
+            EnterCriticalSection(&vcomp_section);
+            WakeAllConditionVariable(&team_data->cond);
+            LeaveCriticalSection(&vcomp_section);
+        }
+        return;
     }
-    else
+
+    for (i = 0; i < vcomp_spin_count && team_data->barrier == barrier; i++)
+        YieldProcessor();
+    if (team_data->barrier == barrier)
     {
-        unsigned int barrier = team_data->barrier;
+        EnterCriticalSection(&vcomp_section);
+        InterlockedIncrement(&team_data->barrier_sleepers);
         while (team_data->barrier == barrier)
             SleepConditionVariableCS(&team_data->cond, &vcomp_section, INFINITE);
+        InterlockedDecrement(&team_data->barrier_sleepers);
+        LeaveCriticalSection(&vcomp_section);
     }
-    LeaveCriticalSection(&vcomp_section);
 }
 
 void CDECL _vcomp_set_num_threads(int num_threads)
@@ -1346,6 +1364,13 @@ void CDECL _vcomp_for_dynamic_init(unsigned int flags, unsigned int first, unsig
         thread_data->dynamic_type = type;
         if ((int)(thread_data->dynamic - task_data->dynamic) > 0)
         {
+            /* Bump the generation first, so threads still in the previous
+             * loop fail their compare-exchange instead of using new bounds. */
+            LONG64 next = task_data->dynamic_next, prev;
+            do prev = next;
+            while ((next = InterlockedCompareExchange64(&task_data->dynamic_next,
+                    (LONG64)((ULONG64)thread_data->dynamic << 32), prev)) != prev);
+
             task_data->dynamic              = thread_data->dynamic;
             task_data->dynamic_first        = first;
             task_data->dynamic_last         = last;
@@ -1376,26 +1401,44 @@ int CDECL _vcomp_for_dynamic_next(unsigned int *begin, unsigned int *end)
     else if (thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_CHUNKED ||
              thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_GUIDED)
     {
-        unsigned int iterations = 0;
-        EnterCriticalSection(&vcomp_section);
-        if (thread_data->dynamic == task_data->dynamic &&
-            task_data->dynamic_iterations != 0)
+        unsigned int iterations, remaining, taken, first, last;
+        LONG64 next, prev;
+        int step;
+
+        for (prev = task_data->dynamic_next;; prev = next)
         {
-            iterations = min(task_data->dynamic_iterations, task_data->dynamic_chunksize);
+            if ((unsigned int)((ULONG64)prev >> 32) != thread_data->dynamic)
+                return 0;
+
+            /* With nowait loops another thread may already be initializing the
+             * next loop, read the bounds before the compare-exchange validates
+             * the generation. */
+            first     = task_data->dynamic_first;
+            last      = task_data->dynamic_last;
+            step      = task_data->dynamic_step;
+            taken     = (unsigned int)prev;
+            remaining = task_data->dynamic_iterations - taken;
+            if (!remaining)
+                return 0;
+
+            iterations = min(remaining, task_data->dynamic_chunksize);
             if (thread_data->dynamic_type == VCOMP_DYNAMIC_FLAGS_GUIDED &&
-                task_data->dynamic_iterations > num_threads * task_data->dynamic_chunksize)
+                remaining > num_threads * task_data->dynamic_chunksize)
             {
-                iterations = (task_data->dynamic_iterations + num_threads - 1) / num_threads;
+                iterations = (remaining + num_threads - 1) / num_threads;
             }
-            *begin = task_data->dynamic_first;
-            *end   = task_data->dynamic_first + (iterations - 1) * task_data->dynamic_step;
-            task_data->dynamic_iterations -= iterations;
-            task_data->dynamic_first      += iterations * task_data->dynamic_step;
-            if (!task_data->dynamic_iterations)
-                *end = task_data->dynamic_last;
+            if (!iterations)
+                return 0;
+
+            next = InterlockedCompareExchange64(&task_data->dynamic_next, prev + iterations, prev);
+            if (next == prev) break;
         }
-        LeaveCriticalSection(&vcomp_section);
-        return iterations != 0;
+
+        *begin = first + taken * step;
+        *end   = *begin + (iterations - 1) * step;
+        if (iterations == remaining)
+            *end = last;
+        return 1;
     }
 
     return 0;
@@ -1429,6 +1472,19 @@ static DWORD WINAPI _vcomp_fork_worker(void *param)
             list_add_tail(&vcomp_idle_threads, &thread_data->entry);
             if (++team->finished_threads >= team->num_threads)
                 WakeAllConditionVariable(&team->cond);
+
+            /* stay hot for a while, parallel regions often come in quick succession */
+            if (vcomp_spin_count)
+            {
+                struct vcomp_team_data * volatile *next_team = &thread_data->team;
+                int i;
+
+                LeaveCriticalSection(&vcomp_section);
+                for (i = 0; i < vcomp_spin_count && !*next_team; i++)
+                    YieldProcessor();
+                EnterCriticalSection(&vcomp_section);
+                if (thread_data->team) continue;
+            }
         }
 
         if (!SleepConditionVariableCS(&thread_data->cond, &vcomp_section, 5000) &&
@@ -1476,10 +1532,12 @@ void WINAPIV _vcomp_fork(BOOL ifval, int nargs, void *wrapper, ...)
     __ms_va_start(team_data.valist, wrapper);
     team_data.barrier           = 0;
     team_data.barrier_count     = 0;
+    team_data.barrier_sleepers  = 0;
 
     task_data.single            = 0;
     task_data.section           = 0;
     task_data.dynamic           = 0;
+    task_data.dynamic_next      = 0;
 
     thread_data.team            = &team_data;
     thread_data.task            = &task_data;
@@ -1561,6 +1619,11 @@ void WINAPIV _vcomp_fork(BOOL ifval, int nargs, void *wrapper, ...)
 
     if (team_data.num_threads > 1)
     {
+        int i;
+
+        for (i = 0; i < vcomp_spin_count && team_data.finished_threads < team_data.num_threads - 1; i++)
+            YieldProcessor();
+
         EnterCriticalSection(&vcomp_section);
 
         team_data.finished_threads++;
@@ -1823,6 +1886,25 @@ void WINAPIV C2VectParallel(int start, int end, int step, BOOL end_included, int
     __ms_va_end(valist);
 }
 
+static void vcomp_init_wait_policy(DWORD num_procs)
+{
+    char policy[16];
+
+    /* spinning would only steal the time slice of the thread we wait for */
+    if (num_procs <= 1)
+        return;
+
+    vcomp_spin_count = 20000;
+    if (GetEnvironmentVariableA("OMP_WAIT_POLICY", policy, sizeof(policy)) < sizeof(policy))
+    {
+        if (!lstrcmpiA(policy, "ACTIVE"))
+            vcomp_spin_count = 2000000;
+        else if (!lstrcmpiA(policy, "PASSIVE"))
+            vcomp_spin_count = 0;
+    }
+    TRACE("spin count %d\n", vcomp_spin_count);
+}
+
 BOOL WINAPI DllMain(HINSTANCE instance, DWORD reason, LPVOID reserved)
 {
     TRACE("(%p, %d, %p)\n", instance, reason, reserved);
@@ -1843,6 +1925,7 @@ BOOL WINAPI DllMain(HINSTANCE instance, DWORD reason, LPVOID reserved)
             vcomp_module      = instance;
             vcomp_max_threads = sysinfo.dwNumberOfProcessors;
             vcomp_num_threads = sysinfo.dwNumberOfProcessors;
+            vcomp_init_wait_policy(sysinfo.dwNumberOfProcessors);
             break;
         }
 
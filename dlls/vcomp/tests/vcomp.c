@@ -1211,6 +1211,54 @@ static void CDECL for_dynamic_guided_cb(unsigned int flags, LONG *a, LONG *b, LO
     }
 }
 
+#define NOWAIT_ITERATIONS 2000
+
+static void CDECL for_dynamic_nowait_cb(LONG *first, LONG *second)
+{
+    unsigned int begin, end, i;
+
+    p_vcomp_for_dynamic_init(VCOMP_DYNAMIC_FLAGS_CHUNKED | VCOMP_DYNAMIC_FLAGS_INCREMENT,
+                             0, NOWAIT_ITERATIONS - 1, 1, 1);
+    while (p_vcomp_for_dynamic_next(&begin, &end))
+    {
+        for (i = begin; i <= end; i++)
+            InterlockedIncrement(&first[i < NOWAIT_ITERATIONS ? i : NOWAIT_ITERATIONS]);
+    }
+
+    p_vcomp_for_dynamic_init(VCOMP_DYNAMIC_FLAGS_GUIDED,
+                             3 * NOWAIT_ITERATIONS - 1, 2 * NOWAIT_ITERATIONS, 1, 1);
+    while (p_vcomp_for_dynamic_next(&begin, &end))
+    {
+        for (i = begin;; i--)
+        {
+            if (i < 2 * NOWAIT_ITERATIONS || i >= 3 * NOWAIT_ITERATIONS)
+                InterlockedIncrement(&second[NOWAIT_ITERATIONS]);
+            else
+                InterlockedIncrement(&second[i - 2 * NOWAIT_ITERATIONS]);
+            if (i <= end) break;
+        }
+    }
+}
+
+static void for_dynamic_nowait_test(void)
+{
+    static LONG first[NOWAIT_ITERATIONS + 1], second[NOWAIT_ITERATIONS + 1];
+    int i, round;
+
+    memset(first, 0, sizeof(first));
+    memset(second, 0, sizeof(second));
+    for (round = 0; round < 50; round++)
+        p_vcomp_fork(TRUE, 2, for_dynamic_nowait_cb, first, second);
+
+    ok(!first[NOWAIT_ITERATIONS], "got %d iterations outside of the first loop\n", first[NOWAIT_ITERATIONS]);
+    ok(!second[NOWAIT_ITERATIONS], "got %d iterations outside of the second loop\n", second[NOWAIT_ITERATIONS]);
+    for (i = 0; i < NOWAIT_ITERATIONS; i++)
+    {
+        if (first[i] != 50 || second[i] != 50) break;
+    }
+    ok(i == NOWAIT_ITERATIONS, "iteration %d ran %d and %d times\n", i, first[i], second[i]);
+}
+
 static void test_vcomp_for_dynamic_init(void)
 {
     static const int guided_a[] = {0, 6041, 9072, 11179};
@@ -1312,9 +1360,99 @@ static void test_vcomp_for_dynamic_init(void)
         ok(d == guided_d[0], "expected d == %d, got %d\n", guided_d[0], d);
     }
 
+    /* test back-to-back loops without a barrier in between */
+    for (i = 2; i <= 4; i++)
+    {
+        pomp_set_num_threads(i);
+        for_dynamic_nowait_test();
+    }
+
     pomp_set_num_threads(max_threads);
 }
 
+#define EPCC_REPS 2000
+
+static void CDECL epcc_empty_cb(void)
+{
+}
+
+static void CDECL epcc_barrier_cb(LONG *count)
+{
+    int num_threads = pomp_get_num_threads();
+    LONG value;
+    int i;
+
+    for (i = 0; i < EPCC_REPS; i++)
+    {
+        InterlockedIncrement(count);
+        p_vcomp_barrier();
+        value = *(LONG volatile *)count;
+        ok(value == (i + 1) * num_threads, "expected count %d, got %d\n", (i + 1) * num_threads, value);
+        p_vcomp_barrier();
+    }
+}
+
+static void CDECL epcc_dynamic_cb(LONG64 *sum)
+{
+    unsigned int begin, end, i;
+    LONG64 local = 0;
+
+    p_vcomp_for_dynamic_init(VCOMP_DYNAMIC_FLAGS_CHUNKED | VCOMP_DYNAMIC_FLAGS_INCREMENT,
+                             0, 100 * EPCC_REPS - 1, 1, 1);
+    while (p_vcomp_for_dynamic_next(&begin, &end))
+    {
+        for (i = begin; i <= end; i++)
+            local += i;
+    }
+    p_vcomp_atomic_add_i8(sum, local);
+}
+
+static double epcc_elapsed(LARGE_INTEGER *start)
+{
+    LARGE_INTEGER end, freq;
+
+    QueryPerformanceCounter(&end);
+    QueryPerformanceFrequency(&freq);
+    return (end.QuadPart - start->QuadPart) * 1000000.0 / freq.QuadPart;
+}
+
+static void test_epcc_overhead(void)
+{
+    int num_threads = pomp_get_max_threads();
+    double serial, fork, barrier, dynamic;
+    LARGE_INTEGER start;
+    LONG64 sum;
+    LONG count;
+    int i;
+
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < EPCC_REPS; i++)
+        p_vcomp_fork(FALSE, 0, epcc_empty_cb);
+    serial = epcc_elapsed(&start);
+
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < EPCC_REPS; i++)
+        p_vcomp_fork(TRUE, 0, epcc_empty_cb);
+    fork = epcc_elapsed(&start);
+
+    count = 0;
+    QueryPerformanceCounter(&start);
+    p_vcomp_fork(TRUE, 1, epcc_barrier_cb, &count);
+    barrier = epcc_elapsed(&start);
+    ok(count == EPCC_REPS * num_threads, "expected count %d, got %d\n", EPCC_REPS * num_threads, count);
+
+    sum = 0;
+    QueryPerformanceCounter(&start);
+    p_vcomp_fork(TRUE, 1, epcc_dynamic_cb, &sum);
+    dynamic = epcc_elapsed(&start);
+    ok(sum == (LONG64)(100 * EPCC_REPS) * (100 * EPCC_REPS - 1) / 2,
+       "got wrong sum %s\n", wine_dbgstr_longlong(sum));
+
+    trace("%d threads: parallel %.2f us, serial %.2f us, barrier %.2f us, dynamic chunk %.3f us\n",
+          num_threads, fork / EPCC_REPS, serial / EPCC_REPS, barrier / (2 * EPCC_REPS),
+          dynamic / (100 * EPCC_REPS));
+}
+
 static void CDECL master_cb(HANDLE semaphore)
 {
     int num_threads = pomp_get_num_threads();
@@ -2238,6 +2376,7 @@ START_TEST(vcomp)
     test_reduction_integer32();
     test_reduction_integer64();
     test_reduction_float_double();
+    test_epcc_overhead();
 
     release_vcomp();
 }
@@ -131,6 +131,358 @@ static void to_sRGB(BYTE *bgr)
 }
 #endif
 
+/* Byte results of to_sRGB_component(): srgb_thresholds[v] is the smallest
+ * linear value that encodes to at least v, srgb_coarse[] gives a starting
+ * point that is at most a few steps below the result. */
+#define SRGB_COARSE_STEPS 1024
+static float srgb_thresholds[256];
+static BYTE srgb_coarse[SRGB_COARSE_STEPS + 1];
+static UINT unpremultiply_recip[256];
+static INIT_ONCE init_tables_once = INIT_ONCE_STATIC_INIT;
+
+static inline BYTE to_sRGB_byte_slow(float f)
+{
+    return (BYTE)floorf(to_sRGB_component(f) * 255.0f + 0.51f);
+}
+
+static BOOL WINAPI init_conversion_tables(INIT_ONCE *once, void *param, void **context)
+{
+    union { float f; UINT i; } lo, hi, mid, one = { 1.0f };
+    UINT i;
+
+    srgb_thresholds[0] = 0.0f;
+    for (i = 1; i < 256; i++)
+    {
+        /* positive floats sort like their bit patterns */
+        lo.i = 0;
+        hi.i = one.i;
+        while (hi.i - lo.i > 1)
+        {
+            mid.i = lo.i + (hi.i - lo.i) / 2;
+            if (to_sRGB_byte_slow(mid.f) >= i) hi.i = mid.i;
+            else lo.i = mid.i;
+        }
+        srgb_thresholds[i] = hi.f;
+    }
+
+    for (i = 0; i <= SRGB_COARSE_STEPS; i++)
+        srgb_coarse[i] = to_sRGB_byte_slow(i / (float)SRGB_COARSE_STEPS);
+
+    /* (x * 255 * recip) >> 24 == x * 255 / alpha for all x, alpha < 256 */
+    unpremultiply_recip[0] = 0;
+    for (i = 1; i < 256; i++)
+        unpremultiply_recip[i] = ((1 << 24) + i - 1) / i;
+
+    return TRUE;
+}
+
+static inline void init_tables(void)
+{
+    InitOnceExecuteOnce(&init_tables_once, init_conversion_tables, NULL, NULL);
+}
+
+/* same result as to_sRGB_byte_slow() */
+static inline BYTE to_sRGB_byte(float f)
+{
+    BYTE v;
+
+    if (!(f >= 0.0f && f <= 1.0f)) return to_sRGB_byte_slow(f);
+
+    v = srgb_coarse[(UINT)(f * SRGB_COARSE_STEPS)];
+    while (v < 255 && f >= srgb_thresholds[v + 1]) v++;
+    return v;
+}
+
+/* Row conversion kernels. These are kept simple enough for the compiler to
+ * vectorize; src and dst may be the same row for 32bpp -> 32bpp kernels. */
+typedef void (*convert_row_func)(const BYTE *src, BYTE *dst, UINT width);
+
+static void convert_row_24bppBGR_to_32bppBGRA(const BYTE *src, BYTE *dst, UINT width)
+{
+    DWORD *dstpixel = (DWORD *)dst;
+    UINT x;
+
+    for (x = 0; x < width; x++, src += 3)
+        dstpixel[x] = 0xff000000 | src[2] << 16 | src[1] << 8 | src[0];
+}
+
+static void convert_row_24bppRGB_to_32bppBGRA(const BYTE *src, BYTE *dst, UINT width)
+{
+    DWORD *dstpixel = (DWORD *)dst;
+    UINT x;
+
+    for (x = 0; x < width; x++, src += 3)
+        dstpixel[x] = 0xff000000 | src[0] << 16 | src[1] << 8 | src[2];
+}
+
+static void convert_row_set_alpha(const BYTE *src, BYTE *dst, UINT width)
+{
+    const DWORD *srcpixel = (const DWORD *)src;
+    DWORD *dstpixel = (DWORD *)dst;
+    UINT x;
+
+    for (x = 0; x < width; x++)
+        dstpixel[x] = srcpixel[x] | 0xff000000;
+}
+
+static void convert_row_swap_rb(const BYTE *src, BYTE *dst, UINT width)
+{
+    const DWORD *srcpixel = (const DWORD *)src;
+    DWORD *dstpixel = (DWORD *)dst;
+    UINT x;
+
+    for (x = 0; x < width; x++)
+    {
+        DWORD pixel = srcpixel[x];
+        dstpixel[x] = (pixel & 0xff00ff00) | (pixel >> 16 & 0xff) | (pixel & 0xff) << 16;
+    }
+}
+
+static void convert_row_premultiply(const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++, src += 4, dst += 4)
+    {
+        UINT alpha = src[3];
+        dst[0] = src[0] * alpha / 255;
+        dst[1] = src[1] * alpha / 255;
+        dst[2] = src[2] * alpha / 255;
+        dst[3] = alpha;
+    }
+}
+
+static void convert_row_unpremultiply(const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++, src += 4, dst += 4)
+    {
+        UINT alpha = src[3];
+        ULONGLONG recip = unpremultiply_recip[alpha];
+        if (alpha != 0 && alpha != 255)
+        {
+            dst[0] = (src[0] * 255 * recip) >> 24;
+            dst[1] = (src[1] * 255 * recip) >> 24;
+            dst[2] = (src[2] * 255 * recip) >> 24;
+        }
+        else
+        {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+        }
+        dst[3] = alpha;
+    }
+}
+
+static void convert_row_32bppBGRA_to_24bppBGR(const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++, src += 4, dst += 3)
+    {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+    }
+}
+
+static void convert_row_32bppBGRA_to_24bppRGB(const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++, src += 4, dst += 3)
+    {
+        dst[0] = src[2];
+        dst[1] = src[1];
+        dst[2] = src[0];
+    }
+}
+
+static void convert_row_48bppRGB_to_32bppBGRA(const BYTE *src, BYTE *dst, UINT width)
+{
+    DWORD *dstpixel = (DWORD *)dst;
+    UINT x;
+
+    for (x = 0; x < width; x++, src += 6)
+        dstpixel[x] = 0xff000000 | src[1] << 16 | src[3] << 8 | src[5];
+}
+
+static void convert_row_64bppRGBA_to_32bppBGRA(const BYTE *src, BYTE *dst, UINT width)
+{
+    DWORD *dstpixel = (DWORD *)dst;
+    UINT x;
+
+    for (x = 0; x < width; x++, src += 8)
+        dstpixel[x] = src[7] << 24 | src[1] << 16 | src[3] << 8 | src[5];
+}
+
+static void convert_row_32bppCMYK_to_32bppBGRA(const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++, src += 4, dst += 4)
+    {
+        UINT c = src[0], m = src[1], y = src[2], k = src[3];
+        dst[0] = (255 - y) * (255 - k) / 255; /* blue */
+        dst[1] = (255 - m) * (255 - k) / 255; /* green */
+        dst[2] = (255 - c) * (255 - k) / 255; /* red */
+        dst[3] = 255; /* alpha */
+    }
+}
+
+static void convert_row_32bppCMYK_to_24bppBGR(const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++, src += 4, dst += 3)
+    {
+        UINT c = src[0], m = src[1], y = src[2], k = src[3];
+        dst[0] = (255 - y) * (255 - k) / 255; /* blue */
+        dst[1] = (255 - m) * (255 - k) / 255; /* green */
+        dst[2] = (255 - c) * (255 - k) / 255; /* red */
+    }
+}
+
+static void convert_row_32bppBGRA_to_32bppGrayFloat(const BYTE *src, BYTE *dst, UINT width)
+{
+    float *dstpixel = (float *)dst;
+    UINT x;
+
+    for (x = 0; x < width; x++, src += 4)
+        dstpixel[x] = (src[2] * 0.2126f + src[1] * 0.7152f + src[0] * 0.0722f) / 255.0f;
+}
+
+static void convert_row_32bppGrayFloat_to_24bppBGR(const BYTE *src, BYTE *dst, UINT width)
+{
+    const float *srcpixel = (const float *)src;
+    UINT x;
+
+    for (x = 0; x < width; x++, dst += 3)
+        dst[0] = dst[1] = dst[2] = to_sRGB_byte(srcpixel[x]);
+}
+
+static void convert_row_32bppGrayFloat_to_8bppGray(const BYTE *src, BYTE *dst, UINT width)
+{
+    const float *srcpixel = (const float *)src;
+    UINT x;
+
+    for (x = 0; x < width; x++)
+        dst[x] = to_sRGB_byte(srcpixel[x]);
+}
+
+static void convert_row_24bppBGR_to_8bppGray(const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++, src += 3)
+        dst[x] = to_sRGB_byte((src[2] * 0.2126f + src[1] * 0.7152f + src[0] * 0.0722f) / 255.0f);
+}
+
+/* Large rectangles are split into bands of rows and converted on the thread
+ * pool. Only the conversion itself is parallel, the source is always read
+ * from the calling thread. The caller takes bands too and only waits for the
+ * ones already running, callbacks starting late find nothing left to do. */
+#define CONVERT_PARALLEL_MIN_PIXELS (256 * 1024)
+#define CONVERT_BAND_MIN_PIXELS     (64 * 1024)
+#define CONVERT_MAX_THREADS         8
+
+struct convert_rows_job
+{
+    convert_row_func func;
+    const BYTE *src;
+    BYTE *dst;
+    UINT srcstride, dststride, width, height;
+    UINT band_rows, bands;
+    LONG next_band;
+    LONG remaining;
+    LONG ref;
+    HANDLE done;
+};
+
+static void convert_rows_job_release(struct convert_rows_job *job)
+{
+    if (InterlockedDecrement(&job->ref)) return;
+    CloseHandle(job->done);
+    HeapFree(GetProcessHeap(), 0, job);
+}
+
+static void convert_bands(struct convert_rows_job *job)
+{
+    LONG band;
+    UINT y, end;
+
+    while ((band = InterlockedIncrement(&job->next_band) - 1) < job->bands)
+    {
+        y = band * job->band_rows;
+        end = min(y + job->band_rows, job->height);
+        for (; y < end; y++)
+            job->func(job->src + y * job->srcstride, job->dst + y * job->dststride, job->width);
+        if (!InterlockedDecrement(&job->remaining)) SetEvent(job->done);
+    }
+}
+
+static void CALLBACK convert_bands_callback(TP_CALLBACK_INSTANCE *instance, void *context)
+{
+    struct convert_rows_job *job = context;
+
+    convert_bands(job);
+    convert_rows_job_release(job);
+}
+
+static void convert_rows(convert_row_func func, const BYTE *src, UINT srcstride,
+    BYTE *dst, UINT dststride, UINT width, UINT height)
+{
+    static UINT cpus;
+    struct convert_rows_job *job = NULL;
+    UINT y, threads;
+
+    if (!cpus)
+    {
+        SYSTEM_INFO si;
+        GetSystemInfo(&si);
+        cpus = max(si.dwNumberOfProcessors, 1);
+    }
+
+    threads = min(cpus, CONVERT_MAX_THREADS);
+    if (threads >= 2 && (ULONGLONG)width * height >= CONVERT_PARALLEL_MIN_PIXELS &&
+        (job = HeapAlloc(GetProcessHeap(), 0, sizeof(*job))) &&
+        !(job->done = CreateEventW(NULL, TRUE, FALSE, NULL)))
+    {
+        HeapFree(GetProcessHeap(), 0, job);
+        job = NULL;
+    }
+
+    if (!job)
+    {
+        for (y = 0; y < height; y++)
+            func(src + y * srcstride, dst + y * dststride, width);
+        return;
+    }
+
+    job->func = func;
+    job->src = src;
+    job->dst = dst;
+    job->srcstride = srcstride;
+    job->dststride = dststride;
+    job->width = width;
+    job->height = height;
+    job->band_rows = max(CONVERT_BAND_MIN_PIXELS / width, 1);
+    job->bands = (height + job->band_rows - 1) / job->band_rows;
+    job->next_band = 0;
+    job->remaining = job->bands;
+    job->ref = threads;
+
+    for (y = 1; y < threads; y++)
+        if (!TrySubmitThreadpoolCallback(convert_bands_callback, job, NULL))
+            InterlockedDecrement(&job->ref);
+
+    convert_bands(job);
+    WaitForSingleObject(job->done, INFINITE);
+    convert_rows_job_release(job);
+}
+
 static inline FormatConverter *impl_from_IWICFormatConverter(IWICFormatConverter *iface)
 {
     return CONTAINING_RECORD(iface, FormatConverter, IWICFormatConverter_iface);
@@ -618,13 +970,8 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         if (prc)
         {
             HRESULT res;
-            INT x, y;
             BYTE *srcdata;
             UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
-            const BYTE *srcpixel;
-            BYTE *dstrow;
-            BYTE *dstpixel;
 
             srcstride = 3 * prc->Width;
             srcdatasize = srcstride * prc->Height;
@@ -635,22 +982,8 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
 
             if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
-                    dstpixel=dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        *dstpixel++=*srcpixel++; /* blue */
-                        *dstpixel++=*srcpixel++; /* green */
-                        *dstpixel++=*srcpixel++; /* red */
-                        *dstpixel++=255; /* alpha */
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
-                }
-            }
+                convert_rows(convert_row_24bppBGR_to_32bppBGRA, srcdata, srcstride,
+                             pbBuffer, cbStride, prc->Width, prc->Height);
 
             HeapFree(GetProcessHeap(), 0, srcdata);
 
@@ -661,14 +994,8 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         if (prc)
         {
             HRESULT res;
-            INT x, y;
             BYTE *srcdata;
             UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
-            const BYTE *srcpixel;
-            BYTE *dstrow;
-            BYTE *dstpixel;
-            BYTE tmppixel[3];
 
             srcstride = 3 * prc->Width;
             srcdatasize = srcstride * prc->Height;
@@ -679,26 +1006,8 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
 
             if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
-                    dstpixel=dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        tmppixel[0]=*srcpixel++; /* red */
-                        tmppixel[1]=*srcpixel++; /* green */
-                        tmppixel[2]=*srcpixel++; /* blue */
-
-                        *dstpixel++=tmppixel[2]; /* blue */
-                        *dstpixel++=tmppixel[1]; /* green */
-                        *dstpixel++=tmppixel[0]; /* red */
-                        *dstpixel++=255; /* alpha */
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
-                }
-            }
+                convert_rows(convert_row_24bppRGB_to_32bppBGRA, srcdata, srcstride,
+                             pbBuffer, cbStride, prc->Width, prc->Height);
 
             HeapFree(GetProcessHeap(), 0, srcdata);
 
@@ -709,15 +1018,13 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         if (prc)
         {
             HRESULT res;
-            INT x, y;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(res)) return res;
 
             /* set all alpha values to 255 */
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                    pbBuffer[cbStride*y+4*x+3] = 0xff;
+            convert_rows(convert_row_set_alpha, pbBuffer, cbStride,
+                         pbBuffer, cbStride, prc->Width, prc->Height);
         }
         return S_OK;
     case format_32bppRGBA:
@@ -726,7 +1033,8 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             HRESULT res;
             res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(res)) return res;
-            reverse_bgr8(4, pbBuffer, prc->Width, prc->Height, cbStride);
+            convert_rows(convert_row_swap_rb, pbBuffer, cbStride,
+                         pbBuffer, cbStride, prc->Width, prc->Height);
         }
         return S_OK;
     case format_32bppBGRA:
@@ -737,35 +1045,21 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         if (prc)
         {
             HRESULT res;
-            INT x, y;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(res)) return res;
 
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 0 && alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * 255 / alpha;
-                    }
-                }
+            init_tables();
+            convert_rows(convert_row_unpremultiply, pbBuffer, cbStride,
+                         pbBuffer, cbStride, prc->Width, prc->Height);
         }
         return S_OK;
     case format_48bppRGB:
         if (prc)
         {
             HRESULT res;
-            INT x, y;
             BYTE *srcdata;
             UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
-            const BYTE *srcpixel;
-            BYTE *dstrow;
-            DWORD *dstpixel;
 
             srcstride = 6 * prc->Width;
             srcdatasize = srcstride * prc->Height;
@@ -776,23 +1070,8 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
 
             if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
-                    dstpixel=(DWORD*)dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        BYTE red, green, blue;
-                        srcpixel++; red = *srcpixel++;
-                        srcpixel++; green = *srcpixel++;
-                        srcpixel++; blue = *srcpixel++;
-                        *dstpixel++=0xff000000|red<<16|green<<8|blue;
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
-                }
-            }
+                convert_rows(convert_row_48bppRGB_to_32bppBGRA, srcdata, srcstride,
+                             pbBuffer, cbStride, prc->Width, prc->Height);
 
             HeapFree(GetProcessHeap(), 0, srcdata);
 
@@ -803,13 +1082,8 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         if (prc)
         {
             HRESULT res;
-            INT x, y;
             BYTE *srcdata;
             UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
-            const BYTE *srcpixel;
-            BYTE *dstrow;
-            DWORD *dstpixel;
 
             srcstride = 8 * prc->Width;
             srcdatasize = srcstride * prc->Height;
@@ -820,24 +1094,8 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
             res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
 
             if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
-                    dstpixel=(DWORD*)dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        BYTE red, green, blue, alpha;
-                        srcpixel++; red = *srcpixel++;
-                        srcpixel++; green = *srcpixel++;
-                        srcpixel++; blue = *srcpixel++;
-                        srcpixel++; alpha = *srcpixel++;
-                        *dstpixel++=alpha<<24|red<<16|green<<8|blue;
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
-                }
-            }
+                convert_rows(convert_row_64bppRGBA_to_32bppBGRA, srcdata, srcstride,
+                             pbBuffer, cbStride, prc->Width, prc->Height);
 
             HeapFree(GetProcessHeap(), 0, srcdata);
 
@@ -848,21 +1106,12 @@ static HRESULT copypixels_to_32bppBGRA(struct FormatConverter *This, const WICRe
         if (prc)
         {
             HRESULT res;
-            UINT x, y;
 
             res = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(res)) return res;
 
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE *pixel = pbBuffer+cbStride*y+4*x;
-                    BYTE c=pixel[0], m=pixel[1], y=pixel[2], k=pixel[3];
-                    pixel[0] = (255-y)*(255-k)/255; /* blue */
-                    pixel[1] = (255-m)*(255-k)/255; /* green */
-                    pixel[2] = (255-c)*(255-k)/255; /* red */
-                    pixel[3] = 255; /* alpha */
-                }
+            convert_rows(convert_row_32bppCMYK_to_32bppBGRA, pbBuffer, cbStride,
+                         pbBuffer, cbStride, prc->Width, prc->Height);
         }
         return S_OK;
     default:
@@ -881,15 +1130,12 @@ static HRESULT copypixels_to_32bppRGBA(struct FormatConverter *This, const WICRe
     case format_32bppRGB:
         if (prc)
         {
-            INT x, y;
-
             hr = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(hr)) return hr;
 
             /* set all alpha values to 255 */
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                    pbBuffer[cbStride*y+4*x+3] = 0xff;
+            convert_rows(convert_row_set_alpha, pbBuffer, cbStride,
+                         pbBuffer, cbStride, prc->Width, prc->Height);
         }
         return S_OK;
 
@@ -901,29 +1147,20 @@ static HRESULT copypixels_to_32bppRGBA(struct FormatConverter *This, const WICRe
     case format_32bppPRGBA:
         if (prc)
         {
-            INT x, y;
-
             hr = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
             if (FAILED(hr)) return hr;
 
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 0 && alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * 255 / alpha;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * 255 / alpha;
-                    }
-                }
+            init_tables();
+            convert_rows(convert_row_unpremultiply, pbBuffer, cbStride,
+                         pbBuffer, cbStride, prc->Width, prc->Height);
         }
         return S_OK;
 
     default:
         hr = copypixels_to_32bppBGRA(This, prc, cbStride, cbBufferSize, pbBuffer, source_format);
         if (SUCCEEDED(hr) && prc)
-              reverse_bgr8(4, pbBuffer, prc->Width, prc->Height, cbStride);
+            convert_rows(convert_row_swap_rb, pbBuffer, cbStride,
+                         pbBuffer, cbStride, prc->Width, prc->Height);
         return hr;
     }
 }
@@ -974,21 +1211,8 @@ static HRESULT copypixels_to_32bppPBGRA(struct FormatConverter *This, const WICR
     default:
         hr = copypixels_to_32bppBGRA(This, prc, cbStride, cbBufferSize, pbBuffer, source_format);
         if (SUCCEEDED(hr) && prc)
-        {
-            INT x, y;
-
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * alpha / 255;
-                    }
-                }
-        }
+            convert_rows(convert_row_premultiply, pbBuffer, cbStride,
+                         pbBuffer, cbStride, prc->Width, prc->Height);
         return hr;
     }
 }
@@ -1007,21 +1231,8 @@ static HRESULT copypixels_to_32bppPRGBA(struct FormatConverter *This, const WICR
     default:
         hr = copypixels_to_32bppRGBA(This, prc, cbStride, cbBufferSize, pbBuffer, source_format);
         if (SUCCEEDED(hr) && prc)
-        {
-            INT x, y;
-
-            for (y=0; y<prc->Height; y++)
-                for (x=0; x<prc->Width; x++)
-                {
-                    BYTE alpha = pbBuffer[cbStride*y+4*x+3];
-                    if (alpha != 255)
-                    {
-                        pbBuffer[cbStride*y+4*x] = pbBuffer[cbStride*y+4*x] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+1] = pbBuffer[cbStride*y+4*x+1] * alpha / 255;
-                        pbBuffer[cbStride*y+4*x+2] = pbBuffer[cbStride*y+4*x+2] * alpha / 255;
-                    }
-                }
-        }
+            convert_rows(convert_row_premultiply, pbBuffer, cbStride,
+                         pbBuffer, cbStride, prc->Width, prc->Height);
         return hr;
     }
 }
@@ -1050,13 +1261,8 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
         if (prc)
         {
             HRESULT res;
-            INT x, y;
             BYTE *srcdata;
             UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
-            const BYTE *srcpixel;
-            BYTE *dstrow;
-            BYTE *dstpixel;
 
             srcstride = 4 * prc->Width;
             srcdatasize = srcstride * prc->Height;
@@ -1067,43 +1273,9 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
             res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
 
             if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-
-                if (source_format == format_32bppRGBA)
-                {
-                    for (y = 0; y < prc->Height; y++)
-                    {
-                        srcpixel = srcrow;
-                        dstpixel = dstrow;
-                        for (x = 0; x < prc->Width; x++) {
-                            *dstpixel++ = srcpixel[2]; /* blue */
-                            *dstpixel++ = srcpixel[1]; /* green */
-                            *dstpixel++ = srcpixel[0]; /* red */
-                            srcpixel += 4;
-                        }
-                        srcrow += srcstride;
-                        dstrow += cbStride;
-                    }
-                }
-                else
-                {
-                    for (y = 0; y < prc->Height; y++)
-                    {
-                        srcpixel = srcrow;
-                        dstpixel = dstrow;
-                        for (x = 0; x < prc->Width; x++) {
-                            *dstpixel++ = *srcpixel++; /* blue */
-                            *dstpixel++ = *srcpixel++; /* green */
-                            *dstpixel++ = *srcpixel++; /* red */
-                            srcpixel++; /* alpha */
-                        }
-                        srcrow += srcstride;
-                        dstrow += cbStride;
-                    }
-                }
-            }
+                convert_rows(source_format == format_32bppRGBA ? convert_row_32bppBGRA_to_24bppRGB
+                                                               : convert_row_32bppBGRA_to_24bppBGR,
+                             srcdata, srcstride, pbBuffer, cbStride, prc->Width, prc->Height);
 
             HeapFree(GetProcessHeap(), 0, srcdata);
 
@@ -1127,24 +1299,9 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
 
             if (SUCCEEDED(hr))
             {
-                INT x, y;
-                BYTE *src = srcdata, *dst = pbBuffer;
-
-                for (y = 0; y < prc->Height; y++)
-                {
-                    float *gray_float = (float *)src;
-                    BYTE *bgr = dst;
-
-                    for (x = 0; x < prc->Width; x++)
-                    {
-                        BYTE gray = (BYTE)floorf(to_sRGB_component(gray_float[x]) * 255.0f + 0.51f);
-                        *bgr++ = gray;
-                        *bgr++ = gray;
-                        *bgr++ = gray;
-                    }
-                    src += srcstride;
-                    dst += cbStride;
-                }
+                init_tables();
+                convert_rows(convert_row_32bppGrayFloat_to_24bppBGR, srcdata, srcstride,
+                             pbBuffer, cbStride, prc->Width, prc->Height);
             }
 
             HeapFree(GetProcessHeap(), 0, srcdata);
@@ -1167,28 +1324,8 @@ static HRESULT copypixels_to_24bppBGR(struct FormatConverter *This, const WICRec
 
             hr = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
             if (SUCCEEDED(hr))
-            {
-                INT x, y;
-                BYTE *src = srcdata, *dst = pbBuffer;
-
-                for (y = 0; y < prc->Height; y++)
-                {
-                    BYTE *cmyk = src;
-                    BYTE *bgr = dst;
-
-                    for (x = 0; x < prc->Width; x++)
-                    {
-                        BYTE c = cmyk[0], m = cmyk[1], y = cmyk[2], k = cmyk[3];
-                        bgr[0] = (255 - y) * (255 - k) / 255; /* B */
-                        bgr[1] = (255 - m) * (255 - k) / 255; /* G */
-                        bgr[2] = (255 - c) * (255 - k) / 255; /* R */
-                        cmyk += 4;
-                        bgr += 3;
-                    }
-                    src += srcstride;
-                    dst += cbStride;
-                }
-            }
+                convert_rows(convert_row_32bppCMYK_to_24bppBGR, srcdata, srcstride,
+                             pbBuffer, cbStride, prc->Width, prc->Height);
 
             heap_free(srcdata);
             return hr;
@@ -1224,14 +1361,8 @@ static HRESULT copypixels_to_24bppRGB(struct FormatConverter *This, const WICRec
         if (prc)
         {
             HRESULT res;
-            INT x, y;
             BYTE *srcdata;
             UINT srcstride, srcdatasize;
-            const BYTE *srcrow;
-            const BYTE *srcpixel;
-            BYTE *dstrow;
-            BYTE *dstpixel;
-            BYTE tmppixel[3];
 
             srcstride = 4 * prc->Width;
             srcdatasize = srcstride * prc->Height;
@@ -1242,26 +1373,8 @@ static HRESULT copypixels_to_24bppRGB(struct FormatConverter *This, const WICRec
             res = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
 
             if (SUCCEEDED(res))
-            {
-                srcrow = srcdata;
-                dstrow = pbBuffer;
-                for (y=0; y<prc->Height; y++) {
-                    srcpixel=srcrow;
-                    dstpixel=dstrow;
-                    for (x=0; x<prc->Width; x++) {
-                        tmppixel[0]=*srcpixel++; /* blue */
-                        tmppixel[1]=*srcpixel++; /* green */
-                        tmppixel[2]=*srcpixel++; /* red */
-                        srcpixel++; /* alpha */
-
-                        *dstpixel++=tmppixel[2]; /* red */
-                        *dstpixel++=tmppixel[1]; /* green */
-                        *dstpixel++=tmppixel[0]; /* blue */
-                    }
-                    srcrow += srcstride;
-                    dstrow += cbStride;
-                }
-            }
+                convert_rows(convert_row_32bppBGRA_to_24bppRGB, srcdata, srcstride,
+                             pbBuffer, cbStride, prc->Width, prc->Height);
 
             HeapFree(GetProcessHeap(), 0, srcdata);
 
@@ -1298,22 +1411,8 @@ static HRESULT copypixels_to_32bppGrayFloat(struct FormatConverter *This, const
     }
 
     if (SUCCEEDED(hr) && prc && source_format != format_32bppGrayFloat)
-    {
-        INT x, y;
-        BYTE *p = pbBuffer;
-
-        for (y = 0; y < prc->Height; y++)
-        {
-            BYTE *bgr = p;
-            for (x = 0; x < prc->Width; x++)
-            {
-                float gray = (bgr[2] * 0.2126f + bgr[1] * 0.7152f + bgr[0] * 0.0722f) / 255.0f;
-                *(float *)bgr = gray;
-                bgr += 4;
-            }
-            p += cbStride;
-        }
-    }
+        convert_rows(convert_row_32bppBGRA_to_32bppGrayFloat, pbBuffer, cbStride,
+                     pbBuffer, cbStride, prc->Width, prc->Height);
     return hr;
 }
 
@@ -1347,20 +1446,9 @@ static HRESULT copypixels_to_8bppGray(struct FormatConverter *This, const WICRec
             hr = IWICBitmapSource_CopyPixels(This->source, prc, srcstride, srcdatasize, srcdata);
             if (SUCCEEDED(hr))
             {
-                INT x, y;
-                BYTE *src = srcdata, *dst = pbBuffer;
-
-                for (y=0; y < prc->Height; y++)
-                {
-                    float *srcpixel = (float*)src;
-                    BYTE *dstpixel = dst;
-
-                    for (x=0; x < prc->Width; x++)
-                        *dstpixel++ = (BYTE)floorf(to_sRGB_component(*srcpixel++) * 255.0f + 0.51f);
-
-                    src += srcstride;
-                    dst += cbStride;
-                }
+                init_tables();
+                convert_rows(convert_row_32bppGrayFloat_to_8bppGray, srcdata, srcstride,
+                             pbBuffer, cbStride, prc->Width, prc->Height);
             }
 
             HeapFree(GetProcessHeap(), 0, srcdata);
@@ -1381,24 +1469,9 @@ static HRESULT copypixels_to_8bppGray(struct FormatConverter *This, const WICRec
     hr = copypixels_to_24bppBGR(This, prc, srcstride, srcdatasize, srcdata, source_format);
     if (SUCCEEDED(hr))
     {
-        INT x, y;
-        BYTE *src = srcdata, *dst = pbBuffer;
-
-        for (y = 0; y < prc->Height; y++)
-        {
-            BYTE *bgr = src;
-
-            for (x = 0; x < prc->Width; x++)
-            {
-                float gray = (bgr[2] * 0.2126f + bgr[1] * 0.7152f + bgr[0] * 0.0722f) / 255.0f;
-
-                gray = to_sRGB_component(gray) * 255.0f;
-                dst[x] = (BYTE)floorf(gray + 0.51f);
-                bgr += 3;
-            }
-            src += srcstride;
-            dst += cbStride;
-        }
+        init_tables();
+        convert_rows(convert_row_24bppBGR_to_8bppGray, srcdata, srcstride,
+                     pbBuffer, cbStride, prc->Width, prc->Height);
     }
 
     HeapFree(GetProcessHeap(), 0, srcdata);
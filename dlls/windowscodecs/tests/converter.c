@@ -637,6 +637,125 @@ static void test_default_converter(void)
     DeleteTestBitmap(src_obj);
 }
 
+static void test_converter_benchmark(void)
+{
+    static const struct
+    {
+        const WICPixelFormatGUID *format;
+        UINT bpp;
+        const char *name;
+    }
+    formats[] =
+    {
+        { &GUID_WICPixelFormatBlackWhite, 1, "BlackWhite" },
+        { &GUID_WICPixelFormat1bppIndexed, 1, "1bppIndexed" },
+        { &GUID_WICPixelFormat2bppIndexed, 2, "2bppIndexed" },
+        { &GUID_WICPixelFormat4bppIndexed, 4, "4bppIndexed" },
+        { &GUID_WICPixelFormat8bppIndexed, 8, "8bppIndexed" },
+        { &GUID_WICPixelFormat2bppGray, 2, "2bppGray" },
+        { &GUID_WICPixelFormat4bppGray, 4, "4bppGray" },
+        { &GUID_WICPixelFormat8bppGray, 8, "8bppGray" },
+        { &GUID_WICPixelFormat16bppGray, 16, "16bppGray" },
+        { &GUID_WICPixelFormat16bppBGR555, 16, "16bppBGR555" },
+        { &GUID_WICPixelFormat16bppBGR565, 16, "16bppBGR565" },
+        { &GUID_WICPixelFormat16bppBGRA5551, 16, "16bppBGRA5551" },
+        { &GUID_WICPixelFormat24bppBGR, 24, "24bppBGR" },
+        { &GUID_WICPixelFormat24bppRGB, 24, "24bppRGB" },
+        { &GUID_WICPixelFormat32bppGrayFloat, 32, "32bppGrayFloat" },
+        { &GUID_WICPixelFormat32bppBGR, 32, "32bppBGR" },
+        { &GUID_WICPixelFormat32bppRGB, 32, "32bppRGB" },
+        { &GUID_WICPixelFormat32bppBGRA, 32, "32bppBGRA" },
+        { &GUID_WICPixelFormat32bppRGBA, 32, "32bppRGBA" },
+        { &GUID_WICPixelFormat32bppPBGRA, 32, "32bppPBGRA" },
+        { &GUID_WICPixelFormat32bppPRGBA, 32, "32bppPRGBA" },
+        { &GUID_WICPixelFormat48bppRGB, 48, "48bppRGB" },
+        { &GUID_WICPixelFormat64bppRGBA, 64, "64bppRGBA" },
+        { &GUID_WICPixelFormat32bppCMYK, 32, "32bppCMYK" },
+    };
+    static const UINT width = 512, height = 512;
+    IWICFormatConverter *converter;
+    LARGE_INTEGER freq, start, end;
+    struct bitmap_data data;
+    BitmapTestSrc *src_obj;
+    BYTE *src_bits, *dst_bits, *ref_bits;
+    UINT i, j, k, stride;
+    BOOL can_convert;
+    WICRect rect;
+    HRESULT hr;
+
+    src_bits = HeapAlloc(GetProcessHeap(), 0, width * height * 8);
+    dst_bits = HeapAlloc(GetProcessHeap(), 0, width * height * 8);
+    ref_bits = HeapAlloc(GetProcessHeap(), 0, width * height * 8);
+    QueryPerformanceFrequency(&freq);
+
+    for (i = 0; i < ARRAY_SIZE(formats); i++)
+    {
+        if (IsEqualGUID(formats[i].format, &GUID_WICPixelFormat32bppGrayFloat))
+            for (k = 0; k < width * height; k++) ((float *)src_bits)[k] = (k % 1021) / 1020.0f;
+        else
+            for (k = 0; k < width * height * 8; k++) src_bits[k] = k * 7 ^ k >> 9;
+
+        data.format = formats[i].format;
+        data.bpp = formats[i].bpp;
+        data.bits = src_bits;
+        data.width = width;
+        data.height = height;
+        data.xres = data.yres = 96.0;
+        data.alt_data = NULL;
+        CreateTestBitmap(&data, &src_obj);
+
+        for (j = 0; j < ARRAY_SIZE(formats); j++)
+        {
+            hr = CoCreateInstance(&CLSID_WICDefaultFormatConverter, NULL, CLSCTX_INPROC_SERVER,
+                                  &IID_IWICFormatConverter, (void **)&converter);
+            ok(hr == S_OK, "CoCreateInstance error %#x\n", hr);
+
+            can_convert = FALSE;
+            hr = IWICFormatConverter_CanConvert(converter, formats[i].format, formats[j].format, &can_convert);
+            if (hr == S_OK && can_convert)
+                hr = IWICFormatConverter_Initialize(converter, &src_obj->IWICBitmapSource_iface,
+                        formats[j].format, WICBitmapDitherTypeNone, NULL, 0.0, WICBitmapPaletteTypeCustom);
+
+            if (hr == S_OK && can_convert)
+            {
+                stride = (formats[j].bpp * width + 7) / 8;
+                memset(dst_bits, 0xcc, stride * height);
+                QueryPerformanceCounter(&start);
+                hr = IWICFormatConverter_CopyPixels(converter, NULL, stride, stride * height, dst_bits);
+                QueryPerformanceCounter(&end);
+                if (hr == S_OK)
+                    trace("%s -> %s: %u ms\n", formats[i].name, formats[j].name,
+                          (UINT)((end.QuadPart - start.QuadPart) * 1000 / freq.QuadPart));
+                else
+                    trace("%s -> %s: CopyPixels error %#x\n", formats[i].name, formats[j].name, hr);
+
+                /* bands too small to be split must give the same result */
+                if (hr == S_OK)
+                {
+                    memset(ref_bits, 0xcc, stride * height);
+                    rect.X = 0;
+                    rect.Width = width;
+                    rect.Height = 32;
+                    for (rect.Y = 0; rect.Y < height && hr == S_OK; rect.Y += rect.Height)
+                        hr = IWICFormatConverter_CopyPixels(converter, &rect, stride,
+                                stride * rect.Height, ref_bits + rect.Y * stride);
+                    ok(hr == S_OK, "%s -> %s: CopyPixels error %#x\n", formats[i].name, formats[j].name, hr);
+                    ok(!memcmp(dst_bits, ref_bits, stride * height), "%s -> %s: output differs\n",
+                       formats[i].name, formats[j].name);
+                }
+            }
+
+            IWICFormatConverter_Release(converter);
+        }
+
+        DeleteTestBitmap(src_obj);
+    }
+
+    HeapFree(GetProcessHeap(), 0, src_bits);
+    HeapFree(GetProcessHeap(), 0, dst_bits);
+    HeapFree(GetProcessHeap(), 0, ref_bits);
+}
+
 typedef struct property_opt_test_data
 {
     LPCOLESTR name;
@@ -1907,6 +2026,7 @@ START_TEST(converter)
     test_invalid_conversion();
     test_default_converter();
     test_converter_8bppIndexed();
+    test_converter_benchmark();
 
     test_encoder(&testdata_8bppIndexed, &CLSID_WICGifEncoder,
                  &testdata_8bppIndexed, &CLSID_WICGifDecoder, "GIF encoder 8bppIndexed");
@@ -2789,6 +2789,15 @@ static BOOL wined3d_cs_queue_is_empty(const struct wined3d_cs *cs, const struct
     return *(volatile LONG *)&queue->head == queue->tail;
 }
 
+/* Called from the CS thread only. */
+static BOOL wined3d_cs_queue_has_packets(struct wined3d_cs_queue *queue)
+{
+    if (queue->head_cache != queue->tail)
+        return TRUE;
+    queue->head_cache = *(volatile LONG *)&queue->head;
+    return queue->head_cache != queue->tail;
+}
+
 static void wined3d_cs_queue_submit(struct wined3d_cs_queue *queue, struct wined3d_cs *cs)
 {
     struct wined3d_cs_packet *packet;
@@ -2798,7 +2807,12 @@ static void wined3d_cs_queue_submit(struct wined3d_cs_queue *queue, struct wined
     packet_size = FIELD_OFFSET(struct wined3d_cs_packet, data[packet->size]);
     InterlockedExchange(&queue->head, (queue->head + packet_size) & (WINED3D_CS_QUEUE_SIZE - 1));
 
-    if (InterlockedCompareExchange(&cs->waiting_for_event, FALSE, TRUE))
+    /* The exchange above is a full barrier, so if the CS thread is about to
+     * wait we either see "waiting_for_event" set here, or it sees the new
+     * head in wined3d_cs_wait_event(). Avoid the interlocked operation while
+     * the CS thread is busy. */
+    if (*(volatile BOOL *)&cs->waiting_for_event
+            && InterlockedCompareExchange(&cs->waiting_for_event, FALSE, TRUE))
         SetEvent(cs->event);
 }
 
@@ -2812,6 +2826,26 @@ static void wined3d_cs_mt_submit(struct wined3d_device_context *context, enum wi
     wined3d_cs_queue_submit(&cs->queue[queue_id], cs);
 }
 
+static BOOL wined3d_cs_queue_has_space(LONG head, LONG tail, size_t packet_size)
+{
+    LONG new_pos;
+
+    /* Empty. */
+    if (head == tail)
+        return TRUE;
+    new_pos = (head + packet_size) & (WINED3D_CS_QUEUE_SIZE - 1);
+    /* Head ahead of tail. We checked the remaining size before, so we only
+     * need to make sure we don't make head equal to tail. */
+    if (head > tail && (new_pos != tail))
+        return TRUE;
+    /* Tail ahead of head. Make sure the new head is before the tail as
+     * well. Note that new_pos is 0 when it's at the end of the queue. */
+    if (new_pos < tail && new_pos)
+        return TRUE;
+
+    return FALSE;
+}
+
 static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size_t size, struct wined3d_cs *cs)
 {
     size_t queue_size = ARRAY_SIZE(queue->data);
@@ -2846,27 +2880,19 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
         assert(!queue->head);
     }
 
-    for (;;)
+    /* The tail only moves forward, so a stale copy can only underestimate
+     * the available space. */
+    while (!wined3d_cs_queue_has_space(queue->head, queue->tail_cache, packet_size))
     {
         LONG tail = *(volatile LONG *)&queue->tail;
-        LONG head = queue->head;
-        LONG new_pos;
-
-        /* Empty. */
-        if (head == tail)
-            break;
-        new_pos = (head + packet_size) & (WINED3D_CS_QUEUE_SIZE - 1);
-        /* Head ahead of tail. We checked the remaining size above, so we only
-         * need to make sure we don't make head equal to tail. */
-        if (head > tail && (new_pos != tail))
-            break;
-        /* Tail ahead of head. Make sure the new head is before the tail as
-         * well. Note that new_pos is 0 when it's at the end of the queue. */
-        if (new_pos < tail && new_pos)
-            break;
-
-        TRACE("Waiting for free space. Head %u, tail %u, packet size %lu.\n",
-                head, tail, (unsigned long)packet_size);
+
+        if (tail == queue->tail_cache)
+        {
+            TRACE("Waiting for free space. Head %u, tail %u, packet size %lu.\n",
+                    queue->head, tail, (unsigned long)packet_size);
+            YieldProcessor();
+        }
+        queue->tail_cache = tail;
     }
 
     packet = (struct wined3d_cs_packet *)&queue->data[queue->head];
@@ -2980,10 +3006,10 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
         }
 
         queue = &cs->queue[WINED3D_CS_QUEUE_MAP];
-        if (wined3d_cs_queue_is_empty(cs, queue))
+        if (!wined3d_cs_queue_has_packets(queue))
         {
             queue = &cs->queue[WINED3D_CS_QUEUE_DEFAULT];
-            if (wined3d_cs_queue_is_empty(cs, queue))
+            if (!wined3d_cs_queue_has_packets(queue))
             {
                 if (++spin_count >= WINED3D_CS_SPIN_COUNT && list_empty(&cs->query_poll_list))
                     wined3d_cs_wait_event(cs);
@@ -4672,10 +4672,20 @@ enum wined3d_push_constants
 #define WINED3D_CS_QUERY_POLL_INTERVAL  10u
 #define WINED3D_CS_QUEUE_SIZE           0x100000u
 #define WINED3D_CS_SPIN_COUNT           10000000u
+#define WINED3D_CS_CACHE_LINE_SIZE      64u
 
+/* Single producer, single consumer ring. "head" is only written by the
+ * application thread and "tail" only by the CS thread; each side keeps a
+ * possibly stale copy of the other's index on its own cache line, and only
+ * rereads the shared one when the copy says the queue is full or empty. */
 struct wined3d_cs_queue
 {
-    LONG head, tail;
+    LONG head;
+    LONG tail_cache;
+    BYTE pad0[WINED3D_CS_CACHE_LINE_SIZE - 2 * sizeof(LONG)];
+    LONG tail;
+    LONG head_cache;
+    BYTE pad1[WINED3D_CS_CACHE_LINE_SIZE - 2 * sizeof(LONG)];
     BYTE data[WINED3D_CS_QUEUE_SIZE];
 };
 
@@ -1431,6 +1431,7 @@ typedef enum
 
 #ifdef __WINESRC__
     SYMOPT_EX_WINE_NATIVE_MODULES = 1000,
+    SYMOPT_EX_WINE_LAZY_DWARF,
 #endif
 } IMAGEHLP_EXTENDED_OPTIONS;
 
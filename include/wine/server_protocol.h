@@ -412,6 +412,10 @@ struct object_type_info
 
 };
 
+
+
+#define HANDLE_GENERATION_COUNT 1024
+
 struct token_groups
 {
     unsigned int count;
@@ -1240,6 +1244,18 @@ struct set_handle_info_reply
 
 
 
+struct get_handle_generations_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_handle_generations_reply
+{
+    struct reply_header __header;
+};
+
+
+
 struct dup_handle_request
 {
     struct request_header __header;
@@ -1335,7 +1351,9 @@ struct create_event_request
     unsigned int access;
     int          manual_reset;
     int          initial_state;
+    int          client_sync;
     /* VARARG(objattr,object_attributes); */
+    char __pad_28[4];
 };
 struct create_event_reply
 {
@@ -1426,8 +1444,8 @@ struct create_mutex_request
     struct request_header __header;
     unsigned int access;
     int          owned;
+    int          client_sync;
     /* VARARG(objattr,object_attributes); */
-    char __pad_20[4];
 };
 struct create_mutex_reply
 {
@@ -1485,13 +1503,31 @@ struct query_mutex_reply
 
 
 
+struct set_mutex_state_request
+{
+    struct request_header __header;
+    obj_handle_t handle;
+    thread_id_t  owner;
+    unsigned int count;
+    int          abandoned;
+    char __pad_28[4];
+};
+struct set_mutex_state_reply
+{
+    struct reply_header __header;
+};
+
+
+
 struct create_semaphore_request
 {
     struct request_header __header;
     unsigned int access;
     unsigned int initial;
     unsigned int max;
+    int          client_sync;
     /* VARARG(objattr,object_attributes); */
+    char __pad_28[4];
 };
 struct create_semaphore_reply
 {
@@ -4708,10 +4744,12 @@ struct get_object_info_reply
 {
     struct reply_header __header;
     unsigned int   access;
+    unsigned int   flags;
     unsigned int   ref_count;
     unsigned int   handle_count;
     data_size_t    total;
     /* VARARG(name,unicode_str); */
+    char __pad_28[4];
 };
 
 
@@ -5414,6 +5452,7 @@ enum request
     REQ_get_apc_result,
     REQ_close_handle,
     REQ_set_handle_info,
+    REQ_get_handle_generations,
     REQ_dup_handle,
     REQ_make_temporary,
     REQ_open_process,
@@ -5429,6 +5468,7 @@ enum request
     REQ_release_mutex,
     REQ_open_mutex,
     REQ_query_mutex,
+    REQ_set_mutex_state,
     REQ_create_semaphore,
     REQ_release_semaphore,
     REQ_query_semaphore,
@@ -5694,6 +5734,7 @@ union generic_request
     struct get_apc_result_request get_apc_result_request;
     struct close_handle_request close_handle_request;
     struct set_handle_info_request set_handle_info_request;
+    struct get_handle_generations_request get_handle_generations_request;
     struct dup_handle_request dup_handle_request;
     struct make_temporary_request make_temporary_request;
     struct open_process_request open_process_request;
@@ -5709,6 +5750,7 @@ union generic_request
     struct release_mutex_request release_mutex_request;
     struct open_mutex_request open_mutex_request;
     struct query_mutex_request query_mutex_request;
+    struct set_mutex_state_request set_mutex_state_request;
     struct create_semaphore_request create_semaphore_request;
     struct release_semaphore_request release_semaphore_request;
     struct query_semaphore_request query_semaphore_request;
@@ -5972,6 +6014,7 @@ union generic_reply
     struct get_apc_result_reply get_apc_result_reply;
     struct close_handle_reply close_handle_reply;
     struct set_handle_info_reply set_handle_info_reply;
+    struct get_handle_generations_reply get_handle_generations_reply;
     struct dup_handle_reply dup_handle_reply;
     struct make_temporary_reply make_temporary_reply;
     struct open_process_reply open_process_reply;
@@ -5987,6 +6030,7 @@ union generic_reply
     struct release_mutex_reply release_mutex_reply;
     struct open_mutex_reply open_mutex_reply;
     struct query_mutex_reply query_mutex_reply;
+    struct set_mutex_state_reply set_mutex_state_reply;
     struct create_semaphore_reply create_semaphore_reply;
     struct release_semaphore_reply release_semaphore_reply;
     struct query_semaphore_reply query_semaphore_reply;
@@ -6226,7 +6270,7 @@ union generic_reply
 
 /* ### protocol_version begin ### */
 
-#define SERVER_PROTOCOL_VERSION 688
+#define SERVER_PROTOCOL_VERSION 691
 
 /* ### protocol_version end ### */
 
@@ -695,6 +695,8 @@ int main(int argc, char** argv)
 
     SymSetOptions((SymGetOptions() & ~(SYMOPT_UNDNAME)) |
                   SYMOPT_LOAD_LINES | SYMOPT_DEFERRED_LOADS | SYMOPT_AUTO_PUBLICS);
+    /* only parse the DWARF compilation units actually looked up */
+    SymSetExtendedOption(SYMOPT_EX_WINE_LAZY_DWARF, TRUE);
 
     if (argc && !strcmp(argv[0], "--auto"))
     {
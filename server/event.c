@@ -293,8 +293,11 @@ DECL_HANDLER(create_event)
         if (get_error() == STATUS_OBJECT_NAME_EXISTS)
             reply->handle = alloc_handle( current->process, event, req->access, objattr->attributes );
         else
+        {
+            event->obj.is_client_sync = req->client_sync;
             reply->handle = alloc_handle_no_access_check( current->process, event,
                                                           req->access, objattr->attributes );
+        }
         release_object( event );
     }
 
@@ -369,16 +369,36 @@ static file_pos_t max_unix_offset = OFF_T_MAX;
 /****************************************************************/
 /* timeouts support */
 
+#define TIMEOUT_EXPIRED (~0u)
+
 struct timeout_user
 {
-    struct list           entry;      /* entry in sorted timeout list */
+    struct list           entry;      /* entry in expired list */
+    unsigned int          index;      /* index in the timeout heap, or TIMEOUT_EXPIRED */
+    unsigned int          seq;        /* insertion order, for timeouts with the same expiry */
     abstime_t             when;       /* timeout expiry */
     timeout_callback      callback;   /* callback function */
     void                 *private;    /* callback private data */
 };
 
-static struct list abs_timeout_list = LIST_INIT(abs_timeout_list); /* sorted absolute timeouts list */
-static struct list rel_timeout_list = LIST_INIT(rel_timeout_list); /* sorted relative timeouts list */
+/* binary heap of timeouts ordered by expiry, earliest first */
+struct timeout_heap
+{
+    struct timeout_user **users;      /* heap array */
+    unsigned int          count;      /* number of timeouts in the heap */
+    unsigned int          size;       /* allocated size of the array */
+};
+
+static struct timeout_heap abs_timeouts;  /* absolute timeouts, against current_time */
+static struct timeout_heap rel_timeouts;  /* relative timeouts, against monotonic_time */
+static unsigned int timeout_seq;
+
+/* main loop statistics, dumped on SIGHUP */
+static unsigned int loop_iterations;
+static unsigned long long loop_events;
+static unsigned int loop_max_events;
+static unsigned int max_timeouts;
+
 timeout_t current_time;
 timeout_t monotonic_time;
 
@@ -432,46 +452,135 @@ void set_current_time(void)
     if (user_shared_data) set_user_shared_data_time();
 }
 
+static inline struct timeout_heap *get_timeout_heap( const struct timeout_user *user )
+{
+    return user->when > 0 ? &abs_timeouts : &rel_timeouts;
+}
+
+/* check if a timeout expires before another one; relative timeouts are stored negated */
+static inline int timeout_before( const struct timeout_user *a, const struct timeout_user *b )
+{
+    abstime_t when_a = a->when > 0 ? a->when : -a->when;
+    abstime_t when_b = b->when > 0 ? b->when : -b->when;
+
+    if (when_a != when_b) return when_a < when_b;
+    return (int)(a->seq - b->seq) > 0;  /* newest first, like the sorted lists used to do */
+}
+
+static inline void set_heap_entry( struct timeout_heap *heap, unsigned int index, struct timeout_user *user )
+{
+    heap->users[index] = user;
+    user->index = index;
+}
+
+static void heap_sift_up( struct timeout_heap *heap, unsigned int index )
+{
+    struct timeout_user *user = heap->users[index];
+
+    while (index)
+    {
+        unsigned int parent = (index - 1) / 2;
+        if (!timeout_before( user, heap->users[parent] )) break;
+        set_heap_entry( heap, index, heap->users[parent] );
+        index = parent;
+    }
+    set_heap_entry( heap, index, user );
+}
+
+static void heap_sift_down( struct timeout_heap *heap, unsigned int index )
+{
+    struct timeout_user *user = heap->users[index];
+
+    for (;;)
+    {
+        unsigned int child = 2 * index + 1;
+
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count && timeout_before( heap->users[child + 1], heap->users[child] ))
+            child++;
+        if (!timeout_before( heap->users[child], user )) break;
+        set_heap_entry( heap, index, heap->users[child] );
+        index = child;
+    }
+    set_heap_entry( heap, index, user );
+}
+
+/* remove a timeout from its heap, leaving its entry free for the expired list */
+static void heap_remove( struct timeout_heap *heap, struct timeout_user *user )
+{
+    unsigned int index = user->index;
+    struct timeout_user *last = heap->users[--heap->count];
+
+    user->index = TIMEOUT_EXPIRED;
+    if (last == user) return;
+    set_heap_entry( heap, index, last );
+    if (index && timeout_before( last, heap->users[(index - 1) / 2] )) heap_sift_up( heap, index );
+    else heap_sift_down( heap, index );
+}
+
 /* add a timeout user */
 struct timeout_user *add_timeout_user( timeout_t when, timeout_callback func, void *private )
 {
     struct timeout_user *user;
-    struct list *ptr;
+    struct timeout_heap *heap;
 
     if (!(user = mem_alloc( sizeof(*user) ))) return NULL;
     user->when     = timeout_to_abstime( when );
+    user->seq      = timeout_seq++;
     user->callback = func;
     user->private  = private;
 
-    /* Now insert it in the linked list */
+    /* Now insert it in the heap */
 
-    if (user->when > 0)
-    {
-        LIST_FOR_EACH( ptr, &abs_timeout_list )
-        {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-            if (timeout->when >= user->when) break;
-        }
-    }
-    else
+    heap = get_timeout_heap( user );
+    if (heap->count == heap->size)
     {
-        LIST_FOR_EACH( ptr, &rel_timeout_list )
+        unsigned int new_size = max( 64, heap->size * 2 );
+        struct timeout_user **new_users;
+
+        if (!(new_users = realloc( heap->users, new_size * sizeof(*new_users) )))
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-            if (timeout->when <= user->when) break;
+            set_error( STATUS_NO_MEMORY );
+            free( user );
+            return NULL;
         }
+        heap->users = new_users;
+        heap->size  = new_size;
     }
-    list_add_before( ptr, &user->entry );
+    heap->users[heap->count++] = user;
+    heap_sift_up( heap, heap->count - 1 );
+
+    if (abs_timeouts.count + rel_timeouts.count > max_timeouts)
+        max_timeouts = abs_timeouts.count + rel_timeouts.count;
     return user;
 }
 
 /* remove a timeout user */
 void remove_timeout_user( struct timeout_user *user )
 {
-    list_remove( &user->entry );
+    if (user->index == TIMEOUT_EXPIRED) list_remove( &user->entry );
+    else heap_remove( get_timeout_heap( user ), user );
     free( user );
 }
 
+/* dump the main loop statistics */
+void dump_main_loop_stats(void)
+{
+    fprintf( stderr, "wineserver: %u loop iterations, %.2f events per wakeup (max %u), "
+             "%u timeouts pending (max %u)\n", loop_iterations,
+             loop_iterations ? (double)loop_events / loop_iterations : 0.0, loop_max_events,
+             abs_timeouts.count + rel_timeouts.count, max_timeouts );
+}
+
+/* update the main loop statistics after a wakeup */
+static inline void update_loop_stats( int events )
+{
+    loop_iterations++;
+    if (events <= 0) return;
+    loop_events += events;
+    if (events > loop_max_events) loop_max_events = events;
+}
+
 /* return a text description of a timeout for debugging purposes */
 const char *get_timeout_str( timeout_t timeout )
 {
@@ -586,8 +695,8 @@ static inline void remove_epoll_user( struct fd *fd, int user )
 
 static inline void main_loop_epoll(void)
 {
-    int i, ret, timeout;
-    struct epoll_event events[128];
+    int i, ret = 0, timeout;
+    static struct epoll_event events[512];
 
     assert( POLLIN == EPOLLIN );
     assert( POLLOUT == EPOLLOUT );
@@ -598,13 +707,19 @@ static inline void main_loop_epoll(void)
 
     while (active_users)
     {
+        /* expired timeouts are always processed, but when the last batch
+         * filled the array don't sleep before fetching the remaining events */
         timeout = get_next_timeout();
+        if (ret == ARRAY_SIZE( events )) timeout = 0;
 
         if (!active_users) break;  /* last user removed by a timeout */
         if (epoll_fd == -1) break;  /* an error occurred with epoll */
 
+        release_global_lock();
         ret = epoll_wait( epoll_fd, events, ARRAY_SIZE( events ), timeout );
+        acquire_global_lock();
         set_current_time();
+        update_loop_stats( ret );
 
         /* put the events into the pollfd array first, like poll does */
         for (i = 0; i < ret; i++)
@@ -708,6 +823,7 @@ static inline void main_loop_epoll(void)
         if (!active_users) break;  /* last user removed by a timeout */
         if (kqueue_fd == -1) break;  /* an error occurred with kqueue */
 
+        release_global_lock();
         if (timeout != -1)
         {
             struct timespec ts;
@@ -717,8 +833,10 @@ static inline void main_loop_epoll(void)
             ret = kevent( kqueue_fd, NULL, 0, events, ARRAY_SIZE( events ), &ts );
         }
         else ret = kevent( kqueue_fd, NULL, 0, events, ARRAY_SIZE( events ), NULL );
+        acquire_global_lock();
 
         set_current_time();
+        update_loop_stats( ret );
 
         /* put the events into the pollfd array first, like poll does */
         for (i = 0; i < ret; i++)
@@ -812,6 +930,7 @@ static inline void main_loop_epoll(void)
         if (!active_users) break;  /* last user removed by a timeout */
         if (port_fd == -1) break;  /* an error occurred with event completion */
 
+        release_global_lock();
         if (timeout != -1)
         {
             struct timespec ts;
@@ -821,10 +940,12 @@ static inline void main_loop_epoll(void)
             ret = port_getn( port_fd, events, ARRAY_SIZE( events ), &nget, &ts );
         }
         else ret = port_getn( port_fd, events, ARRAY_SIZE( events ), &nget, NULL );
+        acquire_global_lock();
 
 	if (ret == -1) break;  /* an error occurred with event completion */
 
         set_current_time();
+        update_loop_stats( nget );
 
         /* put the events into the pollfd array first, like poll does */
         for (i = 0; i < nget; i++)
@@ -916,34 +1037,24 @@ static int get_next_timeout(void)
 {
     int ret = user_shared_data ? user_shared_data_timeout : -1;
 
-    if (!list_empty( &abs_timeout_list ) || !list_empty( &rel_timeout_list ))
+    if (abs_timeouts.count || rel_timeouts.count)
     {
         struct list expired_list, *ptr;
 
-        /* first remove all expired timers from the list */
+        /* first remove all expired timers from the heaps */
 
         list_init( &expired_list );
-        while ((ptr = list_head( &abs_timeout_list )) != NULL)
+        while (abs_timeouts.count && abs_timeouts.users[0]->when <= current_time)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-
-            if (timeout->when <= current_time)
-            {
-                list_remove( &timeout->entry );
-                list_add_tail( &expired_list, &timeout->entry );
-            }
-            else break;
+            struct timeout_user *timeout = abs_timeouts.users[0];
+            heap_remove( &abs_timeouts, timeout );
+            list_add_tail( &expired_list, &timeout->entry );
         }
-        while ((ptr = list_head( &rel_timeout_list )) != NULL)
+        while (rel_timeouts.count && -rel_timeouts.users[0]->when <= monotonic_time)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
-
-            if (-timeout->when <= monotonic_time)
-            {
-                list_remove( &timeout->entry );
-                list_add_tail( &expired_list, &timeout->entry );
-            }
-            else break;
+            struct timeout_user *timeout = rel_timeouts.users[0];
+            heap_remove( &rel_timeouts, timeout );
+            list_add_tail( &expired_list, &timeout->entry );
         }
 
         /* now call the callback for all the removed timers */
@@ -956,18 +1067,18 @@ static int get_next_timeout(void)
             free( timeout );
         }
 
-        if ((ptr = list_head( &abs_timeout_list )) != NULL)
+        if (abs_timeouts.count)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
+            struct timeout_user *timeout = abs_timeouts.users[0];
             timeout_t diff = (timeout->when - current_time + 9999) / 10000;
             if (diff > INT_MAX) diff = INT_MAX;
             else if (diff < 0) diff = 0;
             if (ret == -1 || diff < ret) ret = diff;
         }
 
-        if ((ptr = list_head( &rel_timeout_list )) != NULL)
+        if (rel_timeouts.count)
         {
-            struct timeout_user *timeout = LIST_ENTRY( ptr, struct timeout_user, entry );
+            struct timeout_user *timeout = rel_timeouts.users[0];
             timeout_t diff = (-timeout->when - monotonic_time + 9999) / 10000;
             if (diff > INT_MAX) diff = INT_MAX;
             else if (diff < 0) diff = 0;
@@ -994,8 +1105,11 @@ void main_loop(void)
 
         if (!active_users) break;  /* last user removed by a timeout */
 
+        release_global_lock();
         ret = poll( pollfd, nb_users, timeout );
+        acquire_global_lock();
         set_current_time();
+        update_loop_stats( ret );
 
         if (ret > 0)
         {
@@ -120,6 +120,7 @@ extern void no_fd_queue_async( struct fd *fd, struct async *async, int type, int
 extern void default_fd_queue_async( struct fd *fd, struct async *async, int type, int count );
 extern void default_fd_reselect_async( struct fd *fd, struct async_queue *queue );
 extern void main_loop(void);
+extern void dump_main_loop_stats(void);
 extern void remove_process_locks( struct process *process );
 
 static inline struct fd *get_obj_fd( struct object *obj ) { return obj->ops->get_fd( obj ); }
@@ -174,6 +175,7 @@ extern const pe_image_info_t *get_view_image_info( const struct memory_view *vie
 extern int get_view_nt_name( const struct memory_view *view, struct unicode_str *name );
 extern void free_mapped_views( struct process *process );
 extern int get_page_size(void);
+extern int create_temp_file( file_pos_t size );
 extern struct mapping *create_fd_mapping( struct object *root, const struct unicode_str *name, struct fd *fd,
                                           unsigned int attr, const struct security_descriptor *sd );
 extern struct object *create_user_data_mapping( struct object *root, const struct unicode_str *name,
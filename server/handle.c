@@ -27,6 +27,10 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -34,6 +38,7 @@
 #include "winternl.h"
 
 #include "handle.h"
+#include "file.h"
 #include "process.h"
 #include "thread.h"
 #include "security.h"
@@ -53,6 +58,7 @@ struct handle_table
     int                  last;        /* last used entry */
     int                  free;        /* first entry that may be free */
     struct handle_entry *entries;     /* handle entries */
+    volatile unsigned int *generations; /* generation table shared with the client, if mapped */
 };
 
 static struct handle_table *global_table;
@@ -191,6 +197,8 @@ static void handle_table_destroy( struct object *obj )
         if (obj) release_object_from_handle( obj );
     }
     free( table->entries );
+    if (table->generations)
+        munmap( (void *)table->generations, HANDLE_GENERATION_COUNT * sizeof(*table->generations) );
 }
 
 /* close all the process handles and free the handle table */
@@ -214,6 +222,7 @@ struct handle_table *alloc_handle_table( struct process *process, int count )
     table->count   = count;
     table->last    = -1;
     table->free    = 0;
+    table->generations = NULL;
     if ((table->entries = mem_alloc( count * sizeof(*table->entries) ))) return table;
     release_object( table );
     return NULL;
@@ -422,6 +431,12 @@ struct handle_table *copy_handle_table( struct process *process, struct process
     return table;
 }
 
+/* invalidate the information that the client may have cached about a handle */
+static inline void bump_handle_generation( struct handle_table *table, obj_handle_t handle )
+{
+    if (table->generations) table->generations[handle_to_index( handle ) % HANDLE_GENERATION_COUNT]++;
+}
+
 /* close a handle and decrement the refcount of the associated object */
 unsigned int close_handle( struct process *process, obj_handle_t handle )
 {
@@ -435,6 +450,7 @@ unsigned int close_handle( struct process *process, obj_handle_t handle )
     if (!obj->ops->close_handle( obj, process, handle )) return STATUS_HANDLE_NOT_CLOSABLE;
     entry->ptr = NULL;
     table = handle_is_global(handle) ? global_table : process->handles;
+    bump_handle_generation( table, handle );
     if (entry < table->entries + table->free) table->free = entry - table->entries;
     if (entry == table->entries + table->last) shrink_handle_table( table );
     release_object_from_handle( obj );
@@ -547,6 +563,8 @@ static int set_handle_flags( struct process *process, obj_handle_t handle, int m
     mask  = (mask << RESERVED_SHIFT) & RESERVED_ALL;
     flags = (flags << RESERVED_SHIFT) & mask;
     entry->access = (entry->access & ~mask) | flags;
+    if (entry->access != old_access && !handle_is_global( handle ))
+        bump_handle_generation( process->handles, handle );
     return (old_access & RESERVED_ALL) >> RESERVED_SHIFT;
 }
 
@@ -657,7 +675,46 @@ DECL_HANDLER(set_handle_info)
     reply->old_flags = set_handle_flags( current->process, req->handle, req->mask, req->flags );
 }
 
+/* map the handle generation table and send it to the client */
+DECL_HANDLER(get_handle_generations)
+{
+    struct handle_table *table = current->process->handles;
+    size_t size = HANDLE_GENERATION_COUNT * sizeof(*table->generations);
+    void *ptr;
+    int fd;
+
+    if (!table || table->generations)
+    {
+        set_error( STATUS_ACCESS_DENIED );
+        return;
+    }
+    if ((fd = create_temp_file( size )) == -1) return;
+    if ((ptr = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 )) != MAP_FAILED)
+    {
+        table->generations = ptr;
+        send_client_fd( current->process, fd, 0 );
+    }
+    else file_set_error();
+    close( fd );
+}
+
 /* duplicate a handle */
+/* check if the state of an object is kept by the process owning the handle */
+static int is_client_sync_handle( struct process *process, obj_handle_t handle )
+{
+    struct object *obj;
+    int ret;
+
+    if (!(obj = get_handle_obj( process, handle, 0, NULL )))
+    {
+        clear_error();
+        return 0;
+    }
+    ret = obj->is_client_sync;
+    release_object( obj );
+    return ret;
+}
+
 DECL_HANDLER(dup_handle)
 {
     struct process *src, *dst = NULL;
@@ -665,6 +722,13 @@ DECL_HANDLER(dup_handle)
     reply->handle = 0;
     if ((src = get_process_from_handle( req->src_process, PROCESS_DUP_HANDLE )))
     {
+        /* only the owner can hand the object state over, the client retries through it */
+        if (src != current->process && is_client_sync_handle( src, req->src_handle ))
+        {
+            set_error( STATUS_MORE_PROCESSING_REQUIRED );
+            release_object( src );
+            return;
+        }
         if (req->options & DUPLICATE_MAKE_GLOBAL)
         {
             reply->handle = duplicate_handle( src, req->src_handle, NULL,
@@ -691,6 +755,7 @@ DECL_HANDLER(get_object_info)
     if (!(obj = get_handle_obj( current->process, req->handle, 0, NULL ))) return;
 
     reply->access = get_handle_access( current->process, req->handle );
+    reply->flags = set_handle_flags( current->process, req->handle, 0, 0 );
     reply->ref_count = obj->refcount;
     reply->handle_count = obj->handle_count;
     if ((name = obj->ops->get_full_name( obj, &reply->total )))
@@ -28,6 +28,9 @@
 #include <signal.h>
 #include <stdarg.h>
 #include <sys/types.h>
+#ifdef HAVE_SYS_WAIT_H
+# include <sys/wait.h>
+#endif
 #include <unistd.h>
 #ifdef HAVE_SYS_SYSCALL_H
 #include <sys/syscall.h>
@@ -54,7 +57,8 @@ static mach_port_t server_mach_port;
 
 void sigchld_callback(void)
 {
-    assert(0);  /* should never be called on MacOS */
+    /* reap the processes used to save the registry */
+    while (waitpid( -1, NULL, WNOHANG ) > 0);
 }
 
 static void mach_set_error(kern_return_t mach_error)
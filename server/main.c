@@ -146,6 +146,7 @@ int main( int argc, char *argv[] )
     init_signals();
     init_directories( load_intl_file() );
     init_registry();
+    init_request_workers();
     main_loop();
     return 0;
 }
@@ -282,7 +282,7 @@ static int check_current_dir_for_exec(void)
 }
 
 /* create a temp file for anonymous mappings */
-static int create_temp_file( file_pos_t size )
+int create_temp_file( file_pos_t size )
 {
     static int temp_dir_fd = -1;
     char tmpfn[] = "anonmap.XXXXXX";
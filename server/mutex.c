@@ -215,8 +215,11 @@ DECL_HANDLER(create_mutex)
         if (get_error() == STATUS_OBJECT_NAME_EXISTS)
             reply->handle = alloc_handle( current->process, mutex, req->access, objattr->attributes );
         else
+        {
+            mutex->obj.is_client_sync = req->client_sync;
             reply->handle = alloc_handle_no_access_check( current->process, mutex,
                                                           req->access, objattr->attributes );
+        }
         release_object( mutex );
     }
 
@@ -265,3 +268,36 @@ DECL_HANDLER(query_mutex)
         release_object( mutex );
     }
 }
+
+/* set the state of a mutex previously tracked by the client */
+DECL_HANDLER(set_mutex_state)
+{
+    struct mutex *mutex;
+    struct thread *owner = NULL;
+
+    if (req->count && !(owner = get_thread_from_id( req->owner ))) return;
+
+    if (owner && owner->process != current->process)
+    {
+        set_error( STATUS_ACCESS_DENIED );
+        release_object( owner );
+        return;
+    }
+
+    if ((mutex = (struct mutex *)get_handle_obj( current->process, req->handle,
+                                                 0, &mutex_ops )))
+    {
+        if (mutex->count) set_error( STATUS_MUTANT_NOT_OWNED );
+        else
+        {
+            mutex->abandoned = req->abandoned;
+            if (req->count)
+            {
+                do_grab( mutex, owner );
+                mutex->count = req->count;
+            }
+        }
+        release_object( mutex );
+    }
+    if (owner) release_object( owner );
+}
@@ -202,6 +202,7 @@ void *alloc_object( const struct object_ops *ops )
         obj->refcount     = 1;
         obj->handle_count = 0;
         obj->is_permanent = 0;
+        obj->is_client_sync = 0;
         obj->ops          = ops;
         obj->name         = NULL;
         obj->sd           = NULL;
@@ -422,7 +423,7 @@ struct object *grab_object( void *ptr )
 {
     struct object *obj = (struct object *)ptr;
     assert( obj->refcount < INT_MAX );
-    obj->refcount++;
+    __atomic_add_fetch( &obj->refcount, 1, __ATOMIC_RELAXED );
     return obj;
 }
 
@@ -431,7 +432,8 @@ void release_object( void *ptr )
 {
     struct object *obj = (struct object *)ptr;
     assert( obj->refcount );
-    if (!--obj->refcount)
+    /* request workers may drop references concurrently, see request.c */
+    if (!__atomic_sub_fetch( &obj->refcount, 1, __ATOMIC_ACQ_REL ))
     {
         assert( !obj->handle_count );
         /* if the refcount is 0, nobody can be in the wait queue */
@@ -121,6 +121,7 @@ struct object
     struct object_name       *name;
     struct security_descriptor *sd;
     unsigned int              is_permanent:1;
+    unsigned int              is_client_sync:1; /* state is kept by the creating process */
 #ifdef DEBUG_OBJECTS
     struct list               obj_list;
 #endif
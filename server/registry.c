@@ -74,6 +74,13 @@ struct type_descr key_type =
     },
 };
 
+/* hash index of the subkeys or values of a key */
+struct key_index
+{
+    unsigned int      size;        /* number of slots */
+    int              *slots;       /* array index + 1 of the entry in each slot, 0 if free */
+};
+
 /* a registry key */
 struct key
 {
@@ -89,6 +96,8 @@ struct key
     int               last_value;  /* last in use value */
     int               nb_values;   /* count of allocated values in array */
     struct key_value *values;      /* values array */
+    struct key_index  subkey_index; /* hash index of subkeys, for keys with many subkeys */
+    struct key_index  value_index; /* hash index of values, for keys with many values */
     unsigned int      flags;       /* flags */
     timeout_t         modif;       /* last modification time */
     struct list       notify_list; /* list of notifications */
@@ -101,6 +110,10 @@ struct key
 #define KEY_SYMLINK  0x0008  /* key is a symbolic link */
 #define KEY_WOW64    0x0010  /* key contains a Wow6432Node subkey */
 #define KEY_WOWSHARE 0x0020  /* key is a Wow64 shared key (used for Software\Classes) */
+#define KEY_UNSORTED_SUBKEYS 0x0040  /* subkeys array is not sorted, must use the index */
+#define KEY_UNSORTED_VALUES  0x0080  /* values array is not sorted, must use the index */
+#define KEY_JOURNAL          0x0100  /* key is queued for the next journal write */
+#define KEY_JOURNAL_VALUES   0x0200  /* key values must be written to the journal */
 
 /* a key value */
 struct key_value
@@ -114,6 +127,7 @@ struct key_value
 
 #define MIN_SUBKEYS  8   /* min. number of allocated subkeys per key */
 #define MIN_VALUES   8   /* min. number of allocated values per key */
+#define MIN_INDEXED  256 /* min. number of subkeys or values to build a hash index */
 
 #define MAX_NAME_LEN  256    /* max. length of a key name */
 #define MAX_VALUE_LEN 16383  /* max. length of a value name */
@@ -123,6 +137,7 @@ static struct key *root_key;
 
 static const timeout_t ticks_1601_to_1970 = (timeout_t)86400 * (369 * 365 + 89) * TICKS_PER_SEC;
 static const timeout_t save_period = 30 * -TICKS_PER_SEC;  /* delay between periodic saves */
+static const off_t min_compact_size = 256 * 1024;  /* min. journal size before compacting a branch */
 static struct timeout_user *save_timeout_user;  /* saving timer */
 static enum prefix_type { PREFIX_UNKNOWN, PREFIX_32BIT, PREFIX_64BIT } prefix_type;
 
@@ -133,15 +148,39 @@ static const struct unicode_str symlink_str = { symlink_value, sizeof(symlink_va
 
 static void set_periodic_save_timer(void);
 static struct key_value *find_value( const struct key *key, const struct unicode_str *name, int *index );
+static struct key *find_subkey( const struct key *key, const struct unicode_str *name, int *index );
+static void sort_subkeys( struct key *key );
+static void sort_values( struct key *key );
+
+/* a change waiting to be written to a branch journal */
+struct journal_entry
+{
+    struct list  entry;     /* entry in the branch list of changes */
+    struct key  *key;       /* modified key, NULL for a deleted key */
+    WCHAR       *path;      /* path of the deleted key, relative to the branch */
+    data_size_t  len;       /* length of the path in bytes */
+};
 
 /* information about where to save a registry branch */
 struct save_branch_info
 {
     struct key  *key;
     const char  *path;
+    char        *journal_path;     /* path of the change journal */
+    FILE        *journal;          /* change journal, opened on first write */
+    off_t        journal_size;     /* current size of the change journal */
+    off_t        file_size;        /* size of the branch file when it was last written */
+    int          full_save;        /* next save must rewrite the whole branch file */
+    struct list  changed_keys;     /* keys modified since the last journal write */
+    struct list  deleted_keys;     /* keys deleted since the last journal write */
+    pid_t        compact_pid;      /* process rewriting the branch file, 0 if none */
+    int          compact_fd;       /* pipe to receive the status of the compaction */
+    off_t        compact_offset;   /* journal size when the compaction started */
+    timeout_t    compact_start;    /* time when the compaction started */
 };
 
 #define MAX_SAVE_BRANCH_INFO 3
+#define JOURNAL_COMMIT ";; end of changes"  /* marks the end of a batch of journal changes */
 static int save_branch_count;
 static struct save_branch_info save_branch_info[MAX_SAVE_BRANCH_INFO];
 
@@ -156,6 +195,7 @@ struct file_load_info
     int         line;     /* current input line */
     WCHAR      *tmp;      /* temp buffer to use while parsing input */
     size_t      tmplen;   /* length of temp buffer */
+    int         journal;  /* input is a change journal */
 };
 
 
@@ -270,28 +310,44 @@ static void dump_value( const struct key_value *value, FILE *f )
     fputc( '\n', f );
 }
 
+/* dump the path and modification time of a key */
+static void dump_key_header( const struct key *key, const struct key *base, FILE *f )
+{
+    fprintf( f, "\n[" );
+    if (key != base) dump_path( key, base, f );
+    fprintf( f, "] %u\n", (unsigned int)((key->modif - ticks_1601_to_1970) / TICKS_PER_SEC) );
+    fprintf( f, "#time=%x%08x\n", (unsigned int)(key->modif >> 32), (unsigned int)key->modif );
+}
+
+/* dump the options and values of a key */
+static void dump_key_data( const struct key *key, FILE *f )
+{
+    int i;
+
+    if (key->class)
+    {
+        fprintf( f, "#class=\"" );
+        dump_strW( key->class, key->classlen, f, "\"\"" );
+        fprintf( f, "\"\n" );
+    }
+    if (key->flags & KEY_SYMLINK) fputs( "#link\n", f );
+    for (i = 0; i <= key->last_value; i++) dump_value( &key->values[i], f );
+}
+
 /* save a registry and all its subkeys to a text file */
-static void save_subkeys( const struct key *key, const struct key *base, FILE *f )
+static void save_subkeys( struct key *key, const struct key *base, FILE *f )
 {
     int i;
 
     if (key->flags & KEY_VOLATILE) return;
+    sort_subkeys( key );
+    sort_values( key );
     /* save key if it has either some values or no subkeys, or needs special options */
     /* keys with no values but subkeys are saved implicitly by saving the subkeys */
     if ((key->last_value >= 0) || (key->last_subkey == -1) || key->class || (key->flags & KEY_SYMLINK))
     {
-        fprintf( f, "\n[" );
-        if (key != base) dump_path( key, base, f );
-        fprintf( f, "] %u\n", (unsigned int)((key->modif - ticks_1601_to_1970) / TICKS_PER_SEC) );
-        fprintf( f, "#time=%x%08x\n", (unsigned int)(key->modif >> 32), (unsigned int)key->modif );
-        if (key->class)
-        {
-            fprintf( f, "#class=\"" );
-            dump_strW( key->class, key->classlen, f, "\"\"" );
-            fprintf( f, "\"\n" );
-        }
-        if (key->flags & KEY_SYMLINK) fputs( "#link\n", f );
-        for (i = 0; i <= key->last_value; i++) dump_value( &key->values[i], f );
+        dump_key_header( key, base, f );
+        dump_key_data( key, f );
     }
     for (i = 0; i <= key->last_subkey; i++) save_subkeys( key->subkeys[i], base, f );
 }
@@ -455,6 +511,8 @@ static void key_destroy( struct object *obj )
         release_object( key->subkeys[i] );
     }
     free( key->subkeys );
+    free( key->subkey_index.slots );
+    free( key->value_index.slots );
     /* unconditionally notify everything waiting on this key */
     while ((ptr = list_head( &key->notify_list )))
     {
@@ -521,6 +579,10 @@ static struct key *alloc_key( const struct unicode_str *name, timeout_t modif )
         key->last_value  = -1;
         key->values      = NULL;
         key->modif       = modif;
+        key->subkey_index.size  = 0;
+        key->subkey_index.slots = NULL;
+        key->value_index.size   = 0;
+        key->value_index.slots  = NULL;
         key->parent      = NULL;
         list_init( &key->notify_list );
         if (name->len && !(key->name = memdup( name->str, name->len )))
@@ -554,6 +616,75 @@ static void make_clean( struct key *key )
     for (i = 0; i <= key->last_subkey; i++) make_clean( key->subkeys[i] );
 }
 
+/* find the saved registry branch that contains a key */
+static struct save_branch_info *get_save_branch( const struct key *key )
+{
+    int i;
+
+    for ( ; key; key = key->parent)
+        for (i = 0; i < save_branch_count; i++)
+            if (save_branch_info[i].key == key) return &save_branch_info[i];
+    return NULL;
+}
+
+/* queue a modified key for the next journal write */
+/* the values are only written if they changed, otherwise the key is just touched */
+static void journal_key( struct key *key, int values )
+{
+    struct save_branch_info *branch;
+    struct journal_entry *entry;
+
+    if (key->flags & KEY_VOLATILE) return;
+    if (key->flags & KEY_JOURNAL)
+    {
+        if (values) key->flags |= KEY_JOURNAL_VALUES;
+        return;
+    }
+    if (!(branch = get_save_branch( key ))) return;
+    if (!(entry = malloc( sizeof(*entry) )))
+    {
+        branch->full_save = 1;
+        return;
+    }
+    entry->key  = (struct key *)grab_object( key );
+    entry->path = NULL;
+    entry->len  = 0;
+    list_add_tail( &branch->changed_keys, &entry->entry );
+    key->flags |= KEY_JOURNAL;
+    if (values) key->flags |= KEY_JOURNAL_VALUES;
+}
+
+/* queue a key deletion for the next journal write */
+static void journal_deleted_key( const struct key *key )
+{
+    struct save_branch_info *branch;
+    struct journal_entry *entry;
+    const struct key *k;
+    data_size_t len = 0;
+    WCHAR *p;
+
+    if (key->flags & KEY_VOLATILE) return;
+    if (!(branch = get_save_branch( key )) || branch->key == key) return;
+    for (k = key; k != branch->key; k = k->parent) len += k->namelen + sizeof(WCHAR);
+    len -= sizeof(WCHAR);
+    if (!(entry = malloc( sizeof(*entry) )) || !(entry->path = malloc( len )))
+    {
+        free( entry );
+        branch->full_save = 1;
+        return;
+    }
+    entry->key = NULL;
+    entry->len = len;
+    p = entry->path + len / sizeof(WCHAR);
+    for (k = key; k != branch->key; k = k->parent)
+    {
+        p -= k->namelen / sizeof(WCHAR);
+        memcpy( p, k->name, k->namelen );
+        if (p > entry->path) *--p = '\\';
+    }
+    list_add_tail( &branch->deleted_keys, &entry->entry );
+}
+
 /* go through all the notifications and send them if necessary */
 static void check_notify( struct key *key, unsigned int change, int not_subtree )
 {
@@ -574,6 +705,7 @@ static void touch_key( struct key *key, unsigned int change )
 
     key->modif = current_time;
     make_dirty( key );
+    journal_key( key, change != REG_NOTIFY_CHANGE_NAME );
 
     /* do notifications */
     check_notify( key, change, 1 );
@@ -581,6 +713,202 @@ static void touch_key( struct key *key, unsigned int change )
         check_notify( k, change, 0 );
 }
 
+/* compare two key or value names */
+static inline int compare_names( const WCHAR *name1, data_size_t len1, const WCHAR *name2, data_size_t len2 )
+{
+    int res = memicmp_strW( name1, name2, min( len1, len2 ));
+    if (!res) res = len1 - len2;
+    return res;
+}
+
+/* get the name of a subkey or value of a key */
+static inline void get_entry_name( const struct key *key, int values, int i, struct unicode_str *name )
+{
+    if (values)
+    {
+        name->str = key->values[i].name;
+        name->len = key->values[i].namelen;
+    }
+    else
+    {
+        name->str = key->subkeys[i]->name;
+        name->len = key->subkeys[i]->namelen;
+    }
+}
+
+/* look for a name in a subkey or value hash index; return the array index or -1 */
+static int lookup_index( const struct key *key, int values, const struct unicode_str *name )
+{
+    const struct key_index *index = values ? &key->value_index : &key->subkey_index;
+    unsigned int slot = hash_strW( name->str, name->len, index->size );
+    struct unicode_str entry;
+
+    while (index->slots[slot])
+    {
+        get_entry_name( key, values, index->slots[slot] - 1, &entry );
+        if (!compare_names( entry.str, entry.len, name->str, name->len )) return index->slots[slot] - 1;
+        slot = (slot + 1) % index->size;
+    }
+    return -1;
+}
+
+/* add an array entry to a subkey or value hash index */
+static void add_to_index( struct key *key, int values, int i )
+{
+    struct key_index *index = values ? &key->value_index : &key->subkey_index;
+    struct unicode_str name;
+    unsigned int slot;
+
+    get_entry_name( key, values, i, &name );
+    slot = hash_strW( name.str, name.len, index->size );
+    while (index->slots[slot]) slot = (slot + 1) % index->size;
+    index->slots[slot] = i + 1;
+}
+
+/* (re)build the subkey or value hash index of a key; return 0 on failure */
+static int build_index( struct key *key, int values )
+{
+    struct key_index *index = values ? &key->value_index : &key->subkey_index;
+    int i, count = (values ? key->last_value : key->last_subkey) + 1;
+    unsigned int size = 2 * MIN_INDEXED;
+    int *slots;
+
+    while (size < 3 * count) size *= 2;  /* keep the load factor below 1/2 after growing */
+    if (!(slots = calloc( size, sizeof(*slots) ))) return 0;
+    free( index->slots );
+    index->slots = slots;
+    index->size  = size;
+    for (i = 0; i < count; i++) add_to_index( key, values, i );
+    return 1;
+}
+
+static int subkey_compare( const void *p1, const void *p2 )
+{
+    const struct key *key1 = *(const struct key * const *)p1;
+    const struct key *key2 = *(const struct key * const *)p2;
+    return compare_names( key1->name, key1->namelen, key2->name, key2->namelen );
+}
+
+static int value_compare( const void *p1, const void *p2 )
+{
+    const struct key_value *value1 = p1;
+    const struct key_value *value2 = p2;
+    return compare_names( value1->name, value1->namelen, value2->name, value2->namelen );
+}
+
+/* restore the sort order of the subkeys, needed for enumeration */
+static void sort_subkeys( struct key *key )
+{
+    if (!(key->flags & KEY_UNSORTED_SUBKEYS)) return;
+    qsort( key->subkeys, key->last_subkey + 1, sizeof(*key->subkeys), subkey_compare );
+    key->flags &= ~KEY_UNSORTED_SUBKEYS;
+    if (!build_index( key, 0 ))
+    {
+        free( key->subkey_index.slots );
+        key->subkey_index.slots = NULL;
+    }
+}
+
+/* restore the sort order of the values, needed for enumeration */
+static void sort_values( struct key *key )
+{
+    if (!(key->flags & KEY_UNSORTED_VALUES)) return;
+    qsort( key->values, key->last_value + 1, sizeof(*key->values), value_compare );
+    key->flags &= ~KEY_UNSORTED_VALUES;
+    if (!build_index( key, 1 ))
+    {
+        free( key->value_index.slots );
+        key->value_index.slots = NULL;
+    }
+}
+
+/* update the subkey or value hash index after an entry has been inserted at position i */
+/* return the new position of the entry, in case the array had to be sorted */
+static int index_inserted_entry( struct key *key, int values, int i )
+{
+    struct key_index *index = values ? &key->value_index : &key->subkey_index;
+    unsigned int flag = values ? KEY_UNSORTED_VALUES : KEY_UNSORTED_SUBKEYS;
+    int count = (values ? key->last_value : key->last_subkey) + 1;
+    struct unicode_str name, prev;
+
+    if (!index->slots)
+    {
+        if (count >= MIN_INDEXED) build_index( key, values );
+        return i;
+    }
+    if (i != count - 1 || 2 * count > index->size)
+    {
+        /* entries have moved or the index is full */
+        if (build_index( key, values )) return i;
+        /* without an index the array must be sorted */
+        get_entry_name( key, values, i, &name );
+        if (values) sort_values( key );
+        else sort_subkeys( key );
+        free( index->slots );
+        index->slots = NULL;
+        if (values) find_value( key, &name, &i );
+        else find_subkey( key, &name, &i );
+        return i;
+    }
+    /* appended at the end; lookups go through the index so the array doesn't need to stay sorted */
+    if (i > 0)
+    {
+        get_entry_name( key, values, i, &name );
+        get_entry_name( key, values, i - 1, &prev );
+        if (compare_names( prev.str, prev.len, name.str, name.len ) > 0) key->flags |= flag;
+    }
+    add_to_index( key, values, i );
+    return i;
+}
+
+/* find the hash index slot holding array entry i */
+static unsigned int find_index_slot( const struct key *key, int values, int i )
+{
+    const struct key_index *index = values ? &key->value_index : &key->subkey_index;
+    struct unicode_str name;
+    unsigned int slot;
+
+    get_entry_name( key, values, i, &name );
+    slot = hash_strW( name.str, name.len, index->size );
+    while (index->slots[slot] != i + 1) slot = (slot + 1) % index->size;
+    return slot;
+}
+
+/* free a hash index slot, moving back the following entries of its probe sequence */
+static void free_index_slot( struct key *key, int values, unsigned int slot )
+{
+    struct key_index *index = values ? &key->value_index : &key->subkey_index;
+    struct unicode_str name;
+    unsigned int next, home;
+
+    for (next = (slot + 1) % index->size; index->slots[next]; next = (next + 1) % index->size)
+    {
+        get_entry_name( key, values, index->slots[next] - 1, &name );
+        home = hash_strW( name.str, name.len, index->size );
+        /* the entry can fill the hole if its home slot isn't between the hole and itself */
+        if (slot < next ? (home <= slot || home > next) : (home <= slot && home > next))
+        {
+            index->slots[slot] = index->slots[next];
+            slot = next;
+        }
+    }
+    index->slots[slot] = 0;
+}
+
+/* remove array entry i from the subkey or value hash index, before the caller shifts
+ * the following entries down; the array order is kept so that enumeration doesn't need
+ * to sort it again */
+static void remove_indexed_entry( struct key *key, int values, int i )
+{
+    struct key_index *index = values ? &key->value_index : &key->subkey_index;
+    unsigned int slot;
+
+    if (!index->slots) return;
+    free_index_slot( key, values, find_index_slot( key, values, i ));
+    for (slot = 0; slot < index->size; slot++)
+        if (index->slots[slot] > i + 1) index->slots[slot]--;
+}
+
 /* try to grow the array of subkeys; return 1 if OK, 0 on error */
 static int grow_subkeys( struct key *key )
 {
@@ -629,6 +957,7 @@ static struct key *alloc_subkey( struct key *parent, const struct unicode_str *n
         for (i = ++parent->last_subkey; i > index; i--)
             parent->subkeys[i] = parent->subkeys[i-1];
         parent->subkeys[index] = key;
+        index_inserted_entry( parent, 0, index );
         if (is_wow6432node( key->name, key->namelen ) && !is_wow6432node( parent->name, parent->namelen ))
             parent->flags |= KEY_WOW64;
     }
@@ -639,13 +968,15 @@ static struct key *alloc_subkey( struct key *parent, const struct unicode_str *n
 static void free_subkey( struct key *parent, int index )
 {
     struct key *key;
-    int i, nb_subkeys;
+    int nb_subkeys;
 
     assert( index >= 0 );
     assert( index <= parent->last_subkey );
 
     key = parent->subkeys[index];
-    for (i = index; i < parent->last_subkey; i++) parent->subkeys[i] = parent->subkeys[i + 1];
+    remove_indexed_entry( parent, 0, index );
+    memmove( parent->subkeys + index, parent->subkeys + index + 1,
+             (parent->last_subkey - index) * sizeof(*parent->subkeys) );
     parent->last_subkey--;
     key->flags |= KEY_DELETED;
     key->parent = NULL;
@@ -671,6 +1002,17 @@ static struct key *find_subkey( const struct key *key, const struct unicode_str
     int i, min, max, res;
     data_size_t len;
 
+    if (key->subkey_index.slots)
+    {
+        if ((i = lookup_index( key, 0, name )) == -1)
+        {
+            *index = key->last_subkey + 1;  /* new subkeys are appended */
+            return NULL;
+        }
+        *index = i;
+        return key->subkeys[i];
+    }
+
     min = 0;
     max = key->last_subkey;
     while (min <= max)
@@ -858,6 +1200,7 @@ static struct key *create_key( struct key *key, const struct unicode_str *name,
         free(key->class);
         if (!(key->class = memdup( class->str, key->classlen ))) key->classlen = 0;
     }
+    journal_key( key, 1 );
     touch_key( key->parent, REG_NOTIFY_CHANGE_NAME );
     grab_object( key );
     return key;
@@ -923,6 +1266,7 @@ static void enum_key( struct key *key, int index, int info_class, struct enum_ke
             set_error( STATUS_NO_MORE_ENTRIES );
             return;
         }
+        sort_subkeys( key );
         key = key->subkeys[index];
     }
 
@@ -1027,6 +1371,7 @@ static int delete_key( struct key *key, int recurse )
     }
 
     if (debug_level > 1) dump_operation( key, NULL, "Delete" );
+    journal_deleted_key( key );
     free_subkey( parent, index );
     touch_key( parent, REG_NOTIFY_CHANGE_NAME );
     return 0;
@@ -1063,6 +1408,17 @@ static struct key_value *find_value( const struct key *key, const struct unicode
     int i, min, max, res;
     data_size_t len;
 
+    if (key->value_index.slots)
+    {
+        if ((i = lookup_index( key, 1, name )) == -1)
+        {
+            *index = key->last_value + 1;  /* new values are appended */
+            return NULL;
+        }
+        *index = i;
+        return &key->values[i];
+    }
+
     min = 0;
     max = key->last_value;
     while (min <= max)
@@ -1106,7 +1462,8 @@ static struct key_value *insert_value( struct key *key, const struct unicode_str
     value->namelen = name->len;
     value->len     = 0;
     value->data    = NULL;
-    return value;
+    index = index_inserted_entry( key, 1, index );
+    return &key->values[index];
 }
 
 /* set a key value */
@@ -1188,6 +1545,7 @@ static void enum_value( struct key *key, int i, int info_class, struct enum_key_
         void *data;
         data_size_t namelen, maxlen;
 
+        sort_values( key );
         value = &key->values[i];
         reply->type = value->type;
         namelen = value->namelen;
@@ -1232,7 +1590,9 @@ static void enum_value( struct key *key, int i, int info_class, struct enum_key_
 static void delete_value( struct key *key, const struct unicode_str *name )
 {
     struct key_value *value;
-    int i, index, nb_values;
+    int index, nb_values;
+    WCHAR *value_name;
+    void *value_data;
 
     if (!(value = find_value( key, name, &index )))
     {
@@ -1240,10 +1600,13 @@ static void delete_value( struct key *key, const struct unicode_str *name )
         return;
     }
     if (debug_level > 1) dump_operation( key, value, "Delete" );
-    free( value->name );
-    free( value->data );
-    for (i = index; i < key->last_value; i++) key->values[i] = key->values[i + 1];
+    value_name = value->name;
+    value_data = value->data;
+    remove_indexed_entry( key, 1, index );
+    memmove( key->values + index, key->values + index + 1, (key->last_value - index) * sizeof(*key->values) );
     key->last_value--;
+    free( value_name );
+    free( value_data );
     touch_key( key, REG_NOTIFY_CHANGE_LAST_SET );
 
     /* try to shrink the array */
@@ -1259,6 +1622,22 @@ static void delete_value( struct key *key, const struct unicode_str *name )
     }
 }
 
+/* delete all the values of a key */
+static void clear_values( struct key *key )
+{
+    int i;
+
+    for (i = 0; i <= key->last_value; i++)
+    {
+        free( key->values[i].name );
+        free( key->values[i].data );
+    }
+    key->last_value = -1;
+    key->flags &= ~KEY_UNSORTED_VALUES;
+    free( key->value_index.slots );
+    key->value_index.slots = NULL;
+}
+
 /* get the registry key corresponding to an hkey handle */
 static struct key *get_hkey_obj( obj_handle_t hkey, unsigned int access )
 {
@@ -1421,6 +1800,34 @@ static void update_key_time( struct key *key, timeout_t modif )
     }
 }
 
+/* delete a key listed in a change journal */
+static void load_deleted_key( struct key *base, const char *buffer, struct file_load_info *info )
+{
+    struct unicode_str name, token;
+    struct key *key = base;
+    data_size_t len;
+    int index;
+
+    if (!get_file_tmp_space( info, strlen(buffer) * sizeof(WCHAR) )) return;
+
+    len = info->tmplen;
+    if (parse_strW( info->tmp, &len, buffer, '\"' ) == -1)
+    {
+        file_read_error( "Malformed key", info );
+        return;
+    }
+    name.str = info->tmp;
+    name.len = len - sizeof(WCHAR);
+    token.str = NULL;
+    if (!get_path_token( &name, &token )) return;
+    while (token.len)
+    {
+        if (!(key = find_subkey( key, &token, &index ))) return;  /* already deleted */
+        get_path_token( &name, &token );
+    }
+    if (key != base) delete_key( key, 1 );
+}
+
 /* load a global option from the input file */
 static int load_global_option( const char *buffer, struct file_load_info *info )
 {
@@ -1466,8 +1873,11 @@ static int load_key_option( struct key *key, const char *buffer, struct file_loa
             else if (*p >= 'a' && *p <= 'f') modif = (modif << 4) | (*p - 'a' + 10);
             else break;
         }
-        update_key_time( key, modif );
+        /* the journal records the time of existing keys too */
+        if (info->journal) key->modif = modif;
+        else update_key_time( key, modif );
     }
+    if (info->journal && !strncmp( buffer, "#replace", 8 )) clear_values( key );
     if (!strncmp( buffer, "#class=", 7 ))
     {
         p = buffer + 7;
@@ -1638,7 +2048,8 @@ static int get_prefix_len( struct key *key, const char *name, struct file_load_i
 
 /* load all the keys from the input file */
 /* prefix_len is the number of key name prefixes to skip, or -1 for autodetection */
-static void load_keys( struct key *key, const char *filename, FILE *f, int prefix_len )
+/* journal_size is the committed size when replaying a change journal, 0 for a registry file */
+static void load_keys( struct key *key, const char *filename, FILE *f, int prefix_len, off_t journal_size )
 {
     struct key *subkey = NULL;
     struct file_load_info info;
@@ -1650,6 +2061,7 @@ static void load_keys( struct key *key, const char *filename, FILE *f, int prefi
     info.len    = 4;
     info.tmplen = 4;
     info.line   = 0;
+    info.journal = (journal_size != 0);
     if (!(info.buffer = mem_alloc( info.len ))) return;
     if (!(info.tmp = mem_alloc( info.tmplen )))
     {
@@ -1666,6 +2078,7 @@ static void load_keys( struct key *key, const char *filename, FILE *f, int prefi
 
     while (read_next_line( &info ) == 1)
     {
+        if (journal_size && ftell( f ) > journal_size) break;  /* uncommitted changes */
         p = info.buffer;
         while (*p && isspace(*p)) p++;
         switch(*p)
@@ -1686,7 +2099,17 @@ static void load_keys( struct key *key, const char *filename, FILE *f, int prefi
             else file_read_error( "Value without key", &info );
             break;
         case '#':   /* option */
-            if (subkey) load_key_option( subkey, p, &info );
+            if (info.journal && !strncmp( p, "#delete=\"", 9 ))
+            {
+                if (subkey)
+                {
+                    update_key_time( subkey, modif );
+                    release_object( subkey );
+                    subkey = NULL;
+                }
+                load_deleted_key( key, p + 9, &info );
+            }
+            else if (subkey) load_key_option( subkey, p, &info );
             else if (!load_global_option( p, &info )) goto done;
             break;
         case ';':   /* comment */
@@ -1722,21 +2145,49 @@ static void load_registry( struct key *key, obj_handle_t handle )
         FILE *f = fdopen( fd, "r" );
         if (f)
         {
-            load_keys( key, NULL, f, -1 );
+            load_keys( key, NULL, f, -1, 0 );
             fclose( f );
         }
         else file_set_error();
     }
 }
 
+/* return the size of the committed part of a change journal */
+/* changes are appended in batches, a partially written batch is ignored */
+static off_t get_journal_size( FILE *f )
+{
+    static const char marker[] = "\n" JOURNAL_COMMIT "\n";
+    off_t pos = 0, size = 0;
+    unsigned int i = 0;
+    int c;
+
+    while ((c = getc( f )) != EOF)
+    {
+        pos++;
+        if (c != marker[i]) i = (c == marker[0]);
+        else if (!marker[++i])
+        {
+            size = pos;
+            i = 1;
+        }
+    }
+    rewind( f );
+    return size;
+}
+
 /* load one of the initial registry files */
 static int load_init_registry_from_file( const char *filename, struct key *key )
 {
-    FILE *f;
+    struct save_branch_info *info;
+    char *journal_path;
+    struct stat st;
+    FILE *f, *journal;
+    off_t journal_size = 0;
+    int replayed = 0;
 
     if ((f = fopen( filename, "r" )))
     {
-        load_keys( key, filename, f, 0 );
+        load_keys( key, filename, f, 0, 0 );
         fclose( f );
         if (get_error() == STATUS_NOT_REGISTRY_FILE)
         {
@@ -1745,10 +2196,41 @@ static int load_init_registry_from_file( const char *filename, struct key *key )
         }
     }
 
+    /* replay the changes that were not saved to the file yet */
+    if (!(journal_path = malloc( strlen( filename ) + sizeof(".journal") )))
+        fatal_error( "out of memory\n" );
+    sprintf( journal_path, "%s.journal", filename );
+    if ((journal = fopen( journal_path, "r" )))
+    {
+        if ((journal_size = get_journal_size( journal )))
+        {
+            clear_error();
+            load_keys( key, journal_path, journal, 0, journal_size );
+            replayed = 1;
+            if (get_error() == STATUS_NOT_REGISTRY_FILE)
+            {
+                fprintf( stderr, "%s is not a valid registry journal\n", journal_path );
+                journal_size = 0;
+            }
+        }
+        fclose( journal );
+    }
+
     assert( save_branch_count < MAX_SAVE_BRANCH_INFO );
 
-    save_branch_info[save_branch_count].path = filename;
-    save_branch_info[save_branch_count++].key = (struct key *)grab_object( key );
+    info = &save_branch_info[save_branch_count++];
+    info->path = filename;
+    info->key = (struct key *)grab_object( key );
+    info->journal_path = journal_path;
+    info->journal = NULL;
+    info->journal_size = journal_size;
+    info->file_size = (f && !stat( filename, &st )) ? st.st_size : 0;
+    info->compact_pid = 0;
+    list_init( &info->changed_keys );
+    list_init( &info->deleted_keys );
+    /* the journal can only be used once the file exists and the journal is valid */
+    info->full_save = !f || (replayed && !journal_size);
+    if (info->full_save && replayed) make_dirty( key );
     make_object_permanent( &key->obj );
     return (f != NULL);
 }
@@ -1884,8 +2366,8 @@ void init_registry(void)
     if (fchdir( server_dir_fd ) == -1) fatal_error( "chdir to server dir: %s\n", strerror( errno ));
 }
 
-/* save a registry branch to a file */
-static void save_all_subkeys( struct key *key, FILE *f )
+/* save the header of a registry file */
+static void save_file_header( struct key *key, FILE *f )
 {
     fprintf( f, "WINE REGISTRY Version 2\n" );
     fprintf( f, ";; All keys relative to " );
@@ -1902,6 +2384,12 @@ static void save_all_subkeys( struct key *key, FILE *f )
     default:
         break;
     }
+}
+
+/* save a registry branch to a file */
+static void save_all_subkeys( struct key *key, FILE *f )
+{
+    save_file_header( key, f );
     save_subkeys( key, key, f );
 }
 
@@ -1938,12 +2426,6 @@ static int save_branch( struct key *key, const char *path )
     int fd, count = 0, ret = 0;
     FILE *f;
 
-    if (!(key->flags & KEY_DIRTY))
-    {
-        if (debug_level > 1) dump_operation( key, NULL, "Not saving clean" );
-        return 1;
-    }
-
     /* test the file type */
 
     if ((fd = open( path, O_WRONLY )) != -1)
@@ -2000,7 +2482,216 @@ static int save_branch( struct key *key, const char *path )
 
 done:
     free( tmp );
-    if (ret) make_clean( key );
+    return ret;
+}
+
+/* drop the queued journal entries of a branch */
+static void discard_journal_entries( struct save_branch_info *info )
+{
+    struct journal_entry *entry, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE( entry, next, &info->deleted_keys, struct journal_entry, entry )
+    {
+        list_remove( &entry->entry );
+        free( entry->path );
+        free( entry );
+    }
+    LIST_FOR_EACH_ENTRY_SAFE( entry, next, &info->changed_keys, struct journal_entry, entry )
+    {
+        entry->key->flags &= ~(KEY_JOURNAL | KEY_JOURNAL_VALUES);
+        release_object( entry->key );
+        list_remove( &entry->entry );
+        free( entry );
+    }
+}
+
+/* append the queued changes of a branch to its journal */
+static int write_journal( struct save_branch_info *info )
+{
+    struct journal_entry *entry;
+    struct stat st;
+    FILE *f;
+    int fd;
+
+    if (!info->journal)
+    {
+        /* drop any uncommitted data left at the end of the file */
+        if ((fd = open( info->journal_path, O_WRONLY | O_CREAT | O_APPEND, 0666 )) == -1) return 0;
+        if (ftruncate( fd, info->journal_size ) || !(info->journal = fdopen( fd, "a" )))
+        {
+            close( fd );
+            return 0;
+        }
+        if (!info->journal_size) save_file_header( info->key, info->journal );
+    }
+    f = info->journal;
+
+    /* deletions go first, any key queued at a deleted path was created again afterwards */
+    LIST_FOR_EACH_ENTRY( entry, &info->deleted_keys, struct journal_entry, entry )
+    {
+        fprintf( f, "\n#delete=\"" );
+        dump_strW( entry->path, entry->len, f, "\"\"" );
+        fprintf( f, "\"\n" );
+    }
+    LIST_FOR_EACH_ENTRY( entry, &info->changed_keys, struct journal_entry, entry )
+    {
+        if (entry->key->flags & KEY_DELETED) continue;
+        dump_key_header( entry->key, info->key, f );
+        if (!(entry->key->flags & KEY_JOURNAL_VALUES)) continue;
+        fprintf( f, "#replace\n" );
+        dump_key_data( entry->key, f );
+    }
+    fprintf( f, "\n" JOURNAL_COMMIT "\n" );
+    discard_journal_entries( info );
+
+    if (fflush( f ) || fstat( fileno( f ), &st ))
+    {
+        fclose( f );
+        info->journal = NULL;
+        return 0;
+    }
+    info->journal_size = st.st_size;
+    return 1;
+}
+
+/* remove the part of the journal that has been written to the branch file */
+static void trim_journal( struct save_branch_info *info, off_t offset )
+{
+    size_t size = info->journal_size - offset;
+    char *tmp, *data = NULL;
+    struct stat st;
+    int fd, ret = 0;
+    FILE *f;
+
+    if (info->journal)
+    {
+        fclose( info->journal );
+        info->journal = NULL;
+    }
+    if (!size)
+    {
+        unlink( info->journal_path );
+        info->journal_size = 0;
+        return;
+    }
+
+    /* copy the changes made since then to a new journal */
+    if (!(tmp = malloc( strlen( info->journal_path ) + 5 ))) return;
+    sprintf( tmp, "%s.tmp", info->journal_path );
+    if (!(data = malloc( size ))) goto done;
+    if ((fd = open( info->journal_path, O_RDONLY )) == -1) goto done;
+    ret = (pread( fd, data, size, offset ) == (ssize_t)size);
+    close( fd );
+    if (!ret || !(f = fopen( tmp, "w" ))) goto done;
+    save_file_header( info->key, f );
+    fwrite( data, size, 1, f );
+    ret = !ferror( f );
+    if (fclose( f )) ret = 0;
+    if (ret) ret = !rename( tmp, info->journal_path );
+    if (!ret) unlink( tmp );
+    else if (!stat( info->journal_path, &st )) info->journal_size = st.st_size;
+
+done:
+    free( data );
+    free( tmp );
+}
+
+/* rewrite the branch file in a child process, so that the server isn't blocked */
+static void start_compaction( struct save_branch_info *info )
+{
+    char status;
+    int fd[2];
+
+    if (pipe( fd ) == -1) return;
+    switch ((info->compact_pid = fork()))
+    {
+    case 0:  /* child */
+        close( fd[0] );
+        status = !save_branch( info->key, info->path );
+        /* if the status can't be sent, the parent reads EOF and treats it as a failure */
+        _exit( write( fd[1], &status, 1 ) != 1 );
+    case -1:
+        info->compact_pid = 0;
+        close( fd[0] );
+        close( fd[1] );
+        break;
+    default:  /* parent */
+        close( fd[1] );
+        fcntl( fd[0], F_SETFL, O_NONBLOCK );
+        info->compact_fd = fd[0];
+        info->compact_offset = info->journal_size;
+        info->compact_start = monotonic_counter();
+        if (debug_level > 1)
+            fprintf( stderr, "%s: compacting %lu bytes of journal in process %04x\n",
+                     info->path, (unsigned long)info->journal_size, (int)info->compact_pid );
+        break;
+    }
+}
+
+/* check whether the branch compaction is done, and if so trim the journal */
+static void finish_compaction( struct save_branch_info *info, int wait )
+{
+    char status = 1;
+    struct stat st;
+    int ret;
+
+    if (!info->compact_pid) return;
+    if (wait) fcntl( info->compact_fd, F_SETFL, 0 );
+    while ((ret = read( info->compact_fd, &status, 1 )) == -1 && errno == EINTR);
+    if (ret == -1 && errno == EAGAIN) return;  /* still running */
+
+    close( info->compact_fd );
+    info->compact_pid = 0;
+    if (ret == 1 && !status)
+    {
+        trim_journal( info, info->compact_offset );
+        if (!stat( info->path, &st )) info->file_size = st.st_size;
+        if (debug_level > 1)
+            fprintf( stderr, "%s: compacted in %u ms\n", info->path,
+                     (unsigned int)((monotonic_counter() - info->compact_start) / 10000) );
+    }
+    else if (debug_level > 1) fprintf( stderr, "%s: compaction failed\n", info->path );
+}
+
+/* save the changes made to a registry branch */
+static int save_branch_changes( struct save_branch_info *info, int compact )
+{
+    timeout_t start = monotonic_counter();
+    struct key *key = info->key;
+    struct stat st;
+    int ret;
+
+    finish_compaction( info, 0 );
+    if (!(key->flags & KEY_DIRTY))
+    {
+        if (debug_level > 1) dump_operation( key, NULL, "Not saving clean" );
+        return 1;
+    }
+
+    if (!info->full_save && write_journal( info ))
+    {
+        make_clean( key );
+        if (debug_level > 1)
+            fprintf( stderr, "%s: journaled changes in %u ms\n", info->journal_path,
+                     (unsigned int)((monotonic_counter() - start) / 10000) );
+        if (compact && !info->compact_pid &&
+            info->journal_size > max( info->file_size / 4, min_compact_size ))
+            start_compaction( info );
+        return 1;
+    }
+
+    /* rewrite the whole branch, the journal can't be trusted anymore */
+    finish_compaction( info, 1 );
+    discard_journal_entries( info );
+    info->full_save = 1;
+    if (!(ret = save_branch( key, info->path ))) return 0;
+    make_clean( key );
+    trim_journal( info, info->journal_size );
+    if (!stat( info->path, &st )) info->file_size = st.st_size;
+    info->full_save = 0;
+    if (debug_level > 1)
+        fprintf( stderr, "%s: saved in %u ms\n", info->path,
+                 (unsigned int)((monotonic_counter() - start) / 10000) );
     return ret;
 }
 
@@ -2012,7 +2703,7 @@ static void periodic_save( void *arg )
     if (fchdir( config_dir_fd ) == -1) return;
     save_timeout_user = NULL;
     for (i = 0; i < save_branch_count; i++)
-        save_branch( save_branch_info[i].key, save_branch_info[i].path );
+        save_branch_changes( &save_branch_info[i], 1 );
     if (fchdir( server_dir_fd ) == -1) fatal_error( "chdir to server dir: %s\n", strerror( errno ));
     set_periodic_save_timer();
 }
@@ -2032,12 +2723,14 @@ void flush_registry(void)
     if (fchdir( config_dir_fd ) == -1) return;
     for (i = 0; i < save_branch_count; i++)
     {
-        if (!save_branch( save_branch_info[i].key, save_branch_info[i].path ))
+        if (!save_branch_changes( &save_branch_info[i], 0 ))
         {
             fprintf( stderr, "wineserver: could not save registry branch to %s",
                      save_branch_info[i].path );
             perror( " " );
         }
+        /* don't leave a compaction running behind us */
+        finish_compaction( &save_branch_info[i], 1 );
     }
     if (fchdir( server_dir_fd ) == -1) fatal_error( "chdir to server dir: %s\n", strerror( errno ));
 }
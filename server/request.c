@@ -48,6 +48,7 @@
 #include <sys/un.h>
 #endif
 #include <unistd.h>
+#include <pthread.h>
 #ifdef HAVE_POLL_H
 #include <poll.h>
 #endif
@@ -125,8 +126,8 @@ static const struct fd_ops master_socket_fd_ops =
 };
 
 
-struct thread *current = NULL;  /* thread handling the current request */
-unsigned int global_error = 0;  /* global error code for when no thread is current */
+__thread struct thread *current = NULL;  /* thread handling the current request */
+__thread unsigned int global_error = 0;  /* global error code for when no thread is current */
 timeout_t server_start_time = 0;  /* server startup time */
 char *server_dir = NULL;   /* server directory */
 int server_dir_fd = -1;    /* file descriptor for the server dir */
@@ -331,6 +332,310 @@ static void call_req_handler( struct thread *thread )
     current = NULL;
 }
 
+/* request worker threads
+ *
+ * The main loop holds the global lock exclusively while it dispatches events,
+ * and only drops it while it is blocked waiting for them. Requests that only
+ * look at server state are queued by read_request() and run by the workers
+ * while holding the lock shared, so that several of them can run at once.
+ * The worker sends the reply itself; if that requires changing the poll state
+ * of the thread the reply is handed back to the main loop on the done list.
+ */
+
+struct worker_notify
+{
+    struct object    obj;         /* object header */
+    struct fd       *fd;          /* file descriptor for the pipe side */
+    int              pipe_write;  /* unix fd for the pipe write side */
+};
+
+static void worker_notify_dump( struct object *obj, int verbose );
+static void worker_notify_destroy( struct object *obj );
+static void worker_notify_poll_event( struct fd *fd, int event );
+
+static const struct object_ops worker_notify_ops =
+{
+    sizeof(struct worker_notify),  /* size */
+    &no_type,                      /* type */
+    worker_notify_dump,            /* dump */
+    no_add_queue,                  /* add_queue */
+    NULL,                          /* remove_queue */
+    NULL,                          /* signaled */
+    NULL,                          /* satisfied */
+    no_signal,                     /* signal */
+    no_get_fd,                     /* get_fd */
+    default_map_access,            /* map_access */
+    default_get_sd,                /* get_sd */
+    default_set_sd,                /* set_sd */
+    no_get_full_name,              /* get_full_name */
+    no_lookup_name,                /* lookup_name */
+    no_link_name,                  /* link_name */
+    NULL,                          /* unlink_name */
+    no_open_file,                  /* open_file */
+    no_kernel_obj_list,            /* get_kernel_obj_list */
+    no_close_handle,               /* close_handle */
+    worker_notify_destroy          /* destroy */
+};
+
+static const struct fd_ops worker_notify_fd_ops =
+{
+    NULL,                          /* get_poll_events */
+    worker_notify_poll_event,      /* poll_event */
+    NULL,                          /* flush */
+    NULL,                          /* get_fd_type */
+    NULL,                          /* ioctl */
+    NULL,                          /* queue_async */
+    NULL                           /* reselect_async */
+};
+
+static pthread_rwlock_t global_lock = PTHREAD_RWLOCK_INITIALIZER;
+static pthread_mutex_t worker_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t worker_cond = PTHREAD_COND_INITIALIZER;
+static struct list worker_queue = LIST_INIT( worker_queue );  /* threads with a request to run */
+static struct list worker_done = LIST_INIT( worker_done );    /* threads with a reply to finish */
+static struct worker_notify *worker_notify;
+static int nb_workers;
+
+/* check if the request of a thread can be run by a worker thread */
+static int is_worker_request( struct thread *thread )
+{
+    if (!nb_workers || !thread->reply_fd) return 0;
+
+    switch (thread->req.request_header.req)
+    {
+    case REQ_get_key_value:
+    case REQ_get_token_sid:
+    case REQ_get_token_privileges:
+    case REQ_get_mapping_committed_range:
+    case REQ_is_same_mapping:
+    case REQ_get_mapping_filename:
+        return 1;
+    case REQ_get_mapping_info:
+        /* mapping for read or write access allocates a handle for the shared file */
+        return !(thread->req.get_mapping_info_request.access & (SECTION_MAP_READ | SECTION_MAP_WRITE));
+    default:
+        return 0;
+    }
+}
+
+/* take the global lock on behalf of the main loop */
+void acquire_global_lock(void)
+{
+    if (nb_workers) pthread_rwlock_wrlock( &global_lock );
+}
+
+/* release the global lock before the main loop waits for events */
+void release_global_lock(void)
+{
+    if (nb_workers) pthread_rwlock_unlock( &global_lock );
+}
+
+/* queue the request of a thread for the workers */
+static void queue_worker_request( struct thread *thread )
+{
+    pthread_mutex_lock( &worker_mutex );
+    list_add_tail( &worker_queue, &thread->worker_entry );
+    pthread_cond_signal( &worker_cond );
+    pthread_mutex_unlock( &worker_mutex );
+}
+
+/* remove a thread from the worker lists; called with the global lock held exclusively */
+void cancel_worker_request( struct thread *thread )
+{
+    if (!nb_workers) return;
+    pthread_mutex_lock( &worker_mutex );
+    list_remove( &thread->worker_entry );
+    list_init( &thread->worker_entry );
+    pthread_mutex_unlock( &worker_mutex );
+}
+
+/* run a queued request; called with the global lock held shared */
+static void call_worker_req_handler( struct thread *thread )
+{
+    union generic_reply reply;
+    enum request req = thread->req.request_header.req;
+    int ret;
+
+    current = thread;
+    current->reply_size = 0;
+    clear_error();
+    memset( &reply, 0, sizeof(reply) );
+
+    req_handlers[req]( &current->req, &reply );
+
+    free( current->req_data );
+    current->req_data = NULL;
+
+    reply.reply_header.error = current->error;
+    reply.reply_header.reply_size = current->reply_size;
+
+    if (!current->reply_size)
+        ret = write( get_unix_fd( current->reply_fd ), &reply, sizeof(reply) );
+    else
+    {
+        struct iovec vec[2];
+
+        vec[0].iov_base = (void *)&reply;
+        vec[0].iov_len  = sizeof(reply);
+        vec[1].iov_base = current->reply_data;
+        vec[1].iov_len  = current->reply_size;
+        ret = writev( get_unix_fd( current->reply_fd ), vec, 2 );
+    }
+
+    if (ret == sizeof(reply) + current->reply_size)
+    {
+        free( current->reply_data );
+        current->reply_data = NULL;
+    }
+    else
+    {
+        /* let the main loop deal with partial writes and errors */
+        char dummy = 0;
+
+        current->worker_ret = ret;
+        current->worker_errno = errno;
+        pthread_mutex_lock( &worker_mutex );
+        list_add_tail( &worker_done, &current->worker_entry );
+        pthread_mutex_unlock( &worker_mutex );
+        /* a full pipe means that the main loop already has a wakeup pending */
+        while (write( worker_notify->pipe_write, &dummy, 1 ) == -1)
+        {
+            if (errno == EAGAIN) break;
+            if (errno != EINTR) fatal_error( "cannot wake up the main loop: %s\n", strerror( errno ));
+        }
+    }
+    current = NULL;
+}
+
+/* finish the replies that the workers couldn't send completely */
+static void finish_worker_replies(void)
+{
+    struct list *ptr;
+
+    pthread_mutex_lock( &worker_mutex );
+    while ((ptr = list_head( &worker_done )))
+    {
+        struct thread *thread = LIST_ENTRY( ptr, struct thread, worker_entry );
+        int ret = thread->worker_ret;
+
+        list_remove( &thread->worker_entry );
+        list_init( &thread->worker_entry );
+        pthread_mutex_unlock( &worker_mutex );
+
+        if (ret >= (int)sizeof(union generic_reply))
+        {
+            /* couldn't write it all, wait for POLLOUT */
+            thread->reply_towrite = thread->reply_size - (ret - sizeof(union generic_reply));
+            set_fd_events( thread->reply_fd, POLLOUT );
+            set_fd_events( thread->request_fd, 0 );
+        }
+        else if (ret >= 0)
+            fatal_protocol_error( thread, "partial write %d\n", ret );
+        else if (thread->worker_errno == EPIPE)
+            kill_thread( thread, 0 );  /* normal death */
+        else
+            fatal_protocol_error( thread, "reply write: %s\n", strerror( thread->worker_errno ));
+
+        pthread_mutex_lock( &worker_mutex );
+    }
+    pthread_mutex_unlock( &worker_mutex );
+}
+
+/* main function of the request worker threads */
+static void *worker_thread( void *arg )
+{
+    struct thread *thread;
+    struct list *ptr;
+
+    for (;;)
+    {
+        pthread_mutex_lock( &worker_mutex );
+        while (list_empty( &worker_queue )) pthread_cond_wait( &worker_cond, &worker_mutex );
+        pthread_mutex_unlock( &worker_mutex );
+
+        /* the request is only taken off the queue once we hold the lock, so that
+         * the main loop can't kill the thread while we are running it */
+        pthread_rwlock_rdlock( &global_lock );
+        pthread_mutex_lock( &worker_mutex );
+        if ((ptr = list_head( &worker_queue )))
+        {
+            thread = LIST_ENTRY( ptr, struct thread, worker_entry );
+            list_remove( &thread->worker_entry );
+            list_init( &thread->worker_entry );
+        }
+        pthread_mutex_unlock( &worker_mutex );
+        if (ptr) call_worker_req_handler( thread );
+        pthread_rwlock_unlock( &global_lock );
+    }
+    return NULL;
+}
+
+static void worker_notify_dump( struct object *obj, int verbose )
+{
+    struct worker_notify *notify = (struct worker_notify *)obj;
+    fprintf( stderr, "Request worker notification fd=%p\n", notify->fd );
+}
+
+static void worker_notify_destroy( struct object *obj )
+{
+    struct worker_notify *notify = (struct worker_notify *)obj;
+    if (notify->fd) release_object( notify->fd );
+    close( notify->pipe_write );
+}
+
+static void worker_notify_poll_event( struct fd *fd, int event )
+{
+    char buffer[64];
+
+    if (event & (POLLERR | POLLHUP))
+        fatal_error( "error on request worker pipe\n" );
+
+    while (read( get_unix_fd( fd ), buffer, sizeof(buffer) ) > 0);
+    finish_worker_replies();
+}
+
+/* start the request worker threads, if enabled with WINESERVER_WORKERS */
+void init_request_workers(void)
+{
+    const char *env = getenv( "WINESERVER_WORKERS" );
+    pthread_rwlockattr_t attr;
+    sigset_t sigset, old_sigset;
+    pthread_t id;
+    int i, count, fd[2];
+
+    if (!env || (count = atoi( env )) <= 0) return;
+    if (debug_level) return;  /* request tracing isn't thread-safe */
+    if (count > 64) count = 64;
+
+    if (pipe( fd ) == -1) fatal_error( "cannot create request worker pipe\n" );
+    fcntl( fd[0], F_SETFL, O_NONBLOCK );
+    fcntl( fd[1], F_SETFL, O_NONBLOCK );
+    if (!(worker_notify = alloc_object( &worker_notify_ops ))) fatal_error( "out of memory\n" );
+    worker_notify->pipe_write = fd[1];
+    if (!(worker_notify->fd = create_anonymous_fd( &worker_notify_fd_ops, fd[0], &worker_notify->obj, 0 )))
+        fatal_error( "out of memory\n" );
+    set_fd_events( worker_notify->fd, POLLIN );
+    make_object_permanent( &worker_notify->obj );
+
+    /* make sure the main loop isn't starved by a steady stream of readers */
+    pthread_rwlockattr_init( &attr );
+#ifdef __GLIBC__
+    pthread_rwlockattr_setkind_np( &attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP );
+#endif
+    pthread_rwlock_init( &global_lock, &attr );
+    pthread_rwlockattr_destroy( &attr );
+
+    /* signals must be handled by the main thread */
+    sigfillset( &sigset );
+    pthread_sigmask( SIG_BLOCK, &sigset, &old_sigset );
+    for (i = 0; i < count; i++)
+        if (!pthread_create( &id, NULL, worker_thread, NULL )) pthread_detach( id );
+    pthread_sigmask( SIG_SETMASK, &old_sigset, NULL );
+
+    nb_workers = count;
+    pthread_rwlock_wrlock( &global_lock );
+}
+
 /* read a request from a thread */
 void read_request( struct thread *thread )
 {
@@ -340,10 +645,18 @@ void read_request( struct thread *thread )
     {
         if ((ret = read( get_unix_fd( thread->request_fd ), &thread->req,
                          sizeof(thread->req) )) != sizeof(thread->req)) goto error;
+        if (!list_empty( &thread->worker_entry ))
+        {
+            fatal_protocol_error( thread, "request %d sent while busy\n", thread->req.request_header.req );
+            return;
+        }
         if (!(thread->req_toread = thread->req.request_header.request_size))
         {
             /* no data, handle request at once */
-            call_req_handler( thread );
+            if (is_worker_request( thread ))
+                queue_worker_request( thread );
+            else
+                call_req_handler( thread );
             return;
         }
         if (!(thread->req_data = malloc( thread->req_toread )))
@@ -364,6 +677,12 @@ void read_request( struct thread *thread )
         if (ret <= 0) break;
         if (!(thread->req_toread -= ret))
         {
+            if (is_worker_request( thread ))
+            {
+                /* the worker frees the request data */
+                queue_worker_request( thread );
+                return;
+            }
             call_req_handler( thread );
             free( thread->req_data );
             thread->req_data = NULL;
@@ -54,6 +54,10 @@ extern int receive_fd( struct process *process );
 extern int send_client_fd( struct process *process, int fd, obj_handle_t handle );
 extern void read_request( struct thread *thread );
 extern void write_reply( struct thread *thread );
+extern void init_request_workers(void);
+extern void cancel_worker_request( struct thread *thread );
+extern void acquire_global_lock(void);
+extern void release_global_lock(void);
 extern timeout_t monotonic_counter(void);
 extern void open_master_socket(void);
 extern void close_master_socket( timeout_t timeout );
@@ -142,6 +146,7 @@ DECL_HANDLER(queue_apc);
 DECL_HANDLER(get_apc_result);
 DECL_HANDLER(close_handle);
 DECL_HANDLER(set_handle_info);
+DECL_HANDLER(get_handle_generations);
 DECL_HANDLER(dup_handle);
 DECL_HANDLER(make_temporary);
 DECL_HANDLER(open_process);
@@ -157,6 +162,7 @@ DECL_HANDLER(create_mutex);
 DECL_HANDLER(release_mutex);
 DECL_HANDLER(open_mutex);
 DECL_HANDLER(query_mutex);
+DECL_HANDLER(set_mutex_state);
 DECL_HANDLER(create_semaphore);
 DECL_HANDLER(release_semaphore);
 DECL_HANDLER(query_semaphore);
@@ -421,6 +427,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_get_apc_result,
     (req_handler)req_close_handle,
     (req_handler)req_set_handle_info,
+    (req_handler)req_get_handle_generations,
     (req_handler)req_dup_handle,
     (req_handler)req_make_temporary,
     (req_handler)req_open_process,
@@ -436,6 +443,7 @@ static const req_handler req_handlers[REQ_NB_REQUESTS] =
     (req_handler)req_release_mutex,
     (req_handler)req_open_mutex,
     (req_handler)req_query_mutex,
+    (req_handler)req_set_mutex_state,
     (req_handler)req_create_semaphore,
     (req_handler)req_release_semaphore,
     (req_handler)req_query_semaphore,
@@ -866,6 +874,7 @@ C_ASSERT( FIELD_OFFSET(struct set_handle_info_request, mask) == 20 );
 C_ASSERT( sizeof(struct set_handle_info_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct set_handle_info_reply, old_flags) == 8 );
 C_ASSERT( sizeof(struct set_handle_info_reply) == 16 );
+C_ASSERT( sizeof(struct get_handle_generations_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct dup_handle_request, src_process) == 12 );
 C_ASSERT( FIELD_OFFSET(struct dup_handle_request, src_handle) == 16 );
 C_ASSERT( FIELD_OFFSET(struct dup_handle_request, dst_process) == 20 );
@@ -901,7 +910,8 @@ C_ASSERT( sizeof(struct select_reply) == 64 );
 C_ASSERT( FIELD_OFFSET(struct create_event_request, access) == 12 );
 C_ASSERT( FIELD_OFFSET(struct create_event_request, manual_reset) == 16 );
 C_ASSERT( FIELD_OFFSET(struct create_event_request, initial_state) == 20 );
-C_ASSERT( sizeof(struct create_event_request) == 24 );
+C_ASSERT( FIELD_OFFSET(struct create_event_request, client_sync) == 24 );
+C_ASSERT( sizeof(struct create_event_request) == 32 );
 C_ASSERT( FIELD_OFFSET(struct create_event_reply, handle) == 8 );
 C_ASSERT( sizeof(struct create_event_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct event_op_request, handle) == 12 );
@@ -932,6 +942,7 @@ C_ASSERT( FIELD_OFFSET(struct open_keyed_event_reply, handle) == 8 );
 C_ASSERT( sizeof(struct open_keyed_event_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct create_mutex_request, access) == 12 );
 C_ASSERT( FIELD_OFFSET(struct create_mutex_request, owned) == 16 );
+C_ASSERT( FIELD_OFFSET(struct create_mutex_request, client_sync) == 20 );
 C_ASSERT( sizeof(struct create_mutex_request) == 24 );
 C_ASSERT( FIELD_OFFSET(struct create_mutex_reply, handle) == 8 );
 C_ASSERT( sizeof(struct create_mutex_reply) == 16 );
@@ -951,10 +962,16 @@ C_ASSERT( FIELD_OFFSET(struct query_mutex_reply, count) == 8 );
 C_ASSERT( FIELD_OFFSET(struct query_mutex_reply, owned) == 12 );
 C_ASSERT( FIELD_OFFSET(struct query_mutex_reply, abandoned) == 16 );
 C_ASSERT( sizeof(struct query_mutex_reply) == 24 );
+C_ASSERT( FIELD_OFFSET(struct set_mutex_state_request, handle) == 12 );
+C_ASSERT( FIELD_OFFSET(struct set_mutex_state_request, owner) == 16 );
+C_ASSERT( FIELD_OFFSET(struct set_mutex_state_request, count) == 20 );
+C_ASSERT( FIELD_OFFSET(struct set_mutex_state_request, abandoned) == 24 );
+C_ASSERT( sizeof(struct set_mutex_state_request) == 32 );
 C_ASSERT( FIELD_OFFSET(struct create_semaphore_request, access) == 12 );
 C_ASSERT( FIELD_OFFSET(struct create_semaphore_request, initial) == 16 );
 C_ASSERT( FIELD_OFFSET(struct create_semaphore_request, max) == 20 );
-C_ASSERT( sizeof(struct create_semaphore_request) == 24 );
+C_ASSERT( FIELD_OFFSET(struct create_semaphore_request, client_sync) == 24 );
+C_ASSERT( sizeof(struct create_semaphore_request) == 32 );
 C_ASSERT( FIELD_OFFSET(struct create_semaphore_reply, handle) == 8 );
 C_ASSERT( sizeof(struct create_semaphore_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct release_semaphore_request, handle) == 12 );
@@ -2027,10 +2044,11 @@ C_ASSERT( sizeof(struct query_symlink_reply) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_object_info_request, handle) == 12 );
 C_ASSERT( sizeof(struct get_object_info_request) == 16 );
 C_ASSERT( FIELD_OFFSET(struct get_object_info_reply, access) == 8 );
-C_ASSERT( FIELD_OFFSET(struct get_object_info_reply, ref_count) == 12 );
-C_ASSERT( FIELD_OFFSET(struct get_object_info_reply, handle_count) == 16 );
-C_ASSERT( FIELD_OFFSET(struct get_object_info_reply, total) == 20 );
-C_ASSERT( sizeof(struct get_object_info_reply) == 24 );
+C_ASSERT( FIELD_OFFSET(struct get_object_info_reply, flags) == 12 );
+C_ASSERT( FIELD_OFFSET(struct get_object_info_reply, ref_count) == 16 );
+C_ASSERT( FIELD_OFFSET(struct get_object_info_reply, handle_count) == 20 );
+C_ASSERT( FIELD_OFFSET(struct get_object_info_reply, total) == 24 );
+C_ASSERT( sizeof(struct get_object_info_reply) == 32 );
 C_ASSERT( FIELD_OFFSET(struct get_object_type_request, handle) == 12 );
 C_ASSERT( sizeof(struct get_object_type_request) == 16 );
 C_ASSERT( sizeof(struct get_object_type_reply) == 8 );
@@ -183,8 +183,11 @@ DECL_HANDLER(create_semaphore)
         if (get_error() == STATUS_OBJECT_NAME_EXISTS)
             reply->handle = alloc_handle( current->process, sem, req->access, objattr->attributes );
         else
+        {
+            sem->obj.is_client_sync = req->client_sync;
             reply->handle = alloc_handle_no_access_check( current->process, sem,
                                                           req->access, objattr->attributes );
+        }
         release_object( sem );
     }
 
@@ -181,6 +181,7 @@ static void sighup_callback(void)
 #ifdef DEBUG_OBJECTS
     dump_objects();
 #endif
+    dump_main_loop_stats();
 }
 
 /* SIGTERM callback */
@@ -67,6 +67,9 @@ struct thread
     void                  *reply_data;    /* variable-size data for reply */
     unsigned int           reply_size;    /* size of reply data */
     unsigned int           reply_towrite; /* amount of data still to write in reply */
+    struct list            worker_entry;  /* entry in request worker queue or done list */
+    int                    worker_ret;    /* result of reply write done by a request worker */
+    int                    worker_errno;  /* errno of reply write done by a request worker */
     struct fd             *request_fd;    /* fd for receiving client requests */
     struct fd             *reply_fd;      /* fd to send a reply to a client */
     struct fd             *wait_fd;       /* fd to use to wake a sleeping client */
@@ -92,7 +95,7 @@ struct thread
     WCHAR                 *desc;          /* thread description string */
 };
 
-extern struct thread *current;
+extern __thread struct thread *current;
 
 /* thread functions */
 
@@ -134,7 +137,7 @@ extern int send_thread_signal( struct thread *thread, int sig );
 extern void get_selector_entry( struct thread *thread, int entry, unsigned int *base,
                                 unsigned int *limit, unsigned char *flags );
 
-extern unsigned int global_error;  /* global error code for when no thread is current */
+extern __thread unsigned int global_error;  /* global error code for when no thread is current */
 
 static inline unsigned int get_error(void)       { return current ? current->error : global_error; }
 static inline void set_error( unsigned int err ) { global_error = err; if (current) current->error = err; }
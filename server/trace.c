@@ -1666,6 +1666,10 @@ static void dump_set_handle_info_reply( const struct set_handle_info_reply *req
     fprintf( stderr, " old_flags=%d", req->old_flags );
 }
 
+static void dump_get_handle_generations_request( const struct get_handle_generations_request *req )
+{
+}
+
 static void dump_dup_handle_request( const struct dup_handle_request *req )
 {
     fprintf( stderr, " src_process=%04x", req->src_process );
@@ -1734,6 +1738,7 @@ static void dump_create_event_request( const struct create_event_request *req )
     fprintf( stderr, " access=%08x", req->access );
     fprintf( stderr, ", manual_reset=%d", req->manual_reset );
     fprintf( stderr, ", initial_state=%d", req->initial_state );
+    fprintf( stderr, ", client_sync=%d", req->client_sync );
     dump_varargs_object_attributes( ", objattr=", cur_size );
 }
 
@@ -1805,6 +1810,7 @@ static void dump_create_mutex_request( const struct create_mutex_request *req )
 {
     fprintf( stderr, " access=%08x", req->access );
     fprintf( stderr, ", owned=%d", req->owned );
+    fprintf( stderr, ", client_sync=%d", req->client_sync );
     dump_varargs_object_attributes( ", objattr=", cur_size );
 }
 
@@ -1848,11 +1854,20 @@ static void dump_query_mutex_reply( const struct query_mutex_reply *req )
     fprintf( stderr, ", abandoned=%d", req->abandoned );
 }
 
+static void dump_set_mutex_state_request( const struct set_mutex_state_request *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", owner=%04x", req->owner );
+    fprintf( stderr, ", count=%08x", req->count );
+    fprintf( stderr, ", abandoned=%d", req->abandoned );
+}
+
 static void dump_create_semaphore_request( const struct create_semaphore_request *req )
 {
     fprintf( stderr, " access=%08x", req->access );
     fprintf( stderr, ", initial=%08x", req->initial );
     fprintf( stderr, ", max=%08x", req->max );
+    fprintf( stderr, ", client_sync=%d", req->client_sync );
     dump_varargs_object_attributes( ", objattr=", cur_size );
 }
 
@@ -4033,6 +4048,7 @@ static void dump_get_object_info_request( const struct get_object_info_request *
 static void dump_get_object_info_reply( const struct get_object_info_reply *req )
 {
     fprintf( stderr, " access=%08x", req->access );
+    fprintf( stderr, ", flags=%08x", req->flags );
     fprintf( stderr, ", ref_count=%08x", req->ref_count );
     fprintf( stderr, ", handle_count=%08x", req->handle_count );
     fprintf( stderr, ", total=%u", req->total );
@@ -4478,6 +4494,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_apc_result_request,
     (dump_func)dump_close_handle_request,
     (dump_func)dump_set_handle_info_request,
+    (dump_func)dump_get_handle_generations_request,
     (dump_func)dump_dup_handle_request,
     (dump_func)dump_make_temporary_request,
     (dump_func)dump_open_process_request,
@@ -4493,6 +4510,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_release_mutex_request,
     (dump_func)dump_open_mutex_request,
     (dump_func)dump_query_mutex_request,
+    (dump_func)dump_set_mutex_state_request,
     (dump_func)dump_create_semaphore_request,
     (dump_func)dump_release_semaphore_request,
     (dump_func)dump_query_semaphore_request,
@@ -4754,6 +4772,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_get_apc_result_reply,
     NULL,
     (dump_func)dump_set_handle_info_reply,
+    NULL,
     (dump_func)dump_dup_handle_reply,
     NULL,
     (dump_func)dump_open_process_reply,
@@ -4769,6 +4788,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_release_mutex_reply,
     (dump_func)dump_open_mutex_reply,
     (dump_func)dump_query_mutex_reply,
+    NULL,
     (dump_func)dump_create_semaphore_reply,
     (dump_func)dump_release_semaphore_reply,
     (dump_func)dump_query_semaphore_reply,
@@ -5030,6 +5050,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "get_apc_result",
     "close_handle",
     "set_handle_info",
+    "get_handle_generations",
     "dup_handle",
     "make_temporary",
     "open_process",
@@ -5045,6 +5066,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "release_mutex",
     "open_mutex",
     "query_mutex",
+    "set_mutex_state",
     "create_semaphore",
     "release_semaphore",
     "query_semaphore",